@@ -1,817 +1,7399 @@
-#include "labengine.h"
-
-#include <windows.h>
-#include <crtdbg.h>
-#include <stdio.h>
-#include <strsafe.h>
-
-#define BUFFER_SIZE 32 /// size of queue for keyboard buffer (31 + 1)
-#define MAX_SEM_COUNT BUFFER_SIZE /// max semaphore object count
-
-#define LABASSERT(e)      _ASSERTE(e)
-#define LABASSERT_INIT()  LABASSERT("LabInit() should be called first!" && s_globals.init);
-
-#ifdef _DEBUG 
-#define LAB_ENABLE_REPORT
-#endif
-
-typedef struct labkeyqueue_t
-{
-  int start; // index of first element in queue
-  int end;   // index next to the last element in queue
-  int key[BUFFER_SIZE]; // circular queue
-} labkeyqueue_t;
-
-typedef struct labglobals_t
-{
-  labbool_t init;       // if value is LAB_TRUE, graphics mode has already been initialized
-
-  DWORD threadId;       // receives the thread identifier when thread creates in <code>CreateThread()</code> function
-  HANDLE thread;        // handle to a new thread - return value of <code>CreateThread()</code> function
-  HANDLE syncEvent;     // event used to synchronize with the main thread
-
-  HWND hwnd;            // handle to a window
-
-  labbool_t quit;       // if value is LAB_TRUE, window will be destroyed and graphics mode will be closed
-
-  LONG width;           // width of window
-  LONG height;          // height of window
-  DWORD scale;          // scale factor for buffer output
-
-  HBITMAP hbm;          // a handle to a bitmap used to draw
-  HDC hbmdc;            // a handle to device context of hbm
-  HRGN hrgn;            // a handle to a region to be updated after drawing
-  
-  CRITICAL_SECTION cs;  // critical section object used to provide sinchronization in graphics
-  HANDLE ghSemaphore;   // semaphore object used to provide sinchronization in input system
-
-  COLORREF colors[LABCOLOR_COUNT];  // array of colors (array of rgb)
-  labcolor_t penColor;  // current pen color
-  COLORREF penColorRGB; // current rgb pen color
-
-  RECT updateRect;      // update area
-} labglobals_t;
-
-static labglobals_t s_globals = {
-  LAB_FALSE,    // init
-  ~0,           // threadId
-  NULL,         // thread
-  NULL,         // syncEvent
-  NULL,         // hwnd
-  LAB_FALSE,    // quit
-};
-
-static labkeyqueue_t s_keyQueue;
-
-static COLORREF s_defaultColors[] = {
-  RGB(   0,   0,   0), // LABCOLOR_BLACK,
-  RGB(   0,   0, 128), // LABCOLOR_DARK_BLUE,
-  RGB(   0, 128,   0), // LABCOLOR_DARK_GREEN,
-  RGB(   0, 128, 255), // LABCOLOR_DARK_CYAN,
-  RGB( 128,   0,   0), // LABCOLOR_DARK_RED,
-  RGB( 128,   0, 128), // LABCOLOR_DARK_MAGENTA,
-  RGB( 128,  64,   0), // LABCOLOR_BROWN,
-  RGB( 192, 192, 192), // LABCOLOR_LIGHT_GREY,
-  RGB( 128, 128, 128), // LABCOLOR_DARK_GREY,
-  RGB(   0,   0, 255), // LABCOLOR_BLUE,
-  RGB(   0, 255,   0), // LABCOLOR_GREEN,
-  RGB(   0, 255, 255), // LABCOLOR_CYAN,
-  RGB( 255,   0,   0), // LABCOLOR_RED,
-  RGB( 255,   0, 255), // LABCOLOR_MAGENTA,
-  RGB( 255, 255,   0), // LABCOLOR_YELLOW,
-  RGB( 255, 255, 255), // LABCOLOR_WHITE,
-};
-
-// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-//   Forward declarations
-// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-static __inline int _labGetWindowWidth(void);
-static __inline int _labGetWindowHeight(void);
-
-// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-//   Error report
-// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-void _labReportError()
-{
-#ifdef LAB_ENABLE_REPORT
-
-  LPVOID lpMsgBuf;
-  LPVOID lpDisplayBuf;
-  DWORD dw = GetLastError(); 
-
-  FormatMessage(FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
-    NULL, dw, MAKELANGID(LANG_ENGLISH, SUBLANG_DEFAULT), (LPTSTR) &lpMsgBuf, 0, NULL );
-
-  // Display the error message and exit the process
-  if (dw != 0)
-  {
-    lpDisplayBuf = (LPVOID)LocalAlloc(LMEM_ZEROINIT, (lstrlen((LPCTSTR)lpMsgBuf) + 40) * sizeof(TCHAR)); 
-    StringCchPrintf((LPTSTR)lpDisplayBuf, LocalSize(lpDisplayBuf) / sizeof(TCHAR), TEXT("Failed with error %d: %s"), dw, lpMsgBuf); 
-    OutputDebugString((LPTSTR) lpDisplayBuf);
-    // MessageBox(NULL, (LPCTSTR)lpDisplayBuf, TEXT("Error"), MB_OK); 
-    LocalFree(lpDisplayBuf); 
-  }
-  LocalFree(lpMsgBuf);
-
-#endif LAB_ENABLE_REPORT
-}
-
-
-// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-//   Queue functionality
-// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-labbool_t _labInputQueueFull(void)
-{
-  return ((s_keyQueue.start == s_keyQueue.end + 1) || (s_keyQueue.end - s_keyQueue.start == BUFFER_SIZE - 1)) ? LAB_TRUE : LAB_FALSE;
-}
-
-labbool_t _labInputQueueEmpty(void)
-{
-  return (s_keyQueue.start == s_keyQueue.end) ? LAB_TRUE : LAB_FALSE;
-}
-
-labbool_t _labInputKeyPush(int c)
-{
-  if (!_labInputQueueFull())
-  {
-    s_keyQueue.key[s_keyQueue.end] = c;
-    // make it circular
-    if (s_keyQueue.end + 1 == BUFFER_SIZE)
-      s_keyQueue.end = 0;
-    else
-      s_keyQueue.end++;
-  }
-  else
-    MessageBeep(0xFFFFFFFF); // if queue is full, don't add element, just beep
-  if (!ReleaseSemaphore(s_globals.ghSemaphore, 1, NULL)) // increase semaphore oblect value by one
-    _labReportError();
-  return !_labInputQueueFull();
-}
-
-int _labInputKeyPop(void)
-{
-  int key;
-  if (!_labInputQueueEmpty())
-  {
-    key = s_keyQueue.key[s_keyQueue.start];
-    // pop elemnt
-    s_keyQueue.key[s_keyQueue.start] = 0;
-    // make it circular
-    if (s_keyQueue.start + 1 == BUFFER_SIZE)
-      s_keyQueue.start = 0;
-    else
-      s_keyQueue.start++;
-    return key;
-  }
-  return 0; // if element was not deleted (queue was empty)
-}
-
-
-// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-//   Message handlers
-// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-static LRESULT _onClose(_In_ HWND hwnd, _In_ UINT uMsg, _In_ WPARAM wParam, _In_ LPARAM lParam)
-{
-  if (s_globals.quit)
-  {
-    DestroyWindow(hwnd);
-    DeleteObject(s_globals.hbmdc);
-    DeleteCriticalSection(&s_globals.cs);
-  }
-  return 0;
-}
-
-static LRESULT _onDestroy(_In_ HWND hwnd, _In_ UINT uMsg, _In_ WPARAM wParam, _In_ LPARAM lParam)
-{
-  PostQuitMessage(0);
-  return 0;
-}
-
-static LRESULT _onPaint(_In_ HWND hwnd, _In_ UINT uMsg, _In_ WPARAM wParam, _In_ LPARAM lParam)
-{
-  PAINTSTRUCT ps;
-  HDC hdc;
-  DWORD res;
-  RECT srcRect, dstRect;
-
-  EnterCriticalSection(&s_globals.cs);
-  //	if (TryEnterCriticalSection(&s_globals.cs))
-  {
-    hdc = BeginPaint(hwnd, &ps);
-    if (hdc)
-    {
-      //if (IsRectEmpty(&s_globals.updateRect))
-      CopyRect(&dstRect, &ps.rcPaint);
-      if (s_globals.scale == 1)
-      {
-        res = BitBlt(hdc, dstRect.left, dstRect.top, dstRect.right, dstRect.bottom,
-          s_globals.hbmdc, dstRect.left, dstRect.top, SRCCOPY);
-      }
-      else
-      {
-        // find source rectangle
-        srcRect.left = dstRect.left / s_globals.scale;
-        srcRect.right = (dstRect.right + s_globals.scale - 1) / s_globals.scale;
-        srcRect.top = dstRect.top / s_globals.scale;
-        srcRect.bottom = (dstRect.bottom + s_globals.scale - 1) / s_globals.scale;
-
-        // corresponding screen rectangle (rounded up)
-        dstRect.left = srcRect.left * s_globals.scale;
-        dstRect.right = srcRect.right * s_globals.scale;
-        dstRect.top = srcRect.top * s_globals.scale;
-        dstRect.bottom = srcRect.bottom * s_globals.scale;
-
-        res = StretchBlt(hdc, dstRect.left, dstRect.top, dstRect.right, dstRect.bottom,
-          s_globals.hbmdc, srcRect.left, srcRect.top, srcRect.right, srcRect.bottom, SRCCOPY);
-      }
-      if (!res)
-        _labReportError();
-      SetRectEmpty(&s_globals.updateRect);
-    }
-    LeaveCriticalSection(&s_globals.cs);
-  }
-  EndPaint(hwnd, &ps);
-  return 0;
-}
-
-// button faces and 4 special keys processing
-static LRESULT _onChar(_In_ HWND hwnd, _In_ UINT uMsg, _In_ WPARAM wParam, _In_ LPARAM lParam)
-{
-  int i;
-  int code;
-  int mask = 0x0000FFFF; // 00..011..1
-
-  // special codes for these keys
-  switch (wParam)  
-  {
-  case VK_RETURN: // ENTER key
-    code = LABKEY_ENTER;
-    break;
-
-  case VK_ESCAPE:
-    code = LABKEY_ESC;
-    break;
-
-  case VK_BACK:
-    code = LABKEY_BACK;
-    break;
-
-  case VK_TAB:
-    code = LABKEY_TAB;
-    break;
-
-  default:
-    {
-      // button faces processing
-      code = wParam;
-      break;
-    }
-  }
-
-  for (i = 0; i < (mask & lParam); i++) // repeat count for the current message
-    if (!_labInputKeyPush(code))
-      break;
-  return 0;
-}
-
-// other keys processing
-static LRESULT _onKeydown(_In_ HWND hwnd, _In_ UINT uMsg, _In_ WPARAM wParam, _In_ LPARAM lParam)
-{
-  int i;
-  int virtual_code;
-  int mask = 0x0000FFFF; // 00..011..1
-
-  switch (wParam)
-  {
-  case VK_LEFT:
-    virtual_code = LABKEY_LEFT;
-    break;
-
-  case VK_UP:
-    virtual_code = LABKEY_UP;
-    break;
-
-  case VK_RIGHT:
-    virtual_code = LABKEY_RIGHT;
-    break;
-
-  case VK_DOWN:
-    virtual_code = LABKEY_DOWN;
-    break;
-  case VK_PRIOR: // PAGE UP key
-    virtual_code = LABKEY_PAGE_UP;
-    break;
-
-  case VK_NEXT: // PAGE DOWN key
-    virtual_code = LABKEY_PAGE_DOWN;
-    break;
-
-  default:
-    return 0;
-  }
-
-  for (i = 0; i < (mask & lParam); i++)
-    if (!_labInputKeyPush(virtual_code))
-      break;
-  return 0;
-}
-
-
-// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-//   Input system
-// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-int LabInputKey(void)
-{
-  LABASSERT_INIT();
-  // waits until key pressed in another thread and decreases semaphore object
-  WaitForSingleObject(s_globals.ghSemaphore, INFINITE); 
-//  InvalidateRect(s_globals.hwnd, NULL, FALSE);
-  return _labInputKeyPop();
-}
-
-labbool_t LabInputKeyReady(void)
-{
-  LABASSERT_INIT();
-  return (_labInputQueueEmpty() == LAB_FALSE) ? LAB_TRUE : LAB_FALSE;
-}
-
-
-// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-//   Graphics
-// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-void _labInitColors(void)
-{
-  _STATIC_ASSERT(sizeof(s_defaultColors) == sizeof(s_globals.colors));
-  _STATIC_ASSERT(sizeof(s_defaultColors)/sizeof(s_defaultColors[0]) == LABCOLOR_COUNT);
-  memcpy(s_globals.colors, s_defaultColors, sizeof(s_globals.colors));
-}
-
-void LabSetColor(labcolor_t color)
-{
-  LABASSERT_INIT();
-  s_globals.penColor = color;
-  s_globals.penColorRGB = s_globals.colors[color];
-  SelectObject(s_globals.hbmdc, GetStockObject(DC_PEN));
-  SetDCPenColor(s_globals.hbmdc, s_globals.penColorRGB);
-}
-
-void LabSetColorRGB(int r, int g, int b)
-{
-  LABASSERT_INIT();
-  s_globals.penColor = LABCOLOR_NA;
-  s_globals.penColorRGB = RGB(r & 0xFF, g & 0xFF, b & 0xFF);
-  SelectObject(s_globals.hbmdc, GetStockObject(DC_PEN));
-  SetDCPenColor(s_globals.hbmdc, s_globals.penColorRGB);
-}
-
-int LabGetColor(void)
-{
-  LABASSERT_INIT();
-  return s_globals.penColor;
-}
-
-void LabDrawLine(int x1, int y1,  int x2, int y2)
-{
-  RECT r;
-
-  LABASSERT_INIT();
-
-  // define region to redraw
-  r.left   = x1 <= x2 ? x1 : x2 + 1;
-  r.right  = x1 <  x2 ? x2 : x1 + 1;
-  r.top    = y1 <= y2 ? y1 : y2 + 1;
-  r.bottom = y1 <  y2 ? y2 : y1 + 1;
-//  if (TryEnterCriticalSection(&s_globals.cs))
-  EnterCriticalSection(&s_globals.cs);
-  {
-    MoveToEx(s_globals.hbmdc, x1, y1, NULL);
-    LineTo(s_globals.hbmdc, x2, y2);
-    UnionRect(&s_globals.updateRect, &s_globals.updateRect, &r);
-    //InvalidateRect(s_globals.hwnd, NULL, FALSE);
-    LeaveCriticalSection(&s_globals.cs);
-  }
-}
-
-void LabDrawPoint(int x, int y)
-{
-  RECT r;
-
-  LABASSERT_INIT();
-
-  // define region to redraw
-  r.left   = x;
-  r.right  = x + 1;
-  r.top    = y;
-  r.bottom = y + 1;
-//  if (TryEnterCriticalSection(&s_globals.cs))
-  EnterCriticalSection(&s_globals.cs);
-  {
-    SetPixel(s_globals.hbmdc, x, y, s_globals.penColorRGB); // draw point in current color
-    UnionRect(&s_globals.updateRect, &s_globals.updateRect, &r);
-    //InvalidateRect(s_globals.hwnd, NULL, FALSE);
-    LeaveCriticalSection(&s_globals.cs);
-  }
-}
-
-void LabDrawCircle(int x, int y,  int radius)
-{
-  RECT r;
-
-  LABASSERT_INIT();
-
-  // define region to redraw
-  r.left   = x - radius;
-  r.right  = x + radius + 1;
-  r.top    = y - radius;
-  r.bottom = y + radius + 1;
-//  if (TryEnterCriticalSection(&s_globals.cs))
-  EnterCriticalSection(&s_globals.cs);
-  {
-    SelectObject(s_globals.hbmdc, GetStockObject(NULL_BRUSH)); // not filled circle
-    Ellipse(s_globals.hbmdc, x - radius, y - radius, x + radius, y + radius); 
-    UnionRect(&s_globals.updateRect, &s_globals.updateRect, &r);
-    //InvalidateRect(s_globals.hwnd, NULL, FALSE);
-    LeaveCriticalSection(&s_globals.cs);
-  }
-}
-
-void LabDrawEllipse(int x, int y,  int a, int b)
-{
-  RECT r;
-
-  LABASSERT_INIT();
-
-  // define region to redraw
-  r.left   = x - a;
-  r.right  = x + a + 1;
-  r.top    = y - b;
-  r.bottom = y + b + 1;
-//  if (TryEnterCriticalSection(&s_globals.cs))
-  EnterCriticalSection(&s_globals.cs);
-  {
-    SelectObject(s_globals.hbmdc, GetStockObject(NULL_BRUSH)); // not filled ellipse
-    Ellipse(s_globals.hbmdc, x - a, y - b, x + a, y + b); 
-    UnionRect(&s_globals.updateRect, &s_globals.updateRect, &r);
-    //InvalidateRect(s_globals.hwnd, NULL, FALSE); //    NULL,   &r,      .
-    LeaveCriticalSection(&s_globals.cs);
-  }
-}
-
-void LabDrawRectangle(int x1, int y1,  int x2, int y2)
-{
-  RECT r;
-
-  LABASSERT_INIT();
-
-  // define region to redraw
-  r.left   = x1 < x2 ? x1 : x2;
-  r.right  = x1 < x2 ? x2 : x1;
-  r.top    = y1 < y2 ? y1 : y2;
-  r.bottom = y1 < y2 ? y2 : y1;
-//  if (TryEnterCriticalSection(&s_globals.cs))
-  EnterCriticalSection(&s_globals.cs);
-  {
-    SelectObject(s_globals.hbmdc, GetStockObject(NULL_BRUSH)); // not filled rectangle
-    Rectangle(s_globals.hbmdc, r.left, r.top, r.right, r.bottom);
-    UnionRect(&s_globals.updateRect, &s_globals.updateRect, &r);
-    //InvalidateRect(s_globals.hwnd, NULL, FALSE);
-    LeaveCriticalSection(&s_globals.cs);
-  }
-}
-
-void LabDrawFlush(void)
-{
-  LABASSERT_INIT();
-  InvalidateRect(s_globals.hwnd, NULL, FALSE);
-  UpdateWindow(s_globals.hwnd);
-}
-
-// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-//   Window procedure
-// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-static LRESULT CALLBACK _labWindowProc(_In_ HWND hwnd, _In_ UINT uMsg, _In_ WPARAM wParam, _In_ LPARAM lParam)
-{
-  LRESULT ret = 0;
-
-#define HANDLE_MESSAGE(msg, func) \
-  case msg: \
-  ret = func(hwnd, uMsg, wParam, lParam); \
-  break;
-
-  switch (uMsg)
-  {
-    HANDLE_MESSAGE(WM_CLOSE, _onClose);
-    HANDLE_MESSAGE(WM_DESTROY, _onDestroy);
-    HANDLE_MESSAGE(WM_PAINT, _onPaint);
-    HANDLE_MESSAGE(WM_KEYDOWN, _onKeydown);
-    HANDLE_MESSAGE(WM_CHAR, _onChar);
-
-  default:
-    return DefWindowProc(hwnd, uMsg, wParam, lParam);
-  }
-
-#undef HANDLE_MESSAGE
-
-  return 0;
-}
-
-static HWND _labCreateWindow(void)
-{
-  static LPCTSTR MY_CLASS_NAME = TEXT("LabWindowClass");
-  static LPCTSTR MY_WINDOW_NAME = TEXT("Lab Graphics");
-  WNDCLASSEX wcex;
-  HWND hwnd = NULL;
-  RECT rc = {0, 0, _labGetWindowWidth(), _labGetWindowHeight()};
-  DWORD style = (WS_OVERLAPPEDWINDOW  & ~WS_THICKFRAME  & ~WS_MAXIMIZEBOX) | WS_VISIBLE; /*disable maximize and sising button*/
-  HINSTANCE hInstance = GetModuleHandle(0);
-
-  // Register class
-  wcex.cbSize = sizeof(WNDCLASSEX);
-  wcex.style = CS_HREDRAW | CS_VREDRAW | CS_NOCLOSE; /*disable [X]*/
-  wcex.lpfnWndProc = _labWindowProc;
-  wcex.cbClsExtra = 0;
-  wcex.cbWndExtra = 0;
-  wcex.hInstance = hInstance;
-  wcex.hIcon = LoadIcon(hInstance, IDI_APPLICATION);
-  wcex.hCursor = LoadCursor(NULL, IDC_ARROW);
-  wcex.hbrBackground = (HBRUSH)(COLOR_WINDOW + 1);
-  wcex.lpszMenuName = NULL;
-  wcex.lpszClassName = MY_CLASS_NAME;
-  wcex.hIconSm = LoadIcon(wcex.hInstance, IDI_APPLICATION);
-  if (!RegisterClassEx(&wcex))
-  {
-    _labReportError();
-    return NULL;
-  }
-    
-  // create window
-  AdjustWindowRect(&rc, style, FALSE);
-  hwnd = CreateWindow(MY_CLASS_NAME, MY_WINDOW_NAME, style,
-    CW_USEDEFAULT, CW_USEDEFAULT, rc.right - rc.left, rc.bottom - rc.top, NULL, NULL, hInstance, NULL);
-  if (hwnd == NULL)
-    _labReportError();
-  return hwnd;
-}
-
-// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-//   Thread procedure
-// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-static DWORD WINAPI _labThreadProc(_In_ LPVOID lpParameter)
-{
-  HDC hdc;
-  RECT rect = {0, 0, _labGetWindowWidth(), _labGetWindowHeight()};
-
-  // create window
-  s_globals.hwnd = _labCreateWindow();
-  if (s_globals.hwnd == NULL)
-    _labReportError();
-
-  // create semaphore object
-  s_globals.ghSemaphore = CreateSemaphore( 
-        NULL,           // default security attributes
-        0,              // initial count
-        MAX_SEM_COUNT,  // maximum count
-        NULL);          // unnamed semaphore
-
-  if (s_globals.ghSemaphore == NULL)
-    _labReportError();
-
-  // create second frame buffer
-  hdc = GetDC(s_globals.hwnd);
-  s_globals.hbmdc = CreateCompatibleDC(hdc);
-  if (!s_globals.hbmdc)
-  {
-    SetLastError(ERROR_INVALID_HANDLE);
-    _labReportError();
-  }
-  s_globals.hbm = CreateCompatibleBitmap(hdc, s_globals.width, s_globals.height);
-  if (!s_globals.hbm)
-  {
-    SetLastError(ERROR_INVALID_HANDLE);
-    _labReportError();
-  }
-  SelectObject(s_globals.hbmdc, s_globals.hbm);
-  ReleaseDC(s_globals.hwnd, hdc);
-
-  InitializeCriticalSection(&s_globals.cs);
-
-  // initialize pen and background colors
-  SelectObject(s_globals.hbmdc, GetStockObject(WHITE_PEN));
-  SelectObject(s_globals.hbmdc, GetStockObject(BLACK_BRUSH));
-  //FillRect(s_globals.hbmdc, &rect, (HBRUSH) (BLACK_BRUSH));
-
-  // require to update the entire window first
-  GetClientRect(s_globals.hwnd, &s_globals.updateRect);
-  InvalidateRect(s_globals.hwnd, NULL, TRUE);
-
-  // synchronize with the main thread
-  SetEvent(s_globals.syncEvent);
-  if (!s_globals.hwnd)
-  {
-    _labReportError();
-    return 1;
-  }
-
-  // message loop
-  {
-    MSG msg;
-    BOOL ret;
-    while ((ret = GetMessage(&msg, NULL, 0, 0)) != 0)
-    {
-      if (ret > 0)
-      {
-        TranslateMessage(&msg); 
-        DispatchMessage(&msg);
-      }
-      else
-      {
-        _labReportError();
-        break;
-      }
-    }
-  }
-
-  // exit thread
-  return 0;
-}
-
-
-
-// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-//   Initialization and termination routines
-// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-
-static void _labThreadCleanup(void)
-{
-  DWORD res;
-  if (s_globals.thread != NULL)
-  {
-    // destroy the thread
-    res = CloseHandle(s_globals.thread);
-    if (!res)
-      _labReportError();
-    s_globals.thread = NULL;
-    s_globals.threadId = ~0;
-  }
-
-  // destroy the synchronization object
-  if (s_globals.syncEvent)
-  {
-    res = CloseHandle(s_globals.syncEvent);
-    if (!res)
-      _labReportError();
-    s_globals.syncEvent = NULL;
-  }
-}
-
-labbool_t LabInit(void)
-{
-  labparams_t params;
-
-  params.width = 640;
-  params.height = 480;
-  params.scale = 1;
-
-  return LabInitWith(&params);
-}
-
-labbool_t LabInitWith(labparams_t const* params)
-{
-  DWORD res;
-  LPTHREAD_START_ROUTINE lpStartAddress = NULL;
-
-  // do not initialize twice
-  LABASSERT(!s_globals.init);
-  if (s_globals.init)
-    return LAB_FALSE;
-
-  LABASSERT((params->width > 0) && (params->height > 0));
-  LABASSERT(params->scale > 0);
-  s_globals.width = params->width;
-  s_globals.height = params->height;
-  s_globals.scale = params->scale;
-
-  SetRectEmpty(&s_globals.updateRect);
-
-  // initialize colors
-  _labInitColors();
-
-  // create synchronization object
-  s_globals.syncEvent = CreateEvent(NULL, FALSE, FALSE, TEXT("LabSyncEvent"));
-  if (!s_globals.syncEvent)
-    goto on_error;
-
-  // create thread for message processing and run it
-  if (_labThreadProc == NULL)
-  {
-    SetLastError(ERROR_INVALID_HANDLE);
-    goto on_error;
-  }
-  s_globals.thread = CreateThread(NULL, 0, _labThreadProc , NULL, 0, &s_globals.threadId);
-  if (!s_globals.thread)
-    goto on_error;
-
-  // wait until the window is created in another thread
-  res = WaitForSingleObject(s_globals.syncEvent, INFINITE);
-  if ((!s_globals.hwnd) || (res == WAIT_FAILED))
-    goto on_error;
-
-  // successfully initialized
-  s_globals.init = LAB_TRUE;
-
-  // set defaults now
-  LabSetColor(LABCOLOR_WHITE);
-
-  return LAB_TRUE;
-
-on_error:
-  _labThreadCleanup();
-  _labReportError();
-  return LAB_FALSE;
-}
-
-void LabTerm(void)
-{
-  DWORD res;
-
-  if (!s_globals.init)
-    return;
-
-  s_globals.quit = LAB_TRUE;
-
-  // request the thread to terminate by closing the window
-  _ASSERT(s_globals.hwnd != NULL);
-  PostMessage(s_globals.hwnd, WM_CLOSE, 0, 0);
-
-  // wait for the thread to finish
-  _ASSERT(s_globals.thread);
-  res = WaitForSingleObject(s_globals.thread, INFINITE); // todo: get rid of INFINITE [9/30/2013 paul.smirnov]
-  if (res == WAIT_FAILED)
-    _labReportError();
-  // done
-  _labThreadCleanup();
-  s_globals.init = LAB_FALSE;
-}
-
-void LabDelay(int time)
-{
-  LABASSERT_INIT();
-  Sleep(time);
-}
-
-int LabGetWidth(void)
-{
-  LABASSERT_INIT();
-  return s_globals.width;
-}
-
-static __inline int _labGetWindowWidth(void)
-{
-  return s_globals.width * s_globals.scale;
-}
-
-int LabGetHeight(void)
-{
-  LABASSERT_INIT();
-  return s_globals.height;
-}
-
-static __inline int _labGetWindowHeight(void)
-{
-  return s_globals.height * s_globals.scale;
-}
-
-void LabClear()
-{
-  LABASSERT_INIT();
-  LabClearWith(LABCOLOR_BLACK);
-}
-
-void LabClearWith(labcolor_t color)
-{
-  HBRUSH colorBrush = CreateSolidBrush(s_globals.colors[color]); // todo: why not SetDCBrushColor()? [4/3/2015 paul.smirnov]
-  RECT screenRect = {0, 0, _labGetWindowWidth(), _labGetWindowHeight()};
-
-  LABASSERT_INIT();
-
-  EnterCriticalSection(&s_globals.cs);
-  {
-    //UnionRect(&s_globals.updateRect, &s_globals.updateRect, &screenRect);
-    FillRect(s_globals.hbmdc, &screenRect, colorBrush);
-    LeaveCriticalSection(&s_globals.cs);
-  }
-
-  DeleteObject(colorBrush);
-}
-
-
-// End of file
+#include "labengine.h"
+
+#include <winsock2.h> // before windows.h, which would pull in the old winsock.h
+#include <windows.h>
+#include <crtdbg.h>
+#include <intrin.h>
+#if defined(_M_IX86) || defined(_M_X64)
+#include <emmintrin.h>
+#define LAB_SSE2 1 /// SSE2 paths for blending, gradient and triangle rows, and particles, four at a time
+#else
+#define LAB_SSE2 0
+#endif
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <strsafe.h>
+
+#define BUFFER_SIZE 32 /// size of queue for keyboard buffer (31 + 1)
+#define MAX_SEM_COUNT BUFFER_SIZE /// max semaphore object count
+#define CLIP_STACK_SIZE 16 /// max nesting of LabPushClip() calls
+#define FIXED_SHIFT 8      /// number of fraction bits in sub-pixel coordinates (24.8)
+#define FIXED_HALF (1 << (FIXED_SHIFT - 1))
+#define FIXED_LIMIT (1 << 20) /// sub-pixel coordinates are clamped to +-FIXED_LIMIT pixels
+#define FILL_STACK_SIZE 16384 /// number of pending spans kept by LabFloodFill()
+#define SERVER_TILE_SIZE 16   /// side of the square tiles the frame server compares and sends
+#define SERVER_VERSION 1      /// version of the frame server protocol, sent in the greeting
+#define WM_LABKEY (WM_APP + 1) /// key from another thread, pushed into the queue by the window thread
+#define LAYER_TRANSPARENT 0xFF000000 /// pixel of a layer with nothing drawn, never produced by drawing
+#define JOURNAL_BUFFER_SIZE 65536 /// bytes of the journal collected before writing them to the file
+#define JOURNAL_MAGIC "LABJ"  /// first bytes of a journal file
+#define JOURNAL_VERSION 1     /// version of the journal format, written after JOURNAL_MAGIC
+#define PAINT_SHIFT 16        /// the linear gradient parameter is 8.24, its top bits are the 0..256 weight
+#define PAINT_ONE (1 << 24)   /// the linear gradient parameter at the end of the gradient
+#define PAINT_STEP_LIMIT (1 << 28) /// the parameter increment per pixel is clamped to +-PAINT_STEP_LIMIT
+#define PAINT_PARAM_LIMIT 1e15 /// the parameter at the start of a span is clamped to +-PAINT_PARAM_LIMIT
+#define PARTICLE_LIMIT (1 << 26) /// largest capacity of a particle set
+#define PARTICLE_IMMORTAL FLT_MAX /// life of a particle that lives until it leaves the area
+#define TILEMAP_LIMIT (1 << 26) /// largest number of cells of a tile map, and of pixels in all its tiles
+#define SPRITE_BATCH_SIZE 1024  /// room for sprites in the first batch, doubled when it is not enough
+#define TIMER_LIMIT 64        /// largest number of timers running at once
+#define TIMER_WHEEL_SIZE 256  /// slots of the timer wheel, one millisecond each, a power of two
+#define FLATTEN_TOLERANCE 0.25 /// largest distance in pixels between a curve and the polyline it is drawn as
+#define FLATTEN_SEGMENT_LIMIT 65536 /// largest number of segments of a curve
+#define TWO_PI 6.28318530717958647692
+#define HISTORY_DUMP_PREFIX "labhistory" /// file names of the frames saved by F12
+#define LATENCY_PENDING 64   /// keys taken by the program whose frame is not flushed yet, more are not measured
+#define LATENCY_BUCKETS 240  /// buckets of a latency histogram, the last one takes 2^32 microseconds and more
+#define TRIANGLE_BLOCK 8      /// side of the square blocks a triangle is rasterized in
+#define BLEND_CHUNK 256       /// pixels of a translucent fill painted at once before blending them
+
+#define LABASSERT(e)      _ASSERTE(e)
+#define LABASSERT_INIT()  LABASSERT("LabInit() should be called first!" && s_globals.init);
+
+#ifdef _DEBUG 
+#define LAB_ENABLE_REPORT
+#endif
+
+typedef struct labkeyqueue_t
+{
+  int start; // index of first element in queue
+  int end;   // index next to the last element in queue
+  int key[BUFFER_SIZE]; // circular queue
+  LONGLONG time[BUFFER_SIZE]; // performance counter when each key was pushed
+} labkeyqueue_t;
+
+typedef struct lablayer_t
+{
+  HBITMAP hbm;          // bitmap of the layer, NULL until the layer is selected for the first time
+  HDC hbmdc;            // device context of hbm
+  DWORD* bits;          // pixels of hbm, LAYER_TRANSPARENT where nothing is drawn
+  labbool_t visible;    // the layer takes part in the composition
+  int opacity;          // 0 (invisible) to 255 (opaque)
+  RECT dirty;           // area changed since the last composition
+  RECT used;            // area drawn since the layer was cleared
+} lablayer_t;
+
+typedef struct labglobals_t
+{
+  labbool_t init;       // if value is LAB_TRUE, graphics mode has already been initialized
+  unsigned flags;       // combination of labflag_t values the library was initialized with
+
+  DWORD threadId;       // receives the thread identifier when thread creates in <code>CreateThread()</code> function
+  HANDLE thread;        // handle to a new thread - return value of <code>CreateThread()</code> function
+  HANDLE syncEvent;     // event used to synchronize with the main thread
+
+  HWND hwnd;            // handle to a window
+
+  labbool_t quit;       // if value is LAB_TRUE, window will be destroyed and graphics mode will be closed
+
+  LONG width;           // width of window
+  LONG height;          // height of window
+  DWORD scale;          // scale factor for buffer output
+
+  HBITMAP hbm;          // a handle to a bitmap used to draw, the one of the current layer
+  HDC hbmdc;            // a handle to device context of hbm
+  DWORD* bits;          // pixels of hbm (top-down, 0x00RRGGBB, pitch equals width)
+  HRGN hrgn;            // a handle to a region to be updated after drawing
+  
+  CRITICAL_SECTION cs;  // critical section object used to provide sinchronization in graphics
+  HANDLE ghSemaphore;   // semaphore object used to provide sinchronization in input system
+
+  COLORREF colors[LABCOLOR_COUNT];  // array of colors (array of rgb)
+  labcolor_t penColor;  // current pen color
+  COLORREF penColorRGB; // current rgb pen color
+  DWORD penPixel;       // current pen color in the pixel format of bits
+  labbool_t penPending; // penColorRGB is not given to the pen of hbmdc yet
+
+  labblend_t blend;     // how shapes mix with the buffer
+  int alpha;            // opacity of shapes, 0 to 255
+  labbool_t blending;   // shapes are not simply written, see _labPut()
+  DWORD blendPixel;     // the last color blended by _labPut() and its factors
+  DWORD blendAdd, blendMul;
+
+  RECT updateRect;      // area of the current layer changed since the last composition
+  unsigned clearCount;  // number of LabClear() and LabClearWith() calls, tile maps are drawn anew after one
+
+  lablayer_t layers[LAB_LAYER_COUNT]; // layer 0 is the buffer created at the initialization
+  int layer;            // index of the current layer, drawn through hbm, hbmdc and bits
+  HBITMAP frameHbm;     // bitmap the layers are composed into, NULL while there is only layer 0
+  HDC frameDC;          // device context of the frame shown on the screen, hbmdc of layer 0 if there is no frameHbm
+  DWORD* frameBits;     // pixels of the frame
+
+  RECT clipRect;        // current clip rectangle in buffer coordinates
+  RECT clipStack[CLIP_STACK_SIZE]; // clip rectangles saved by LabPushClip()
+  int clipDepth;        // number of saved clip rectangles
+  HRGN clipRgn;         // clip region selected into hbmdc, mirrors clipRect
+  POINT origin;         // viewport origin added to all coordinates
+
+  HANDLE shareMapping;  // file mapping created by LabShareStart()
+  labshareheader_t* share; // view of shareMapping, the header followed by the last flushed frame
+} labglobals_t;
+
+static labglobals_t s_globals = {
+  LAB_FALSE,    // init
+  LABFLAG_NONE, // flags
+  ~0,           // threadId
+  NULL,         // thread
+  NULL,         // syncEvent
+  NULL,         // hwnd
+  LAB_FALSE,    // quit
+};
+
+static labkeyqueue_t s_keyQueue;
+
+typedef struct labserver_t
+{
+  labbool_t running;    // LabServerStart() succeeded and LabServerStop() has not been called yet
+  SOCKET listener;      // socket listening on the loopback address
+  SOCKET client;        // connected viewer, or INVALID_SOCKET
+  HANDLE thread;        // thread encoding and sending frames
+  HANDLE stopEvent;     // asks the thread to finish
+  HANDLE frameEvent;    // a new frame has been posted
+  WSAEVENT netEvent;    // network events of both sockets
+
+  CRITICAL_SECTION cs;  // guards posted, fresh and postedNumber
+  DWORD* posted;        // the latest flushed frame, overwritten by newer flushes
+  labbool_t fresh;      // posted holds a frame the thread has not taken yet
+  unsigned postedNumber; // number of flushes so far
+
+  DWORD* frame;         // the frame being sent, swapped with posted
+  unsigned frameNumber; // number of the frame being sent
+  labbool_t haveFrame;  // frame holds something worth sending to a new viewer
+  labbool_t needFrame;  // the viewer has just connected and waits for the whole frame
+  DWORD* sent;          // what the viewer has on the screen
+  BYTE* packet;         // the message being sent
+  int packetSize;       // size of the message
+  int packetSent;       // number of bytes of the message already sent
+  BYTE input[64];       // bytes received from the viewer but not parsed yet
+  int inputSize;        // number of bytes in input
+} labserver_t;
+
+typedef struct labterminal_t
+{
+  HANDLE output;        // standard output, a console or whatever it is redirected to
+  DWORD outputMode;     // console mode of output to restore
+  UINT outputCP;        // console code page to restore, 0 if output is not a console
+  HANDLE input;         // standard input if it is a console, NULL otherwise
+  DWORD inputMode;      // console mode of input to restore
+  HANDLE thread;        // thread reading keys from input
+  HANDLE stopEvent;     // asks the thread to finish
+
+  int scale;            // side of the square of pixels averaged into one half of a cell
+  int cols;             // number of cells in a row
+  int rows;             // number of rows of cells
+  DWORD* cells;         // colors of the top and bottom halves of the cells on the screen
+  char* text;           // escape sequences and characters of one frame
+} labterminal_t;
+
+static labterminal_t s_terminal;
+
+// records of the journal, the values are stored in the files and should never change
+typedef enum labjournalop_t
+{
+  JOURNAL_CLEAR_WITH = 1,
+  JOURNAL_SET_COLOR,
+  JOURNAL_SET_COLOR_RGB,
+  JOURNAL_DRAW_LINE,
+  JOURNAL_DRAW_POINT,
+  JOURNAL_DRAW_RECTANGLE,
+  JOURNAL_DRAW_CIRCLE,
+  JOURNAL_DRAW_ELLIPSE,
+  JOURNAL_DRAW_POLYLINE,
+  JOURNAL_DRAW_POINTF,
+  JOURNAL_DRAW_LINEF,
+  JOURNAL_DRAW_POLYLINEF,
+  JOURNAL_DRAW_CIRCLEF,
+  JOURNAL_DRAW_TEXT,
+  JOURNAL_PUSH_CLIP,
+  JOURNAL_POP_CLIP,
+  JOURNAL_SET_ORIGIN,
+  JOURNAL_DRAW_FLUSH,
+  JOURNAL_FLOOD_FILL,
+  JOURNAL_WRITE_PIXELS,
+  JOURNAL_INPUT_KEY,
+  JOURNAL_INPUT_KEY_READY,
+  JOURNAL_DELAY,
+  JOURNAL_CLEAR,
+  JOURNAL_SET_LAYER,
+  JOURNAL_SET_LAYER_VISIBLE,
+  JOURNAL_SET_LAYER_OPACITY,
+  JOURNAL_COPY_RECT,
+  JOURNAL_SCROLL,
+  JOURNAL_FILL_RECT,
+  JOURNAL_FILL_CIRCLE,
+  JOURNAL_FILL_POLYGON,
+  JOURNAL_DRAW_POINT_RGB,
+  JOURNAL_DRAW_LINE_RGB,
+  JOURNAL_DRAW_RECTANGLE_RGB,
+  JOURNAL_DRAW_POLYLINE_RGB,
+  JOURNAL_DRAW_BEZIER,
+  JOURNAL_DRAW_ARC,
+  JOURNAL_SET_BLEND,
+  JOURNAL_SET_ALPHA,
+  JOURNAL_FILL_TRIANGLE,
+  JOURNAL_DEPTH_START,
+  JOURNAL_DEPTH_STOP,
+  JOURNAL_DEPTH_CLEAR,
+} labjournalop_t;
+
+typedef struct labjournal_t
+{
+  HANDLE file;          // journal being recorded, NULL if there is none
+  labbool_t failed;     // some bytes could not be written to the file
+  int size;             // number of bytes in buffer
+  BYTE buffer[JOURNAL_BUFFER_SIZE]; // records not written to the file yet
+} labjournal_t;
+
+static labjournal_t s_journal;
+
+typedef struct labsprite_t
+{
+  unsigned __int64 key;    // the order of drawing
+  labimage_t const* image;
+  RECT r;                  // visible part in buffer coordinates
+  int sx, sy;              // position of r in the image
+} labsprite_t;
+
+typedef struct labspritebatch_t
+{
+  labbool_t active;        // between LabSpriteBegin() and LabSpriteEnd()
+  int count;               // number of sprites submitted
+  int capacity;            // room in sprites and temp
+  labsprite_t* sprites;    // sprites to draw
+  labsprite_t* temp;       // the other buffer of the sort
+} labspritebatch_t;
+
+static labspritebatch_t s_sprites;
+
+typedef struct labtimer_t
+{
+  int id;                  // number given by LabTimerStart(), 0 while the timer is free
+  DWORD due;               // GetTickCount() value of the next call
+  int period;              // milliseconds between calls, 0 for a single call
+  int next, prev;          // neighbours in the list of its wheel slot, -1 at the ends
+} labtimer_t;
+
+typedef struct labrun_t
+{
+  labbool_t running;       // inside LabRun()
+  labbool_t stop;          // LabRunStop() was called
+  labbool_t dirty;         // the frame should be drawn
+  int wakeups;             // waits ended since LabRun() was called
+  labtimer_t timers[TIMER_LIMIT];
+  int count;               // number of timers started
+  int lastId;              // the number of the last timer started
+  int wheel[TIMER_WHEEL_SIZE]; // first timer due in each millisecond modulo the wheel size, -1 if none
+  DWORD tick;              // no timers are due before it
+} labrun_t;
+
+static labrun_t s_run;
+
+typedef struct labhistory_t
+{
+  DWORD* last;             // the last flushed frame, NULL while the history is off
+  DWORD* ring;             // records of the frame differences, budget DWORDs
+  DWORD* scratch;          // the record being encoded
+  int budget;              // size of ring in DWORDs
+  int first;               // the oldest record
+  int end;                 // the end of the newest record
+  int wrap;                // the end of the records at the back of ring, while wrapped
+  labbool_t wrapped;       // the newer records start over at the beginning of ring
+  int count;               // number of records
+  int used;                // DWORDs of ring taken by the records
+  int flushes;             // frames recorded since LabHistoryStart()
+  LONGLONG ticks;          // performance counter ticks spent recording
+  LONG volatile dump;      // F12 was pressed, the next LabDrawFlush() saves the frames
+} labhistory_t;
+
+static labhistory_t s_history;
+
+typedef struct lablatency_t
+{
+  LONGLONG frequency;      // performance counter ticks per second
+  LONGLONG taken[LATENCY_PENDING]; // when the keys taken since the last flush were pressed
+  int count;               // number of such keys
+  LONGLONG painted;        // when _onPaint() has last shown the frame, under the lock
+  unsigned histogram[LABLATENCY_STAGE_COUNT][LATENCY_BUCKETS]; // times from a key press to each stage
+} lablatency_t;
+
+static lablatency_t s_latency;
+
+typedef struct labdepth_t
+{
+  void* buffer;            // a depth for every pixel of the buffer, NULL while the depth test is off
+  int bits;                // 16 for unsigned shorts, 32 for floats, 0 while off
+} labdepth_t;
+
+static labdepth_t s_depth;
+
+static labserver_t s_server = {
+  LAB_FALSE,      // running
+  INVALID_SOCKET, // listener
+  INVALID_SOCKET, // client
+};
+
+static COLORREF s_defaultColors[] = {
+  RGB(   0,   0,   0), // LABCOLOR_BLACK,
+  RGB(   0,   0, 128), // LABCOLOR_DARK_BLUE,
+  RGB(   0, 128,   0), // LABCOLOR_DARK_GREEN,
+  RGB(   0, 128, 255), // LABCOLOR_DARK_CYAN,
+  RGB( 128,   0,   0), // LABCOLOR_DARK_RED,
+  RGB( 128,   0, 128), // LABCOLOR_DARK_MAGENTA,
+  RGB( 128,  64,   0), // LABCOLOR_BROWN,
+  RGB( 192, 192, 192), // LABCOLOR_LIGHT_GREY,
+  RGB( 128, 128, 128), // LABCOLOR_DARK_GREY,
+  RGB(   0,   0, 255), // LABCOLOR_BLUE,
+  RGB(   0, 255,   0), // LABCOLOR_GREEN,
+  RGB(   0, 255, 255), // LABCOLOR_CYAN,
+  RGB( 255,   0,   0), // LABCOLOR_RED,
+  RGB( 255,   0, 255), // LABCOLOR_MAGENTA,
+  RGB( 255, 255,   0), // LABCOLOR_YELLOW,
+  RGB( 255, 255, 255), // LABCOLOR_WHITE,
+};
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Forward declarations
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static __inline int _labGetWindowWidth(void);
+static __inline int _labGetWindowHeight(void);
+static void _labServerPost(void);
+static void _labSharePost(void);
+static void _labHistoryPost(void);
+static LONGLONG _labLatencyNow(void);
+static void _labLatencyTaken(LONGLONG pressed);
+static void _labLatencyPresented(LONGLONG flushed);
+static void _labTerminalPresent(void);
+static labbool_t _labTerminalInit(void);
+static void _labTerminalTerm(void);
+static labbool_t _labCreateBitmap(HDC hdc, HBITMAP* hbm, HDC* hbmdc, DWORD** bits);
+static void _labClearTransparent(void);
+static void _labComposeLayers(void);
+static void _labJournalCall(int op, int count, ...);
+static void _labPolyline(labpoint_t const* points, int count, labbool_t closed, DWORD pixel);
+static void _labRectangle(int x1, int y1, int x2, int y2, DWORD pixel);
+static void _labEllipse(int cx, int cy, int a, int b, DWORD pixel);
+static void _labJournalCallF(int op, int count, ...);
+static void _labJournalPoints(labpoint_t const* points, int count);
+static void _labJournalPolylineF(labpointf_t const* points, int count, labbool_t closed);
+static void _labJournalBezier(labpointf_t const* points, int count);
+static void _labJournalTriangle(labvertex_t const* vertices);
+static void _labJournalText(int x, int y, char const* text);
+static void _labJournalPixels(int x1, int y1, int x2, int y2, labrgb_t const* src, int stride);
+static void _labJournalPaint(labpaint_t const* paint);
+static void _labSpriteFree(void);
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Error report
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void _labReportError()
+{
+#ifdef LAB_ENABLE_REPORT
+
+  LPVOID lpMsgBuf;
+  LPVOID lpDisplayBuf;
+  DWORD dw = GetLastError(); 
+
+  FormatMessage(FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
+    NULL, dw, MAKELANGID(LANG_ENGLISH, SUBLANG_DEFAULT), (LPTSTR) &lpMsgBuf, 0, NULL );
+
+  // Display the error message and exit the process
+  if (dw != 0)
+  {
+    lpDisplayBuf = (LPVOID)LocalAlloc(LMEM_ZEROINIT, (lstrlen((LPCTSTR)lpMsgBuf) + 40) * sizeof(TCHAR)); 
+    StringCchPrintf((LPTSTR)lpDisplayBuf, LocalSize(lpDisplayBuf) / sizeof(TCHAR), TEXT("Failed with error %d: %s"), dw, lpMsgBuf); 
+    OutputDebugString((LPTSTR) lpDisplayBuf);
+    // MessageBox(NULL, (LPCTSTR)lpDisplayBuf, TEXT("Error"), MB_OK); 
+    LocalFree(lpDisplayBuf); 
+  }
+  LocalFree(lpMsgBuf);
+
+#endif LAB_ENABLE_REPORT
+}
+
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Queue functionality
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+labbool_t _labInputQueueFull(void)
+{
+  return ((s_keyQueue.start == s_keyQueue.end + 1) || (s_keyQueue.end - s_keyQueue.start == BUFFER_SIZE - 1)) ? LAB_TRUE : LAB_FALSE;
+}
+
+labbool_t _labInputQueueEmpty(void)
+{
+  return (s_keyQueue.start == s_keyQueue.end) ? LAB_TRUE : LAB_FALSE;
+}
+
+labbool_t _labInputKeyPush(int c)
+{
+  if (!_labInputQueueFull())
+  {
+    s_keyQueue.key[s_keyQueue.end] = c;
+    s_keyQueue.time[s_keyQueue.end] = _labLatencyNow();
+    // make it circular
+    if (s_keyQueue.end + 1 == BUFFER_SIZE)
+      s_keyQueue.end = 0;
+    else
+      s_keyQueue.end++;
+  }
+  else
+    MessageBeep(0xFFFFFFFF); // if queue is full, don't add element, just beep
+  if (!ReleaseSemaphore(s_globals.ghSemaphore, 1, NULL)) // increase semaphore oblect value by one
+    _labReportError();
+  return !_labInputQueueFull();
+}
+
+int _labInputKeyPop(void)
+{
+  int key;
+  if (!_labInputQueueEmpty())
+  {
+    key = s_keyQueue.key[s_keyQueue.start];
+    _labLatencyTaken(s_keyQueue.time[s_keyQueue.start]);
+    // pop elemnt
+    s_keyQueue.key[s_keyQueue.start] = 0;
+    // make it circular
+    if (s_keyQueue.start + 1 == BUFFER_SIZE)
+      s_keyQueue.start = 0;
+    else
+      s_keyQueue.start++;
+    return key;
+  }
+  return 0; // if element was not deleted (queue was empty)
+}
+
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Message handlers
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static LRESULT _onClose(_In_ HWND hwnd, _In_ UINT uMsg, _In_ WPARAM wParam, _In_ LPARAM lParam)
+{
+  if (s_globals.quit)
+  {
+    DestroyWindow(hwnd);
+    DeleteObject(s_globals.hbmdc);
+    DeleteCriticalSection(&s_globals.cs);
+  }
+  return 0;
+}
+
+static LRESULT _onDestroy(_In_ HWND hwnd, _In_ UINT uMsg, _In_ WPARAM wParam, _In_ LPARAM lParam)
+{
+  PostQuitMessage(0);
+  return 0;
+}
+
+static LRESULT _onPaint(_In_ HWND hwnd, _In_ UINT uMsg, _In_ WPARAM wParam, _In_ LPARAM lParam)
+{
+  PAINTSTRUCT ps;
+  HDC hdc;
+  DWORD res;
+  RECT srcRect, dstRect;
+
+  EnterCriticalSection(&s_globals.cs);
+  //	if (TryEnterCriticalSection(&s_globals.cs))
+  {
+    hdc = BeginPaint(hwnd, &ps);
+    if (hdc)
+    {
+      //if (IsRectEmpty(&s_globals.updateRect))
+      CopyRect(&dstRect, &ps.rcPaint);
+      if (s_globals.scale == 1)
+      {
+        res = BitBlt(hdc, dstRect.left, dstRect.top, dstRect.right, dstRect.bottom,
+          s_globals.frameDC, dstRect.left, dstRect.top, SRCCOPY);
+      }
+      else
+      {
+        // find source rectangle
+        srcRect.left = dstRect.left / s_globals.scale;
+        srcRect.right = (dstRect.right + s_globals.scale - 1) / s_globals.scale;
+        srcRect.top = dstRect.top / s_globals.scale;
+        srcRect.bottom = (dstRect.bottom + s_globals.scale - 1) / s_globals.scale;
+
+        // corresponding screen rectangle (rounded up)
+        dstRect.left = srcRect.left * s_globals.scale;
+        dstRect.right = srcRect.right * s_globals.scale;
+        dstRect.top = srcRect.top * s_globals.scale;
+        dstRect.bottom = srcRect.bottom * s_globals.scale;
+
+        res = StretchBlt(hdc, dstRect.left, dstRect.top, dstRect.right, dstRect.bottom,
+          s_globals.frameDC, srcRect.left, srcRect.top, srcRect.right, srcRect.bottom, SRCCOPY);
+      }
+      if (!res)
+        _labReportError();
+      s_latency.painted = _labLatencyNow();
+    }
+    LeaveCriticalSection(&s_globals.cs);
+  }
+  EndPaint(hwnd, &ps);
+  return 0;
+}
+
+// button faces and 4 special keys, special codes for the latter
+static int _labKeyFromChar(WPARAM c)
+{
+  switch (c)
+  {
+  case VK_RETURN: // ENTER key
+    return LABKEY_ENTER;
+
+  case VK_ESCAPE:
+    return LABKEY_ESC;
+
+  case VK_BACK:
+    return LABKEY_BACK;
+
+  case VK_TAB:
+    return LABKEY_TAB;
+
+  default:
+    // button faces processing
+    return (int)c;
+  }
+}
+
+// other keys, returns 0 for the keys that come as characters
+static int _labKeyFromVirtual(WPARAM vk)
+{
+  switch (vk)
+  {
+  case VK_LEFT:
+    return LABKEY_LEFT;
+
+  case VK_UP:
+    return LABKEY_UP;
+
+  case VK_RIGHT:
+    return LABKEY_RIGHT;
+
+  case VK_DOWN:
+    return LABKEY_DOWN;
+
+  case VK_PRIOR: // PAGE UP key
+    return LABKEY_PAGE_UP;
+
+  case VK_NEXT: // PAGE DOWN key
+    return LABKEY_PAGE_DOWN;
+
+  default:
+    return 0;
+  }
+}
+
+// button faces and 4 special keys processing
+static LRESULT _onChar(_In_ HWND hwnd, _In_ UINT uMsg, _In_ WPARAM wParam, _In_ LPARAM lParam)
+{
+  int i;
+  int code = _labKeyFromChar(wParam);
+  int mask = 0x0000FFFF; // 00..011..1
+
+  for (i = 0; i < (mask & lParam); i++) // repeat count for the current message
+    if (!_labInputKeyPush(code))
+      break;
+  return 0;
+}
+
+// other keys processing
+static LRESULT _onKeydown(_In_ HWND hwnd, _In_ UINT uMsg, _In_ WPARAM wParam, _In_ LPARAM lParam)
+{
+  int i;
+  int virtual_code = _labKeyFromVirtual(wParam);
+  int mask = 0x0000FFFF; // 00..011..1
+
+  // the history hotkey is for the person debugging, the program does not see it; the files are written
+  // by the drawing thread on its next flush, so the window keeps responding meanwhile
+  if (wParam == VK_F12 && s_history.last)
+  {
+    InterlockedExchange(&s_history.dump, 1);
+    return 0;
+  }
+  if (!virtual_code)
+    return 0;
+  for (i = 0; i < (mask & lParam); i++)
+    if (!_labInputKeyPush(virtual_code))
+      break;
+  return 0;
+}
+
+// keys from other threads (the frame server, the console), already translated
+static LRESULT _onLabKey(_In_ HWND hwnd, _In_ UINT uMsg, _In_ WPARAM wParam, _In_ LPARAM lParam)
+{
+  _labInputKeyPush((int)wParam);
+  return 0;
+}
+
+// push a key from a thread other than the window one
+static void _labInputKeyPost(int key)
+{
+  // the window thread fills the key queue when there is a window, let it do so for others too;
+  // without a window several threads may push keys, so they take turns
+  if (s_globals.flags & LABFLAG_HEADLESS)
+  {
+    EnterCriticalSection(&s_globals.cs);
+    _labInputKeyPush(key);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+  else
+    PostMessage(s_globals.hwnd, WM_LABKEY, (WPARAM)key, 0);
+}
+
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Input system
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int LabInputKey(void)
+{
+  int key;
+
+  LABASSERT_INIT();
+  // waits until key pressed in another thread and decreases semaphore object,
+  // in headless mode nobody is going to press a key unless a viewer is allowed to connect
+  // or keys are read from the console
+  WaitForSingleObject(s_globals.ghSemaphore,
+    ((s_globals.flags & LABFLAG_HEADLESS) && !s_server.running && !s_terminal.thread) ? 0 : INFINITE);
+//  InvalidateRect(s_globals.hwnd, NULL, FALSE);
+  key = _labInputKeyPop();
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_INPUT_KEY, 1, key);
+  return key;
+}
+
+void LabInputKeyPost(labkey_t key)
+{
+  LABASSERT_INIT();
+  _labInputKeyPost(key);
+}
+
+labbool_t LabInputKeyReady(void)
+{
+  labbool_t ready;
+
+  LABASSERT_INIT();
+  ready = (_labInputQueueEmpty() == LAB_FALSE) ? LAB_TRUE : LAB_FALSE;
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_INPUT_KEY_READY, 1, ready);
+  return ready;
+}
+
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Input latency
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Every key gets the performance counter when it enters the queue. Taking it out records the queue stage,
+// and the keys taken since the last flush wait in s_latency.taken until LabDrawFlush(), which records
+// the flush stage when it starts and the present stage when the frame is on the screen. The histograms
+// keep 8 buckets per power of two microseconds, so percentiles are off by less than 1/16.
+
+static LONGLONG _labLatencyNow(void)
+{
+  LARGE_INTEGER now;
+  QueryPerformanceCounter(&now);
+  return now.QuadPart;
+}
+
+static void _labLatencyReset(void)
+{
+  LARGE_INTEGER frequency;
+
+  memset(&s_latency, 0, sizeof(s_latency));
+  QueryPerformanceFrequency(&frequency);
+  s_latency.frequency = frequency.QuadPart > 0 ? frequency.QuadPart : 1;
+}
+
+// the bucket of a time in microseconds, exact below 8
+static int _labLatencyBucket(LONGLONG ticks)
+{
+  unsigned __int64 us = ticks > 0 ? (unsigned __int64)ticks * 1000000 / s_latency.frequency : 0;
+  int octave = 3;
+
+  if (us >= 0xFFFFFFFF)
+    return LATENCY_BUCKETS - 1;
+  if (us < 8)
+    return (int)us;
+  while (us >> (octave + 1))
+    octave++;
+  return (octave - 2) * 8 + (int)((us >> (octave - 3)) & 7);
+}
+
+// the middle of a bucket in microseconds
+static float _labLatencyBucketTime(int bucket)
+{
+  int octave = bucket / 8 + 2;
+
+  if (bucket < 8)
+    return (float)bucket;
+  return (float)(8 + bucket % 8 + 0.5) * (float)(1u << (octave - 3));
+}
+
+static __inline void _labLatencyRecord(int stage, LONGLONG pressed, LONGLONG now)
+{
+  s_latency.histogram[stage][_labLatencyBucket(now - pressed)]++;
+}
+
+// a key pressed at the given time has been taken by the program
+static void _labLatencyTaken(LONGLONG pressed)
+{
+  _labLatencyRecord(LABLATENCY_QUEUE, pressed, _labLatencyNow());
+  if (s_latency.count < LATENCY_PENDING)
+    s_latency.taken[s_latency.count++] = pressed;
+}
+
+// the frame flushed at the given time has been presented, it shows what the taken keys have changed
+static void _labLatencyPresented(LONGLONG flushed)
+{
+  LONGLONG presented = _labLatencyNow(), painted;
+  int i;
+
+  // the window thread notes when it has painted, UpdateWindow() waits for that; the time is read
+  // under the lock it was written with, as 64 bits are not read at once on x86
+  EnterCriticalSection(&s_globals.cs);
+  painted = s_latency.painted;
+  LeaveCriticalSection(&s_globals.cs);
+  if (painted > flushed && painted < presented)
+    presented = painted;
+  for (i = 0; i < s_latency.count; i++)
+  {
+    _labLatencyRecord(LABLATENCY_FLUSH, s_latency.taken[i], flushed);
+    _labLatencyRecord(LABLATENCY_PRESENT, s_latency.taken[i], presented);
+  }
+  s_latency.count = 0;
+}
+
+void LabLatencyReset(void)
+{
+  LABASSERT_INIT();
+  _labLatencyReset();
+}
+
+float LabLatencyPercentile(lablatencystage_t stage, float percent)
+{
+  unsigned const* histogram;
+  unsigned __int64 total = 0, rank, sum = 0;
+  int i;
+
+  LABASSERT_INIT();
+  LABASSERT(stage >= LABLATENCY_QUEUE && stage < LABLATENCY_STAGE_COUNT);
+  if (stage < LABLATENCY_QUEUE || stage >= LABLATENCY_STAGE_COUNT)
+    return 0.0f;
+
+  histogram = s_latency.histogram[stage];
+  for (i = 0; i < LATENCY_BUCKETS; i++)
+    total += histogram[i];
+  if (total == 0)
+    return 0.0f;
+  percent = percent < 0.0f ? 0.0f : percent > 100.0f ? 100.0f : percent;
+  rank = (unsigned __int64)ceil(percent / 100.0 * (double)total);
+  if (rank == 0)
+    rank = 1;
+  for (i = 0; i < LATENCY_BUCKETS - 1; i++)
+  {
+    sum += histogram[i];
+    if (sum >= rank)
+      break;
+  }
+  return _labLatencyBucketTime(i);
+}
+
+void LabLatencyGetInfo(lablatencystage_t stage, lablatencyinfo_t* info)
+{
+  int i;
+
+  LABASSERT_INIT();
+  LABASSERT(stage >= LABLATENCY_QUEUE && stage < LABLATENCY_STAGE_COUNT);
+  LABASSERT(info != NULL);
+  if (!info)
+    return;
+  memset(info, 0, sizeof(*info));
+  if (stage < LABLATENCY_QUEUE || stage >= LABLATENCY_STAGE_COUNT)
+    return;
+
+  for (i = 0; i < LATENCY_BUCKETS; i++)
+    info->count += s_latency.histogram[stage][i];
+  info->p50 = LabLatencyPercentile(stage, 50.0f);
+  info->p99 = LabLatencyPercentile(stage, 99.0f);
+  info->max = LabLatencyPercentile(stage, 100.0f);
+}
+
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Run loop
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// A timer waits in the slot of the wheel given by the low bits of its due time. Firing visits the slots from
+// s_run.tick up to now, so starting, stopping and firing a timer take constant time whatever the number of timers.
+
+static void _labRunReset(void)
+{
+  int i;
+
+  memset(&s_run, 0, sizeof(s_run));
+  for (i = 0; i < TIMER_WHEEL_SIZE; i++)
+    s_run.wheel[i] = -1;
+}
+
+static void _labTimerLink(int i)
+{
+  labtimer_t* t = &s_run.timers[i];
+  int* head = &s_run.wheel[t->due & (TIMER_WHEEL_SIZE - 1)];
+
+  t->prev = -1;
+  t->next = *head;
+  if (*head >= 0)
+    s_run.timers[*head].prev = i;
+  *head = i;
+}
+
+static void _labTimerUnlink(int i)
+{
+  labtimer_t* t = &s_run.timers[i];
+
+  if (t->prev >= 0)
+    s_run.timers[t->prev].next = t->next;
+  else
+    s_run.wheel[t->due & (TIMER_WHEEL_SIZE - 1)] = t->next;
+  if (t->next >= 0)
+    s_run.timers[t->next].prev = t->prev;
+}
+
+// finds a timer due by now, or returns -1 and moves the wheel past now
+static int _labTimerDue(DWORD now)
+{
+  int i;
+
+  if ((int)(now - s_run.tick) >= TIMER_WHEEL_SIZE)
+    s_run.tick = now - TIMER_WHEEL_SIZE + 1; // every slot is visited once
+  for (; (int)(now - s_run.tick) >= 0; s_run.tick++)
+    for (i = s_run.wheel[s_run.tick & (TIMER_WHEEL_SIZE - 1)]; i >= 0; i = s_run.timers[i].next)
+      if ((int)(s_run.timers[i].due - now) <= 0)
+        return i;
+  return -1;
+}
+
+// schedules the next call of a due timer or frees it, returns its number
+static int _labTimerFire(int i, DWORD now)
+{
+  labtimer_t* t = &s_run.timers[i];
+  int id = t->id;
+
+  _labTimerUnlink(i);
+  if (t->period > 0)
+  {
+    // calls missed while the program was busy are dropped
+    t->due += t->period;
+    if ((int)(t->due - now) <= 0)
+      t->due = now + t->period;
+    _labTimerLink(i);
+  }
+  else
+  {
+    t->id = 0;
+    s_run.count--;
+  }
+  return id;
+}
+
+// milliseconds until the first timer is due, INFINITE if there are no timers
+static DWORD _labTimerWait(DWORD now)
+{
+  DWORD tick, wait = INFINITE;
+  int i;
+
+  if (s_run.count == 0)
+    return INFINITE;
+  // a timer due within a turn of the wheel is found in the slot of its time
+  for (tick = s_run.tick; tick != s_run.tick + TIMER_WHEEL_SIZE; tick++)
+    for (i = s_run.wheel[tick & (TIMER_WHEEL_SIZE - 1)]; i >= 0; i = s_run.timers[i].next)
+      if (s_run.timers[i].due == tick)
+        return (int)(tick - now) > 0 ? tick - now : 0;
+  for (i = 0; i < TIMER_LIMIT; i++)
+    if (s_run.timers[i].id)
+    {
+      if ((int)(s_run.timers[i].due - now) <= 0)
+        return 0;
+      if (s_run.timers[i].due - now < wait)
+        wait = s_run.timers[i].due - now;
+    }
+  return wait;
+}
+
+void LabRun(labcallbacks_t const* callbacks)
+{
+  DWORD now, wait, res;
+  int i, key;
+  labbool_t input;
+
+  LABASSERT_INIT();
+  LABASSERT(callbacks && !s_run.running);
+  if (!callbacks || s_run.running)
+    return;
+
+  // the same sources of keys LabInputKey() waits for
+  input = (!(s_globals.flags & LABFLAG_HEADLESS) || s_server.running || s_terminal.thread) ? LAB_TRUE : LAB_FALSE;
+  s_run.running = LAB_TRUE;
+  s_run.stop = LAB_FALSE;
+  s_run.dirty = LAB_TRUE;
+  s_run.wakeups = 0;
+  while (!s_run.stop)
+  {
+    // timers go first, one at a time, since a handler may start and stop timers or ask for a frame
+    now = GetTickCount();
+    i = _labTimerDue(now);
+    if (i >= 0)
+    {
+      i = _labTimerFire(i, now);
+      if (callbacks->onTimer)
+        callbacks->onTimer(i, callbacks->context);
+      continue;
+    }
+
+    if (s_run.dirty)
+    {
+      s_run.dirty = LAB_FALSE;
+      if (callbacks->onFrame)
+        callbacks->onFrame(callbacks->context);
+      LabDrawFlush();
+      if (s_run.stop)
+        break;
+    }
+
+    // sleep until a key or the next timer, only look at the keys if the next frame is asked for already
+    wait = s_run.dirty ? 0 : _labTimerWait(GetTickCount());
+    if (wait == INFINITE && !input)
+      break;
+    res = WaitForSingleObject(s_globals.ghSemaphore, wait);
+    s_run.wakeups++;
+    if (res != WAIT_OBJECT_0)
+      continue;
+    key = _labInputKeyPop();
+    if (s_journal.file)
+      _labJournalCall(JOURNAL_INPUT_KEY, 1, key);
+    if (callbacks->onKey)
+      callbacks->onKey((labkey_t)key, callbacks->context);
+  }
+  s_run.running = LAB_FALSE;
+}
+
+void LabRunStop(void)
+{
+  LABASSERT_INIT();
+  s_run.stop = LAB_TRUE;
+}
+
+void LabRunInvalidate(void)
+{
+  LABASSERT_INIT();
+  s_run.dirty = LAB_TRUE;
+}
+
+int LabRunWakeups(void)
+{
+  LABASSERT_INIT();
+  return s_run.wakeups;
+}
+
+int LabTimerStart(int delay, int period)
+{
+  labtimer_t* t;
+  DWORD now;
+  int i;
+
+  LABASSERT_INIT();
+  LABASSERT(delay >= 0 && period >= 0);
+  if (delay < 0 || period < 0 || s_run.count == TIMER_LIMIT)
+    return 0;
+
+  for (i = 0; s_run.timers[i].id; i++)
+    ;
+  t = &s_run.timers[i];
+  now = GetTickCount();
+  if (s_run.count == 0)
+    s_run.tick = now; // nothing is due before now
+  t->due = now + delay;
+  if ((int)(t->due - s_run.tick) < 0)
+    t->due = s_run.tick; // started by a handler while the wheel is past now
+  t->period = period;
+  if (s_run.lastId == INT_MAX)
+    s_run.lastId = 0;
+  t->id = ++s_run.lastId;
+  s_run.count++;
+  _labTimerLink(i);
+  return t->id;
+}
+
+void LabTimerStop(int timer)
+{
+  int i;
+
+  LABASSERT_INIT();
+  if (timer <= 0)
+    return;
+  for (i = 0; i < TIMER_LIMIT; i++)
+    if (s_run.timers[i].id == timer)
+    {
+      _labTimerUnlink(i);
+      s_run.timers[i].id = 0;
+      s_run.count--;
+      return;
+    }
+}
+
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Blend modes
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Shapes drawn with alpha below 255 or in another mode than LABBLEND_ALPHA mix their color into the buffer.
+// The source color is premultiplied by alpha, and then every mode except XOR is d' = add + d * mul / 255
+// per component, saturated: alpha blending adds the premultiplied color to the background scaled by 1 - a,
+// additive blending keeps the whole background, multiplication scales the background by the premultiplied
+// color plus 1 - a. While nothing is blended (blending is LAB_FALSE) shapes write their pixels as before.
+
+// v / 255 rounded to the nearest integer, exact for products of two bytes
+static __inline unsigned _labDiv255(unsigned v)
+{
+  v += 128;
+  return (v + (v >> 8)) >> 8;
+}
+
+// the factors of the current mode for a source color, the XOR mask goes to add
+static __inline void _labBlendFactors(DWORD pixel, DWORD* add, DWORD* mul)
+{
+  unsigned a = s_globals.alpha, ia = 255 - a, s, i;
+
+  *add = *mul = 0;
+  for (i = 0; i < 24; i += 8)
+  {
+    s = _labDiv255(((pixel >> i) & 0xFF) * a);
+    switch (s_globals.blend)
+    {
+    case LABBLEND_ADD:
+      *add |= s << i;
+      *mul |= 255u << i;
+      break;
+    case LABBLEND_MULTIPLY:
+      *mul |= (s + ia) << i;
+      break;
+    case LABBLEND_XOR:
+      *add |= s << i;
+      break;
+    default:
+      *add |= s << i;
+      *mul |= ia << i;
+      break;
+    }
+  }
+}
+
+// pixels of layers where nothing is drawn count as black, the result is never transparent
+static __inline DWORD _labBlendApply(DWORD d, DWORD add, DWORD mul)
+{
+  DWORD result = 0;
+  unsigned v, i;
+
+  if (s_globals.blend == LABBLEND_XOR)
+    return (d ^ add) & 0x00FFFFFF;
+  for (i = 0; i < 24; i += 8)
+  {
+    v = ((add >> i) & 0xFF) + _labDiv255(((d >> i) & 0xFF) * ((mul >> i) & 0xFF));
+    result |= (v > 255 ? 255 : v) << i;
+  }
+  return result;
+}
+
+// write a pixel of a shape, the caller holds the lock
+static __inline void _labPut(DWORD* p, DWORD pixel)
+{
+  if (!s_globals.blending)
+  {
+    *p = pixel;
+    return;
+  }
+  // shapes have one color, so the factors are kept until another one comes
+  if (pixel != s_globals.blendPixel)
+  {
+    _labBlendFactors(pixel, &s_globals.blendAdd, &s_globals.blendMul);
+    s_globals.blendPixel = pixel;
+  }
+  *p = _labBlendApply(*p, s_globals.blendAdd, s_globals.blendMul);
+}
+
+#if LAB_SSE2
+// v / 255 rounded in every 16-bit lane holding a product of two bytes
+static __inline __m128i _labDiv255x8(__m128i v)
+{
+  v = _mm_add_epi16(v, _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)), 8);
+}
+
+// blend the pixels d with the colors s, both are two pixels unpacked to 16 bits per component
+static __inline __m128i _labBlend2(__m128i d, __m128i s, __m128i alpha, __m128i inverse)
+{
+  s = _labDiv255x8(_mm_mullo_epi16(s, alpha));
+  switch (s_globals.blend)
+  {
+  case LABBLEND_ADD:
+    return _mm_add_epi16(d, s);
+  case LABBLEND_MULTIPLY:
+    return _labDiv255x8(_mm_mullo_epi16(d, _mm_add_epi16(s, inverse)));
+  case LABBLEND_XOR:
+    return _mm_xor_si128(d, s);
+  default:
+    return _mm_add_epi16(s, _labDiv255x8(_mm_mullo_epi16(d, inverse)));
+  }
+}
+#endif
+
+// blend a run of pixels with a run of colors, the caller holds the lock
+static void _labBlendPixels(DWORD* dst, DWORD const* src, int count)
+{
+  DWORD add, mul;
+  int i = 0;
+
+#if LAB_SSE2
+  {
+    __m128i zero = _mm_setzero_si128(), mask = _mm_set1_epi32(0x00FFFFFF);
+    __m128i alpha = _mm_set1_epi16((short)s_globals.alpha), inverse = _mm_set1_epi16((short)(255 - s_globals.alpha));
+    __m128i d, s, lo, hi;
+
+    for (; i + 4 <= count; i += 4)
+    {
+      d = _mm_loadu_si128((__m128i const*)(dst + i));
+      s = _mm_and_si128(_mm_loadu_si128((__m128i const*)(src + i)), mask);
+      lo = _labBlend2(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s, zero), alpha, inverse);
+      hi = _labBlend2(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s, zero), alpha, inverse);
+      _mm_storeu_si128((__m128i*)(dst + i), _mm_and_si128(_mm_packus_epi16(lo, hi), mask));
+    }
+  }
+#endif
+  for (; i < count; i++)
+  {
+    _labBlendFactors(src[i], &add, &mul);
+    dst[i] = _labBlendApply(dst[i], add, mul);
+  }
+}
+
+static void _labUpdateBlending(void)
+{
+  s_globals.blending = (s_globals.blend != LABBLEND_ALPHA || s_globals.alpha != 255) ? LAB_TRUE : LAB_FALSE;
+  s_globals.blendPixel = LAYER_TRANSPARENT; // never a color of a shape, the factors are computed again
+}
+
+void LabSetBlend(labblend_t blend)
+{
+  LABASSERT_INIT();
+  LABASSERT(blend >= LABBLEND_ALPHA && blend <= LABBLEND_XOR);
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_SET_BLEND, 1, blend);
+  if (blend < LABBLEND_ALPHA || blend > LABBLEND_XOR)
+    return;
+  s_globals.blend = blend;
+  _labUpdateBlending();
+}
+
+labblend_t LabGetBlend(void)
+{
+  LABASSERT_INIT();
+  return s_globals.blend;
+}
+
+void LabSetAlpha(int alpha)
+{
+  LABASSERT_INIT();
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_SET_ALPHA, 1, alpha);
+  s_globals.alpha = alpha < 0 ? 0 : alpha > 255 ? 255 : alpha;
+  _labUpdateBlending();
+}
+
+int LabGetAlpha(void)
+{
+  LABASSERT_INIT();
+  return s_globals.alpha;
+}
+
+void LabSetColorRGBA(int r, int g, int b, int a)
+{
+  LabSetColorRGB(r, g, b);
+  LabSetAlpha(a);
+}
+
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Graphics
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void _labInitColors(void)
+{
+  _STATIC_ASSERT(sizeof(s_defaultColors) == sizeof(s_globals.colors));
+  _STATIC_ASSERT(sizeof(s_defaultColors)/sizeof(s_defaultColors[0]) == LABCOLOR_COUNT);
+  memcpy(s_globals.colors, s_defaultColors, sizeof(s_globals.colors));
+}
+
+static __inline DWORD _labPixelFromColor(COLORREF color)
+{
+  return (GetRValue(color) << 16) | (GetGValue(color) << 8) | GetBValue(color);
+}
+
+// clip the rectangle in buffer coordinates, returns LAB_FALSE if nothing is left to draw
+static __inline labbool_t _labClipRect(RECT* r)
+{
+  RECT const* c = &s_globals.clipRect;
+  if (r->left < c->left)
+    r->left = c->left;
+  if (r->right > c->right)
+    r->right = c->right;
+  if (r->top < c->top)
+    r->top = c->top;
+  if (r->bottom > c->bottom)
+    r->bottom = c->bottom;
+  return (r->left < r->right && r->top < r->bottom) ? LAB_TRUE : LAB_FALSE;
+}
+
+// select the current clip rectangle into the buffer DC, so that GDI clips the same way
+static void _labApplyClip(void)
+{
+  EnterCriticalSection(&s_globals.cs);
+  {
+    SetRectRgn(s_globals.clipRgn, s_globals.clipRect.left, s_globals.clipRect.top,
+      s_globals.clipRect.right, s_globals.clipRect.bottom);
+    SelectClipRgn(s_globals.hbmdc, s_globals.clipRgn);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+}
+
+static void _labResetClip(void)
+{
+  SetRect(&s_globals.clipRect, 0, 0, s_globals.width, s_globals.height);
+  s_globals.clipDepth = 0;
+  s_globals.origin.x = 0;
+  s_globals.origin.y = 0;
+}
+
+void LabPushClip(int x1, int y1, int x2, int y2)
+{
+  RECT r;
+
+  LABASSERT_INIT();
+  LABASSERT("Too many nested LabPushClip() calls" && s_globals.clipDepth < CLIP_STACK_SIZE);
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_PUSH_CLIP, 4, x1, y1, x2, y2);
+  if (s_globals.clipDepth >= CLIP_STACK_SIZE)
+    return;
+
+  r.left   = (x1 < x2 ? x1 : x2) + s_globals.origin.x;
+  r.right  = (x1 < x2 ? x2 : x1) + s_globals.origin.x;
+  r.top    = (y1 < y2 ? y1 : y2) + s_globals.origin.y;
+  r.bottom = (y1 < y2 ? y2 : y1) + s_globals.origin.y;
+  s_globals.clipStack[s_globals.clipDepth++] = s_globals.clipRect;
+  if (!_labClipRect(&r))
+    SetRectEmpty(&r);
+  s_globals.clipRect = r;
+  _labApplyClip();
+}
+
+void LabPopClip(void)
+{
+  LABASSERT_INIT();
+  LABASSERT("LabPopClip() without LabPushClip()" && s_globals.clipDepth > 0);
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_POP_CLIP, 0);
+  if (s_globals.clipDepth <= 0)
+    return;
+
+  s_globals.clipRect = s_globals.clipStack[--s_globals.clipDepth];
+  _labApplyClip();
+}
+
+void LabSetOrigin(int x, int y)
+{
+  LABASSERT_INIT();
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_SET_ORIGIN, 2, x, y);
+  s_globals.origin.x = x;
+  s_globals.origin.y = y;
+}
+
+void LabGetOrigin(int* x, int* y)
+{
+  LABASSERT_INIT();
+  if (x)
+    *x = s_globals.origin.x;
+  if (y)
+    *y = s_globals.origin.y;
+}
+
+// Most primitives write penPixel directly, only the GDI ones need the pen of the device context. Setting
+// the color just remembers it, and the pen is updated right before a GDI primitive if the color has changed.
+
+static void _labSetPen(COLORREF color)
+{
+  if (color == s_globals.penColorRGB)
+    return;
+  s_globals.penColorRGB = color;
+  s_globals.penPixel = _labPixelFromColor(color);
+  s_globals.penPending = LAB_TRUE;
+}
+
+// give the current color to the pen of hbmdc, the caller holds the lock
+static __inline void _labApplyPen(void)
+{
+  if (!s_globals.penPending)
+    return;
+  SelectObject(s_globals.hbmdc, GetStockObject(DC_PEN));
+  SetDCPenColor(s_globals.hbmdc, s_globals.penColorRGB);
+  s_globals.penPending = LAB_FALSE;
+}
+
+void LabSetColor(labcolor_t color)
+{
+  LABASSERT_INIT();
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_SET_COLOR, 1, color);
+  s_globals.penColor = color;
+  _labSetPen(s_globals.colors[color]);
+}
+
+void LabSetColorRGB(int r, int g, int b)
+{
+  LABASSERT_INIT();
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_SET_COLOR_RGB, 3, r, g, b);
+  s_globals.penColor = LABCOLOR_NA;
+  _labSetPen(RGB(r & 0xFF, g & 0xFF, b & 0xFF));
+}
+
+int LabGetColor(void)
+{
+  LABASSERT_INIT();
+  return s_globals.penColor;
+}
+
+void LabDrawLine(int x1, int y1,  int x2, int y2)
+{
+  RECT r;
+
+  LABASSERT_INIT();
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_DRAW_LINE, 4, x1, y1, x2, y2);
+  if (s_globals.blending)
+  {
+    labpoint_t points[2];
+    points[0].x = x1;
+    points[0].y = y1;
+    points[1].x = x2;
+    points[1].y = y2;
+    _labPolyline(points, 2, LAB_FALSE, s_globals.penPixel);
+    return;
+  }
+
+  x1 += s_globals.origin.x;
+  y1 += s_globals.origin.y;
+  x2 += s_globals.origin.x;
+  y2 += s_globals.origin.y;
+
+  // define region to redraw
+  r.left   = x1 <= x2 ? x1 : x2 + 1;
+  r.right  = x1 <  x2 ? x2 : x1 + 1;
+  r.top    = y1 <= y2 ? y1 : y2 + 1;
+  r.bottom = y1 <  y2 ? y2 : y1 + 1;
+  if (!_labClipRect(&r))
+    return;
+//  if (TryEnterCriticalSection(&s_globals.cs))
+  EnterCriticalSection(&s_globals.cs);
+  {
+    _labApplyPen();
+    MoveToEx(s_globals.hbmdc, x1, y1, NULL);
+    LineTo(s_globals.hbmdc, x2, y2);
+    UnionRect(&s_globals.updateRect, &s_globals.updateRect, &r);
+    //InvalidateRect(s_globals.hwnd, NULL, FALSE);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+}
+
+void LabDrawPoint(int x, int y)
+{
+  RECT r;
+
+  LABASSERT_INIT();
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_DRAW_POINT, 2, x, y);
+
+  x += s_globals.origin.x;
+  y += s_globals.origin.y;
+
+  // define region to redraw
+  r.left   = x;
+  r.right  = x + 1;
+  r.top    = y;
+  r.bottom = y + 1;
+  if (!_labClipRect(&r))
+    return;
+//  if (TryEnterCriticalSection(&s_globals.cs))
+  EnterCriticalSection(&s_globals.cs);
+  {
+    if (s_globals.blending)
+    {
+      GdiFlush(); // let GDI finish before touching the pixels directly
+      _labPut(s_globals.bits + y * s_globals.width + x, s_globals.penPixel);
+    }
+    else
+      SetPixel(s_globals.hbmdc, x, y, s_globals.penColorRGB); // draw point in current color
+    UnionRect(&s_globals.updateRect, &s_globals.updateRect, &r);
+    //InvalidateRect(s_globals.hwnd, NULL, FALSE);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+}
+
+void LabDrawCircle(int x, int y,  int radius)
+{
+  RECT r;
+
+  LABASSERT_INIT();
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_DRAW_CIRCLE, 3, x, y, radius);
+
+  x += s_globals.origin.x;
+  y += s_globals.origin.y;
+
+  // define region to redraw
+  r.left   = x - radius;
+  r.right  = x + radius + 1;
+  r.top    = y - radius;
+  r.bottom = y + radius + 1;
+  if (!_labClipRect(&r))
+    return;
+//  if (TryEnterCriticalSection(&s_globals.cs))
+  EnterCriticalSection(&s_globals.cs);
+  {
+    if (s_globals.blending)
+    {
+      GdiFlush(); // let GDI finish before touching the pixels directly
+      _labEllipse(x, y, radius, radius, s_globals.penPixel);
+    }
+    else
+    {
+      _labApplyPen();
+      SelectObject(s_globals.hbmdc, GetStockObject(NULL_BRUSH)); // not filled circle
+      Ellipse(s_globals.hbmdc, x - radius, y - radius, x + radius, y + radius); 
+    }
+    UnionRect(&s_globals.updateRect, &s_globals.updateRect, &r);
+    //InvalidateRect(s_globals.hwnd, NULL, FALSE);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+}
+
+void LabDrawEllipse(int x, int y,  int a, int b)
+{
+  RECT r;
+
+  LABASSERT_INIT();
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_DRAW_ELLIPSE, 4, x, y, a, b);
+
+  x += s_globals.origin.x;
+  y += s_globals.origin.y;
+
+  // define region to redraw
+  r.left   = x - a;
+  r.right  = x + a + 1;
+  r.top    = y - b;
+  r.bottom = y + b + 1;
+  if (!_labClipRect(&r))
+    return;
+//  if (TryEnterCriticalSection(&s_globals.cs))
+  EnterCriticalSection(&s_globals.cs);
+  {
+    if (s_globals.blending)
+    {
+      GdiFlush(); // let GDI finish before touching the pixels directly
+      _labEllipse(x, y, a, b, s_globals.penPixel);
+    }
+    else
+    {
+      _labApplyPen();
+      SelectObject(s_globals.hbmdc, GetStockObject(NULL_BRUSH)); // not filled ellipse
+      Ellipse(s_globals.hbmdc, x - a, y - b, x + a, y + b); 
+    }
+    UnionRect(&s_globals.updateRect, &s_globals.updateRect, &r);
+    //InvalidateRect(s_globals.hwnd, NULL, FALSE); // Если тут не NULL, а положенный &r, то обновляется медленно при удерживании клавиши.
+    LeaveCriticalSection(&s_globals.cs);
+  }
+}
+
+void LabDrawRectangle(int x1, int y1,  int x2, int y2)
+{
+  RECT r, shape;
+
+  LABASSERT_INIT();
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_DRAW_RECTANGLE, 4, x1, y1, x2, y2);
+  if (s_globals.blending)
+  {
+    _labRectangle(x1, y1, x2, y2, s_globals.penPixel);
+    return;
+  }
+
+  x1 += s_globals.origin.x;
+  y1 += s_globals.origin.y;
+  x2 += s_globals.origin.x;
+  y2 += s_globals.origin.y;
+
+  // define region to redraw
+  r.left   = x1 < x2 ? x1 : x2;
+  r.right  = x1 < x2 ? x2 : x1;
+  r.top    = y1 < y2 ? y1 : y2;
+  r.bottom = y1 < y2 ? y2 : y1;
+  shape = r;
+  if (!_labClipRect(&r))
+    return;
+//  if (TryEnterCriticalSection(&s_globals.cs))
+  EnterCriticalSection(&s_globals.cs);
+  {
+    _labApplyPen();
+    SelectObject(s_globals.hbmdc, GetStockObject(NULL_BRUSH)); // not filled rectangle
+    Rectangle(s_globals.hbmdc, shape.left, shape.top, shape.right, shape.bottom);
+    UnionRect(&s_globals.updateRect, &s_globals.updateRect, &r);
+    //InvalidateRect(s_globals.hwnd, NULL, FALSE);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+}
+
+// floor((a * b + c) / d) for d > 0 when the result is well within 64 bits while a * b may be not: the estimate
+// in doubles is off by a few units at most, and the remainder that corrects it is exact in wrapping arithmetic
+static __int64 _labMulDiv(__int64 a, __int64 b, __int64 c, __int64 d)
+{
+  __int64 q = (__int64)floor(((double)a * (double)b + (double)c) / (double)d);
+  __int64 r = (__int64)((unsigned __int64)a * (unsigned __int64)b + (unsigned __int64)c - (unsigned __int64)q * (unsigned __int64)d);
+
+  return q + (r >= 0 ? r / d : -((d - 1 - r) / d));
+}
+
+// draw a line segment without its last point, the caller holds the lock; if clip is LAB_FALSE the whole segment
+// should lie inside the clip rectangle, otherwise only the steps inside it are walked
+static void _labLine(__int64 x1, __int64 y1, __int64 x2, __int64 y2, DWORD pixel, labbool_t clip)
+{
+  RECT const* c = &s_globals.clipRect;
+  __int64 dx = x2 > x1 ? x2 - x1 : x1 - x2;
+  __int64 dy = y2 > y1 ? y2 - y1 : y1 - y2;
+  __int64 u1, v1, du, dv, ulo, uhi, vlo, vhi, first, last, klo, khi, k, err;
+  int su, sv, pu, pv;
+  DWORD* p;
+
+  // step along the major axis u and sometimes along the minor one v: at step i the point is (u1 + su * i,
+  // v1 + sv * k(i)), where k(i) = ceil((i * dv - du / 2) / du) is how many times the error has wrapped
+  if (dx >= dy)
+  {
+    u1 = x1, v1 = y1, du = dx, dv = dy;
+    su = x1 < x2 ? 1 : -1;
+    sv = y1 < y2 ? 1 : -1;
+    ulo = c->left, uhi = c->right, vlo = c->top, vhi = c->bottom;
+    pu = su;
+    pv = sv * s_globals.width;
+  }
+  else
+  {
+    u1 = y1, v1 = x1, du = dy, dv = dx;
+    su = y1 < y2 ? 1 : -1;
+    sv = x1 < x2 ? 1 : -1;
+    ulo = c->top, uhi = c->bottom, vlo = c->left, vhi = c->right;
+    pu = su * s_globals.width;
+    pv = sv;
+  }
+  first = 0;
+  last = du - 1;
+  if (clip)
+  {
+    // the steps inside the clip range along u
+    if (su > 0)
+      first = max(first, ulo - u1), last = min(last, uhi - 1 - u1);
+    else
+      first = max(first, u1 - (uhi - 1)), last = min(last, u1 - ulo);
+    // the wraps inside the clip range along v, turned into steps
+    klo = sv > 0 ? vlo - v1 : v1 - (vhi - 1);
+    khi = sv > 0 ? vhi - 1 - v1 : v1 - vlo;
+    if (dv == 0)
+    {
+      if (klo > 0 || khi < 0)
+        return;
+    }
+    else
+    {
+      klo = max(klo, 0);
+      khi = min(khi, dv);
+      if (klo > khi)
+        return;
+      k = _labMulDiv(klo, du, (du >> 1) - du + dv, dv);
+      first = max(first, k);
+      k = _labMulDiv(khi, du, du >> 1, dv);
+      last = min(last, k);
+    }
+    if (first > last)
+      return;
+  }
+
+  // the point and the error at the first step, then the plain walk
+  k = first == 0 ? 0 : _labMulDiv(first, dv, du - 1 - (du >> 1), du);
+  err = (__int64)((unsigned __int64)(du >> 1) - (unsigned __int64)first * dv + (unsigned __int64)k * du); // exact in [0, du)
+  p = s_globals.bits + (ptrdiff_t)(u1 + su * first) * (pu * su) + (ptrdiff_t)(v1 + sv * k) * (pv * sv);
+  for (last -= first - 1; last > 0; last--, p += pu)
+  {
+    _labPut(p, pixel);
+    if ((err -= dv) < 0)
+    {
+      err += du;
+      p += pv;
+    }
+  }
+}
+
+static void _labPolyline(labpoint_t const* points, int count, labbool_t closed, DWORD pixel)
+{
+  RECT r;
+  RECT const* c = &s_globals.clipRect;
+  labpoint_t const* a;
+  labpoint_t const* b;
+  labbool_t clip;
+  __int64 left, top, right, bottom, x1, y1, x2, y2;
+  int i, ox, oy;
+
+  if (count < 2)
+    return;
+
+  // bounding rectangle of the whole strip, in 64 bits as the origin may push the points out of int
+  ox = s_globals.origin.x;
+  oy = s_globals.origin.y;
+  left = right = points[0].x;
+  top = bottom = points[0].y;
+  for (i = 1; i < count; i++)
+  {
+    if (points[i].x < left)
+      left = points[i].x;
+    else if (points[i].x > right)
+      right = points[i].x;
+    if (points[i].y < top)
+      top = points[i].y;
+    else if (points[i].y > bottom)
+      bottom = points[i].y;
+  }
+  left += ox;
+  right += ox + 1;
+  top += oy;
+  bottom += oy + 1;
+  clip = (left < c->left || top < c->top || right > c->right || bottom > c->bottom) ? LAB_TRUE : LAB_FALSE;
+  if (left >= c->right || top >= c->bottom || right <= c->left || bottom <= c->top)
+    return;
+  SetRect(&r, (int)max(left, c->left), (int)max(top, c->top), (int)min(right, c->right), (int)min(bottom, c->bottom));
+
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish before touching the pixels directly
+    for (i = 1; i <= count; i++)
+    {
+      a = &points[i - 1];
+      if (i == count)
+      {
+        if (!closed)
+          break;
+        if (count == 2)
+        {
+          // going back along the same segment would put its pixels twice, only the end is left
+          if ((x1 != x2 || y1 != y2) && x2 >= c->left && x2 < c->right && y2 >= c->top && y2 < c->bottom)
+            _labPut(s_globals.bits + (ptrdiff_t)y2 * s_globals.width + (ptrdiff_t)x2, pixel);
+          break;
+        }
+        b = &points[0];
+      }
+      else
+        b = &points[i];
+
+      // every segment starts where the previous one has stopped short, so joints are drawn once
+      x1 = (__int64)a->x + ox;
+      y1 = (__int64)a->y + oy;
+      x2 = (__int64)b->x + ox;
+      y2 = (__int64)b->y + oy;
+      if (!clip)
+        _labLine(x1, y1, x2, y2, pixel, LAB_FALSE);
+      else if ((x1 >= c->left || x2 >= c->left) && (y1 >= c->top || y2 >= c->top) &&
+        (x1 < c->right || x2 < c->right) && (y1 < c->bottom || y2 < c->bottom))
+      {
+        _labLine(x1, y1, x2, y2, pixel,
+          (x1 < c->left || x2 < c->left || y1 < c->top || y2 < c->top ||
+           x1 >= c->right || x2 >= c->right || y1 >= c->bottom || y2 >= c->bottom) ? LAB_TRUE : LAB_FALSE);
+      }
+    }
+    UnionRect(&s_globals.updateRect, &s_globals.updateRect, &r);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+}
+
+// the outline goes along the pixels inside, the right and bottom sides are one less as in LabDrawRectangle()
+static void _labRectangle(int x1, int y1, int x2, int y2, DWORD pixel)
+{
+  labpoint_t points[4];
+
+  if (x1 == x2 || y1 == y2)
+    return;
+  points[0].x = points[3].x = x1 < x2 ? x1 : x2;
+  points[1].x = points[2].x = (x1 < x2 ? x2 : x1) - 1;
+  points[0].y = points[1].y = y1 < y2 ? y1 : y2;
+  points[2].y = points[3].y = (y1 < y2 ? y2 : y1) - 1;
+  if (points[0].y == points[2].y)
+  {
+    // one pixel tall, the outline would go over the same pixels twice, so a single segment one pixel longer
+    points[1].x++;
+    _labPolyline(points, 2, LAB_FALSE, pixel);
+  }
+  else if (points[0].x == points[1].x)
+  {
+    // one pixel wide, the same down the column
+    points[1].y = points[2].y + 1;
+    _labPolyline(points, 2, LAB_FALSE, pixel);
+  }
+  else
+    _labPolyline(points, 4, LAB_TRUE, pixel);
+}
+
+void LabDrawPolyline(labpoint_t const* points, int count, labbool_t closed)
+{
+  LABASSERT_INIT();
+  LABASSERT(points != NULL || count == 0);
+
+  if (s_journal.file)
+  {
+    _labJournalCall(JOURNAL_DRAW_POLYLINE, 2, count, closed);
+    _labJournalPoints(points, count);
+  }
+  _labPolyline(points, count, closed, s_globals.penPixel);
+}
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Drawing with explicit colors
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// These calls take the color as an argument and leave the current color and the pen alone. They write the
+// pixels directly and give the same result as setting the color and calling the usual functions.
+
+void LabDrawPointRGB(int x, int y, labrgb_t color)
+{
+  RECT r;
+
+  LABASSERT_INIT();
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_DRAW_POINT_RGB, 3, x, y, (int)color);
+
+  x += s_globals.origin.x;
+  y += s_globals.origin.y;
+  SetRect(&r, x, y, x + 1, y + 1);
+  if (!_labClipRect(&r))
+    return;
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish before touching the pixels directly
+    _labPut(s_globals.bits + y * s_globals.width + x, color & 0x00FFFFFF);
+    UnionRect(&s_globals.updateRect, &s_globals.updateRect, &r);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+}
+
+void LabDrawLineRGB(int x1, int y1, int x2, int y2, labrgb_t color)
+{
+  labpoint_t points[2];
+
+  LABASSERT_INIT();
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_DRAW_LINE_RGB, 5, x1, y1, x2, y2, (int)color);
+  points[0].x = x1;
+  points[0].y = y1;
+  points[1].x = x2;
+  points[1].y = y2;
+  _labPolyline(points, 2, LAB_FALSE, color & 0x00FFFFFF);
+}
+
+void LabDrawRectangleRGB(int x1, int y1, int x2, int y2, labrgb_t color)
+{
+  LABASSERT_INIT();
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_DRAW_RECTANGLE_RGB, 5, x1, y1, x2, y2, (int)color);
+  _labRectangle(x1, y1, x2, y2, color & 0x00FFFFFF);
+}
+
+void LabDrawPolylineRGB(labpoint_t const* points, int count, labbool_t closed, labrgb_t color)
+{
+  LABASSERT_INIT();
+  LABASSERT(points != NULL || count == 0);
+
+  if (s_journal.file)
+  {
+    _labJournalCall(JOURNAL_DRAW_POLYLINE_RGB, 3, count, closed, (int)color);
+    _labJournalPoints(points, count);
+  }
+  _labPolyline(points, count, closed, color & 0x00FFFFFF);
+}
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Sub-pixel drawing
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Float coordinates are converted to 24.8 fixed point once per call, everything after that is integer math
+// and gives the same pixels on every machine. Pixel centers have integer coordinates, so whole numbers
+// address the same pixels as in the integer functions.
+
+// the buffer coordinate is clamped before the cast, NaN should be skipped by the caller and gives 0 here
+static __inline int _labToFixed(float v, int origin)
+{
+  double f = (double)v + origin;
+  if (_isnan(f))
+    return 0;
+  if (f > FIXED_LIMIT)
+    f = FIXED_LIMIT;
+  else if (f < -FIXED_LIMIT)
+    f = -FIXED_LIMIT;
+  return (int)floor(f * (1 << FIXED_SHIFT) + 0.5);
+}
+
+// round a fixed point coordinate to the nearest pixel, halves go right and down
+static __inline int _labFixedRound(int v)
+{
+  return (v + FIXED_HALF) >> FIXED_SHIFT;
+}
+
+// plain integer square root, exact on any FPU
+static unsigned _labSqrt(unsigned __int64 v)
+{
+  unsigned __int64 s = (unsigned __int64)sqrt((double)v);
+  while (s * s > v)
+    s--;
+  while ((s + 1) * (s + 1) <= v)
+    s++;
+  return (unsigned)s;
+}
+
+static __inline void _labPlot(int x, int y, DWORD pixel)
+{
+  RECT const* c = &s_globals.clipRect;
+  if (x >= c->left && x < c->right && y >= c->top && y < c->bottom)
+    _labPut(s_globals.bits + y * s_globals.width + x, pixel);
+}
+
+// bounding rectangle of a sub-pixel segment, clipped; returns LAB_FALSE if nothing is visible
+static labbool_t _labLineFixedRect(int x1, int y1, int x2, int y2, RECT* r)
+{
+  r->left   = _labFixedRound(x1 < x2 ? x1 : x2);
+  r->right  = _labFixedRound(x1 < x2 ? x2 : x1) + 1;
+  r->top    = _labFixedRound(y1 < y2 ? y1 : y2);
+  r->bottom = _labFixedRound(y1 < y2 ? y2 : y1) + 1;
+  return _labClipRect(r);
+}
+
+// Digital differential analyzer for 24.8 end points. The major axis is sampled at pixel centers
+// in the half-open range from the first point to the last one, the minor coordinate is kept
+// in 16.16 and rounded to the nearest pixel. The caller holds the lock.
+static void _labLineFixed(int x1, int y1, int x2, int y2, DWORD pixel)
+{
+  RECT const* c = &s_globals.clipRect;
+  int dx = x2 - x1, dy = y2 - y1;
+  int adx = dx < 0 ? -dx : dx, ady = dy < 0 ? -dy : dy;
+  int major1, major2, minor1, dmajor, dminor, first, last, step, lo, hi, i, m;
+  __int64 pos, inc, num;
+  DWORD* p;
+  int pitch;
+
+  if (adx >= ady)
+  {
+    major1 = x1; major2 = x2; minor1 = y1; dmajor = dx; dminor = dy;
+    lo = c->left; hi = c->right;
+  }
+  else
+  {
+    major1 = y1; major2 = y2; minor1 = x1; dmajor = dy; dminor = dx;
+    lo = c->top; hi = c->bottom;
+  }
+  if (dmajor == 0)
+    return;
+
+  // pixel centers i with major1 <= i < major2 (or major2 < i <= major1 going backwards)
+  if (dmajor > 0)
+  {
+    step = 1;
+    first = (major1 + (1 << FIXED_SHIFT) - 1) >> FIXED_SHIFT;
+    last = (major2 + (1 << FIXED_SHIFT) - 1) >> FIXED_SHIFT;
+    if (first < lo)
+      first = lo;
+    if (last > hi)
+      last = hi;
+    if (first >= last)
+      return;
+  }
+  else
+  {
+    step = -1;
+    first = major1 >> FIXED_SHIFT;
+    last = major2 >> FIXED_SHIFT;
+    if (first > hi - 1)
+      first = hi - 1;
+    if (last < lo - 1)
+      last = lo - 1;
+    if (first <= last)
+      return;
+  }
+
+  // minor coordinate at the first sample and its increment per step, both 16.16
+  inc = ((__int64)dminor << 16) / (dmajor < 0 ? -dmajor : dmajor);
+  num = (__int64)(first * (1 << FIXED_SHIFT) - major1) * dminor;
+  pos = (__int64)minor1 * (1 << (16 - FIXED_SHIFT)) + num / dmajor * (1 << (16 - FIXED_SHIFT)) +
+    num % dmajor * (1 << (16 - FIXED_SHIFT)) / dmajor;
+  pos += 1 << 15; // rounding to the nearest pixel
+
+  pitch = s_globals.width;
+  if (adx >= ady)
+  {
+    p = s_globals.bits + first;
+    for (i = first; i != last; i += step, pos += inc)
+    {
+      m = (int)(pos >> 16);
+      if (m >= c->top && m < c->bottom)
+        _labPut(p + m * pitch, pixel);
+      p += step;
+    }
+  }
+  else
+  {
+    p = s_globals.bits + first * pitch;
+    for (i = first; i != last; i += step, pos += inc)
+    {
+      m = (int)(pos >> 16);
+      if (m >= c->left && m < c->right)
+        _labPut(p + m, pixel);
+      p += step * pitch;
+    }
+  }
+}
+
+void LabDrawPointF(float x, float y)
+{
+  RECT r;
+  int px, py;
+
+  LABASSERT_INIT();
+
+  if (s_journal.file)
+    _labJournalCallF(JOURNAL_DRAW_POINTF, 2, x, y);
+  if (_isnan(x) || _isnan(y))
+    return;
+
+  px = _labFixedRound(_labToFixed(x, s_globals.origin.x));
+  py = _labFixedRound(_labToFixed(y, s_globals.origin.y));
+  r.left   = px;
+  r.right  = px + 1;
+  r.top    = py;
+  r.bottom = py + 1;
+  if (!_labClipRect(&r))
+    return;
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish before touching the pixels directly
+    _labPut(s_globals.bits + py * s_globals.width + px, s_globals.penPixel);
+    UnionRect(&s_globals.updateRect, &s_globals.updateRect, &r);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+}
+
+void LabDrawLineF(float x1, float y1, float x2, float y2)
+{
+  RECT r;
+  int fx1, fy1, fx2, fy2;
+
+  LABASSERT_INIT();
+
+  if (s_journal.file)
+    _labJournalCallF(JOURNAL_DRAW_LINEF, 4, x1, y1, x2, y2);
+  if (_isnan(x1) || _isnan(y1) || _isnan(x2) || _isnan(y2))
+    return;
+
+  fx1 = _labToFixed(x1, s_globals.origin.x);
+  fy1 = _labToFixed(y1, s_globals.origin.y);
+  fx2 = _labToFixed(x2, s_globals.origin.x);
+  fy2 = _labToFixed(y2, s_globals.origin.y);
+  if (!_labLineFixedRect(fx1, fy1, fx2, fy2, &r))
+    return;
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish before touching the pixels directly
+    _labLineFixed(fx1, fy1, fx2, fy2, s_globals.penPixel);
+    UnionRect(&s_globals.updateRect, &s_globals.updateRect, &r);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+}
+
+// a polyline drawn vertex by vertex, the caller holds the lock
+typedef struct labstroke_t
+{
+  int x, y;                // last vertex in 24.8 buffer coordinates
+  RECT r;                  // pixels changed so far
+} labstroke_t;
+
+static void _labStrokeStart(labstroke_t* stroke, float x, float y)
+{
+  stroke->x = _labToFixed(x, s_globals.origin.x);
+  stroke->y = _labToFixed(y, s_globals.origin.y);
+  SetRectEmpty(&stroke->r);
+}
+
+static void _labStrokeTo(labstroke_t* stroke, float x, float y)
+{
+  RECT r;
+  int x1 = stroke->x, y1 = stroke->y;
+
+  stroke->x = _labToFixed(x, s_globals.origin.x);
+  stroke->y = _labToFixed(y, s_globals.origin.y);
+  if (_labLineFixedRect(x1, y1, stroke->x, stroke->y, &r))
+  {
+    _labLineFixed(x1, y1, stroke->x, stroke->y, s_globals.penPixel);
+    UnionRect(&stroke->r, &stroke->r, &r);
+  }
+}
+
+static void _labStrokeEnd(labstroke_t const* stroke)
+{
+  if (!IsRectEmpty(&stroke->r))
+    UnionRect(&s_globals.updateRect, &s_globals.updateRect, &stroke->r);
+}
+
+void LabDrawPolylineF(labpointf_t const* points, int count, labbool_t closed)
+{
+  labstroke_t stroke;
+  RECT r;
+  int i, first, x, y, left, top, right, bottom;
+
+  LABASSERT_INIT();
+  LABASSERT(points != NULL || count == 0);
+
+  if (s_journal.file)
+    _labJournalPolylineF(points, count, closed);
+  if (count < 2)
+    return;
+
+  // points with NaN coordinates are left out, the bounding rectangle of the rest is rejected before locking
+  for (first = 0; first < count && (_isnan(points[first].x) || _isnan(points[first].y)); first++)
+    ;
+  if (first == count)
+    return;
+  left = right = _labToFixed(points[first].x, s_globals.origin.x);
+  top = bottom = _labToFixed(points[first].y, s_globals.origin.y);
+  for (i = first + 1; i < count; i++)
+  {
+    if (_isnan(points[i].x) || _isnan(points[i].y))
+      continue;
+    x = _labToFixed(points[i].x, s_globals.origin.x);
+    y = _labToFixed(points[i].y, s_globals.origin.y);
+    left = min(left, x);
+    right = max(right, x);
+    top = min(top, y);
+    bottom = max(bottom, y);
+  }
+  if (!_labLineFixedRect(left, top, right, bottom, &r))
+    return;
+
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish before touching the pixels directly
+    _labStrokeStart(&stroke, points[first].x, points[first].y);
+    for (i = first + 1; i < count; i++)
+      if (!_isnan(points[i].x) && !_isnan(points[i].y))
+        _labStrokeTo(&stroke, points[i].x, points[i].y);
+    if (closed)
+      _labStrokeTo(&stroke, points[first].x, points[first].y);
+    _labStrokeEnd(&stroke);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+}
+
+// Circle outline through the pixels nearest to the exact circle. Columns closer to the center than
+// radius / sqrt(2) get their top and bottom points, the remaining rows get their left and right points,
+// so every pixel is plotted once.
+static void _labCircleFixed(int cx, int cy, int radius, DWORD pixel)
+{
+  RECT const* c = &s_globals.clipRect;
+  __int64 r2 = (__int64)radius * radius;
+  __int64 d2;
+  int i, first, last, d, h, a, b;
+
+  // columns near the vertical axis
+  first = (cx - radius + (1 << FIXED_SHIFT) - 1) >> FIXED_SHIFT;
+  last = (cx + radius) >> FIXED_SHIFT;
+  if (first < c->left)
+    first = c->left;
+  if (last > c->right - 1)
+    last = c->right - 1;
+  for (i = first; i <= last; i++)
+  {
+    d = (i << FIXED_SHIFT) - cx;
+    d2 = (__int64)d * d;
+    if (2 * d2 > r2)
+      continue;
+    h = _labSqrt(r2 - d2);
+    a = _labFixedRound(cy - h);
+    b = _labFixedRound(cy + h);
+    _labPlot(i, a, pixel);
+    if (b != a)
+      _labPlot(i, b, pixel);
+  }
+
+  // rows near the horizontal axis
+  first = (cy - radius + (1 << FIXED_SHIFT) - 1) >> FIXED_SHIFT;
+  last = (cy + radius) >> FIXED_SHIFT;
+  if (first < c->top)
+    first = c->top;
+  if (last > c->bottom - 1)
+    last = c->bottom - 1;
+  for (i = first; i <= last; i++)
+  {
+    d = (i << FIXED_SHIFT) - cy;
+    d2 = (__int64)d * d;
+    if (2 * d2 >= r2)
+      continue;
+    h = _labSqrt(r2 - d2);
+    a = _labFixedRound(cx - h);
+    b = _labFixedRound(cx + h);
+    // skip the columns already done above
+    d = (a << FIXED_SHIFT) - cx;
+    if (2 * (__int64)d * d > r2)
+      _labPlot(a, i, pixel);
+    d = (b << FIXED_SHIFT) - cx;
+    if (b != a && 2 * (__int64)d * d > r2)
+      _labPlot(b, i, pixel);
+  }
+}
+
+// Ellipse outline in buffer coordinates for translucent drawing, where every pixel must be plotted once.
+// It fits the same box as GDI Ellipse(cx - a, cy - b, cx + a, cy + b), which leaves out the right and bottom
+// sides, so the center lies half a pixel up and to the left of (cx, cy) and the rows and columns mirror
+// around it. As in _labCircleFixed(), columns up to the point where the slope is 45 degrees get their top
+// and bottom points, the remaining rows get their left and right points. Only the columns and rows inside
+// the clip rectangle are walked. The caller holds the lock.
+static void _labEllipse(int cx, int cy, int a, int b, DWORD pixel)
+{
+  RECT const* c = &s_globals.clipRect;
+  double ra, rb, a2, b2, xs, ys, u, h;
+  int i, first, last, near;
+
+  a = a < 0 ? -a : a;
+  b = b < 0 ? -b : b;
+  if (a == 0 || b == 0)
+    return;
+  ra = a - 0.5;
+  rb = b - 0.5;
+  a2 = ra * ra;
+  b2 = rb * rb;
+  xs = a2 * a2 / (a2 + b2); // squared distances from the center to the 45 degree points
+  ys = b2 * b2 / (a2 + b2);
+
+  first = max(cx - a, c->left);
+  last = min(cx + a, c->right);
+  for (i = first; i < last; i++)
+  {
+    u = i - cx + 0.5;
+    if (u * u > xs)
+      continue;
+    h = rb * sqrt(max(0.0, 1.0 - u * u / a2));
+    near = min((int)floor(cy - h), cy - 1);
+    _labPlot(i, near, pixel);
+    _labPlot(i, 2 * cy - 1 - near, pixel);
+  }
+  first = max(cy - b, c->top);
+  last = min(cy + b, c->bottom);
+  for (i = first; i < last; i++)
+  {
+    u = i - cy + 0.5;
+    if (u * u >= ys)
+      continue;
+    h = ra * sqrt(max(0.0, 1.0 - u * u / b2));
+    near = min((int)floor(cx - h), cx - 1);
+    // skip the columns already done above
+    u = near - cx + 0.5;
+    if (u * u <= xs)
+      continue;
+    _labPlot(near, i, pixel);
+    _labPlot(2 * cx - 1 - near, i, pixel);
+  }
+}
+
+void LabDrawCircleF(float x, float y, float radius)
+{
+  RECT r;
+  int cx, cy, fr;
+
+  LABASSERT_INIT();
+
+  if (s_journal.file)
+    _labJournalCallF(JOURNAL_DRAW_CIRCLEF, 3, x, y, radius);
+  if (_isnan(x) || _isnan(y) || _isnan(radius))
+    return;
+
+  cx = _labToFixed(x, s_globals.origin.x);
+  cy = _labToFixed(y, s_globals.origin.y);
+  fr = _labToFixed(radius < 0 ? -radius : radius, 0);
+
+  // define region to redraw
+  r.left   = _labFixedRound(cx - fr);
+  r.right  = _labFixedRound(cx + fr) + 1;
+  r.top    = _labFixedRound(cy - fr);
+  r.bottom = _labFixedRound(cy + fr) + 1;
+  if (!_labClipRect(&r))
+    return;
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish before touching the pixels directly
+    _labCircleFixed(cx, cy, fr, s_globals.penPixel);
+    UnionRect(&s_globals.updateRect, &s_globals.updateRect, &r);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+}
+
+// Curves are flattened into the fewest segments of equal parameter step that keep within FLATTEN_TOLERANCE
+// pixels of the exact curve and drawn as one polyline. The vertices of a Bezier curve come from forward
+// differences of its cubic polynomial, those of an arc from rotating the radius by a fixed angle, so no
+// step evaluates the curve anew.
+
+static int _labFlattenCount(double n)
+{
+  if (!(n < FLATTEN_SEGMENT_LIMIT)) // NaN included
+    return FLATTEN_SEGMENT_LIMIT;
+  return n < 1 ? 1 : (int)ceil(n);
+}
+
+// whether anything of a curve within the rectangle can be visible, checked before taking the lock; the extra
+// pixel around it covers the rounding of the vertices stepped on the way
+static labbool_t _labCurveVisible(double left, double top, double right, double bottom)
+{
+  RECT r;
+
+  if (_isnan(left) || _isnan(top) || _isnan(right) || _isnan(bottom))
+    return LAB_FALSE;
+  // far beyond FIXED_LIMIT anyway, but within float
+  left = max(left - 1, -1e30);
+  top = max(top - 1, -1e30);
+  right = min(right + 1, 1e30);
+  bottom = min(bottom + 1, 1e30);
+  return _labLineFixedRect(_labToFixed((float)left, s_globals.origin.x), _labToFixed((float)top, s_globals.origin.y),
+    _labToFixed((float)right, s_globals.origin.x), _labToFixed((float)bottom, s_globals.origin.y), &r);
+}
+
+// x(t) = ax t^3 + bx t^2 + cx t + x0 for t from 0 to 1 in n steps
+static void _labStrokeCubic(labstroke_t* stroke, labpointf_t const* first, labpointf_t const* last,
+  double const* a, double const* b, double const* c, int n)
+{
+  double x, y, dx, dy, ddx, ddy, dddx, dddy, h = 1.0 / n;
+  int i;
+
+  x = first->x;
+  y = first->y;
+  dx = ((a[0] * h + b[0]) * h + c[0]) * h;
+  dy = ((a[1] * h + b[1]) * h + c[1]) * h;
+  dddx = 6 * a[0] * h * h * h;
+  dddy = 6 * a[1] * h * h * h;
+  ddx = dddx + 2 * b[0] * h * h;
+  ddy = dddy + 2 * b[1] * h * h;
+  for (i = 1; i < n; i++)
+  {
+    x += dx;
+    y += dy;
+    dx += ddx;
+    dy += ddy;
+    ddx += dddx;
+    ddy += dddy;
+    _labStrokeTo(stroke, (float)x, (float)y);
+  }
+  _labStrokeTo(stroke, last->x, last->y);
+}
+
+void LabDrawBezier(labpointf_t const* points, int count)
+{
+  labstroke_t stroke;
+  labpointf_t const* p = points;
+  double a[2], b[2], c[2], d1, d2, left, top, right, bottom;
+  int i, n;
+
+  LABASSERT_INIT();
+  LABASSERT(points != NULL && (count == 3 || count == 4));
+  if (!points || (count != 3 && count != 4))
+    return;
+
+  if (s_journal.file)
+    _labJournalBezier(points, count);
+
+  // the curve stays within the control points
+  left = right = p[0].x;
+  top = bottom = p[0].y;
+  for (i = 0; i < count; i++)
+  {
+    if (_isnan(p[i].x) || _isnan(p[i].y))
+      return;
+    left = min(left, p[i].x);
+    right = max(right, p[i].x);
+    top = min(top, p[i].y);
+    bottom = max(bottom, p[i].y);
+  }
+  if (!_labCurveVisible(left, top, right, bottom))
+    return;
+
+  // polynomial coefficients and the number of steps by Wang's formula: the second differences of the
+  // control points bound the distance between the curve and the chords
+  if (count == 3)
+  {
+    a[0] = a[1] = 0;
+    b[0] = (double)p[0].x - 2.0 * p[1].x + p[2].x;
+    b[1] = (double)p[0].y - 2.0 * p[1].y + p[2].y;
+    c[0] = 2.0 * ((double)p[1].x - p[0].x);
+    c[1] = 2.0 * ((double)p[1].y - p[0].y);
+    n = _labFlattenCount(sqrt(sqrt(b[0] * b[0] + b[1] * b[1]) / (4 * FLATTEN_TOLERANCE)));
+  }
+  else
+  {
+    a[0] = (double)p[3].x - 3.0 * p[2].x + 3.0 * p[1].x - p[0].x;
+    a[1] = (double)p[3].y - 3.0 * p[2].y + 3.0 * p[1].y - p[0].y;
+    b[0] = 3.0 * ((double)p[0].x - 2.0 * p[1].x + p[2].x);
+    b[1] = 3.0 * ((double)p[0].y - 2.0 * p[1].y + p[2].y);
+    c[0] = 3.0 * ((double)p[1].x - p[0].x);
+    c[1] = 3.0 * ((double)p[1].y - p[0].y);
+    d1 = (b[0] * b[0] + b[1] * b[1]) / 9;
+    d2 = ((double)p[1].x - 2.0 * p[2].x + p[3].x) * ((double)p[1].x - 2.0 * p[2].x + p[3].x) +
+      ((double)p[1].y - 2.0 * p[2].y + p[3].y) * ((double)p[1].y - 2.0 * p[2].y + p[3].y);
+    n = _labFlattenCount(sqrt(3 * sqrt(d1 > d2 ? d1 : d2) / (4 * FLATTEN_TOLERANCE)));
+  }
+
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish before touching the pixels directly
+    _labStrokeStart(&stroke, p[0].x, p[0].y);
+    _labStrokeCubic(&stroke, &p[0], &p[count - 1], a, b, c, n);
+    _labStrokeEnd(&stroke);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+}
+
+void LabDrawArc(float x, float y, float radius, float start, float sweep)
+{
+  labstroke_t stroke;
+  double r = radius < 0 ? -radius : radius, angle = sweep, step, co, si, u, v, t;
+  int i, n;
+
+  LABASSERT_INIT();
+
+  if (s_journal.file)
+    _labJournalCallF(JOURNAL_DRAW_ARC, 5, x, y, radius, start, sweep);
+  if (_isnan(start) || _isnan(sweep) || !_labCurveVisible(x - r, y - r, x + r, y + r))
+    return;
+
+  if (angle > TWO_PI)
+    angle = TWO_PI;
+  else if (angle < -TWO_PI)
+    angle = -TWO_PI;
+  // a chord of the angle step sags by r (1 - cos(step / 2))
+  step = r > FLATTEN_TOLERANCE ? 2 * acos(1 - FLATTEN_TOLERANCE / r) : TWO_PI / 2;
+  n = _labFlattenCount((angle < 0 ? -angle : angle) / step);
+  co = cos(angle / n);
+  si = sin(angle / n);
+  u = r * cos((double)start);
+  v = r * sin((double)start);
+
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish before touching the pixels directly
+    _labStrokeStart(&stroke, (float)(x + u), (float)(y + v));
+    for (i = 1; i < n; i++)
+    {
+      t = u * co - v * si;
+      v = u * si + v * co;
+      u = t;
+      _labStrokeTo(&stroke, (float)(x + u), (float)(y + v));
+    }
+    _labStrokeTo(&stroke, (float)(x + r * cos((double)start + angle)), (float)(y + r * sin((double)start + angle)));
+    _labStrokeEnd(&stroke);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+}
+
+void LabDrawFlush(void)
+{
+  LONGLONG flushed;
+
+  LABASSERT_INIT();
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_DRAW_FLUSH, 0);
+  flushed = s_latency.count ? _labLatencyNow() : 0;
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish drawing before the layers are blended
+    _labComposeLayers();
+    LeaveCriticalSection(&s_globals.cs);
+  }
+  _labServerPost();
+  _labSharePost();
+  _labHistoryPost();
+  if (s_globals.flags & LABFLAG_HEADLESS)
+  {
+    // nothing to present but the terminal
+    if (s_globals.flags & LABFLAG_TERMINAL)
+    {
+      EnterCriticalSection(&s_globals.cs);
+      {
+        GdiFlush();
+        _labTerminalPresent();
+        LeaveCriticalSection(&s_globals.cs);
+      }
+    }
+    if (flushed)
+      _labLatencyPresented(flushed);
+    return;
+  }
+  InvalidateRect(s_globals.hwnd, NULL, FALSE);
+  UpdateWindow(s_globals.hwnd);
+  if (flushed)
+    _labLatencyPresented(flushed);
+}
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Layers
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Layer 0 is the buffer created at the initialization. Until another layer is selected it is also the frame
+// shown on the screen, and nothing is composed. The first other layer brings a separate frame buffer, and
+// from then on LabDrawFlush() blends the changed parts of the visible layers into it. Each layer keeps the
+// area changed since the last composition (dirty) and the area drawn since it was cleared (used), so that
+// clearing a layer or hiding it touches only what was there.
+
+// blend count pixels of a layer over the frame, transparent ones are skipped;
+// both paths compute (s * a + d * (256 - a)) >> 8 per component and give the same result
+static void _labBlendRow(DWORD* dst, DWORD const* src, int count, int opacity)
+{
+  unsigned a = opacity + (opacity >> 7); // 0..256, so that 255 covers the frame completely
+  unsigned s, d;
+  int i = 0;
+
+#if LAB_SSE2
+  {
+    __m128i transparent = _mm_set1_epi32((int)LAYER_TRANSPARENT);
+    __m128i rgb = _mm_set1_epi32(0x00FFFFFF);
+    __m128i zero = _mm_setzero_si128();
+    __m128i sa = _mm_set1_epi16((short)a);
+    __m128i da = _mm_set1_epi16((short)(256 - a));
+    __m128i sv, dv, keep, lo, hi;
+
+    for (; i + 4 <= count; i += 4)
+    {
+      sv = _mm_loadu_si128((__m128i const*)(src + i));
+      dv = _mm_loadu_si128((__m128i const*)(dst + i));
+      keep = _mm_cmpeq_epi32(sv, transparent);
+      if (a == 256)
+        sv = _mm_and_si128(sv, rgb);
+      else
+      {
+        // 16 bits per component are enough: the products add up to 255 * 256 at most
+        lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(sv, zero), sa),
+          _mm_mullo_epi16(_mm_unpacklo_epi8(dv, zero), da));
+        hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(sv, zero), sa),
+          _mm_mullo_epi16(_mm_unpackhi_epi8(dv, zero), da));
+        sv = _mm_and_si128(_mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)), rgb);
+      }
+      _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_and_si128(keep, dv), _mm_andnot_si128(keep, sv)));
+    }
+  }
+#endif
+
+  for (; i < count; i++)
+  {
+    s = src[i];
+    if (s == LAYER_TRANSPARENT)
+      continue;
+    d = dst[i];
+    dst[i] = ((((s >> 16) & 0xFF) * a + ((d >> 16) & 0xFF) * (256 - a)) >> 8 << 16) |
+      ((((s >> 8) & 0xFF) * a + ((d >> 8) & 0xFF) * (256 - a)) >> 8 << 8) |
+      (((s & 0xFF) * a + (d & 0xFF) * (256 - a)) >> 8);
+  }
+}
+
+// compose one rectangle of the frame from scratch
+static void _labComposeRect(RECT const* area)
+{
+  lablayer_t const* layer = &s_globals.layers[0];
+  DWORD* frame = s_globals.frameBits;
+  RECT part;
+  int i, y, width = s_globals.width, count = area->right - area->left;
+
+  // the bottom layer has no transparent pixels, in the usual case it is simply copied
+  for (y = area->top; y < area->bottom; y++)
+    if (layer->visible && layer->opacity == 255)
+      memcpy(frame + y * width + area->left, layer->bits + y * width + area->left, count * sizeof(DWORD));
+    else
+      memset(frame + y * width + area->left, 0, count * sizeof(DWORD));
+  if (layer->visible && layer->opacity < 255)
+    for (y = area->top; y < area->bottom; y++)
+      _labBlendRow(frame + y * width + area->left, layer->bits + y * width + area->left, count, layer->opacity);
+
+  for (i = 1; i < LAB_LAYER_COUNT; i++)
+  {
+    layer = &s_globals.layers[i];
+    if (!layer->hbm || !layer->visible || layer->opacity == 0 || !IntersectRect(&part, area, &layer->used))
+      continue;
+    for (y = part.top; y < part.bottom; y++)
+      _labBlendRow(frame + y * width + part.left, layer->bits + y * width + part.left, part.right - part.left,
+        layer->opacity);
+  }
+}
+
+// move the changes of the current layer from updateRect to the layer
+static void _labLayerSave(void)
+{
+  lablayer_t* layer = &s_globals.layers[s_globals.layer];
+  UnionRect(&layer->dirty, &layer->dirty, &s_globals.updateRect);
+  UnionRect(&layer->used, &layer->used, &s_globals.updateRect);
+  SetRectEmpty(&s_globals.updateRect);
+}
+
+// called by LabDrawFlush() under the critical section after GdiFlush()
+static void _labComposeLayers(void)
+{
+  RECT areas[LAB_LAYER_COUNT];
+  RECT r, common, all = {0, 0, s_globals.width, s_globals.height};
+  int i, j, count = 0;
+
+  _labLayerSave();
+  if (!s_globals.frameHbm)
+  {
+    // the only layer is the frame itself
+    SetRectEmpty(&s_globals.layers[0].dirty);
+    return;
+  }
+
+  // overlapping changes of different layers are composed together, separate ones apart
+  for (i = 0; i < LAB_LAYER_COUNT; i++)
+  {
+    if (!IntersectRect(&r, &s_globals.layers[i].dirty, &all))
+      continue;
+    SetRectEmpty(&s_globals.layers[i].dirty);
+    for (j = 0; j < count; )
+      if (IntersectRect(&common, &areas[j], &r))
+      {
+        // the union may overlap the areas already passed, start over
+        UnionRect(&r, &r, &areas[j]);
+        areas[j] = areas[--count];
+        j = 0;
+      }
+      else
+        j++;
+    areas[count++] = r;
+  }
+  for (i = 0; i < count; i++)
+    _labComposeRect(&areas[i]);
+}
+
+// the whole drawn area of the layer has to be composed again
+static void _labLayerChanged(int index)
+{
+  lablayer_t* layer = &s_globals.layers[index];
+  if (index == s_globals.layer)
+    _labLayerSave();
+  UnionRect(&layer->dirty, &layer->dirty, &layer->used);
+}
+
+// create the bitmap of a layer above 0, the first such layer also brings the frame
+static labbool_t _labCreateLayer(int index)
+{
+  lablayer_t* layer = &s_globals.layers[index];
+  HBITMAP frameHbm;
+  HDC frameDC;
+  DWORD* frameBits;
+  int i, count = s_globals.width * s_globals.height;
+
+  if (!s_globals.frameHbm)
+  {
+    if (!_labCreateBitmap(NULL, &frameHbm, &frameDC, &frameBits))
+      return LAB_FALSE;
+    // the window may paint at any moment, so the frame is ready before it is shown
+    EnterCriticalSection(&s_globals.cs);
+    {
+      GdiFlush();
+      memcpy(frameBits, s_globals.layers[0].bits, count * sizeof(DWORD));
+      s_globals.frameHbm = frameHbm;
+      s_globals.frameDC = frameDC;
+      s_globals.frameBits = frameBits;
+      LeaveCriticalSection(&s_globals.cs);
+    }
+  }
+
+  if (!_labCreateBitmap(NULL, &layer->hbm, &layer->hbmdc, &layer->bits))
+    return LAB_FALSE;
+  for (i = 0; i < count; i++)
+    layer->bits[i] = LAYER_TRANSPARENT;
+  SetRectEmpty(&layer->dirty);
+  SetRectEmpty(&layer->used);
+  return LAB_TRUE;
+}
+
+// LabClear() on a layer above 0, only the used part of the layer may need clearing
+static void _labClearTransparent(void)
+{
+  lablayer_t* layer = &s_globals.layers[s_globals.layer];
+  DWORD* p;
+  RECT r;
+  int x, y;
+
+  _labLayerSave();
+  if (!IntersectRect(&r, &layer->used, &s_globals.clipRect))
+    return;
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish before touching the pixels directly
+    for (y = r.top; y < r.bottom; y++)
+      for (p = s_globals.bits + y * s_globals.width + r.left, x = r.left; x < r.right; x++)
+        *p++ = LAYER_TRANSPARENT;
+    LeaveCriticalSection(&s_globals.cs);
+  }
+  UnionRect(&layer->dirty, &layer->dirty, &r);
+  if (EqualRect(&r, &layer->used))
+    SetRectEmpty(&layer->used);
+}
+
+void LabSetLayer(int layer)
+{
+  lablayer_t* l;
+
+  LABASSERT_INIT();
+  LABASSERT("Layer number is out of range" && layer >= 0 && layer < LAB_LAYER_COUNT);
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_SET_LAYER, 1, layer);
+  if (layer < 0 || layer >= LAB_LAYER_COUNT || layer == s_globals.layer)
+    return;
+  l = &s_globals.layers[layer];
+  if (!l->hbm && !_labCreateLayer(layer))
+    return;
+
+  _labLayerSave();
+  s_globals.layer = layer;
+  s_globals.hbm = l->hbm;
+  s_globals.hbmdc = l->hbmdc;
+  s_globals.bits = l->bits;
+  // the clip rectangle and the pen belong to the drawing state, not to a layer
+  _labApplyClip();
+  s_globals.penPending = LAB_TRUE;
+}
+
+int LabGetLayer(void)
+{
+  LABASSERT_INIT();
+  return s_globals.layer;
+}
+
+void LabSetLayerVisible(int layer, labbool_t visible)
+{
+  LABASSERT_INIT();
+  LABASSERT("Layer number is out of range" && layer >= 0 && layer < LAB_LAYER_COUNT);
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_SET_LAYER_VISIBLE, 2, layer, visible);
+  if (layer < 0 || layer >= LAB_LAYER_COUNT)
+    return;
+  visible = visible ? LAB_TRUE : LAB_FALSE;
+  if (s_globals.layers[layer].visible == visible)
+    return;
+  s_globals.layers[layer].visible = visible;
+  _labLayerChanged(layer);
+}
+
+void LabSetLayerOpacity(int layer, int opacity)
+{
+  LABASSERT_INIT();
+  LABASSERT("Layer number is out of range" && layer >= 0 && layer < LAB_LAYER_COUNT);
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_SET_LAYER_OPACITY, 2, layer, opacity);
+  if (layer < 0 || layer >= LAB_LAYER_COUNT)
+    return;
+  opacity = opacity < 0 ? 0 : opacity > 255 ? 255 : opacity;
+  if (s_globals.layers[layer].opacity == opacity)
+    return;
+  s_globals.layers[layer].opacity = opacity;
+  _labLayerChanged(layer);
+}
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Flood fill
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Scanline fill with an explicit stack of spans. A span is a range of a row to look at, each matching
+// run found in it is extended left and right, painted, marked as visited and gives spans for the rows
+// above and below. The visited bitmap makes the fill color irrelevant for termination (it may match
+// the target within the tolerance) and lets the stack be fixed-size: spans that do not fit are
+// dropped and recovered later by a rescan of the bitmap, so memory use never exceeds one bit per
+// pixel plus the stack.
+
+typedef struct labfillspan_t
+{
+  int x1;  // first pixel of the range
+  int x2;  // last pixel of the range
+  int y;   // row
+} labfillspan_t;
+
+typedef struct labfill_t
+{
+  RECT area;           // clip rectangle the fill stays within
+  int pitch;           // bytes per row of visited
+  unsigned char* visited; // one bit per pixel of area
+  DWORD target;        // color being replaced
+  int tolerance;       // allowed difference of every component
+  int spread;          // 1 for 8-connectivity (spans grow diagonally), 0 for 4-connectivity
+  labfillspan_t* stack;
+  int depth;           // number of spans in stack
+  labbool_t overflow;  // some spans were dropped
+  RECT bounds;         // filled area
+} labfill_t;
+
+static __inline labbool_t _labFillMatch(labfill_t const* f, int x, int y)
+{
+  DWORD p = s_globals.bits[y * s_globals.width + x] & 0x00FFFFFF;
+  int d;
+
+  if (f->visited[(y - f->area.top) * f->pitch + ((x - f->area.left) >> 3)] & (1 << ((x - f->area.left) & 7)))
+    return LAB_FALSE;
+  if (f->tolerance == 0)
+    return p == f->target ? LAB_TRUE : LAB_FALSE;
+  d = (int)((p >> 16) & 0xFF) - (int)((f->target >> 16) & 0xFF);
+  if (d > f->tolerance || d < -f->tolerance)
+    return LAB_FALSE;
+  d = (int)((p >> 8) & 0xFF) - (int)((f->target >> 8) & 0xFF);
+  if (d > f->tolerance || d < -f->tolerance)
+    return LAB_FALSE;
+  d = (int)(p & 0xFF) - (int)(f->target & 0xFF);
+  return (d <= f->tolerance && d >= -f->tolerance) ? LAB_TRUE : LAB_FALSE;
+}
+
+static __inline void _labFillPush(labfill_t* f, int x1, int x2, int y)
+{
+  if (y < f->area.top || y >= f->area.bottom)
+    return;
+  if (x1 < f->area.left)
+    x1 = f->area.left;
+  if (x2 >= f->area.right)
+    x2 = f->area.right - 1;
+  if (f->depth == FILL_STACK_SIZE)
+  {
+    f->overflow = LAB_TRUE;
+    return;
+  }
+  f->stack[f->depth].x1 = x1;
+  f->stack[f->depth].x2 = x2;
+  f->stack[f->depth].y = y;
+  f->depth++;
+}
+
+static void _labFillRun(labfill_t* f, int x1, int x2, int y, DWORD pixel)
+{
+  DWORD* p = s_globals.bits + y * s_globals.width;
+  unsigned char* v = f->visited + (y - f->area.top) * f->pitch;
+  int x;
+
+  for (x = x1; x <= x2; x++)
+  {
+    _labPut(p + x, pixel);
+    v[(x - f->area.left) >> 3] |= 1 << ((x - f->area.left) & 7);
+  }
+  if (x1 < f->bounds.left)
+    f->bounds.left = x1;
+  if (x2 >= f->bounds.right)
+    f->bounds.right = x2 + 1;
+  if (y < f->bounds.top)
+    f->bounds.top = y;
+  if (y >= f->bounds.bottom)
+    f->bounds.bottom = y + 1;
+  _labFillPush(f, x1 - f->spread, x2 + f->spread, y - 1);
+  _labFillPush(f, x1 - f->spread, x2 + f->spread, y + 1);
+}
+
+static void _labFillScan(labfill_t* f, DWORD pixel)
+{
+  labfillspan_t s;
+  int x, left, right;
+
+  while (f->depth > 0)
+  {
+    s = f->stack[--f->depth];
+    for (x = s.x1; x <= s.x2; x++)
+    {
+      if (!_labFillMatch(f, x, s.y))
+        continue;
+      // extend the run beyond the span in both directions
+      for (left = x; left > f->area.left && _labFillMatch(f, left - 1, s.y); left--)
+        ;
+      for (right = x; right + 1 < f->area.right && _labFillMatch(f, right + 1, s.y); right++)
+        ;
+      _labFillRun(f, left, right, s.y, pixel);
+      x = right + 1;
+    }
+  }
+}
+
+// push the range of the row if there is anything to fill in it
+static void _labFillPushMatching(labfill_t* f, int x1, int x2, int y)
+{
+  int x;
+
+  if (y < f->area.top || y >= f->area.bottom)
+    return;
+  if (x1 < f->area.left)
+    x1 = f->area.left;
+  if (x2 >= f->area.right)
+    x2 = f->area.right - 1;
+  for (x = x1; x <= x2; x++)
+  {
+    if (_labFillMatch(f, x, y))
+    {
+      _labFillPush(f, x1, x2, y);
+      return;
+    }
+  }
+}
+
+// find the neighbours of painted runs that were lost when the stack overflowed,
+// only ranges with something left to fill are pushed, so every rescan makes progress
+static void _labFillRescan(labfill_t* f)
+{
+  int x, y, start;
+  unsigned char const* v;
+
+  f->overflow = LAB_FALSE;
+  for (y = f->bounds.top; y < f->bounds.bottom; y++)
+  {
+    v = f->visited + (y - f->area.top) * f->pitch;
+    for (x = f->bounds.left; x < f->bounds.right; x++)
+    {
+      if (!(v[(x - f->area.left) >> 3] & (1 << ((x - f->area.left) & 7))))
+        continue;
+      for (start = x; x + 1 < f->bounds.right && (v[(x + 1 - f->area.left) >> 3] & (1 << ((x + 1 - f->area.left) & 7))); x++)
+        ;
+      _labFillPushMatching(f, start - f->spread, x + f->spread, y - 1);
+      _labFillPushMatching(f, start - f->spread, x + f->spread, y + 1);
+    }
+  }
+}
+
+void LabFloodFillWith(int x, int y, labrgb_t color, labfillparams_t const* params)
+{
+  labfill_t f;
+  DWORD pixel = color & 0x00FFFFFF;
+
+  LABASSERT_INIT();
+  LABASSERT(params != NULL);
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_FLOOD_FILL, 5, x, y, (int)color, params->tolerance, params->diagonal);
+
+  x += s_globals.origin.x;
+  y += s_globals.origin.y;
+  f.area = s_globals.clipRect;
+  if (x < f.area.left || x >= f.area.right || y < f.area.top || y >= f.area.bottom)
+    return;
+
+  f.pitch = (f.area.right - f.area.left + 7) >> 3;
+  f.visited = (unsigned char*)calloc(f.pitch * (f.area.bottom - f.area.top), 1);
+  f.stack = (labfillspan_t*)malloc(FILL_STACK_SIZE * sizeof(labfillspan_t));
+  if (!f.visited || !f.stack)
+  {
+    free(f.visited);
+    free(f.stack);
+    return;
+  }
+  f.tolerance = params->tolerance;
+  f.spread = params->diagonal ? 1 : 0;
+  f.depth = 0;
+  f.overflow = LAB_FALSE;
+  SetRect(&f.bounds, x, y, x + 1, y + 1);
+
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish before touching the pixels directly
+    f.target = s_globals.bits[y * s_globals.width + x] & 0x00FFFFFF;
+    _labFillPush(&f, x, x, y);
+    do
+    {
+      if (f.overflow)
+        _labFillRescan(&f);
+      _labFillScan(&f, pixel);
+    } while (f.overflow);
+    UnionRect(&s_globals.updateRect, &s_globals.updateRect, &f.bounds);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+
+  free(f.visited);
+  free(f.stack);
+}
+
+void LabFloodFill(int x, int y, labrgb_t color)
+{
+  labfillparams_t params;
+
+  params.tolerance = 0;
+  params.diagonal = LAB_FALSE;
+  LabFloodFillWith(x, y, color, &params);
+}
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Pixel readback
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+labrgb_t LabGetPixel(int x, int y)
+{
+  labrgb_t color = 0;
+
+  LABASSERT_INIT();
+
+  x += s_globals.origin.x;
+  y += s_globals.origin.y;
+  if ((unsigned)x >= (unsigned)s_globals.width || (unsigned)y >= (unsigned)s_globals.height)
+    return 0;
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish drawing before reading
+    color = s_globals.bits[y * s_globals.width + x] & 0x00FFFFFF;
+    LeaveCriticalSection(&s_globals.cs);
+  }
+  return color;
+}
+
+void LabReadPixels(labrect_t const* rect, labrgb_t* dst, int stride)
+{
+  RECT r, src;
+  int y, width;
+  labrgb_t* line;
+  _STATIC_ASSERT(sizeof(labrgb_t) == sizeof(DWORD));
+
+  LABASSERT_INIT();
+  LABASSERT(rect != NULL && dst != NULL);
+  LABASSERT(stride >= rect->right - rect->left);
+
+  r.left   = rect->left + s_globals.origin.x;
+  r.right  = rect->right + s_globals.origin.x;
+  r.top    = rect->top + s_globals.origin.y;
+  r.bottom = rect->bottom + s_globals.origin.y;
+  width = r.right - r.left;
+  if (width <= 0 || r.bottom <= r.top)
+    return;
+
+  // the part of the rectangle that is out of the buffer reads as black
+  SetRect(&src, 0, 0, s_globals.width, s_globals.height);
+  if (!IntersectRect(&src, &src, &r))
+  {
+    for (y = r.top; y < r.bottom; y++, dst += stride)
+      memset(dst, 0, width * sizeof(labrgb_t));
+    return;
+  }
+  for (y = r.top, line = dst; y < src.top; y++, line += stride)
+    memset(line, 0, width * sizeof(labrgb_t));
+  for (y = src.bottom; y < r.bottom; y++)
+    memset(dst + (y - r.top) * stride, 0, width * sizeof(labrgb_t));
+  line = dst + (src.top - r.top) * stride;
+  if (src.left > r.left || src.right < r.right)
+  {
+    for (y = src.top; y < src.bottom; y++, line += stride)
+    {
+      memset(line, 0, (src.left - r.left) * sizeof(labrgb_t));
+      memset(line + (src.right - r.left), 0, (r.right - src.right) * sizeof(labrgb_t));
+    }
+    line = dst + (src.top - r.top) * stride;
+  }
+
+  // the buffer already holds 0x00RRGGBB, so whole rows are copied under a single lock,
+  // which also keeps the window thread from presenting in the middle of the copy
+  line += src.left - r.left;
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish drawing before reading
+    for (y = src.top; y < src.bottom; y++, line += stride)
+      memcpy(line, s_globals.bits + y * s_globals.width + src.left, (src.right - src.left) * sizeof(labrgb_t));
+    LeaveCriticalSection(&s_globals.cs);
+  }
+}
+
+void LabWritePixels(labrect_t const* rect, labrgb_t const* src, int stride)
+{
+  RECT r;
+  int y;
+  LABASSERT_INIT();
+  LABASSERT(rect != NULL && src != NULL);
+  LABASSERT(stride >= rect->right - rect->left);
+
+  if (s_journal.file)
+    _labJournalPixels(rect->left, rect->top, rect->right, rect->bottom, src, stride);
+
+  SetRect(&r, rect->left + s_globals.origin.x, rect->top + s_globals.origin.y,
+    rect->right + s_globals.origin.x, rect->bottom + s_globals.origin.y);
+  if (!_labClipRect(&r))
+    return;
+  src += (r.top - rect->top - s_globals.origin.y) * stride + (r.left - rect->left - s_globals.origin.x);
+
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish drawing before writing
+    for (y = r.top; y < r.bottom; y++, src += stride)
+      memcpy(s_globals.bits + y * s_globals.width + r.left, src, (r.right - r.left) * sizeof(labrgb_t));
+    UnionRect(&s_globals.updateRect, &s_globals.updateRect, &r);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+}
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Scrolling
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// move the pixels of src (buffer coordinates) by (dx, dy), the source is clipped to the buffer and the
+// destination to the clip rectangle; rows go in the order that never overwrites the ones still to be moved
+static void _labMoveRect(RECT const* src, int dx, int dy)
+{
+  RECT s, d, all = {0, 0, s_globals.width, s_globals.height};
+  DWORD* bits = s_globals.bits;
+  int y, width = s_globals.width;
+
+  if (!IntersectRect(&s, src, &all))
+    return;
+  OffsetRect(&s, dx, dy);
+  if (!IntersectRect(&d, &s, &s_globals.clipRect))
+    return;
+
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish before touching the pixels directly
+    if (dy > 0)
+      for (y = d.bottom - 1; y >= d.top; y--)
+        memmove(bits + y * width + d.left, bits + (y - dy) * width + d.left - dx, (d.right - d.left) * sizeof(DWORD));
+    else
+      for (y = d.top; y < d.bottom; y++)
+        memmove(bits + y * width + d.left, bits + (y - dy) * width + d.left - dx, (d.right - d.left) * sizeof(DWORD));
+    UnionRect(&s_globals.updateRect, &s_globals.updateRect, &d);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+}
+
+// fill a rectangle already clipped
+static void _labFillPixels(RECT const* r, DWORD pixel)
+{
+  DWORD* p;
+  int x, y;
+
+  if (IsRectEmpty(r))
+    return;
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish before touching the pixels directly
+    for (y = r->top; y < r->bottom; y++)
+      for (p = s_globals.bits + y * s_globals.width + r->left, x = r->left; x < r->right; x++)
+        *p++ = pixel;
+    UnionRect(&s_globals.updateRect, &s_globals.updateRect, r);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+}
+
+void LabCopyRect(labrect_t const* src, int x, int y)
+{
+  RECT r;
+
+  LABASSERT_INIT();
+  LABASSERT(src != NULL);
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_COPY_RECT, 6, src->left, src->top, src->right, src->bottom, x, y);
+  SetRect(&r, src->left + s_globals.origin.x, src->top + s_globals.origin.y,
+    src->right + s_globals.origin.x, src->bottom + s_globals.origin.y);
+  _labMoveRect(&r, x - src->left, y - src->top);
+}
+
+void LabScroll(int dx, int dy, labrgb_t color)
+{
+  RECT area = s_globals.clipRect, strip;
+  DWORD pixel = color & 0x00FFFFFF;
+
+  LABASSERT_INIT();
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_SCROLL, 3, dx, dy, (int)color);
+  if (IsRectEmpty(&area))
+    return;
+  _labMoveRect(&area, dx, dy);
+
+  // the strips the contents have left, a shift larger than the area leaves all of it
+  strip = area;
+  if (dx > 0 && area.left + dx < area.right)
+    strip.right = area.left + dx;
+  else if (dx < 0 && area.right + dx > area.left)
+    strip.left = area.right + dx;
+  if (dx != 0)
+    _labFillPixels(&strip, pixel);
+  strip = area;
+  if (dy > 0 && area.top + dy < area.bottom)
+    strip.bottom = area.top + dy;
+  else if (dy < 0 && area.bottom + dy > area.top)
+    strip.top = area.bottom + dy;
+  if (dy != 0)
+    _labFillPixels(&strip, pixel);
+}
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Shape fills
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Shapes are cut into horizontal spans, and the paint fills a whole span at once. Gradients give each pixel
+// a weight 0..256 of the second color: a linear gradient steps an 8.24 parameter along the span, a radial
+// one takes the distance to the center. Both paths mix the colors as (c0 * (256 - w) + c1 * w) >> 8.
+
+typedef struct labpainter_t
+{
+  labpaint_t const* paint;
+  double ty, tc;        // linear: the parameter at (x, y) of the buffer is step * x + ty * y + tc
+  int step;             // linear: the parameter increment from one pixel to the next
+  float cx, cy, scale;  // radial: center in buffer coordinates and weight per pixel of distance
+  DWORD pixel0, pixel1; // the colors of the gradient
+} labpainter_t;
+
+static void _labPainterInit(labpainter_t* p, labpaint_t const* paint)
+{
+  double ux, uy, len2, tx = 0.0, step;
+
+  p->paint = paint;
+  p->pixel0 = paint->color0 & 0x00FFFFFF;
+  p->pixel1 = paint->color1 & 0x00FFFFFF;
+  p->ty = p->tc = 0.0;
+  p->step = 0;
+  p->cx = paint->x0 + s_globals.origin.x;
+  p->cy = paint->y0 + s_globals.origin.y;
+  p->scale = paint->radius > 0.0f ? 256.0f / paint->radius : 0.0f;
+  if (paint->type != LABPAINT_LINEAR)
+    return;
+
+  // a degenerate gradient has the first color everywhere
+  ux = (double)paint->x1 - paint->x0;
+  uy = (double)paint->y1 - paint->y0;
+  len2 = ux * ux + uy * uy;
+  if (len2 > 0.0)
+  {
+    tx = ux / len2 * PAINT_ONE;
+    p->ty = uy / len2 * PAINT_ONE;
+  }
+  // the rounded step is used everywhere along the rows, so that shapes painted side by side have no seams
+  step = floor(tx + 0.5);
+  p->step = step > PAINT_STEP_LIMIT ? PAINT_STEP_LIMIT : step < -PAINT_STEP_LIMIT ? -PAINT_STEP_LIMIT : (int)step;
+  p->tc = -((double)p->step * ((double)paint->x0 + s_globals.origin.x) + p->ty * ((double)paint->y0 + s_globals.origin.y));
+}
+
+static __inline DWORD _labMixPixel(DWORD c0, DWORD c1, unsigned w)
+{
+  return (((((c0 >> 16) & 0xFF) * (256 - w) + ((c1 >> 16) & 0xFF) * w) >> 8) << 16) |
+    (((((c0 >> 8) & 0xFF) * (256 - w) + ((c1 >> 8) & 0xFF) * w) >> 8) << 8) |
+    (((c0 & 0xFF) * (256 - w) + (c1 & 0xFF) * w) >> 8);
+}
+
+static __inline void _labFillRow(DWORD* dst, int count, DWORD pixel)
+{
+  while (count-- > 0)
+    *dst++ = pixel;
+}
+
+#if LAB_SSE2
+// mix four pixels with the weights in the 32-bit lanes of w, the colors are unpacked to 16 bits per component
+static __inline __m128i _labMix4(__m128i w, __m128i c0, __m128i c1)
+{
+  __m128i full = _mm_set1_epi16(256);
+  __m128i w01, w23, lo, hi;
+
+  w = _mm_packs_epi32(w, w);
+  w = _mm_min_epi16(_mm_max_epi16(w, _mm_setzero_si128()), full);
+  w = _mm_unpacklo_epi16(w, w);
+  w01 = _mm_unpacklo_epi32(w, w);
+  w23 = _mm_unpackhi_epi32(w, w);
+  // the sum is 255 * 256 at most and fits 16 bits
+  lo = _mm_add_epi16(_mm_mullo_epi16(c0, _mm_sub_epi16(full, w01)), _mm_mullo_epi16(c1, w01));
+  hi = _mm_add_epi16(_mm_mullo_epi16(c0, _mm_sub_epi16(full, w23)), _mm_mullo_epi16(c1, w23));
+  return _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+}
+#endif
+
+// the part of a linear gradient span where the parameter t stays within 0..PAINT_ONE
+static void _labLinearRow(DWORD* dst, int count, int t, int step, DWORD c0, DWORD c1)
+{
+  int i = 0, w;
+
+#if LAB_SSE2
+  {
+    __m128i v0 = _mm_unpacklo_epi8(_mm_set1_epi32((int)c0), _mm_setzero_si128());
+    __m128i v1 = _mm_unpacklo_epi8(_mm_set1_epi32((int)c1), _mm_setzero_si128());
+    __m128i tv = _mm_setr_epi32(t, t + step, t + 2 * step, t + 3 * step);
+    __m128i dt = _mm_set1_epi32(4 * step);
+
+    for (; i + 4 <= count; i += 4, t += 4 * step)
+    {
+      _mm_storeu_si128((__m128i*)(dst + i), _labMix4(_mm_srai_epi32(tv, PAINT_SHIFT), v0, v1));
+      tv = _mm_add_epi32(tv, dt);
+    }
+  }
+#endif
+
+  for (; i < count; i++, t += step)
+  {
+    w = t >> PAINT_SHIFT;
+    dst[i] = _labMixPixel(c0, c1, w < 0 ? 0 : w > 256 ? 256 : w);
+  }
+}
+
+// a linear gradient span starting with the parameter t; the pixels before the gradient and after it are
+// plain runs, so only the part in between needs mixing and fits 32-bit arithmetic however long the span is
+static void _labLinearSpan(DWORD* dst, int count, __int64 t, int step, DWORD c0, DWORD c1)
+{
+  __int64 n;
+  int head = 0, mid;
+
+  if (step > 0)
+  {
+    n = t < 0 ? (-t + step - 1) / step : 0;
+    head = n < count ? (int)n : count;
+    _labFillRow(dst, head, c0);
+    t += (__int64)head * step;
+    n = t <= PAINT_ONE ? (PAINT_ONE - t) / step + 1 : 0;
+  }
+  else if (step < 0)
+  {
+    n = t > PAINT_ONE ? (t - PAINT_ONE - step - 1) / -step : 0;
+    head = n < count ? (int)n : count;
+    _labFillRow(dst, head, c1);
+    t += (__int64)head * step;
+    n = t >= 0 ? t / -step + 1 : 0;
+  }
+  else
+  {
+    t = t < 0 ? 0 : t > PAINT_ONE ? PAINT_ONE : t;
+    n = count;
+  }
+  mid = n < count - head ? (int)n : count - head;
+  _labLinearRow(dst + head, mid, (int)t, step, c0, c1);
+  _labFillRow(dst + head + mid, count - head - mid, step > 0 ? c1 : c0);
+}
+
+// a radial gradient span, dx is the horizontal distance from the center to the first pixel
+static void _labRadialRow(DWORD* dst, int count, float dx, float dy2, float scale, DWORD c0, DWORD c1)
+{
+  float f;
+  int i = 0;
+
+#if LAB_SSE2
+  {
+    __m128i v0 = _mm_unpacklo_epi8(_mm_set1_epi32((int)c0), _mm_setzero_si128());
+    __m128i v1 = _mm_unpacklo_epi8(_mm_set1_epi32((int)c1), _mm_setzero_si128());
+    __m128i iv = _mm_setr_epi32(0, 1, 2, 3);
+    __m128i di = _mm_set1_epi32(4);
+    __m128 x, limit = _mm_set1_ps(512.0f);
+
+    for (; i + 4 <= count; i += 4)
+    {
+      x = _mm_add_ps(_mm_set1_ps(dx), _mm_cvtepi32_ps(iv));
+      x = _mm_mul_ps(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_set1_ps(dy2))), _mm_set1_ps(scale));
+      _mm_storeu_si128((__m128i*)(dst + i), _labMix4(_mm_cvttps_epi32(_mm_min_ps(x, limit)), v0, v1));
+      iv = _mm_add_epi32(iv, di);
+    }
+  }
+#endif
+
+  for (; i < count; i++)
+  {
+    f = dx + (float)i;
+    f = (float)sqrt(f * f + dy2) * scale;
+    dst[i] = _labMixPixel(c0, c1, f < 256.0f ? (int)f : 256);
+  }
+}
+
+// write the colors of count pixels starting at (x1, y) to dst, coordinates are in the buffer
+static void _labPaintRow(labpainter_t const* p, DWORD* dst, int x1, int count, int y)
+{
+  double t;
+  float dy;
+
+  switch (p->paint->type)
+  {
+  case LABPAINT_LINEAR:
+    t = floor(p->ty * y + p->tc + 0.5);
+    t = t > PAINT_PARAM_LIMIT ? PAINT_PARAM_LIMIT : t < -PAINT_PARAM_LIMIT ? -PAINT_PARAM_LIMIT : t;
+    _labLinearSpan(dst, count, (__int64)t + (__int64)p->step * x1, p->step, p->pixel0, p->pixel1);
+    break;
+  case LABPAINT_RADIAL:
+    dy = (float)y - p->cy;
+    _labRadialRow(dst, count, (float)x1 - p->cx, dy * dy, p->scale, p->pixel0, p->pixel1);
+    break;
+  case LABPAINT_SPAN:
+    p->paint->span(x1 - s_globals.origin.x, y - s_globals.origin.y, count, (labrgb_t*)dst, p->paint->context);
+    // the callback cannot make pixels of a layer transparent
+    for (; count > 0; count--, dst++)
+      *dst &= 0x00FFFFFF;
+    break;
+  }
+}
+
+// paint the pixels x1..x2-1 of the row y, all in buffer coordinates
+static void _labPaintSpan(labpainter_t const* p, int x1, int x2, int y)
+{
+  RECT const* c = &s_globals.clipRect;
+  DWORD row[BLEND_CHUNK];
+  DWORD* dst;
+  int count;
+
+  if (y < c->top || y >= c->bottom)
+    return;
+  if (x1 < c->left)
+    x1 = c->left;
+  if (x2 > c->right)
+    x2 = c->right;
+  if (x1 >= x2)
+    return;
+  dst = s_globals.bits + y * s_globals.width + x1;
+  if (!s_globals.blending)
+  {
+    _labPaintRow(p, dst, x1, x2 - x1, y);
+    return;
+  }
+
+  // translucent paint goes through a small buffer, a callback still sees the pixels under it
+  for (; x1 < x2; x1 += count, dst += count)
+  {
+    count = x2 - x1 < BLEND_CHUNK ? x2 - x1 : BLEND_CHUNK;
+    memcpy(row, dst, count * sizeof(DWORD));
+    _labPaintRow(p, row, x1, count, y);
+    _labBlendPixels(dst, row, count);
+  }
+}
+
+// the result of a callback cannot be replayed from the call, the painted pixels are recorded instead
+static void _labJournalFilled(RECT const* r)
+{
+  int ox = s_globals.origin.x, oy = s_globals.origin.y;
+  _labJournalPixels(r->left - ox, r->top - oy, r->right - ox, r->bottom - oy,
+    (labrgb_t const*)s_globals.bits + r->top * s_globals.width + r->left, s_globals.width);
+}
+
+void LabFillRect(int x1, int y1, int x2, int y2, labpaint_t const* paint)
+{
+  labpainter_t p;
+  RECT r;
+  int y;
+
+  LABASSERT_INIT();
+  LABASSERT(paint != NULL);
+  LABASSERT(paint->type != LABPAINT_SPAN || paint->span != NULL);
+
+  if (s_journal.file && paint->type != LABPAINT_SPAN)
+  {
+    _labJournalCall(JOURNAL_FILL_RECT, 4, x1, y1, x2, y2);
+    _labJournalPaint(paint);
+  }
+
+  SetRect(&r, (x1 < x2 ? x1 : x2) + s_globals.origin.x, (y1 < y2 ? y1 : y2) + s_globals.origin.y,
+    (x1 < x2 ? x2 : x1) + s_globals.origin.x, (y1 < y2 ? y2 : y1) + s_globals.origin.y);
+  if (!_labClipRect(&r))
+    return;
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish before touching the pixels directly
+    _labPainterInit(&p, paint);
+    for (y = r.top; y < r.bottom; y++)
+      _labPaintSpan(&p, r.left, r.right, y);
+    UnionRect(&s_globals.updateRect, &s_globals.updateRect, &r);
+    if (s_journal.file && paint->type == LABPAINT_SPAN)
+      _labJournalFilled(&r);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+}
+
+void LabFillCircle(int x, int y, int radius, labpaint_t const* paint)
+{
+  labpainter_t p;
+  RECT r;
+  __int64 r2, dy;
+  int i, h;
+
+  LABASSERT_INIT();
+  LABASSERT(paint != NULL);
+  LABASSERT(paint->type != LABPAINT_SPAN || paint->span != NULL);
+
+  if (s_journal.file && paint->type != LABPAINT_SPAN)
+  {
+    _labJournalCall(JOURNAL_FILL_CIRCLE, 3, x, y, radius);
+    _labJournalPaint(paint);
+  }
+
+  if (radius < 0)
+    radius = -radius;
+  x += s_globals.origin.x;
+  y += s_globals.origin.y;
+  SetRect(&r, x - radius, y - radius, x + radius + 1, y + radius + 1);
+  if (!_labClipRect(&r))
+    return;
+  r2 = (__int64)radius * radius;
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish before touching the pixels directly
+    _labPainterInit(&p, paint);
+    for (i = r.top; i < r.bottom; i++)
+    {
+      dy = i - y;
+      h = _labSqrt(r2 - dy * dy);
+      _labPaintSpan(&p, x - h, x + h + 1, i);
+    }
+    UnionRect(&s_globals.updateRect, &s_globals.updateRect, &r);
+    if (s_journal.file && paint->type == LABPAINT_SPAN)
+      _labJournalFilled(&r);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+}
+
+// the first pixel column to the right of where the edge a-b crosses the row y, ya <= y < yb
+static __inline int _labEdgeCross(labpoint_t const* a, labpoint_t const* b, int y)
+{
+  __int64 num = (__int64)(y - a->y) * (b->x - a->x);
+  __int64 den = b->y - a->y;
+  return a->x + (int)(num >= 0 ? (num + den - 1) / den : -(-num / den));
+}
+
+void LabFillPolygon(labpoint_t const* points, int count, labpaint_t const* paint)
+{
+  labpainter_t p;
+  labpoint_t const *a, *b;
+  RECT r;
+  int* cross;
+  int i, j, k, n, y;
+
+  LABASSERT_INIT();
+  LABASSERT(points != NULL || count == 0);
+  LABASSERT(paint != NULL);
+  LABASSERT(paint->type != LABPAINT_SPAN || paint->span != NULL);
+
+  if (s_journal.file && paint->type != LABPAINT_SPAN)
+  {
+    _labJournalCall(JOURNAL_FILL_POLYGON, 1, count);
+    _labJournalPoints(points, count);
+    _labJournalPaint(paint);
+  }
+
+  if (count < 3)
+    return;
+  SetRect(&r, points[0].x, points[0].y, points[0].x, points[0].y);
+  for (i = 1; i < count; i++)
+  {
+    if (points[i].x < r.left)
+      r.left = points[i].x;
+    if (points[i].x > r.right)
+      r.right = points[i].x;
+    if (points[i].y < r.top)
+      r.top = points[i].y;
+    if (points[i].y > r.bottom)
+      r.bottom = points[i].y;
+  }
+  // pixel centers on the right and bottom edges are outside
+  OffsetRect(&r, s_globals.origin.x, s_globals.origin.y);
+  if (!_labClipRect(&r))
+    return;
+  cross = (int*)malloc(count * sizeof(int));
+  if (!cross)
+  {
+    _labReportError();
+    return;
+  }
+
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish before touching the pixels directly
+    _labPainterInit(&p, paint);
+    for (y = r.top; y < r.bottom; y++)
+    {
+      // crossings of the row with the edges, each edge includes its upper end only
+      for (n = 0, i = 0; i < count; i++)
+      {
+        a = &points[i];
+        b = &points[i + 1 < count ? i + 1 : 0];
+        if (a->y == b->y)
+          continue;
+        if (a->y > b->y)
+        {
+          labpoint_t const* t = a;
+          a = b;
+          b = t;
+        }
+        if (y - s_globals.origin.y < a->y || y - s_globals.origin.y >= b->y)
+          continue;
+        k = _labEdgeCross(a, b, y - s_globals.origin.y) + s_globals.origin.x;
+        for (j = n++; j > 0 && cross[j - 1] > k; j--)
+          cross[j] = cross[j - 1];
+        cross[j] = k;
+      }
+      for (i = 0; i + 1 < n; i += 2)
+        _labPaintSpan(&p, cross[i], cross[i + 1], y);
+    }
+    UnionRect(&s_globals.updateRect, &s_globals.updateRect, &r);
+    if (s_journal.file && paint->type == LABPAINT_SPAN)
+      _labJournalFilled(&r);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+  free(cross);
+}
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Triangles
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// A pixel belongs to a triangle when its center lies on the inner side of all three edges, checked with edge
+// functions in 24.8 fixed point. A center exactly on an edge is taken only for top and left edges, so triangles
+// sharing an edge fill each pixel once. The bounding box is walked in blocks of TRIANGLE_BLOCK pixels: blocks
+// outside an edge are skipped, blocks inside all edges are shaded without tests, and the blocks on the edges
+// test four pixels at a time. Colors and depth are planes over the triangle, evaluated in floats with the same
+// operations on both paths.
+
+typedef struct labtriangle_t
+{
+  __int64 edge[3];         // edge functions at the pixel (left, top), less one for edges that are not top-left
+  __int64 stepX[3];        // their increments from a pixel to the next one
+  __int64 stepY[3];        // and from a row to the next one
+  int ramp[3][4];          // stepX times 0..3 for the 32-bit coverage test
+  labbool_t rampFits;      // ramp holds exact values
+  float value[4];          // red, green, blue and depth at the pixel (left, top)
+  float dx[4], dy[4];      // their increments along the row and the column
+  int left, top;
+} labtriangle_t;
+
+static __inline labbool_t _labFits32(__int64 v)
+{
+  return (v >= INT_MIN && v <= INT_MAX) ? LAB_TRUE : LAB_FALSE;
+}
+
+static void _labDepthClear(void)
+{
+  float* depth = (float*)s_depth.buffer;
+  int i, count = s_globals.width * s_globals.height;
+
+  if (s_depth.bits == 16)
+    memset(s_depth.buffer, 0xFF, count * sizeof(unsigned short));
+  else if (s_depth.bits == 32)
+    for (i = 0; i < count; i++)
+      depth[i] = FLT_MAX;
+}
+
+static void _labDepthFree(void)
+{
+  free(s_depth.buffer);
+  s_depth.buffer = NULL;
+  s_depth.bits = 0;
+}
+
+// the pixels x..x+3 of a row that are inside all edges, e are the edge functions at x
+static unsigned _labTriangleCover(labtriangle_t const* t, __int64 const* e)
+{
+  unsigned mask = 0;
+  int k;
+
+#if LAB_SSE2
+  // the four values fit 32 bits when the first and the last ones do
+  if (t->rampFits && _labFits32(e[0]) && _labFits32(e[0] + t->ramp[0][3]) && _labFits32(e[1]) &&
+    _labFits32(e[1] + t->ramp[1][3]) && _labFits32(e[2]) && _labFits32(e[2] + t->ramp[2][3]))
+  {
+    __m128i outside = _mm_setzero_si128();
+    int i;
+    for (i = 0; i < 3; i++)
+      outside = _mm_or_si128(outside,
+        _mm_add_epi32(_mm_set1_epi32((int)e[i]), _mm_loadu_si128((__m128i const*)t->ramp[i])));
+    return ~(unsigned)_mm_movemask_ps(_mm_castsi128_ps(outside)) & 15;
+  }
+#endif
+  for (k = 0; k < 4; k++)
+    if (e[0] + k * t->stepX[0] >= 0 && e[1] + k * t->stepX[1] >= 0 && e[2] + k * t->stepX[2] >= 0)
+      mask |= 1u << k;
+  return mask;
+}
+
+// shade the pixels x..x+3 of the row y given by mask, the caller holds the lock
+static void _labTriangleQuad(labtriangle_t const* t, int x, int y, unsigned mask)
+{
+  DWORD* dst = s_globals.bits + y * s_globals.width + x;
+  float fx = (float)(x - t->left), fy = (float)(y - t->top);
+  float z[4];
+  DWORD colors[4];
+  unsigned short q;
+  int i, k;
+
+#if LAB_SSE2
+  {
+    __m128 offset = _mm_setr_ps(fx, fx + 1.0f, fx + 2.0f, fx + 3.0f);
+    __m128 zero = _mm_setzero_ps(), top = _mm_set1_ps(255.0f), half = _mm_set1_ps(0.5f);
+    __m128 v[4];
+    __m128i pixels = _mm_setzero_si128();
+
+    for (i = 0; i < 4; i++)
+      v[i] = _mm_add_ps(_mm_set1_ps(t->value[i] + fy * t->dy[i]), _mm_mul_ps(offset, _mm_set1_ps(t->dx[i])));
+    for (i = 0; i < 3; i++)
+      pixels = _mm_or_si128(_mm_slli_epi32(pixels, 8),
+        _mm_cvttps_epi32(_mm_add_ps(_mm_min_ps(_mm_max_ps(v[i], zero), top), half)));
+    _mm_storeu_si128((__m128i*)colors, pixels);
+    _mm_storeu_ps(z, _mm_min_ps(_mm_max_ps(v[3], zero), _mm_set1_ps(1.0f)));
+  }
+#else
+  for (k = 0; k < 4; k++)
+  {
+    float v;
+    colors[k] = 0;
+    for (i = 0; i < 3; i++)
+    {
+      v = t->value[i] + fy * t->dy[i] + (fx + (float)k) * t->dx[i];
+      v = v < 0.0f ? 0.0f : v > 255.0f ? 255.0f : v;
+      colors[k] = (colors[k] << 8) | (DWORD)(int)(v + 0.5f);
+    }
+    v = t->value[3] + fy * t->dy[3] + (fx + (float)k) * t->dx[3];
+    z[k] = v < 0.0f ? 0.0f : v > 1.0f ? 1.0f : v;
+  }
+#endif
+
+  for (k = 0; k < 4; k++)
+  {
+    if (!(mask & (1u << k)))
+      continue;
+    // nearer pixels pass, a clear buffer lets everything through
+    if (s_depth.bits == 32)
+    {
+      float* depth = (float*)s_depth.buffer + y * s_globals.width + x + k;
+      if (!(z[k] < *depth))
+        continue;
+      *depth = z[k];
+    }
+    else if (s_depth.bits == 16)
+    {
+      unsigned short* depth = (unsigned short*)s_depth.buffer + y * s_globals.width + x + k;
+      q = (unsigned short)(int)(z[k] * 65534.0f + 0.5f);
+      if (q >= *depth)
+        continue;
+      *depth = q;
+    }
+    _labPut(dst + k, colors[k]);
+  }
+}
+
+// shade count pixels of the row y from x on inside the triangle with no depth test and no blending, the
+// caller holds the lock; the colors are computed as in _labTriangleQuad() and written directly
+static void _labTriangleSpan(labtriangle_t const* t, int x, int y, int count)
+{
+  DWORD* dst = s_globals.bits + y * s_globals.width + x;
+  float fx = (float)(x - t->left), fy = (float)(y - t->top);
+  int i, k = 0;
+
+#if LAB_SSE2
+  {
+    __m128 offset = _mm_setr_ps(fx, fx + 1.0f, fx + 2.0f, fx + 3.0f), four = _mm_set1_ps(4.0f);
+    __m128 zero = _mm_setzero_ps(), top = _mm_set1_ps(255.0f), half = _mm_set1_ps(0.5f);
+    __m128 base[3], step[3];
+    __m128i pixels;
+
+    for (i = 0; i < 3; i++)
+    {
+      base[i] = _mm_set1_ps(t->value[i] + fy * t->dy[i]);
+      step[i] = _mm_set1_ps(t->dx[i]);
+    }
+    for (; k + 4 <= count; k += 4, offset = _mm_add_ps(offset, four))
+    {
+      pixels = _mm_setzero_si128();
+      for (i = 0; i < 3; i++)
+        pixels = _mm_or_si128(_mm_slli_epi32(pixels, 8), _mm_cvttps_epi32(_mm_add_ps(_mm_min_ps(_mm_max_ps(
+          _mm_add_ps(base[i], _mm_mul_ps(offset, step[i])), zero), top), half)));
+      _mm_storeu_si128((__m128i*)(dst + k), pixels);
+    }
+    if (k < count)
+      _labTriangleQuad(t, x + k, y, (1u << (count - k)) - 1);
+  }
+#else
+  for (; k < count; k++)
+  {
+    float v;
+    DWORD color = 0;
+    for (i = 0; i < 3; i++)
+    {
+      v = t->value[i] + fy * t->dy[i] + (fx + (float)k) * t->dx[i];
+      v = v < 0.0f ? 0.0f : v > 255.0f ? 255.0f : v;
+      color = (color << 8) | (DWORD)(int)(v + 0.5f);
+    }
+    dst[k] = color;
+  }
+#endif
+}
+
+// walk the blocks of the bounding box r, the caller holds the lock
+static void _labTriangleFill(labtriangle_t const* t, RECT const* r)
+{
+  __int64 row[3], e[3], c[4];
+  labbool_t inside, outside, direct = (!s_depth.bits && !s_globals.blending) ? LAB_TRUE : LAB_FALSE;
+  unsigned mask;
+  int bx, by, x, y, w, h, i, k;
+
+  for (by = r->top; by < r->bottom; by += TRIANGLE_BLOCK)
+  {
+    h = r->bottom - by < TRIANGLE_BLOCK ? r->bottom - by : TRIANGLE_BLOCK;
+    for (bx = r->left; bx < r->right; bx += TRIANGLE_BLOCK)
+    {
+      w = r->right - bx < TRIANGLE_BLOCK ? r->right - bx : TRIANGLE_BLOCK;
+
+      // the corners tell where the block is, the edge functions are linear
+      inside = LAB_TRUE;
+      outside = LAB_FALSE;
+      for (i = 0; i < 3; i++)
+      {
+        row[i] = t->edge[i] + (bx - t->left) * t->stepX[i] + (by - t->top) * t->stepY[i];
+        c[0] = row[i];
+        c[1] = row[i] + (w - 1) * t->stepX[i];
+        c[2] = c[0] + (h - 1) * t->stepY[i];
+        c[3] = c[1] + (h - 1) * t->stepY[i];
+        if (c[0] < 0 && c[1] < 0 && c[2] < 0 && c[3] < 0)
+          outside = LAB_TRUE;
+        if (c[0] < 0 || c[1] < 0 || c[2] < 0 || c[3] < 0)
+          inside = LAB_FALSE;
+      }
+      if (outside)
+        continue;
+      // covered blocks without anything to test or blend are written row by row
+      if (inside && direct)
+      {
+        for (y = by; y < by + h; y++)
+          _labTriangleSpan(t, bx, y, w);
+        continue;
+      }
+
+      for (y = by; y < by + h; y++)
+      {
+        for (x = bx; x < bx + w; x += 4)
+        {
+          mask = x + 4 > bx + w ? (1u << (bx + w - x)) - 1 : 15;
+          if (!inside)
+          {
+            for (k = 0; k < 3; k++)
+              e[k] = row[k] + (x - bx) * t->stepX[k];
+            mask &= _labTriangleCover(t, e);
+          }
+          if (mask)
+            _labTriangleQuad(t, x, y, mask);
+        }
+        for (i = 0; i < 3; i++)
+          row[i] += t->stepY[i];
+      }
+    }
+  }
+}
+
+void LabFillTriangle(labvertex_t const* vertices)
+{
+  labtriangle_t t;
+  labvertex_t const* v[3];
+  labvertex_t const* swap;
+  RECT r;
+  __int64 area;
+  double a[3], gx, gy;
+  int px[3], py[3], i, j, k, dx, dy;
+
+  LABASSERT_INIT();
+  LABASSERT(vertices != NULL);
+
+  if (s_journal.file)
+    _labJournalTriangle(vertices);
+
+  for (i = 0; i < 3; i++)
+    if (_isnan(vertices[i].x) || _isnan(vertices[i].y))
+      return;
+  for (i = 0; i < 3; i++)
+  {
+    v[i] = &vertices[i];
+    px[i] = _labToFixed(vertices[i].x, s_globals.origin.x);
+    py[i] = _labToFixed(vertices[i].y, s_globals.origin.y);
+  }
+  // the vertices go so that the inside is on the positive side of every edge
+  area = (__int64)(px[1] - px[0]) * (py[2] - py[0]) - (__int64)(py[1] - py[0]) * (px[2] - px[0]);
+  if (area == 0)
+    return;
+  if (area < 0)
+  {
+    k = px[1]; px[1] = px[2]; px[2] = k;
+    k = py[1]; py[1] = py[2]; py[2] = k;
+    swap = v[1]; v[1] = v[2]; v[2] = swap;
+    area = -area;
+  }
+
+  // pixel centers within the extent of the vertices
+  r.left = (min(px[0], min(px[1], px[2])) + (1 << FIXED_SHIFT) - 1) >> FIXED_SHIFT;
+  r.right = (max(px[0], max(px[1], px[2])) >> FIXED_SHIFT) + 1;
+  r.top = (min(py[0], min(py[1], py[2])) + (1 << FIXED_SHIFT) - 1) >> FIXED_SHIFT;
+  r.bottom = (max(py[0], max(py[1], py[2])) >> FIXED_SHIFT) + 1;
+  if (!_labClipRect(&r))
+    return;
+  t.left = r.left;
+  t.top = r.top;
+
+  t.rampFits = LAB_TRUE;
+  for (i = 0; i < 3; i++)
+  {
+    j = i < 2 ? i + 1 : 0;
+    dx = px[j] - px[i];
+    dy = py[j] - py[i];
+    t.stepX[i] = -(__int64)dy * (1 << FIXED_SHIFT);
+    t.stepY[i] = (__int64)dx * (1 << FIXED_SHIFT);
+    t.edge[i] = (__int64)dx * (r.top * (1 << FIXED_SHIFT) - py[i]) - (__int64)dy * (r.left * (1 << FIXED_SHIFT) - px[i]);
+    // top edges go right along a row and left edges go up, the others leave out the centers on them
+    if (!((dy == 0 && dx > 0) || dy < 0))
+      t.edge[i]--;
+    if (!_labFits32(3 * t.stepX[i]))
+      t.rampFits = LAB_FALSE;
+    for (k = 0; k < 4; k++)
+      t.ramp[i][k] = (int)(k * t.stepX[i]);
+  }
+
+  // the plane of each value through the vertices, its gradient is per 24.8 unit
+  for (k = 0; k < 4; k++)
+  {
+    for (i = 0; i < 3; i++)
+      a[i] = k == 0 ? LABRGB_R(v[i]->color) : k == 1 ? LABRGB_G(v[i]->color) : k == 2 ? LABRGB_B(v[i]->color) : v[i]->z;
+    gx = ((a[1] - a[0]) * (py[2] - py[0]) - (a[2] - a[0]) * (py[1] - py[0])) / (double)area;
+    gy = ((a[2] - a[0]) * (px[1] - px[0]) - (a[1] - a[0]) * (px[2] - px[0])) / (double)area;
+    t.value[k] = (float)(a[0] + gx * (r.left * (1 << FIXED_SHIFT) - px[0]) + gy * (r.top * (1 << FIXED_SHIFT) - py[0]));
+    t.dx[k] = (float)(gx * (1 << FIXED_SHIFT));
+    t.dy[k] = (float)(gy * (1 << FIXED_SHIFT));
+  }
+
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish before touching the pixels directly
+    _labTriangleFill(&t, &r);
+    UnionRect(&s_globals.updateRect, &s_globals.updateRect, &r);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+}
+
+labbool_t LabDepthStart(int bits)
+{
+  LABASSERT_INIT();
+  LABASSERT(bits == 16 || bits == 32);
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_DEPTH_START, 1, bits);
+  _labDepthFree();
+  if (bits != 16 && bits != 32)
+    return LAB_FALSE;
+  s_depth.buffer = malloc((size_t)s_globals.width * s_globals.height * (bits / 8));
+  if (!s_depth.buffer)
+  {
+    _labReportError();
+    return LAB_FALSE;
+  }
+  s_depth.bits = bits;
+  _labDepthClear();
+  return LAB_TRUE;
+}
+
+void LabDepthStop(void)
+{
+  LABASSERT_INIT();
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_DEPTH_STOP, 0);
+  _labDepthFree();
+}
+
+void LabDepthClear(void)
+{
+  LABASSERT_INIT();
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_DEPTH_CLEAR, 0);
+  _labDepthClear();
+}
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Particles
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Every value of the particles has an array of its own, so that four particles are loaded into a register
+// at once. The arrays have room for a multiple of four. Particles to remove get a life of zero or less
+// during the pass and are replaced by the last ones after it, so the live particles stay packed.
+
+struct labparticles_t
+{
+  int count;        // number of live particles
+  int capacity;     // largest number of particles
+  float* x;         // positions
+  float* y;
+  float* vx;        // velocities, pixels per second
+  float* vy;
+  float* life;      // seconds left, PARTICLE_IMMORTAL for particles without a lifetime
+  DWORD* color;     // pixels to draw
+};
+
+labparticles_t* LabParticlesCreate(int capacity)
+{
+  labparticles_t* p;
+  int room = (capacity + 3) & ~3;
+
+  LABASSERT(capacity >= 0 && capacity <= PARTICLE_LIMIT);
+  if (capacity < 0 || capacity > PARTICLE_LIMIT)
+    return NULL;
+  p = (labparticles_t*)malloc(sizeof(labparticles_t) + room * (5 * sizeof(float) + sizeof(DWORD)));
+  if (!p)
+    return NULL;
+  p->count = 0;
+  p->capacity = capacity;
+  p->x = (float*)(p + 1);
+  p->y = p->x + room;
+  p->vx = p->y + room;
+  p->vy = p->vx + room;
+  p->life = p->vy + room;
+  p->color = (DWORD*)(p->life + room);
+  return p;
+}
+
+void LabParticlesDestroy(labparticles_t* particles)
+{
+  free(particles);
+}
+
+labbool_t LabParticlesAdd(labparticles_t* particles, float x, float y, float vx, float vy, labrgb_t color, float life)
+{
+  int i;
+
+  LABASSERT(particles != NULL);
+  if (particles->count >= particles->capacity)
+    return LAB_FALSE;
+  i = particles->count++;
+  particles->x[i] = x;
+  particles->y[i] = y;
+  particles->vx[i] = vx;
+  particles->vy[i] = vy;
+  particles->life[i] = life > 0.0f ? life : PARTICLE_IMMORTAL;
+  particles->color[i] = color & 0x00FFFFFF;
+  return LAB_TRUE;
+}
+
+int LabParticlesCount(labparticles_t const* particles)
+{
+  LABASSERT(particles != NULL);
+  return particles->count;
+}
+
+// both paths do the same float operations in the same order and move the particles identically
+void LabParticlesUpdate(labparticles_t* particles, float dt, labparticleparams_t const* params)
+{
+  labparticleparams_t none;
+  float *x, *y, *vx, *vy, *life;
+  float px, py, pvx, pvy, pl, dvx, dvy, left2, right2, top2, bottom2, e;
+  labbool_t removed = LAB_FALSE;
+  int i = 0, n;
+
+  LABASSERT(particles != NULL);
+  if (!params)
+  {
+    memset(&none, 0, sizeof(none));
+    none.edge = LABPARTICLE_PASS;
+    params = &none;
+  }
+  x = particles->x;
+  y = particles->y;
+  vx = particles->vx;
+  vy = particles->vy;
+  life = particles->life;
+  n = particles->count;
+  dvx = params->ax * dt;
+  dvy = params->ay * dt;
+  // a particle out of the area is reflected back from the edge
+  left2 = params->left + params->left;
+  right2 = params->right + params->right;
+  top2 = params->top + params->top;
+  bottom2 = params->bottom + params->bottom;
+  e = -params->bounce;
+
+#if LAB_SSE2
+  {
+    __m128 vdt = _mm_set1_ps(dt), vdvx = _mm_set1_ps(dvx), vdvy = _mm_set1_ps(dvy);
+    __m128 left = _mm_set1_ps(params->left), right = _mm_set1_ps(params->right);
+    __m128 top = _mm_set1_ps(params->top), bottom = _mm_set1_ps(params->bottom);
+    __m128 vleft2 = _mm_set1_ps(left2), vright2 = _mm_set1_ps(right2);
+    __m128 vtop2 = _mm_set1_ps(top2), vbottom2 = _mm_set1_ps(bottom2);
+    __m128 ve = _mm_set1_ps(e), zero = _mm_setzero_ps(), dead = _mm_set1_ps(-1.0f), any = _mm_setzero_ps();
+    __m128 qx, qy, qvx, qvy, ql, out;
+
+#define SELECT_PS(m, a, b) _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b))
+    for (; i + 4 <= n; i += 4)
+    {
+      qvx = _mm_add_ps(_mm_loadu_ps(vx + i), vdvx);
+      qvy = _mm_add_ps(_mm_loadu_ps(vy + i), vdvy);
+      qx = _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(qvx, vdt));
+      qy = _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(qvy, vdt));
+      ql = _mm_sub_ps(_mm_loadu_ps(life + i), vdt);
+      if (params->edge == LABPARTICLE_BOUNCE)
+      {
+        out = _mm_cmplt_ps(qx, left);
+        qx = SELECT_PS(out, _mm_sub_ps(vleft2, qx), qx);
+        qvx = SELECT_PS(out, _mm_mul_ps(qvx, ve), qvx);
+        out = _mm_cmpgt_ps(qx, right);
+        qx = SELECT_PS(out, _mm_sub_ps(vright2, qx), qx);
+        qvx = SELECT_PS(out, _mm_mul_ps(qvx, ve), qvx);
+        out = _mm_cmplt_ps(qy, top);
+        qy = SELECT_PS(out, _mm_sub_ps(vtop2, qy), qy);
+        qvy = SELECT_PS(out, _mm_mul_ps(qvy, ve), qvy);
+        out = _mm_cmpgt_ps(qy, bottom);
+        qy = SELECT_PS(out, _mm_sub_ps(vbottom2, qy), qy);
+        qvy = SELECT_PS(out, _mm_mul_ps(qvy, ve), qvy);
+      }
+      else if (params->edge == LABPARTICLE_REMOVE)
+      {
+        out = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(qx, left), _mm_cmpgt_ps(qx, right)),
+          _mm_or_ps(_mm_cmplt_ps(qy, top), _mm_cmpgt_ps(qy, bottom)));
+        ql = SELECT_PS(out, dead, ql);
+      }
+      any = _mm_or_ps(any, _mm_cmple_ps(ql, zero));
+      _mm_storeu_ps(x + i, qx);
+      _mm_storeu_ps(y + i, qy);
+      _mm_storeu_ps(vx + i, qvx);
+      _mm_storeu_ps(vy + i, qvy);
+      _mm_storeu_ps(life + i, ql);
+    }
+#undef SELECT_PS
+    removed = _mm_movemask_ps(any) ? LAB_TRUE : LAB_FALSE;
+  }
+#endif
+
+  for (; i < n; i++)
+  {
+    pvx = vx[i] + dvx;
+    pvy = vy[i] + dvy;
+    px = x[i] + pvx * dt;
+    py = y[i] + pvy * dt;
+    pl = life[i] - dt;
+    if (params->edge == LABPARTICLE_BOUNCE)
+    {
+      if (px < params->left)
+      {
+        px = left2 - px;
+        pvx = pvx * e;
+      }
+      if (px > params->right)
+      {
+        px = right2 - px;
+        pvx = pvx * e;
+      }
+      if (py < params->top)
+      {
+        py = top2 - py;
+        pvy = pvy * e;
+      }
+      if (py > params->bottom)
+      {
+        py = bottom2 - py;
+        pvy = pvy * e;
+      }
+    }
+    else if (params->edge == LABPARTICLE_REMOVE &&
+      (px < params->left || px > params->right || py < params->top || py > params->bottom))
+      pl = -1.0f;
+    if (pl <= 0.0f)
+      removed = LAB_TRUE;
+    x[i] = px;
+    y[i] = py;
+    vx[i] = pvx;
+    vy[i] = pvy;
+    life[i] = pl;
+  }
+
+  for (i = 0; removed && i < n; )
+  {
+    if (life[i] > 0.0f)
+    {
+      i++;
+      continue;
+    }
+    n--;
+    x[i] = x[n];
+    y[i] = y[n];
+    vx[i] = vx[n];
+    vy[i] = vy[n];
+    life[i] = life[n];
+    particles->color[i] = particles->color[n];
+  }
+  particles->count = n;
+}
+
+// one visible particle, the caller holds the lock
+static __inline void _labParticlePlot(int x, int y, DWORD pixel, RECT* bounds)
+{
+  _labPut(s_globals.bits + y * s_globals.width + x, pixel);
+  if (x < bounds->left)
+    bounds->left = x;
+  if (x >= bounds->right)
+    bounds->right = x + 1;
+  if (y < bounds->top)
+    bounds->top = y;
+  if (y >= bounds->bottom)
+    bounds->bottom = y + 1;
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_DRAW_POINT_RGB, 3, x - s_globals.origin.x, y - s_globals.origin.y, (int)pixel);
+}
+
+// particles are culled in float against the clip rectangle, the ones left are positive and truncation rounds them
+void LabParticlesDraw(labparticles_t const* particles)
+{
+  RECT const* c = &s_globals.clipRect;
+  RECT bounds;
+  float const *x, *y;
+  DWORD const* color;
+  float fx, fy, ox, oy, left, top, right, bottom;
+  int i = 0, n;
+
+  LABASSERT_INIT();
+  LABASSERT(particles != NULL);
+
+  x = particles->x;
+  y = particles->y;
+  color = particles->color;
+  n = particles->count;
+  ox = s_globals.origin.x + 0.5f;
+  oy = s_globals.origin.y + 0.5f;
+  left = (float)c->left;
+  top = (float)c->top;
+  right = (float)c->right;
+  bottom = (float)c->bottom;
+  SetRect(&bounds, c->right, c->bottom, c->left, c->top);
+
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish before touching the pixels directly
+
+#if LAB_SSE2
+    {
+      __m128 vox = _mm_set1_ps(ox), voy = _mm_set1_ps(oy);
+      __m128 vleft = _mm_set1_ps(left), vtop = _mm_set1_ps(top);
+      __m128 vright = _mm_set1_ps(right), vbottom = _mm_set1_ps(bottom);
+      __m128 qx, qy;
+      int xs[4], ys[4], k, mask;
+
+      for (; i + 4 <= n; i += 4)
+      {
+        qx = _mm_add_ps(_mm_loadu_ps(x + i), vox);
+        qy = _mm_add_ps(_mm_loadu_ps(y + i), voy);
+        mask = _mm_movemask_ps(_mm_and_ps(_mm_and_ps(_mm_cmpge_ps(qx, vleft), _mm_cmplt_ps(qx, vright)),
+          _mm_and_ps(_mm_cmpge_ps(qy, vtop), _mm_cmplt_ps(qy, vbottom))));
+        if (!mask)
+          continue;
+        _mm_storeu_si128((__m128i*)xs, _mm_cvttps_epi32(qx));
+        _mm_storeu_si128((__m128i*)ys, _mm_cvttps_epi32(qy));
+        for (k = 0; k < 4; k++)
+          if (mask & (1 << k))
+            _labParticlePlot(xs[k], ys[k], color[i + k], &bounds);
+      }
+    }
+#endif
+
+    for (; i < n; i++)
+    {
+      fx = x[i] + ox;
+      fy = y[i] + oy;
+      if (fx >= left && fx < right && fy >= top && fy < bottom)
+        _labParticlePlot((int)fx, (int)fy, color[i], &bounds);
+    }
+    if (bounds.left < bounds.right)
+      UnionRect(&s_globals.updateRect, &s_globals.updateRect, &bounds);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+}
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Tile maps
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// A cell changed by LabTilemapSet() goes into the dirty list once, and drawing walks the list only, so the cost
+// depends on the changes and not on the size of the grid. The whole map is drawn if the place it was drawn
+// to may not hold it any more: it has moved, the layer or the clip rectangle is another, the buffer was cleared.
+
+struct labtilemap_t
+{
+  int columns, rows;      // size of the grid in cells
+  int tileWidth, tileHeight;
+  int tileCount;
+  DWORD* tiles;           // images of the tiles one after another, tileWidth * tileHeight pixels each
+  int* cells;             // tile of every cell, row by row
+  BYTE* dirty;            // nonzero for the cells in the dirty list
+  int* dirtyList;         // cells changed since the map was drawn
+  int dirtyCount;
+  labbool_t redrawAll;    // every cell is to be drawn, the dirty list does not matter
+  POINT drawnAt;          // where the map was drawn last time, in buffer coordinates
+  int drawnLayer;         // the layer it was drawn to
+  RECT drawnClip;         // the clip rectangle it was drawn with
+  unsigned drawnClears;   // the number of clears at the time
+};
+
+labtilemap_t* LabTilemapCreate(int columns, int rows, int tileWidth, int tileHeight, int tileCount)
+{
+  labtilemap_t* map;
+  size_t cells, pixels;
+
+  LABASSERT(columns > 0 && rows > 0 && tileWidth > 0 && tileHeight > 0 && tileCount > 0);
+  if (columns <= 0 || rows <= 0 || tileWidth <= 0 || tileHeight <= 0 || tileCount <= 0 ||
+    columns > TILEMAP_LIMIT / rows || tileWidth > TILEMAP_LIMIT / tileHeight ||
+    tileCount > TILEMAP_LIMIT / (tileWidth * tileHeight))
+    return NULL;
+  cells = (size_t)columns * rows;
+  pixels = (size_t)tileCount * tileWidth * tileHeight;
+  map = (labtilemap_t*)malloc(sizeof(labtilemap_t) + pixels * sizeof(DWORD) + cells * (2 * sizeof(int) + 1));
+  if (!map)
+    return NULL;
+  map->columns = columns;
+  map->rows = rows;
+  map->tileWidth = tileWidth;
+  map->tileHeight = tileHeight;
+  map->tileCount = tileCount;
+  map->tiles = (DWORD*)(map + 1);
+  map->cells = (int*)(map->tiles + pixels);
+  map->dirtyList = map->cells + cells;
+  map->dirty = (BYTE*)(map->dirtyList + cells);
+  memset(map->tiles, 0, pixels * sizeof(DWORD));
+  memset(map->cells, 0, cells * sizeof(int));
+  memset(map->dirty, 0, cells);
+  map->dirtyCount = 0;
+  map->redrawAll = LAB_TRUE;
+  map->drawnAt.x = map->drawnAt.y = 0;
+  map->drawnLayer = -1;
+  SetRectEmpty(&map->drawnClip);
+  map->drawnClears = 0;
+  return map;
+}
+
+void LabTilemapDestroy(labtilemap_t* map)
+{
+  free(map);
+}
+
+void LabTilemapSetTile(labtilemap_t* map, int tile, labrgb_t const* pixels, int stride)
+{
+  DWORD* dst;
+  int x, y;
+
+  LABASSERT(map != NULL && pixels != NULL);
+  LABASSERT(tile >= 0 && tile < map->tileCount && stride >= map->tileWidth);
+  if (tile < 0 || tile >= map->tileCount)
+    return;
+  dst = map->tiles + tile * map->tileWidth * map->tileHeight;
+  for (y = 0; y < map->tileHeight; y++, pixels += stride)
+    for (x = 0; x < map->tileWidth; x++)
+      *dst++ = pixels[x] & 0x00FFFFFF;
+  map->redrawAll = LAB_TRUE;
+}
+
+void LabTilemapSet(labtilemap_t* map, int x, int y, int tile)
+{
+  int cell;
+
+  LABASSERT(map != NULL);
+  LABASSERT(tile >= 0 && tile < map->tileCount);
+  if (x < 0 || x >= map->columns || y < 0 || y >= map->rows || tile < 0 || tile >= map->tileCount)
+    return;
+  cell = y * map->columns + x;
+  if (map->cells[cell] == tile)
+    return;
+  map->cells[cell] = tile;
+  if (!map->dirty[cell])
+  {
+    map->dirty[cell] = 1;
+    map->dirtyList[map->dirtyCount++] = cell;
+  }
+}
+
+int LabTilemapGet(labtilemap_t const* map, int x, int y)
+{
+  LABASSERT(map != NULL);
+  if (x < 0 || x >= map->columns || y < 0 || y >= map->rows)
+    return -1;
+  return map->cells[y * map->columns + x];
+}
+
+void LabTilemapInvalidate(labtilemap_t* map)
+{
+  LABASSERT(map != NULL);
+  map->redrawAll = LAB_TRUE;
+}
+
+// copy the tile of a cell to the buffer, the caller holds the lock; returns LAB_FALSE if it is clipped away
+static labbool_t _labTilemapCell(labtilemap_t const* map, int cell, int x, int y, RECT* r)
+{
+  DWORD const* src = map->tiles + map->cells[cell] * map->tileWidth * map->tileHeight;
+  int i;
+
+  x += (cell % map->columns) * map->tileWidth;
+  y += (cell / map->columns) * map->tileHeight;
+  SetRect(r, x, y, x + map->tileWidth, y + map->tileHeight);
+  if (!_labClipRect(r))
+    return LAB_FALSE;
+  src += (r->top - y) * map->tileWidth + (r->left - x);
+  for (i = r->top; i < r->bottom; i++, src += map->tileWidth)
+    memcpy(s_globals.bits + i * s_globals.width + r->left, src, (r->right - r->left) * sizeof(DWORD));
+  return LAB_TRUE;
+}
+
+void LabTilemapDraw(labtilemap_t* map, int x, int y)
+{
+  RECT r, area;
+  int i, count;
+
+  LABASSERT_INIT();
+  LABASSERT(map != NULL);
+
+  x += s_globals.origin.x;
+  y += s_globals.origin.y;
+  if (x != map->drawnAt.x || y != map->drawnAt.y || s_globals.layer != map->drawnLayer ||
+    !EqualRect(&s_globals.clipRect, &map->drawnClip) || s_globals.clearCount != map->drawnClears)
+    map->redrawAll = LAB_TRUE;
+  map->drawnAt.x = x;
+  map->drawnAt.y = y;
+  map->drawnLayer = s_globals.layer;
+  map->drawnClip = s_globals.clipRect;
+  map->drawnClears = s_globals.clearCount;
+
+  count = map->redrawAll ? map->columns * map->rows : map->dirtyCount;
+  SetRectEmpty(&area);
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish before touching the pixels directly
+    for (i = 0; i < count; i++)
+      if (_labTilemapCell(map, map->redrawAll ? i : map->dirtyList[i], x, y, &r))
+      {
+        UnionRect(&area, &area, &r);
+        // the cells go into the journal as their pixels, the map itself is not recorded
+        if (s_journal.file)
+          _labJournalFilled(&r);
+      }
+    UnionRect(&s_globals.updateRect, &s_globals.updateRect, &area);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+
+  for (i = 0; i < map->dirtyCount; i++)
+    map->dirty[map->dirtyList[i]] = 0;
+  map->dirtyCount = 0;
+  map->redrawAll = LAB_FALSE;
+}
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Sprite batches
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Sprites are clipped when submitted, and the ones left are sorted by a 64-bit key: the depth in the upper
+// half, flipped to sort as unsigned, and the number of the sprite in the batch below, so that sprites of equal
+// depth keep the order they were submitted in. The sort is radix by bytes, and the bytes equal in all keys
+// are skipped.
+
+static void _labSpriteFree(void)
+{
+  free(s_sprites.sprites);
+  free(s_sprites.temp);
+  ZeroMemory(&s_sprites, sizeof(s_sprites));
+}
+
+static labbool_t _labSpriteGrow(void)
+{
+  labsprite_t* p;
+  int capacity = s_sprites.capacity ? s_sprites.capacity * 2 : SPRITE_BATCH_SIZE;
+
+  if (s_sprites.capacity > INT_MAX / 2 / (int)sizeof(labsprite_t))
+    return LAB_FALSE;
+  p = (labsprite_t*)realloc(s_sprites.sprites, capacity * sizeof(labsprite_t));
+  if (!p)
+    return LAB_FALSE;
+  s_sprites.sprites = p;
+  p = (labsprite_t*)realloc(s_sprites.temp, capacity * sizeof(labsprite_t));
+  if (!p)
+    return LAB_FALSE;
+  s_sprites.temp = p;
+  s_sprites.capacity = capacity;
+  return LAB_TRUE;
+}
+
+static void _labSpriteSort(void)
+{
+  static unsigned counts[8][256];
+  labsprite_t* src = s_sprites.sprites;
+  labsprite_t* dst = s_sprites.temp;
+  labsprite_t* t;
+  unsigned offset, c;
+  int i, d, n = s_sprites.count, shift;
+
+  memset(counts, 0, sizeof(counts));
+  for (i = 0; i < n; i++)
+    for (d = 0; d < 8; d++)
+      counts[d][(src[i].key >> (8 * d)) & 0xFF]++;
+
+  for (d = 0; d < 8; d++)
+  {
+    shift = 8 * d;
+    if (counts[d][(src[0].key >> shift) & 0xFF] == (unsigned)n)
+      continue;
+    for (offset = 0, i = 0; i < 256; i++)
+    {
+      c = counts[d][i];
+      counts[d][i] = offset;
+      offset += c;
+    }
+    for (i = 0; i < n; i++)
+      dst[counts[d][(src[i].key >> shift) & 0xFF]++] = src[i];
+    t = src;
+    src = dst;
+    dst = t;
+  }
+  s_sprites.sprites = src;
+  s_sprites.temp = dst;
+}
+
+// copy the visible part of a sprite, the caller holds the lock
+static void _labSpriteBlit(labsprite_t const* s)
+{
+  labimage_t const* image = s->image;
+  labrgb_t const* src = image->pixels + s->sy * image->width + s->sx;
+  DWORD* dst = s_globals.bits + s->r.top * s_globals.width + s->r.left;
+  labrgb_t key = image->key & 0x00FFFFFF;
+  int x, y, width = s->r.right - s->r.left;
+
+  for (y = s->r.top; y < s->r.bottom; y++, src += image->width, dst += s_globals.width)
+  {
+    if (!image->transparent)
+    {
+      memcpy(dst, src, width * sizeof(DWORD));
+      continue;
+    }
+    for (x = 0; x < width; x++)
+      if ((src[x] & 0x00FFFFFF) != key)
+        dst[x] = src[x];
+  }
+}
+
+void LabSpriteBegin(void)
+{
+  LABASSERT_INIT();
+  LABASSERT("LabSpriteBegin() without LabSpriteEnd()" && !s_sprites.active);
+
+  s_sprites.active = LAB_TRUE;
+  s_sprites.count = 0;
+}
+
+void LabSpriteSubmit(labimage_t const* image, int x, int y, int z)
+{
+  labsprite_t* s;
+  RECT r;
+
+  LABASSERT_INIT();
+  LABASSERT("LabSpriteSubmit() without LabSpriteBegin()" && s_sprites.active);
+  LABASSERT(image != NULL && image->pixels != NULL && image->width >= 0 && image->height >= 0);
+
+  x += s_globals.origin.x;
+  y += s_globals.origin.y;
+  SetRect(&r, x, y, x + image->width, y + image->height);
+  if (!s_sprites.active || !_labClipRect(&r))
+    return;
+  if (s_sprites.count == s_sprites.capacity && !_labSpriteGrow())
+    return;
+  s = &s_sprites.sprites[s_sprites.count];
+  s->key = ((unsigned __int64)((unsigned)z ^ 0x80000000u) << 32) | (unsigned)s_sprites.count;
+  s_sprites.count++;
+  s->image = image;
+  s->r = r;
+  s->sx = r.left - x;
+  s->sy = r.top - y;
+}
+
+void LabSpriteEnd(void)
+{
+  RECT bounds;
+  int i;
+
+  LABASSERT_INIT();
+  LABASSERT("LabSpriteEnd() without LabSpriteBegin()" && s_sprites.active);
+
+  s_sprites.active = LAB_FALSE;
+  if (s_sprites.count == 0)
+    return;
+  _labSpriteSort();
+  SetRectEmpty(&bounds);
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish before touching the pixels directly
+    for (i = 0; i < s_sprites.count; i++)
+    {
+      _labSpriteBlit(&s_sprites.sprites[i]);
+      UnionRect(&bounds, &bounds, &s_sprites.sprites[i].r);
+    }
+    UnionRect(&s_globals.updateRect, &s_globals.updateRect, &bounds);
+    // the images are not recorded, the journal gets the result
+    if (s_journal.file)
+      _labJournalFilled(&bounds);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+  s_sprites.count = 0;
+}
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Text output
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#define LAB_FONT_WIDTH 8   /// width of a glyph cell in pixels
+#define LAB_FONT_HEIGHT 8  /// height of a glyph cell in pixels
+#define TEXT_CACHE_SIZE 64 /// number of prepared strings kept in the text cache
+#define TEXT_CACHE_CHARS 64 /// longest piece of a line stored in one cache entry
+#define TEXT_CACHE_WORDS ((TEXT_CACHE_CHARS * LAB_FONT_WIDTH + 31) / 32) /// mask words per pixel row
+
+typedef struct labtextspan_t
+{
+  unsigned hash;    // hash of the text
+  int length;       // number of characters, 0 for an unused entry
+  char text[TEXT_CACHE_CHARS];                   // characters the mask was built from
+  DWORD mask[LAB_FONT_HEIGHT][TEXT_CACHE_WORDS]; // packed 1-bpp image, the least significant bit is the leftmost pixel
+} labtextspan_t;
+
+static labtextspan_t s_textCache[TEXT_CACHE_SIZE];
+
+// 1-bpp glyph atlas for Windows-1251, one byte per row, the least significant bit is the leftmost pixel
+static const unsigned char s_font[256][LAB_FONT_HEIGHT] = {
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x00
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x01
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x02
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x03
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x04
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x05
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x06
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x07
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x08
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x09
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x0A
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x0B
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x0C
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x0D
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x0E
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x0F
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x10
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x11
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x12
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x13
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x14
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x15
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x16
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x17
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x18
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x19
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x1A
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x1B
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x1C
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x1D
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x1E
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x1F
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x20 ' '
+  { 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x00, 0x0C, 0x00 }, // 0x21 '!'
+  { 0x36, 0x36, 0x12, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x22 '"'
+  { 0x36, 0x36, 0x7F, 0x36, 0x7F, 0x36, 0x36, 0x00 }, // 0x23 '#'
+  { 0x08, 0x3E, 0x0B, 0x1E, 0x68, 0x1F, 0x08, 0x00 }, // 0x24 '$'
+  { 0x63, 0x33, 0x18, 0x0C, 0x06, 0x33, 0x31, 0x00 }, // 0x25 '%'
+  { 0x1C, 0x36, 0x1C, 0x6E, 0x3B, 0x33, 0x6E, 0x00 }, // 0x26 '&'
+  { 0x18, 0x18, 0x0C, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x27 "'"
+  { 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x18, 0x30, 0x00 }, // 0x28 '('
+  { 0x0C, 0x18, 0x30, 0x30, 0x30, 0x18, 0x0C, 0x00 }, // 0x29 ')'
+  { 0x00, 0x36, 0x1C, 0x7F, 0x1C, 0x36, 0x00, 0x00 }, // 0x2A '*'
+  { 0x00, 0x18, 0x18, 0x7E, 0x18, 0x18, 0x00, 0x00 }, // 0x2B '+'
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x0C }, // 0x2C ','
+  { 0x00, 0x00, 0x00, 0x7E, 0x00, 0x00, 0x00, 0x00 }, // 0x2D '-'
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x00 }, // 0x2E '.'
+  { 0x40, 0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x00 }, // 0x2F '/'
+  { 0x3E, 0x63, 0x73, 0x6B, 0x67, 0x63, 0x3E, 0x00 }, // 0x30 '0'
+  { 0x18, 0x1C, 0x1E, 0x18, 0x18, 0x18, 0x7E, 0x00 }, // 0x31 '1'
+  { 0x3E, 0x63, 0x60, 0x38, 0x0E, 0x03, 0x7F, 0x00 }, // 0x32 '2'
+  { 0x3E, 0x63, 0x60, 0x3C, 0x60, 0x63, 0x3E, 0x00 }, // 0x33 '3'
+  { 0x30, 0x38, 0x3C, 0x36, 0x7F, 0x30, 0x30, 0x00 }, // 0x34 '4'
+  { 0x7F, 0x03, 0x3F, 0x60, 0x60, 0x63, 0x3E, 0x00 }, // 0x35 '5'
+  { 0x3C, 0x06, 0x03, 0x3F, 0x63, 0x63, 0x3E, 0x00 }, // 0x36 '6'
+  { 0x7F, 0x60, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x00 }, // 0x37 '7'
+  { 0x3E, 0x63, 0x63, 0x3E, 0x63, 0x63, 0x3E, 0x00 }, // 0x38 '8'
+  { 0x3E, 0x63, 0x63, 0x7E, 0x60, 0x30, 0x1E, 0x00 }, // 0x39 '9'
+  { 0x00, 0x18, 0x18, 0x00, 0x18, 0x18, 0x00, 0x00 }, // 0x3A ':'
+  { 0x00, 0x18, 0x18, 0x00, 0x18, 0x18, 0x0C, 0x00 }, // 0x3B ';'
+  { 0x30, 0x18, 0x0C, 0x06, 0x0C, 0x18, 0x30, 0x00 }, // 0x3C '<'
+  { 0x00, 0x00, 0x7E, 0x00, 0x7E, 0x00, 0x00, 0x00 }, // 0x3D '='
+  { 0x06, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x06, 0x00 }, // 0x3E '>'
+  { 0x3E, 0x63, 0x30, 0x18, 0x18, 0x00, 0x18, 0x00 }, // 0x3F '?'
+  { 0x3E, 0x63, 0x7B, 0x7B, 0x3B, 0x03, 0x3E, 0x00 }, // 0x40 '@'
+  { 0x1C, 0x36, 0x63, 0x63, 0x7F, 0x63, 0x63, 0x00 }, // 0x41 'A'
+  { 0x3F, 0x63, 0x63, 0x3F, 0x63, 0x63, 0x3F, 0x00 }, // 0x42 'B'
+  { 0x3E, 0x63, 0x03, 0x03, 0x03, 0x63, 0x3E, 0x00 }, // 0x43 'C'
+  { 0x1F, 0x33, 0x63, 0x63, 0x63, 0x33, 0x1F, 0x00 }, // 0x44 'D'
+  { 0x7F, 0x03, 0x03, 0x3F, 0x03, 0x03, 0x7F, 0x00 }, // 0x45 'E'
+  { 0x7F, 0x03, 0x03, 0x3F, 0x03, 0x03, 0x03, 0x00 }, // 0x46 'F'
+  { 0x3E, 0x63, 0x03, 0x7B, 0x63, 0x63, 0x7E, 0x00 }, // 0x47 'G'
+  { 0x63, 0x63, 0x63, 0x7F, 0x63, 0x63, 0x63, 0x00 }, // 0x48 'H'
+  { 0x7E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x7E, 0x00 }, // 0x49 'I'
+  { 0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E, 0x00 }, // 0x4A 'J'
+  { 0x63, 0x33, 0x1B, 0x0F, 0x1B, 0x33, 0x63, 0x00 }, // 0x4B 'K'
+  { 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x7F, 0x00 }, // 0x4C 'L'
+  { 0x63, 0x77, 0x7F, 0x6B, 0x63, 0x63, 0x63, 0x00 }, // 0x4D 'M'
+  { 0x63, 0x67, 0x6F, 0x7B, 0x73, 0x63, 0x63, 0x00 }, // 0x4E 'N'
+  { 0x3E, 0x63, 0x63, 0x63, 0x63, 0x63, 0x3E, 0x00 }, // 0x4F 'O'
+  { 0x3F, 0x63, 0x63, 0x3F, 0x03, 0x03, 0x03, 0x00 }, // 0x50 'P'
+  { 0x3E, 0x63, 0x63, 0x63, 0x6B, 0x33, 0x6E, 0x00 }, // 0x51 'Q'
+  { 0x3F, 0x63, 0x63, 0x3F, 0x1B, 0x33, 0x63, 0x00 }, // 0x52 'R'
+  { 0x3E, 0x63, 0x03, 0x3E, 0x60, 0x63, 0x3E, 0x00 }, // 0x53 'S'
+  { 0x7E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x00 }, // 0x54 'T'
+  { 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x3E, 0x00 }, // 0x55 'U'
+  { 0x63, 0x63, 0x63, 0x63, 0x36, 0x1C, 0x08, 0x00 }, // 0x56 'V'
+  { 0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00 }, // 0x57 'W'
+  { 0x63, 0x63, 0x36, 0x1C, 0x36, 0x63, 0x63, 0x00 }, // 0x58 'X'
+  { 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x0C, 0x00 }, // 0x59 'Y'
+  { 0x7F, 0x60, 0x30, 0x18, 0x0C, 0x06, 0x7F, 0x00 }, // 0x5A 'Z'
+  { 0x3C, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x3C, 0x00 }, // 0x5B '['
+  { 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x40, 0x00 }, // 0x5C '\\'
+  { 0x3C, 0x30, 0x30, 0x30, 0x30, 0x30, 0x3C, 0x00 }, // 0x5D ']'
+  { 0x08, 0x1C, 0x36, 0x63, 0x00, 0x00, 0x00, 0x00 }, // 0x5E '^'
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7F }, // 0x5F '_'
+  { 0x0C, 0x18, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x60 '`'
+  { 0x00, 0x00, 0x1E, 0x30, 0x3E, 0x33, 0x6E, 0x00 }, // 0x61 'a'
+  { 0x03, 0x03, 0x1F, 0x33, 0x33, 0x33, 0x1F, 0x00 }, // 0x62 'b'
+  { 0x00, 0x00, 0x1E, 0x33, 0x03, 0x33, 0x1E, 0x00 }, // 0x63 'c'
+  { 0x30, 0x30, 0x3E, 0x33, 0x33, 0x33, 0x3E, 0x00 }, // 0x64 'd'
+  { 0x00, 0x00, 0x1E, 0x33, 0x3F, 0x03, 0x1E, 0x00 }, // 0x65 'e'
+  { 0x1C, 0x36, 0x06, 0x0F, 0x06, 0x06, 0x0F, 0x00 }, // 0x66 'f'
+  { 0x00, 0x00, 0x3E, 0x33, 0x33, 0x3E, 0x30, 0x1F }, // 0x67 'g'
+  { 0x03, 0x03, 0x1F, 0x33, 0x33, 0x33, 0x33, 0x00 }, // 0x68 'h'
+  { 0x0C, 0x00, 0x0E, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 }, // 0x69 'i'
+  { 0x30, 0x00, 0x38, 0x30, 0x30, 0x33, 0x33, 0x1E }, // 0x6A 'j'
+  { 0x03, 0x03, 0x33, 0x1B, 0x0F, 0x1B, 0x33, 0x00 }, // 0x6B 'k'
+  { 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 }, // 0x6C 'l'
+  { 0x00, 0x00, 0x1B, 0x7F, 0x6B, 0x6B, 0x63, 0x00 }, // 0x6D 'm'
+  { 0x00, 0x00, 0x1F, 0x33, 0x33, 0x33, 0x33, 0x00 }, // 0x6E 'n'
+  { 0x00, 0x00, 0x1E, 0x33, 0x33, 0x33, 0x1E, 0x00 }, // 0x6F 'o'
+  { 0x00, 0x00, 0x1F, 0x33, 0x33, 0x1F, 0x03, 0x03 }, // 0x70 'p'
+  { 0x00, 0x00, 0x3E, 0x33, 0x33, 0x3E, 0x30, 0x30 }, // 0x71 'q'
+  { 0x00, 0x00, 0x1B, 0x37, 0x03, 0x03, 0x03, 0x00 }, // 0x72 'r'
+  { 0x00, 0x00, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x00 }, // 0x73 's'
+  { 0x0C, 0x0C, 0x3F, 0x0C, 0x0C, 0x2C, 0x18, 0x00 }, // 0x74 't'
+  { 0x00, 0x00, 0x33, 0x33, 0x33, 0x33, 0x6E, 0x00 }, // 0x75 'u'
+  { 0x00, 0x00, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00 }, // 0x76 'v'
+  { 0x00, 0x00, 0x63, 0x6B, 0x6B, 0x7F, 0x36, 0x00 }, // 0x77 'w'
+  { 0x00, 0x00, 0x33, 0x1E, 0x0C, 0x1E, 0x33, 0x00 }, // 0x78 'x'
+  { 0x00, 0x00, 0x33, 0x33, 0x33, 0x3E, 0x30, 0x1F }, // 0x79 'y'
+  { 0x00, 0x00, 0x3F, 0x18, 0x0C, 0x06, 0x3F, 0x00 }, // 0x7A 'z'
+  { 0x70, 0x18, 0x18, 0x0E, 0x18, 0x18, 0x70, 0x00 }, // 0x7B '{'
+  { 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x00 }, // 0x7C '|'
+  { 0x0E, 0x18, 0x18, 0x70, 0x18, 0x18, 0x0E, 0x00 }, // 0x7D '}'
+  { 0x6E, 0x3B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x7E '~'
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x7F
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x80
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x81
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x82
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x83
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x84
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x85
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x86
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x87
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x88
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x89
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x8A
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x8B
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x8C
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x8D
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x8E
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x8F
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x90
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x91
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x92
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x93
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x94
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x95
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x96
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x97
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x98
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x99
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x9A
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x9B
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x9C
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x9D
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x9E
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0x9F
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xA0
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xA1
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xA2
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xA3
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xA4
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xA5
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xA6
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xA7
+  { 0x36, 0x00, 0x7F, 0x03, 0x3F, 0x03, 0x7F, 0x00 }, // 0xA8 Ё
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xA9
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xAA
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xAB
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xAC
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xAD
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xAE
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xAF
+  { 0x1C, 0x36, 0x1C, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xB0 °
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xB1
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xB2
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xB3
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xB4
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xB5
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xB6
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xB7
+  { 0x36, 0x00, 0x1E, 0x33, 0x3F, 0x03, 0x1E, 0x00 }, // 0xB8 ё
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xB9
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xBA
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xBB
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xBC
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xBD
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xBE
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // 0xBF
+  { 0x1C, 0x36, 0x63, 0x63, 0x7F, 0x63, 0x63, 0x00 }, // 0xC0 А
+  { 0x7F, 0x03, 0x03, 0x3F, 0x63, 0x63, 0x3F, 0x00 }, // 0xC1 Б
+  { 0x3F, 0x63, 0x63, 0x3F, 0x63, 0x63, 0x3F, 0x00 }, // 0xC2 В
+  { 0x7F, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x00 }, // 0xC3 Г
+  { 0x3C, 0x36, 0x36, 0x36, 0x36, 0x7F, 0x63, 0x41 }, // 0xC4 Д
+  { 0x7F, 0x03, 0x03, 0x3F, 0x03, 0x03, 0x7F, 0x00 }, // 0xC5 Е
+  { 0x6B, 0x6B, 0x3E, 0x1C, 0x3E, 0x6B, 0x6B, 0x00 }, // 0xC6 Ж
+  { 0x3E, 0x63, 0x60, 0x38, 0x60, 0x63, 0x3E, 0x00 }, // 0xC7 З
+  { 0x63, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x63, 0x00 }, // 0xC8 И
+  { 0x5D, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x63, 0x00 }, // 0xC9 Й
+  { 0x63, 0x33, 0x1B, 0x0F, 0x1B, 0x33, 0x63, 0x00 }, // 0xCA К
+  { 0x7C, 0x66, 0x66, 0x66, 0x66, 0x66, 0x63, 0x00 }, // 0xCB Л
+  { 0x63, 0x77, 0x7F, 0x6B, 0x63, 0x63, 0x63, 0x00 }, // 0xCC М
+  { 0x63, 0x63, 0x63, 0x7F, 0x63, 0x63, 0x63, 0x00 }, // 0xCD Н
+  { 0x3E, 0x63, 0x63, 0x63, 0x63, 0x63, 0x3E, 0x00 }, // 0xCE О
+  { 0x7F, 0x63, 0x63, 0x63, 0x63, 0x63, 0x63, 0x00 }, // 0xCF П
+  { 0x3F, 0x63, 0x63, 0x3F, 0x03, 0x03, 0x03, 0x00 }, // 0xD0 Р
+  { 0x3E, 0x63, 0x03, 0x03, 0x03, 0x63, 0x3E, 0x00 }, // 0xD1 С
+  { 0x7E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x00 }, // 0xD2 Т
+  { 0x63, 0x63, 0x63, 0x7E, 0x60, 0x63, 0x3E, 0x00 }, // 0xD3 У
+  { 0x08, 0x3E, 0x6B, 0x6B, 0x6B, 0x3E, 0x08, 0x00 }, // 0xD4 Ф
+  { 0x63, 0x63, 0x36, 0x1C, 0x36, 0x63, 0x63, 0x00 }, // 0xD5 Х
+  { 0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x7F, 0x60 }, // 0xD6 Ц
+  { 0x63, 0x63, 0x63, 0x7E, 0x60, 0x60, 0x60, 0x00 }, // 0xD7 Ч
+  { 0x6B, 0x6B, 0x6B, 0x6B, 0x6B, 0x6B, 0x7F, 0x00 }, // 0xD8 Ш
+  { 0x6B, 0x6B, 0x6B, 0x6B, 0x6B, 0x6B, 0x7F, 0x40 }, // 0xD9 Щ
+  { 0x07, 0x06, 0x06, 0x3E, 0x66, 0x66, 0x3E, 0x00 }, // 0xDA Ъ
+  { 0x63, 0x63, 0x63, 0x6F, 0x7B, 0x7B, 0x6F, 0x00 }, // 0xDB Ы
+  { 0x03, 0x03, 0x03, 0x3F, 0x63, 0x63, 0x3F, 0x00 }, // 0xDC Ь
+  { 0x3E, 0x63, 0x60, 0x7C, 0x60, 0x63, 0x3E, 0x00 }, // 0xDD Э
+  { 0x33, 0x6B, 0x6B, 0x6F, 0x6B, 0x6B, 0x33, 0x00 }, // 0xDE Ю
+  { 0x7E, 0x63, 0x63, 0x7E, 0x6C, 0x66, 0x63, 0x00 }, // 0xDF Я
+  { 0x00, 0x00, 0x1E, 0x30, 0x3E, 0x33, 0x6E, 0x00 }, // 0xE0 а
+  { 0x3C, 0x06, 0x03, 0x1F, 0x33, 0x33, 0x1E, 0x00 }, // 0xE1 б
+  { 0x00, 0x00, 0x1F, 0x33, 0x1F, 0x33, 0x1F, 0x00 }, // 0xE2 в
+  { 0x00, 0x00, 0x3F, 0x03, 0x03, 0x03, 0x03, 0x00 }, // 0xE3 г
+  { 0x00, 0x00, 0x3C, 0x36, 0x36, 0x7F, 0x63, 0x00 }, // 0xE4 д
+  { 0x00, 0x00, 0x1E, 0x33, 0x3F, 0x03, 0x1E, 0x00 }, // 0xE5 е
+  { 0x00, 0x00, 0x6B, 0x3E, 0x1C, 0x3E, 0x6B, 0x00 }, // 0xE6 ж
+  { 0x00, 0x00, 0x1E, 0x33, 0x18, 0x33, 0x1E, 0x00 }, // 0xE7 з
+  { 0x00, 0x00, 0x33, 0x3B, 0x3F, 0x37, 0x33, 0x00 }, // 0xE8 и
+  { 0x12, 0x0C, 0x33, 0x3B, 0x3F, 0x37, 0x33, 0x00 }, // 0xE9 й
+  { 0x00, 0x00, 0x33, 0x1B, 0x0F, 0x1B, 0x33, 0x00 }, // 0xEA к
+  { 0x00, 0x00, 0x3C, 0x36, 0x36, 0x36, 0x33, 0x00 }, // 0xEB л
+  { 0x00, 0x00, 0x63, 0x77, 0x6B, 0x63, 0x63, 0x00 }, // 0xEC м
+  { 0x00, 0x00, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x00 }, // 0xED н
+  { 0x00, 0x00, 0x1E, 0x33, 0x33, 0x33, 0x1E, 0x00 }, // 0xEE о
+  { 0x00, 0x00, 0x3F, 0x33, 0x33, 0x33, 0x33, 0x00 }, // 0xEF п
+  { 0x00, 0x00, 0x1F, 0x33, 0x33, 0x1F, 0x03, 0x03 }, // 0xF0 р
+  { 0x00, 0x00, 0x1E, 0x33, 0x03, 0x33, 0x1E, 0x00 }, // 0xF1 с
+  { 0x00, 0x00, 0x3F, 0x0C, 0x0C, 0x0C, 0x0C, 0x00 }, // 0xF2 т
+  { 0x00, 0x00, 0x33, 0x33, 0x33, 0x3E, 0x30, 0x1F }, // 0xF3 у
+  { 0x08, 0x08, 0x3E, 0x6B, 0x6B, 0x3E, 0x08, 0x08 }, // 0xF4 ф
+  { 0x00, 0x00, 0x33, 0x1E, 0x0C, 0x1E, 0x33, 0x00 }, // 0xF5 х
+  { 0x00, 0x00, 0x33, 0x33, 0x33, 0x33, 0x7F, 0x60 }, // 0xF6 ц
+  { 0x00, 0x00, 0x33, 0x33, 0x3E, 0x30, 0x30, 0x00 }, // 0xF7 ч
+  { 0x00, 0x00, 0x6B, 0x6B, 0x6B, 0x6B, 0x7F, 0x00 }, // 0xF8 ш
+  { 0x00, 0x00, 0x6B, 0x6B, 0x6B, 0x6B, 0x7F, 0x40 }, // 0xF9 щ
+  { 0x00, 0x00, 0x07, 0x06, 0x1E, 0x36, 0x1E, 0x00 }, // 0xFA ъ
+  { 0x00, 0x00, 0x63, 0x63, 0x6F, 0x7B, 0x6F, 0x00 }, // 0xFB ы
+  { 0x00, 0x00, 0x03, 0x03, 0x1F, 0x33, 0x1F, 0x00 }, // 0xFC ь
+  { 0x00, 0x00, 0x1E, 0x33, 0x3C, 0x33, 0x1E, 0x00 }, // 0xFD э
+  { 0x00, 0x00, 0x33, 0x6B, 0x6F, 0x6B, 0x33, 0x00 }, // 0xFE ю
+  { 0x00, 0x00, 0x3E, 0x33, 0x3E, 0x36, 0x33, 0x00 }, // 0xFF я
+};
+
+static unsigned _labTextHash(char const* text, int length)
+{
+  unsigned hash = 2166136261u; // FNV-1a
+  int i;
+  for (i = 0; i < length; i++)
+    hash = (hash ^ (unsigned char)text[i]) * 16777619u;
+  return hash;
+}
+
+// find the prepared image of the text or build it, length should not exceed TEXT_CACHE_CHARS
+static labtextspan_t const* _labTextSpan(char const* text, int length)
+{
+  unsigned hash = _labTextHash(text, length);
+  labtextspan_t* span = &s_textCache[hash % TEXT_CACHE_SIZE];
+  int i, row;
+
+  LABASSERT(length > 0 && length <= TEXT_CACHE_CHARS);
+  if (span->length == length && span->hash == hash && memcmp(span->text, text, length) == 0)
+    return span;
+
+  // glyphs are byte-aligned inside the words, so every glyph row goes into exactly one word
+  memset(span->mask, 0, sizeof(span->mask));
+  for (i = 0; i < length; i++)
+  {
+    unsigned char const* glyph = s_font[(unsigned char)text[i]];
+    int word = (i * LAB_FONT_WIDTH) >> 5;
+    int shift = (i * LAB_FONT_WIDTH) & 31;
+    for (row = 0; row < LAB_FONT_HEIGHT; row++)
+      span->mask[row][word] |= (DWORD)glyph[row] << shift;
+  }
+  memcpy(span->text, text, length);
+  span->length = length;
+  span->hash = hash;
+  return span;
+}
+
+// plot the set bits of the mask in the pen color, the caller holds the lock
+static void _labTextBlit(int x, int y, labtextspan_t const* span)
+{
+  RECT const* c = &s_globals.clipRect;
+  int words = (span->length * LAB_FONT_WIDTH + 31) >> 5;
+  int rowFirst = y < c->top ? c->top - y : 0;
+  int rowLast = y + LAB_FONT_HEIGHT > c->bottom ? c->bottom - y : LAB_FONT_HEIGHT;
+  int row, word, left;
+  DWORD bits;
+  DWORD* line;
+  unsigned long index;
+
+  for (row = rowFirst; row < rowLast; row++)
+  {
+    line = s_globals.bits + (y + row) * s_globals.width;
+    for (word = 0; word < words; word++)
+    {
+      bits = span->mask[row][word];
+      left = x + (word << 5);
+      // skip empty words and clip the partially visible ones
+      if (!bits || left <= c->left - 32)
+        continue;
+      if (left >= c->right)
+        break;
+      if (left < c->left)
+        bits &= ~0u << (c->left - left);
+      if (left + 32 > c->right)
+        bits &= (1u << (c->right - left)) - 1;
+      while (bits)
+      {
+        _BitScanForward(&index, bits);
+        _labPut(line + left + index, s_globals.penPixel);
+        bits &= bits - 1;
+      }
+    }
+  }
+}
+
+static void _labTextLine(int x, int y, char const* text, int length)
+{
+  RECT r;
+  int count;
+
+  x += s_globals.origin.x;
+  y += s_globals.origin.y;
+
+  // nothing to do if the line is clipped out
+  if (y >= s_globals.clipRect.bottom || y + LAB_FONT_HEIGHT <= s_globals.clipRect.top || x >= s_globals.clipRect.right)
+    return;
+
+  // long lines are drawn by cache-sized pieces
+  for (; length > 0; text += count, length -= count, x += count * LAB_FONT_WIDTH)
+  {
+    count = length < TEXT_CACHE_CHARS ? length : TEXT_CACHE_CHARS;
+    r.left   = x;
+    r.right  = x + count * LAB_FONT_WIDTH;
+    r.top    = y;
+    r.bottom = y + LAB_FONT_HEIGHT;
+    if (x >= s_globals.clipRect.right)
+      break;
+    if (!_labClipRect(&r))
+      continue;
+    EnterCriticalSection(&s_globals.cs);
+    {
+      GdiFlush(); // let GDI finish before touching the pixels directly
+      _labTextBlit(x, y, _labTextSpan(text, count));
+      UnionRect(&s_globals.updateRect, &s_globals.updateRect, &r);
+      LeaveCriticalSection(&s_globals.cs);
+    }
+  }
+}
+
+void LabDrawText(int x, int y, char const* text)
+{
+  char const* end;
+
+  LABASSERT_INIT();
+  LABASSERT(text != NULL);
+
+  if (s_journal.file)
+    _labJournalText(x, y, text);
+
+  for (;; y += LAB_FONT_HEIGHT)
+  {
+    for (end = text; *end && *end != '\n'; end++)
+      ;
+    if (end != text)
+      _labTextLine(x, y, text, (int)(end - text));
+    if (!*end)
+      break;
+    text = end + 1;
+  }
+}
+
+void LabDrawTextf(int x, int y, char const* format, ...)
+{
+  char buffer[1024];
+  va_list args;
+
+  LABASSERT_INIT();
+
+  va_start(args, format);
+  StringCchVPrintfA(buffer, sizeof(buffer), format, args); // too long output is truncated
+  va_end(args);
+  LabDrawText(x, y, buffer);
+}
+
+int LabGetTextWidth(char const* text)
+{
+  int length = 0, longest = 0;
+
+  LABASSERT(text != NULL);
+  for (;; text++)
+  {
+    if (*text == '\n' || !*text)
+    {
+      if (length > longest)
+        longest = length;
+      length = 0;
+      if (!*text)
+        break;
+    }
+    else
+      length++;
+  }
+  return longest * LAB_FONT_WIDTH;
+}
+
+int LabGetTextHeight(void)
+{
+  return LAB_FONT_HEIGHT;
+}
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Frame server
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// LabDrawFlush() only copies the buffer into the posted frame and wakes the server thread up. The thread
+// compares the frame with what the viewer has tile by tile and sends the changed tiles. All sockets are
+// non-blocking: while a message is waiting for room in the socket, newer flushes overwrite the posted
+// frame, so a slow viewer skips frames and the program never waits for it.
+
+#define SERVER_FRAME_HEADER 9  /// 'F', frame number, tile count
+#define SERVER_TILE_HEADER 13  /// x, y, width, height, encoding, payload size
+#define SERVER_TILE_RAW 0      /// payload holds the pixels of the tile
+#define SERVER_TILE_XOR_RLE 1  /// payload holds runs of the XOR of the tile with the viewer's pixels
+
+static __inline BYTE* _labPut16(BYTE* p, unsigned value)
+{
+  p[0] = (BYTE)value;
+  p[1] = (BYTE)(value >> 8);
+  return p + 2;
+}
+
+static __inline BYTE* _labPut32(BYTE* p, DWORD value)
+{
+  p[0] = (BYTE)value;
+  p[1] = (BYTE)(value >> 8);
+  p[2] = (BYTE)(value >> 16);
+  p[3] = (BYTE)(value >> 24);
+  return p + 4;
+}
+
+// called by LabDrawFlush(), takes a copy of the buffer for the server thread and returns at once
+static void _labServerPost(void)
+{
+  if (!s_server.running)
+    return;
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish drawing before copying
+    EnterCriticalSection(&s_server.cs);
+    memcpy(s_server.posted, s_globals.frameBits, s_globals.width * s_globals.height * sizeof(DWORD));
+    s_server.fresh = LAB_TRUE;
+    s_server.postedNumber++;
+    LeaveCriticalSection(&s_server.cs);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+  SetEvent(s_server.frameEvent);
+}
+
+static void _labServerDrop(void)
+{
+  closesocket(s_server.client);
+  s_server.client = INVALID_SOCKET;
+  s_server.packetSize = s_server.packetSent = 0;
+  s_server.inputSize = 0;
+}
+
+// a tile is sent either as is or as runs of its XOR with what the viewer has, whichever is shorter
+static BYTE* _labServerEncodeTile(BYTE* p, int x, int y, int width, int height)
+{
+  int pitch = s_globals.width;
+  DWORD const* frame = s_server.frame + y * pitch + x;
+  DWORD* sent = s_server.sent + y * pitch + x;
+  BYTE* data = p + SERVER_TILE_HEADER;
+  BYTE* q = data;
+  BYTE encoding = SERVER_TILE_XOR_RLE;
+  DWORD value, run = 0;
+  int i, j, count = 0;
+
+  // unchanged pixels give zeros, so a few changes in a tile cost a few runs
+  for (j = 0; j < height; j++)
+  {
+    for (i = 0; i < width; i++)
+    {
+      value = frame[j * pitch + i] ^ sent[j * pitch + i];
+      if (count > 0 && value == run)
+      {
+        count++;
+        continue;
+      }
+      if (count > 0)
+      {
+        q = _labPut16(q, count);
+        q = _labPut32(q, run);
+      }
+      run = value;
+      count = 1;
+    }
+  }
+  q = _labPut16(q, count);
+  q = _labPut32(q, run);
+
+  if (q - data >= width * height * (int)sizeof(DWORD))
+  {
+    encoding = SERVER_TILE_RAW;
+    q = data;
+    for (j = 0; j < height; j++)
+      for (i = 0; i < width; i++)
+        q = _labPut32(q, frame[j * pitch + i]);
+  }
+  for (j = 0; j < height; j++)
+    memcpy(sent + j * pitch, frame + j * pitch, width * sizeof(DWORD));
+
+  p = _labPut16(p, x);
+  p = _labPut16(p, y);
+  p = _labPut16(p, width);
+  p = _labPut16(p, height);
+  *p++ = encoding;
+  _labPut32(p, (DWORD)(q - data));
+  return q;
+}
+
+static void _labServerEncodeFrame(void)
+{
+  BYTE* p = s_server.packet + SERVER_FRAME_HEADER;
+  int x, y, j, width, height, tiles = 0, pitch = s_globals.width;
+
+  for (y = 0; y < s_globals.height; y += SERVER_TILE_SIZE)
+  {
+    height = min(SERVER_TILE_SIZE, s_globals.height - y);
+    for (x = 0; x < s_globals.width; x += SERVER_TILE_SIZE)
+    {
+      width = min(SERVER_TILE_SIZE, s_globals.width - x);
+      for (j = 0; j < height; j++)
+        if (memcmp(s_server.frame + (y + j) * pitch + x, s_server.sent + (y + j) * pitch + x, width * sizeof(DWORD)) != 0)
+          break;
+      if (j < height)
+      {
+        p = _labServerEncodeTile(p, x, y, width, height);
+        tiles++;
+      }
+    }
+  }
+
+  s_server.packet[0] = 'F';
+  _labPut32(_labPut32(s_server.packet + 1, s_server.frameNumber), tiles);
+  s_server.packetSize = (int)(p - s_server.packet);
+  s_server.packetSent = 0;
+}
+
+// send what is left of the current message, then encode the newest frame if there is one
+static void _labServerPump(void)
+{
+  int res;
+  labbool_t encode;
+  DWORD* frame;
+
+  while (s_server.client != INVALID_SOCKET)
+  {
+    if (s_server.packetSent < s_server.packetSize)
+    {
+      res = send(s_server.client, (char const*)s_server.packet + s_server.packetSent,
+        s_server.packetSize - s_server.packetSent, 0);
+      if (res == SOCKET_ERROR)
+      {
+        // FD_WRITE tells when there is room in the socket again
+        if (WSAGetLastError() != WSAEWOULDBLOCK)
+          _labServerDrop();
+        return;
+      }
+      s_server.packetSent += res;
+      continue;
+    }
+
+    encode = s_server.needFrame;
+    s_server.needFrame = LAB_FALSE;
+    EnterCriticalSection(&s_server.cs);
+    if (s_server.fresh)
+    {
+      frame = s_server.frame;
+      s_server.frame = s_server.posted;
+      s_server.posted = frame;
+      s_server.frameNumber = s_server.postedNumber;
+      s_server.fresh = LAB_FALSE;
+      s_server.haveFrame = LAB_TRUE;
+      encode = LAB_TRUE;
+    }
+    LeaveCriticalSection(&s_server.cs);
+    if (!encode)
+      return;
+    _labServerEncodeFrame();
+  }
+}
+
+static void _labServerAccept(void)
+{
+  SOCKET client;
+  BYTE* p;
+  BOOL noDelay = TRUE;
+
+  client = accept(s_server.listener, NULL, NULL);
+  if (client == INVALID_SOCKET)
+    return;
+  // one viewer at a time
+  if (s_server.client != INVALID_SOCKET ||
+    WSAEventSelect(client, s_server.netEvent, FD_READ | FD_WRITE | FD_CLOSE) == SOCKET_ERROR)
+  {
+    closesocket(client);
+    return;
+  }
+  setsockopt(client, IPPROTO_TCP, TCP_NODELAY, (char const*)&noDelay, sizeof(noDelay));
+  s_server.client = client;
+
+  // the viewer starts with a black screen and gets the whole last frame after the greeting
+  ZeroMemory(s_server.sent, s_globals.width * s_globals.height * sizeof(DWORD));
+  p = s_server.packet;
+  *p++ = 'L';
+  *p++ = 'A';
+  *p++ = 'B';
+  *p++ = 'F';
+  p = _labPut16(p, SERVER_VERSION);
+  p = _labPut16(p, s_globals.width);
+  p = _labPut16(p, s_globals.height);
+  p = _labPut16(p, SERVER_TILE_SIZE);
+  s_server.packetSize = (int)(p - s_server.packet);
+  s_server.packetSent = 0;
+  s_server.needFrame = s_server.haveFrame;
+}
+
+// every message from the viewer is a key: 'K' and the key code in 4 bytes
+static void _labServerRead(void)
+{
+  int i, res;
+  BYTE const* m;
+
+  while (s_server.client != INVALID_SOCKET)
+  {
+    res = recv(s_server.client, (char*)s_server.input + s_server.inputSize, sizeof(s_server.input) - s_server.inputSize, 0);
+    if (res == SOCKET_ERROR && WSAGetLastError() == WSAEWOULDBLOCK)
+      return;
+    if (res == SOCKET_ERROR || res == 0)
+    {
+      _labServerDrop();
+      return;
+    }
+    s_server.inputSize += res;
+
+    for (i = 0; s_server.inputSize - i >= 5; i += 5)
+    {
+      m = s_server.input + i;
+      if (m[0] != 'K')
+      {
+        _labServerDrop();
+        return;
+      }
+      _labInputKeyPost(m[1] | (m[2] << 8) | (m[3] << 16) | (m[4] << 24));
+    }
+    s_server.inputSize -= i;
+    memmove(s_server.input, s_server.input + i, s_server.inputSize);
+  }
+}
+
+static DWORD WINAPI _labServerThreadProc(_In_ LPVOID lpParameter)
+{
+  HANDLE events[3];
+  WSANETWORKEVENTS ne;
+  DWORD res;
+
+  events[0] = s_server.stopEvent;
+  events[1] = s_server.netEvent;
+  events[2] = s_server.frameEvent;
+  for (;;)
+  {
+    res = WaitForMultipleObjects(3, events, FALSE, INFINITE);
+    if (res != WAIT_OBJECT_0 + 1 && res != WAIT_OBJECT_0 + 2)
+      break;
+
+    // events arriving after the reset set the event again, so none is lost between the two sockets
+    WSAResetEvent(s_server.netEvent);
+    if (WSAEnumNetworkEvents(s_server.listener, NULL, &ne) == 0 && (ne.lNetworkEvents & FD_ACCEPT))
+      _labServerAccept();
+    if (s_server.client != INVALID_SOCKET && WSAEnumNetworkEvents(s_server.client, NULL, &ne) == 0 &&
+      (ne.lNetworkEvents & (FD_READ | FD_CLOSE)))
+      _labServerRead();
+    _labServerPump();
+  }
+
+  if (s_server.client != INVALID_SOCKET)
+    _labServerDrop();
+  return 0;
+}
+
+static void _labServerCleanup(void)
+{
+  if (s_server.listener != INVALID_SOCKET)
+  {
+    closesocket(s_server.listener);
+    s_server.listener = INVALID_SOCKET;
+  }
+  if (s_server.netEvent)
+  {
+    WSACloseEvent(s_server.netEvent);
+    s_server.netEvent = NULL;
+  }
+  if (s_server.stopEvent)
+  {
+    CloseHandle(s_server.stopEvent);
+    s_server.stopEvent = NULL;
+  }
+  if (s_server.frameEvent)
+  {
+    CloseHandle(s_server.frameEvent);
+    s_server.frameEvent = NULL;
+  }
+  free(s_server.posted);
+  free(s_server.frame);
+  free(s_server.sent);
+  free(s_server.packet);
+  s_server.posted = s_server.frame = s_server.sent = NULL;
+  s_server.packet = NULL;
+  WSACleanup();
+}
+
+labbool_t LabServerStart(int port)
+{
+  WSADATA wsaData;
+  struct sockaddr_in addr;
+  size_t size;
+  int tiles;
+
+  LABASSERT_INIT();
+  LABASSERT(port > 0 && port < 65536);
+  if (s_server.running)
+    return LAB_FALSE;
+  if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+    return LAB_FALSE;
+
+  s_server.client = INVALID_SOCKET;
+  s_server.listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (s_server.listener == INVALID_SOCKET)
+    goto on_error;
+  ZeroMemory(&addr, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons((u_short)port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // never visible from other machines
+  if (bind(s_server.listener, (struct sockaddr const*)&addr, sizeof(addr)) == SOCKET_ERROR ||
+    listen(s_server.listener, 1) == SOCKET_ERROR)
+    goto on_error;
+
+  // a tile encoded as runs never takes more than 6 bytes per pixel
+  size = s_globals.width * s_globals.height * sizeof(DWORD);
+  tiles = ((s_globals.width + SERVER_TILE_SIZE - 1) / SERVER_TILE_SIZE) *
+    ((s_globals.height + SERVER_TILE_SIZE - 1) / SERVER_TILE_SIZE);
+  s_server.posted = (DWORD*)calloc(1, size);
+  s_server.frame = (DWORD*)calloc(1, size);
+  s_server.sent = (DWORD*)calloc(1, size);
+  s_server.packet = (BYTE*)malloc(SERVER_FRAME_HEADER + tiles * (SERVER_TILE_HEADER + 6 * SERVER_TILE_SIZE * SERVER_TILE_SIZE));
+  if (!s_server.posted || !s_server.frame || !s_server.sent || !s_server.packet)
+    goto on_error;
+
+  s_server.stopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+  s_server.frameEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+  s_server.netEvent = WSACreateEvent();
+  if (!s_server.stopEvent || !s_server.frameEvent || !s_server.netEvent)
+    goto on_error;
+  if (WSAEventSelect(s_server.listener, s_server.netEvent, FD_ACCEPT) == SOCKET_ERROR)
+    goto on_error;
+
+  s_server.fresh = s_server.haveFrame = s_server.needFrame = LAB_FALSE;
+  s_server.postedNumber = s_server.frameNumber = 0;
+  s_server.packetSize = s_server.packetSent = s_server.inputSize = 0;
+  InitializeCriticalSection(&s_server.cs);
+  s_server.thread = CreateThread(NULL, 0, _labServerThreadProc, NULL, 0, NULL);
+  if (!s_server.thread)
+  {
+    DeleteCriticalSection(&s_server.cs);
+    goto on_error;
+  }
+  s_server.running = LAB_TRUE;
+  return LAB_TRUE;
+
+on_error:
+  _labReportError();
+  _labServerCleanup();
+  return LAB_FALSE;
+}
+
+void LabServerStop(void)
+{
+  LABASSERT_INIT();
+  if (!s_server.running)
+    return;
+  s_server.running = LAB_FALSE;
+
+  SetEvent(s_server.stopEvent);
+  if (WaitForSingleObject(s_server.thread, INFINITE) == WAIT_FAILED)
+    _labReportError();
+  CloseHandle(s_server.thread);
+  s_server.thread = NULL;
+  DeleteCriticalSection(&s_server.cs);
+  _labServerCleanup();
+}
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Shared memory export
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#define SHARE_HEADER_SIZE 64 /// the frame starts at this offset, leaving room for the header to grow
+
+// called by LabDrawFlush(), publishes the buffer under the seqlock
+static void _labSharePost(void)
+{
+  labshareheader_t* header = s_globals.share;
+  if (!header)
+    return;
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish drawing before copying
+    // an odd counter tells readers the frame is being written, the interlocked increments are full barriers
+    InterlockedIncrement(&header->sequence);
+    memcpy((BYTE*)header + header->offset, s_globals.frameBits, header->height * header->pitch);
+    header->frame++;
+    InterlockedIncrement(&header->sequence);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+}
+
+labbool_t LabShareStart(char const* name)
+{
+  DWORD size;
+  _STATIC_ASSERT(sizeof(labshareheader_t) <= SHARE_HEADER_SIZE);
+
+  LABASSERT_INIT();
+  LABASSERT(name != NULL);
+  if (s_globals.share)
+    return LAB_FALSE;
+
+  size = SHARE_HEADER_SIZE + s_globals.width * s_globals.height * sizeof(DWORD);
+  s_globals.shareMapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, size, name);
+  if (!s_globals.shareMapping)
+    goto on_error;
+  // somebody else exports frames under this name
+  if (GetLastError() == ERROR_ALREADY_EXISTS)
+    goto on_error;
+  s_globals.share = (labshareheader_t*)MapViewOfFile(s_globals.shareMapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+  if (!s_globals.share)
+    goto on_error;
+
+  s_globals.share->magic = LABSHARE_MAGIC;
+  s_globals.share->size = size;
+  s_globals.share->offset = SHARE_HEADER_SIZE;
+  s_globals.share->width = s_globals.width;
+  s_globals.share->height = s_globals.height;
+  s_globals.share->pitch = s_globals.width * sizeof(DWORD);
+  s_globals.share->format = LABSHARE_FORMAT_XRGB8888;
+  s_globals.share->sequence = 0;
+  s_globals.share->frame = 0;
+  _labSharePost();
+  return LAB_TRUE;
+
+on_error:
+  _labReportError();
+  if (s_globals.shareMapping)
+  {
+    CloseHandle(s_globals.shareMapping);
+    s_globals.shareMapping = NULL;
+  }
+  return LAB_FALSE;
+}
+
+void LabShareStop(void)
+{
+  LABASSERT_INIT();
+  if (!s_globals.share)
+    return;
+  UnmapViewOfFile(s_globals.share);
+  CloseHandle(s_globals.shareMapping);
+  s_globals.share = NULL;
+  s_globals.shareMapping = NULL;
+}
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Frame history
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The history keeps a copy of the last flushed frame and, for every flush before it, the XOR of the frame with
+// the one before, compressed into runs. Going back from the copy, each record turns a frame into the previous
+// one. Records are kept in a ring of DWORDs as the record size, the runs and the size again, so that they can
+// be walked both ways. A run header holds the number of pixels shifted left by one and a flag in bit 0: set
+// for one value repeated, clear for as many values as pixels. When the end of the ring is too close the next
+// record starts over at the beginning, and the oldest records give way to new ones.
+
+#define HISTORY_RUN_MIN 3     /// shorter runs of equal values go to literal runs
+#define HISTORY_BLOCK 64      /// pixels compared at once while looking for the end of an unchanged run
+
+// runs of the XOR of frame and last, returns the number of DWORDs written; never longer than the frame by
+// more than one header, since a repeated run only breaks a literal run when it saves more than the header
+static int _labHistoryEncode(DWORD* dst, DWORD const* frame, DWORD const* last, int count)
+{
+  DWORD* q = dst;
+  DWORD* literal = NULL;
+  DWORD value;
+  int i, j;
+
+  for (i = 0; i < count; i = j)
+  {
+    value = frame[i] ^ last[i];
+    j = i + 1;
+    // most of a frame is usually unchanged, compare it in blocks
+    if (value == 0)
+      while (j + HISTORY_BLOCK <= count && memcmp(frame + j, last + j, HISTORY_BLOCK * sizeof(DWORD)) == 0)
+        j += HISTORY_BLOCK;
+    for (; j < count && (frame[j] ^ last[j]) == value; j++)
+      ;
+    if (j - i >= HISTORY_RUN_MIN)
+    {
+      *q++ = ((DWORD)(j - i) << 1) | 1;
+      *q++ = value;
+      literal = NULL;
+      continue;
+    }
+    if (!literal)
+    {
+      literal = q++;
+      *literal = 0;
+    }
+    *literal += (DWORD)(j - i) << 1;
+    for (; i < j; i++)
+      *q++ = value;
+  }
+  return (int)(q - dst);
+}
+
+// XOR the runs into the frame
+static void _labHistoryApply(DWORD* frame, DWORD const* p, DWORD const* end)
+{
+  DWORD header, value, i, count;
+
+  while (p < end)
+  {
+    header = *p++;
+    count = header >> 1;
+    if (header & 1)
+    {
+      value = *p++;
+      if (value)
+        for (i = 0; i < count; i++)
+          frame[i] ^= value;
+    }
+    else
+    {
+      for (i = 0; i < count; i++)
+        frame[i] ^= p[i];
+      p += count;
+    }
+    frame += count;
+  }
+}
+
+static void _labHistoryDropOldest(void)
+{
+  int size = s_history.ring[s_history.first] + 2;
+
+  s_history.first += size;
+  s_history.used -= size;
+  s_history.count--;
+  if (s_history.wrapped && s_history.first == s_history.wrap)
+  {
+    s_history.first = 0;
+    s_history.wrapped = LAB_FALSE;
+  }
+  if (s_history.count == 0)
+  {
+    s_history.first = s_history.end = 0;
+    s_history.wrapped = LAB_FALSE;
+  }
+}
+
+// store the record of size DWORDs encoded in scratch
+static void _labHistoryPush(int size)
+{
+  int length = size + 2;
+  DWORD* r;
+
+  if (length > s_history.budget)
+  {
+    // the record does not fit at all, and nothing before it can be reached without it
+    while (s_history.count > 0)
+      _labHistoryDropOldest();
+    return;
+  }
+  for (;;)
+  {
+    // an empty ring starts at 0, where any record up to the budget fits
+    if (!s_history.wrapped)
+    {
+      if (s_history.budget - s_history.end >= length)
+        break;
+      if (s_history.first >= length)
+      {
+        s_history.wrap = s_history.end;
+        s_history.wrapped = LAB_TRUE;
+        s_history.end = 0;
+        break;
+      }
+    }
+    else if (s_history.first - s_history.end >= length)
+      break;
+    _labHistoryDropOldest();
+  }
+
+  r = s_history.ring + s_history.end;
+  r[0] = r[size + 1] = (DWORD)size;
+  memcpy(r + 1, s_history.scratch, size * sizeof(DWORD));
+  s_history.end += length;
+  s_history.used += length;
+  s_history.count++;
+}
+
+// called by LabDrawFlush(), records the difference of the composed frame with the previous one
+static void _labHistoryPost(void)
+{
+  LARGE_INTEGER start, stop;
+  int count = s_globals.width * s_globals.height;
+
+  if (!s_history.last)
+    return;
+  QueryPerformanceCounter(&start);
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish drawing before reading the frame
+    if (s_history.flushes > 0)
+      _labHistoryPush(_labHistoryEncode(s_history.scratch, s_globals.frameBits, s_history.last, count));
+    memcpy(s_history.last, s_globals.frameBits, count * sizeof(DWORD));
+    s_history.flushes++;
+    LeaveCriticalSection(&s_globals.cs);
+  }
+  QueryPerformanceCounter(&stop);
+  s_history.ticks += stop.QuadPart - start.QuadPart;
+  if (InterlockedExchange(&s_history.dump, 0))
+    LabHistoryDump(HISTORY_DUMP_PREFIX, 0, INT_MAX);
+}
+
+// frames that can be restored, the caller holds the lock
+static __inline int _labHistoryFrames(void)
+{
+  return s_history.flushes > 0 ? s_history.count + 1 : 0;
+}
+
+// turns the frame at position *p into the previous one and moves *p to the record before; the history
+// is either s_history with the lock held or a copy of it
+static void _labHistoryStepBack(labhistory_t const* h, DWORD* frame, int* p)
+{
+  DWORD const* ring = h->ring;
+  int size;
+
+  if (*p == 0 && h->wrapped)
+    *p = h->wrap;
+  size = (int)ring[*p - 1];
+  _labHistoryApply(frame, ring + *p - size - 1, ring + *p - 1);
+  *p -= size + 2;
+}
+
+static labbool_t _labHistoryWriteBitmap(char const* path, DWORD const* pixels)
+{
+  BYTE header[54], *p;
+  DWORD size = s_globals.width * s_globals.height * sizeof(DWORD), written;
+  HANDLE file;
+  labbool_t ok;
+
+  // a top-down 32-bit bitmap keeps the pixels as they are
+  memset(header, 0, sizeof(header));
+  header[0] = 'B';
+  header[1] = 'M';
+  _labPut32(header + 2, sizeof(header) + size);
+  _labPut32(header + 10, sizeof(header));
+  p = _labPut32(header + 14, 40);
+  p = _labPut32(p, s_globals.width);
+  p = _labPut32(p, (DWORD)-s_globals.height);
+  p = _labPut16(p, 1);
+  p = _labPut16(p, 32);
+  p = _labPut32(p, BI_RGB);
+  _labPut32(p, size);
+
+  file = CreateFileA(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+    return LAB_FALSE;
+  ok = WriteFile(file, header, sizeof(header), &written, NULL) && written == sizeof(header) &&
+    WriteFile(file, pixels, size, &written, NULL) && written == size;
+  CloseHandle(file);
+  return ok;
+}
+
+labbool_t LabHistoryStart(int budget)
+{
+  int count;
+
+  LABASSERT_INIT();
+  LABASSERT(budget > 0);
+  if (s_history.last || budget <= 0)
+    return LAB_FALSE;
+
+  count = s_globals.width * s_globals.height;
+  memset(&s_history, 0, sizeof(s_history));
+  s_history.budget = budget / sizeof(DWORD);
+  s_history.ring = (DWORD*)malloc(s_history.budget * sizeof(DWORD));
+  s_history.scratch = (DWORD*)malloc((count + 1) * sizeof(DWORD));
+  s_history.last = (DWORD*)malloc(count * sizeof(DWORD));
+  if (!s_history.ring || !s_history.scratch || !s_history.last)
+  {
+    LabHistoryStop();
+    return LAB_FALSE;
+  }
+  return LAB_TRUE;
+}
+
+void LabHistoryStop(void)
+{
+  LABASSERT_INIT();
+  EnterCriticalSection(&s_globals.cs);
+  {
+    free(s_history.ring);
+    free(s_history.scratch);
+    free(s_history.last);
+    memset(&s_history, 0, sizeof(s_history));
+    LeaveCriticalSection(&s_globals.cs);
+  }
+}
+
+int LabHistoryCount(void)
+{
+  int frames;
+
+  LABASSERT_INIT();
+  EnterCriticalSection(&s_globals.cs);
+  {
+    frames = _labHistoryFrames();
+    LeaveCriticalSection(&s_globals.cs);
+  }
+  return frames;
+}
+
+labbool_t LabHistoryGetFrame(int age, labrgb_t* pixels)
+{
+  labbool_t ok;
+  int i, p;
+
+  LABASSERT_INIT();
+  LABASSERT(pixels != NULL);
+  EnterCriticalSection(&s_globals.cs);
+  {
+    ok = (age >= 0 && age < _labHistoryFrames()) ? LAB_TRUE : LAB_FALSE;
+    if (ok)
+    {
+      memcpy(pixels, s_history.last, s_globals.width * s_globals.height * sizeof(DWORD));
+      for (i = 0, p = s_history.end; i < age; i++)
+        _labHistoryStepBack(&s_history, (DWORD*)pixels, &p);
+    }
+    LeaveCriticalSection(&s_globals.cs);
+  }
+  return ok;
+}
+
+int LabHistoryDump(char const* prefix, int first, int last)
+{
+  char path[MAX_PATH];
+  labhistory_t h;
+  DWORD* frame;
+  int age, p, saved = 0;
+
+  LABASSERT_INIT();
+  LABASSERT(prefix != NULL);
+  frame = (DWORD*)malloc(s_globals.width * s_globals.height * sizeof(DWORD));
+  if (!frame)
+    return 0;
+
+  // the records and the last frame are copied under the lock, the slow disk writes go without it
+  EnterCriticalSection(&s_globals.cs);
+  {
+    h = s_history;
+    h.ring = NULL;
+    if (first < 0)
+      first = 0;
+    if (last > _labHistoryFrames() - 1)
+      last = _labHistoryFrames() - 1;
+    if (first <= last)
+    {
+      memcpy(frame, s_history.last, s_globals.width * s_globals.height * sizeof(DWORD));
+      h.ring = last > 0 ? (DWORD*)malloc(s_history.budget * sizeof(DWORD)) : NULL;
+      if (h.ring && !s_history.wrapped)
+        memcpy(h.ring + h.first, s_history.ring + h.first, (h.end - h.first) * sizeof(DWORD));
+      else if (h.ring)
+      {
+        memcpy(h.ring, s_history.ring, h.end * sizeof(DWORD));
+        memcpy(h.ring + h.first, s_history.ring + h.first, (h.wrap - h.first) * sizeof(DWORD));
+      }
+      else if (last > 0)
+        last = 0; // no memory for the copy, the last frame is still there
+    }
+    LeaveCriticalSection(&s_globals.cs);
+  }
+
+  for (age = 0, p = h.end; age <= last; age++)
+  {
+    if (age > 0)
+      _labHistoryStepBack(&h, frame, &p);
+    if (age < first)
+      continue;
+    StringCchPrintfA(path, MAX_PATH, "%s%06d.bmp", prefix, h.flushes - 1 - age);
+    if (_labHistoryWriteBitmap(path, frame))
+      saved++;
+  }
+  free(h.ring);
+  free(frame);
+  return saved;
+}
+
+void LabHistoryGetInfo(labhistoryinfo_t* info)
+{
+  LARGE_INTEGER frequency;
+
+  LABASSERT_INIT();
+  LABASSERT(info != NULL);
+  EnterCriticalSection(&s_globals.cs);
+  {
+    info->frames = _labHistoryFrames();
+    info->deltaBytes = s_history.used * sizeof(DWORD);
+    info->memoryBytes = s_history.last ?
+      (s_history.budget + 2 * s_globals.width * s_globals.height + 1) * sizeof(DWORD) : 0;
+    info->flushes = s_history.flushes;
+    QueryPerformanceFrequency(&frequency);
+    info->flushMicroseconds = s_history.flushes > 0 ?
+      (float)(s_history.ticks * 1e6 / frequency.QuadPart / s_history.flushes) : 0.0f;
+    LeaveCriticalSection(&s_globals.cs);
+  }
+}
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Terminal output
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Every character cell shows two pixels one above the other: the upper half block is painted with the
+// foreground color of the top pixel over the background color of the bottom one. The colors of the cells
+// already on the screen are kept, so that each frame only rewrites the cells that have changed.
+
+#define TERMINAL_NO_COLOR 0xFFFFFFFF /// never a pixel, makes every cell look changed
+
+static char* _labAppendText(char* p, char const* text)
+{
+  while (*text)
+    *p++ = *text++;
+  return p;
+}
+
+static char* _labAppendInt(char* p, unsigned value)
+{
+  char digits[10];
+  int n = 0;
+  do
+    digits[n++] = (char)('0' + value % 10);
+  while ((value /= 10) != 0);
+  while (n > 0)
+    *p++ = digits[--n];
+  return p;
+}
+
+static char* _labAppendColor(char* p, DWORD pixel)
+{
+  p = _labAppendInt(p, (pixel >> 16) & 0xFF);
+  *p++ = ';';
+  p = _labAppendInt(p, (pixel >> 8) & 0xFF);
+  *p++ = ';';
+  return _labAppendInt(p, pixel & 0xFF);
+}
+
+// average color of a scale x scale block of pixels, black below the buffer
+static DWORD _labTerminalSample(int x, int y)
+{
+  int i, j, scale = s_terminal.scale, count = 0;
+  DWORD const* row;
+  DWORD r = 0, g = 0, b = 0;
+
+  for (j = y; j < y + scale && j < s_globals.height; j++)
+  {
+    row = s_globals.frameBits + j * s_globals.width;
+    for (i = x; i < x + scale && i < s_globals.width; i++, count++)
+    {
+      r += (row[i] >> 16) & 0xFF;
+      g += (row[i] >> 8) & 0xFF;
+      b += row[i] & 0xFF;
+    }
+  }
+  if (count == 0)
+    return 0;
+  return ((r / count) << 16) | ((g / count) << 8) | (b / count);
+}
+
+// called by LabDrawFlush() with the buffer locked
+static void _labTerminalPresent(void)
+{
+  char* p = s_terminal.text;
+  int x, y, cursorX = -1, cursorY = -1, scale = s_terminal.scale;
+  DWORD top, bottom, fg = TERMINAL_NO_COLOR, bg = TERMINAL_NO_COLOR, written;
+  DWORD* cell;
+
+  for (y = 0; y < s_terminal.rows; y++)
+  {
+    for (x = 0; x < s_terminal.cols; x++)
+    {
+      top = _labTerminalSample(x * scale, 2 * y * scale);
+      bottom = _labTerminalSample(x * scale, (2 * y + 1) * scale);
+      cell = s_terminal.cells + 2 * (y * s_terminal.cols + x);
+      if (cell[0] == top && cell[1] == bottom)
+        continue;
+      cell[0] = top;
+      cell[1] = bottom;
+
+      // move forward on the same row, or jump to the cell (rows and columns count from 1)
+      if (y == cursorY && x > cursorX)
+      {
+        p = _labAppendText(p, "\x1B[");
+        if (x - cursorX > 1)
+          p = _labAppendInt(p, x - cursorX);
+        *p++ = 'C';
+      }
+      else if (y != cursorY || x != cursorX)
+      {
+        p = _labAppendText(p, "\x1B[");
+        p = _labAppendInt(p, y + 1);
+        *p++ = ';';
+        p = _labAppendInt(p, x + 1);
+        *p++ = 'H';
+      }
+
+      // change only the colors that differ from the previous cell
+      if (top != fg || bottom != bg)
+      {
+        p = _labAppendText(p, "\x1B[");
+        if (top != fg)
+        {
+          p = _labAppendText(p, "38;2;");
+          p = _labAppendColor(p, top);
+          if (bottom != bg)
+            *p++ = ';';
+        }
+        if (bottom != bg)
+        {
+          p = _labAppendText(p, "48;2;");
+          p = _labAppendColor(p, bottom);
+        }
+        *p++ = 'm';
+        fg = top;
+        bg = bottom;
+      }
+      p = _labAppendText(p, "\xE2\x96\x80"); // U+2580 upper half block in UTF-8
+      cursorX = x + 1;
+      cursorY = y;
+    }
+  }
+
+  if (p != s_terminal.text)
+  {
+    p = _labAppendText(p, "\x1B[0m");
+    WriteFile(s_terminal.output, s_terminal.text, (DWORD)(p - s_terminal.text), &written, NULL);
+  }
+}
+
+static DWORD WINAPI _labTerminalThreadProc(_In_ LPVOID lpParameter)
+{
+  HANDLE events[2];
+  INPUT_RECORD records[16];
+  KEY_EVENT_RECORD const* key;
+  DWORD i, count;
+  int code, n;
+
+  events[0] = s_terminal.stopEvent;
+  events[1] = s_terminal.input;
+  while (WaitForMultipleObjects(2, events, FALSE, INFINITE) == WAIT_OBJECT_0 + 1)
+  {
+    if (!ReadConsoleInput(s_terminal.input, records, sizeof(records) / sizeof(records[0]), &count))
+      break;
+    for (i = 0; i < count; i++)
+    {
+      if (records[i].EventType != KEY_EVENT || !records[i].Event.KeyEvent.bKeyDown)
+        continue;
+      key = &records[i].Event.KeyEvent;
+      code = _labKeyFromVirtual(key->wVirtualKeyCode);
+      if (!code && key->uChar.AsciiChar)
+        code = _labKeyFromChar((BYTE)key->uChar.AsciiChar);
+      for (n = 0; code && n < key->wRepeatCount; n++)
+        _labInputKeyPost(code);
+    }
+  }
+  return 0;
+}
+
+static void _labTerminalTerm(void)
+{
+  DWORD written;
+  char* p;
+
+  if (s_terminal.thread)
+  {
+    SetEvent(s_terminal.stopEvent);
+    WaitForSingleObject(s_terminal.thread, INFINITE);
+    CloseHandle(s_terminal.thread);
+    s_terminal.thread = NULL;
+  }
+  if (s_terminal.stopEvent)
+  {
+    CloseHandle(s_terminal.stopEvent);
+    s_terminal.stopEvent = NULL;
+  }
+  if (s_terminal.input)
+  {
+    SetConsoleMode(s_terminal.input, s_terminal.inputMode);
+    s_terminal.input = NULL;
+  }
+
+  // leave the picture on the screen and put the cursor below it
+  if (s_terminal.text)
+  {
+    p = _labAppendText(s_terminal.text, "\x1B[0m\x1B[");
+    p = _labAppendInt(p, s_terminal.rows + 1);
+    p = _labAppendText(p, ";1H\x1B[?25h");
+    WriteFile(s_terminal.output, s_terminal.text, (DWORD)(p - s_terminal.text), &written, NULL);
+  }
+  if (s_terminal.outputCP)
+  {
+    SetConsoleOutputCP(s_terminal.outputCP);
+    SetConsoleMode(s_terminal.output, s_terminal.outputMode);
+    s_terminal.outputCP = 0;
+  }
+  free(s_terminal.cells);
+  free(s_terminal.text);
+  s_terminal.cells = NULL;
+  s_terminal.text = NULL;
+  s_terminal.output = NULL;
+}
+
+static labbool_t _labTerminalInit(void)
+{
+  CONSOLE_SCREEN_BUFFER_INFO info;
+  int i, termCols = 80, termRows = 24;
+  DWORD mode, written;
+
+  s_terminal.output = GetStdHandle(STD_OUTPUT_HANDLE);
+  if (!s_terminal.output || s_terminal.output == INVALID_HANDLE_VALUE)
+    return LAB_FALSE;
+  // a console has to be asked to understand escape sequences and UTF-8, a file or a pipe takes them as is
+  if (GetConsoleMode(s_terminal.output, &s_terminal.outputMode))
+  {
+    s_terminal.outputCP = GetConsoleOutputCP();
+    SetConsoleMode(s_terminal.output, s_terminal.outputMode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+    SetConsoleOutputCP(CP_UTF8);
+  }
+  if (GetConsoleScreenBufferInfo(s_terminal.output, &info))
+  {
+    termCols = info.srWindow.Right - info.srWindow.Left + 1;
+    termRows = info.srWindow.Bottom - info.srWindow.Top + 1;
+  }
+
+  // shrink the picture by a whole factor to fit, keeping the last column and row free to avoid scrolling
+  termCols = max(termCols - 1, 1);
+  termRows = max(termRows - 1, 1);
+  s_terminal.scale = max((s_globals.width + termCols - 1) / termCols, (s_globals.height + 2 * termRows - 1) / (2 * termRows));
+  s_terminal.scale = max(s_terminal.scale, 1);
+  s_terminal.cols = (s_globals.width + s_terminal.scale - 1) / s_terminal.scale;
+  s_terminal.rows = (s_globals.height + 2 * s_terminal.scale - 1) / (2 * s_terminal.scale);
+
+  // a cell takes at most a jump, both colors and the block
+  s_terminal.cells = (DWORD*)malloc(2 * s_terminal.cols * s_terminal.rows * sizeof(DWORD));
+  s_terminal.text = (char*)malloc(s_terminal.cols * s_terminal.rows * 64 + 64);
+  if (!s_terminal.cells || !s_terminal.text)
+    goto on_error;
+  for (i = 0; i < 2 * s_terminal.cols * s_terminal.rows; i++)
+    s_terminal.cells[i] = TERMINAL_NO_COLOR;
+
+  // keys are read only from a console, there is nothing to wait for otherwise
+  s_terminal.input = GetStdHandle(STD_INPUT_HANDLE);
+  if (s_terminal.input && GetConsoleMode(s_terminal.input, &s_terminal.inputMode))
+  {
+    mode = s_terminal.inputMode & ~(ENABLE_LINE_INPUT | ENABLE_ECHO_INPUT | ENABLE_PROCESSED_INPUT);
+    SetConsoleMode(s_terminal.input, mode);
+    s_terminal.stopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+    if (!s_terminal.stopEvent)
+      goto on_error;
+    s_terminal.thread = CreateThread(NULL, 0, _labTerminalThreadProc, NULL, 0, NULL);
+    if (!s_terminal.thread)
+      goto on_error;
+  }
+  else
+    s_terminal.input = NULL;
+
+  // hide the cursor and start from a clean screen
+  WriteFile(s_terminal.output, "\x1B[?25l\x1B[2J", 10, &written, NULL);
+  return LAB_TRUE;
+
+on_error:
+  _labReportError();
+  _labTerminalTerm();
+  return LAB_FALSE;
+}
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Journal
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// A journal is the header (LABJ, version, width, height) followed by records. A record is the operation
+// code and its arguments. Integers are zigzag varints: 7 bits per byte, low bits first, the high bit set
+// in all bytes but the last, so that small coordinates of either sign take one or two bytes. Floats and
+// pixels are stored as is, 4 bytes little-endian. Pixels of a rectangle are runs of (count, pixel).
+
+static void _labJournalFlush(void)
+{
+  DWORD written;
+  if (s_journal.size && (!WriteFile(s_journal.file, s_journal.buffer, s_journal.size, &written, NULL) ||
+    written != (DWORD)s_journal.size))
+    s_journal.failed = LAB_TRUE;
+  s_journal.size = 0;
+}
+
+static void _labJournalInt(int value)
+{
+  unsigned u = ((unsigned)value << 1) ^ (unsigned)(value >> 31); // zigzag: 0, -1, 1, -2, ...
+  BYTE* p;
+
+  if (s_journal.size + 5 > JOURNAL_BUFFER_SIZE)
+    _labJournalFlush();
+  p = s_journal.buffer + s_journal.size;
+  for (; u >= 0x80; u >>= 7)
+    *p++ = (BYTE)(u | 0x80);
+  *p++ = (BYTE)u;
+  s_journal.size = (int)(p - s_journal.buffer);
+}
+
+static void _labJournalBytes(void const* data, int size)
+{
+  BYTE const* src = (BYTE const*)data;
+  int n;
+
+  while (size > 0)
+  {
+    if (s_journal.size == JOURNAL_BUFFER_SIZE)
+      _labJournalFlush();
+    n = JOURNAL_BUFFER_SIZE - s_journal.size;
+    if (n > size)
+      n = size;
+    memcpy(s_journal.buffer + s_journal.size, src, n);
+    s_journal.size += n;
+    src += n;
+    size -= n;
+  }
+}
+
+// a call with count int arguments
+static void _labJournalCall(int op, int count, ...)
+{
+  va_list args;
+
+  va_start(args, count);
+  _labJournalInt(op);
+  while (count-- > 0)
+    _labJournalInt(va_arg(args, int));
+  va_end(args);
+}
+
+// a call with count float arguments
+static void _labJournalCallF(int op, int count, ...)
+{
+  va_list args;
+  float value;
+
+  va_start(args, count);
+  _labJournalInt(op);
+  while (count-- > 0)
+  {
+    value = (float)va_arg(args, double);
+    _labJournalBytes(&value, sizeof(value));
+  }
+  va_end(args);
+}
+
+// vertices of a polyline or a polygon, written after the call
+static void _labJournalPoints(labpoint_t const* points, int count)
+{
+  int i;
+
+  for (i = 0; i < count; i++)
+  {
+    _labJournalInt(points[i].x);
+    _labJournalInt(points[i].y);
+  }
+}
+
+static void _labJournalPolylineF(labpointf_t const* points, int count, labbool_t closed)
+{
+  _labJournalCall(JOURNAL_DRAW_POLYLINEF, 2, count, closed);
+  _labJournalBytes(points, count * sizeof(labpointf_t));
+}
+
+static void _labJournalBezier(labpointf_t const* points, int count)
+{
+  _labJournalCall(JOURNAL_DRAW_BEZIER, 1, count);
+  _labJournalBytes(points, count * sizeof(labpointf_t));
+}
+
+static void _labJournalTriangle(labvertex_t const* vertices)
+{
+  _labJournalInt(JOURNAL_FILL_TRIANGLE);
+  _labJournalBytes(vertices, 3 * sizeof(labvertex_t));
+}
+
+static void _labJournalText(int x, int y, char const* text)
+{
+  int length = (int)strlen(text);
+
+  _labJournalCall(JOURNAL_DRAW_TEXT, 3, x, y, length);
+  _labJournalBytes(text, length);
+}
+
+static void _labJournalPixels(int x1, int y1, int x2, int y2, labrgb_t const* src, int stride)
+{
+  labrgb_t pixel = 0;
+  int x, y, run = 0;
+
+  _labJournalCall(JOURNAL_WRITE_PIXELS, 4, x1, y1, x2, y2);
+  for (y = y1; y < y2; y++, src += stride)
+    for (x = 0; x < x2 - x1; x++)
+    {
+      if (run > 0 && src[x] == pixel)
+      {
+        run++;
+        continue;
+      }
+      if (run > 0)
+      {
+        _labJournalInt(run);
+        _labJournalBytes(&pixel, sizeof(pixel));
+      }
+      pixel = src[x];
+      run = 1;
+    }
+  if (run > 0)
+  {
+    _labJournalInt(run);
+    _labJournalBytes(&pixel, sizeof(pixel));
+  }
+}
+
+// a gradient paint, written after the shape
+static void _labJournalPaint(labpaint_t const* paint)
+{
+  float values[5];
+
+  values[0] = paint->x0;
+  values[1] = paint->y0;
+  values[2] = paint->x1;
+  values[3] = paint->y1;
+  values[4] = paint->radius;
+  _labJournalInt(paint->type);
+  _labJournalBytes(values, sizeof(values));
+  _labJournalInt((int)paint->color0);
+  _labJournalInt((int)paint->color1);
+}
+
+labbool_t LabJournalStart(char const* path)
+{
+  lablayer_t const* layer;
+  int i;
+
+  LABASSERT_INIT();
+  LABASSERT(path != NULL);
+  if (s_journal.file)
+    return LAB_FALSE;
+
+  s_journal.file = CreateFileA(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (s_journal.file == INVALID_HANDLE_VALUE)
+  {
+    _labReportError();
+    s_journal.file = NULL;
+    return LAB_FALSE;
+  }
+  s_journal.failed = LAB_FALSE;
+  s_journal.size = 0;
+
+  // the replay starts from the same pictures and state, with no clipping and zero origin
+  _labJournalBytes(JOURNAL_MAGIC, 4);
+  _labJournalInt(JOURNAL_VERSION);
+  _labJournalInt(s_globals.width);
+  _labJournalInt(s_globals.height);
+  EnterCriticalSection(&s_globals.cs);
+  {
+    GdiFlush(); // let GDI finish drawing before reading
+    for (i = 0; i < LAB_LAYER_COUNT; i++)
+    {
+      layer = &s_globals.layers[i];
+      if (layer->hbm)
+      {
+        _labJournalCall(JOURNAL_SET_LAYER, 1, i);
+        _labJournalPixels(0, 0, s_globals.width, s_globals.height, (labrgb_t const*)layer->bits, s_globals.width);
+      }
+      if (!layer->visible)
+        _labJournalCall(JOURNAL_SET_LAYER_VISIBLE, 2, i, layer->visible);
+      if (layer->opacity != 255)
+        _labJournalCall(JOURNAL_SET_LAYER_OPACITY, 2, i, layer->opacity);
+    }
+    _labJournalCall(JOURNAL_SET_LAYER, 1, s_globals.layer);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+  for (i = 1; i <= s_globals.clipDepth; i++)
+  {
+    RECT const* r = (i < s_globals.clipDepth) ? &s_globals.clipStack[i] : &s_globals.clipRect;
+    _labJournalCall(JOURNAL_PUSH_CLIP, 4, r->left, r->top, r->right, r->bottom);
+  }
+  _labJournalCall(JOURNAL_SET_ORIGIN, 2, s_globals.origin.x, s_globals.origin.y);
+  if (s_globals.penColor == LABCOLOR_NA)
+    _labJournalCall(JOURNAL_SET_COLOR_RGB, 3, GetRValue(s_globals.penColorRGB), GetGValue(s_globals.penColorRGB),
+      GetBValue(s_globals.penColorRGB));
+  else
+    _labJournalCall(JOURNAL_SET_COLOR, 1, s_globals.penColor);
+  _labJournalCall(JOURNAL_SET_BLEND, 1, s_globals.blend);
+  _labJournalCall(JOURNAL_SET_ALPHA, 1, s_globals.alpha);
+  // the depths are not recorded, the replay starts with a clear depth buffer
+  if (s_depth.bits)
+    _labJournalCall(JOURNAL_DEPTH_START, 1, s_depth.bits);
+  return LAB_TRUE;
+}
+
+labbool_t LabJournalStop(void)
+{
+  labbool_t ok;
+
+  LABASSERT_INIT();
+  if (!s_journal.file)
+    return LAB_FALSE;
+  _labJournalFlush();
+  ok = !s_journal.failed;
+  if (!CloseHandle(s_journal.file))
+    ok = LAB_FALSE;
+  s_journal.file = NULL;
+  return ok;
+}
+
+typedef struct labjournalreader_t
+{
+  BYTE const* p;        // next byte to read
+  BYTE const* end;      // end of the journal
+  labbool_t bad;        // the journal has ended in the middle of a record or makes no sense
+  void* scratch;        // space for points, text and pixels of the current record
+  int capacity;         // size of scratch in bytes
+} labjournalreader_t;
+
+static int _labJournalGetInt(labjournalreader_t* r)
+{
+  unsigned u = 0;
+  int shift = 0;
+
+  do
+  {
+    if (r->p >= r->end || shift > 28)
+    {
+      r->bad = LAB_TRUE;
+      return 0;
+    }
+    u |= (unsigned)(*r->p & 0x7F) << shift;
+    shift += 7;
+  } while (*r->p++ & 0x80);
+  return (int)(u >> 1) ^ -(int)(u & 1);
+}
+
+static BYTE const* _labJournalGetBytes(labjournalreader_t* r, int size)
+{
+  BYTE const* p = r->p;
+  if (r->bad || size < 0 || size > r->end - r->p)
+  {
+    r->bad = LAB_TRUE;
+    return NULL;
+  }
+  r->p += size;
+  return p;
+}
+
+static float _labJournalGetFloat(labjournalreader_t* r)
+{
+  float value = 0.0f;
+  BYTE const* p = _labJournalGetBytes(r, sizeof(value));
+  if (p)
+    memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+static labrgb_t _labJournalGetPixel(labjournalreader_t* r)
+{
+  labrgb_t pixel = 0;
+  BYTE const* p = _labJournalGetBytes(r, sizeof(pixel));
+  if (p)
+    memcpy(&pixel, p, sizeof(pixel));
+  return pixel;
+}
+
+// at least size bytes of scratch space, NULL if there is no memory
+static void* _labJournalGetScratch(labjournalreader_t* r, int size)
+{
+  void* scratch;
+
+  if (r->bad)
+    return NULL;
+  if (size > r->capacity)
+  {
+    scratch = realloc(r->scratch, size);
+    if (!scratch)
+    {
+      r->bad = LAB_TRUE;
+      return NULL;
+    }
+    r->scratch = scratch;
+    r->capacity = size;
+  }
+  return r->scratch;
+}
+
+// count vertices in the scratch space, NULL if they cannot be read
+static labpoint_t* _labJournalGetPoints(labjournalreader_t* r, int count)
+{
+  labpoint_t* points;
+  int i;
+
+  // every point takes two bytes at least, a broken count should not ask for much memory
+  if (count < 0 || count > (r->end - r->p) / 2)
+    r->bad = LAB_TRUE;
+  points = (labpoint_t*)_labJournalGetScratch(r, count * sizeof(labpoint_t));
+  if (!points)
+    return NULL;
+  for (i = 0; i < count; i++)
+  {
+    points[i].x = _labJournalGetInt(r);
+    points[i].y = _labJournalGetInt(r);
+  }
+  return r->bad ? NULL : points;
+}
+
+static void _labJournalReplayPolyline(labjournalreader_t* r)
+{
+  labpoint_t* points;
+  int count = _labJournalGetInt(r);
+  labbool_t closed = _labJournalGetInt(r);
+
+  points = _labJournalGetPoints(r, count);
+  if (points)
+    LabDrawPolyline(points, count, closed);
+}
+
+static void _labJournalReplayPolylineRGB(labjournalreader_t* r)
+{
+  labpoint_t* points;
+  int count = _labJournalGetInt(r);
+  labbool_t closed = _labJournalGetInt(r);
+  labrgb_t color = (labrgb_t)_labJournalGetInt(r);
+
+  points = _labJournalGetPoints(r, count);
+  if (points)
+    LabDrawPolylineRGB(points, count, closed, color);
+}
+
+static void _labJournalReplayPolylineF(labjournalreader_t* r)
+{
+  labpointf_t* points;
+  BYTE const* data;
+  int count = _labJournalGetInt(r);
+  labbool_t closed = _labJournalGetInt(r);
+
+  if (count < 0 || count > (r->end - r->p) / (int)sizeof(labpointf_t))
+    r->bad = LAB_TRUE;
+  points = (labpointf_t*)_labJournalGetScratch(r, count * sizeof(labpointf_t));
+  data = _labJournalGetBytes(r, count * sizeof(labpointf_t));
+  if (!points || !data)
+    return;
+  memcpy(points, data, count * sizeof(labpointf_t));
+  LabDrawPolylineF(points, count, closed);
+}
+
+static void _labJournalReplayBezier(labjournalreader_t* r)
+{
+  labpointf_t points[4];
+  int i, count = _labJournalGetInt(r);
+
+  if (count != 3 && count != 4)
+    r->bad = LAB_TRUE;
+  for (i = 0; i < count && !r->bad; i++)
+  {
+    points[i].x = _labJournalGetFloat(r);
+    points[i].y = _labJournalGetFloat(r);
+  }
+  if (!r->bad)
+    LabDrawBezier(points, count);
+}
+
+static void _labJournalReplayTriangle(labjournalreader_t* r)
+{
+  labvertex_t vertices[3];
+  BYTE const* data = _labJournalGetBytes(r, sizeof(vertices));
+
+  if (!data)
+    return;
+  memcpy(vertices, data, sizeof(vertices));
+  LabFillTriangle(vertices);
+}
+
+static void _labJournalReplayText(labjournalreader_t* r)
+{
+  char* text;
+  BYTE const* data;
+  int x = _labJournalGetInt(r);
+  int y = _labJournalGetInt(r);
+  int length = _labJournalGetInt(r);
+
+  data = _labJournalGetBytes(r, length);
+  text = (char*)_labJournalGetScratch(r, length + 1);
+  if (!data || !text)
+    return;
+  memcpy(text, data, length);
+  text[length] = '\0';
+  LabDrawText(x, y, text);
+}
+
+// pixels go row by row, so that a huge rectangle of a few runs does not need much memory
+static void _labJournalReplayPixels(labjournalreader_t* r)
+{
+  labrect_t rect;
+  labrgb_t* row;
+  labrgb_t pixel = 0;
+  int x, width, bottom, run = 0;
+
+  rect.left = _labJournalGetInt(r);
+  rect.top = _labJournalGetInt(r);
+  rect.right = _labJournalGetInt(r);
+  bottom = _labJournalGetInt(r);
+  width = rect.right - rect.left;
+  if (width < 0 || width > 0xFFFF || bottom < rect.top || bottom - rect.top > 0xFFFF)
+    r->bad = LAB_TRUE;
+  row = (labrgb_t*)_labJournalGetScratch(r, width * sizeof(labrgb_t));
+  for (; row && rect.top < bottom; rect.top++)
+  {
+    for (x = 0; x < width; x++, run--)
+    {
+      if (run == 0)
+      {
+        run = _labJournalGetInt(r);
+        pixel = _labJournalGetPixel(r);
+        if (r->bad || run <= 0)
+        {
+          r->bad = LAB_TRUE;
+          return;
+        }
+      }
+      row[x] = pixel;
+    }
+    rect.bottom = rect.top + 1;
+    LabWritePixels(&rect, row, width);
+  }
+  if (run != 0)
+    r->bad = LAB_TRUE;
+}
+
+static void _labJournalReplayFloodFill(labjournalreader_t* r)
+{
+  labfillparams_t params;
+  int x = _labJournalGetInt(r);
+  int y = _labJournalGetInt(r);
+  labrgb_t color = (labrgb_t)_labJournalGetInt(r);
+
+  params.tolerance = _labJournalGetInt(r);
+  params.diagonal = _labJournalGetInt(r);
+  if (!r->bad)
+    LabFloodFillWith(x, y, color, &params);
+}
+
+static void _labJournalReplayCopyRect(labjournalreader_t* r)
+{
+  labrect_t rect;
+  int x, y;
+
+  rect.left = _labJournalGetInt(r);
+  rect.top = _labJournalGetInt(r);
+  rect.right = _labJournalGetInt(r);
+  rect.bottom = _labJournalGetInt(r);
+  x = _labJournalGetInt(r);
+  y = _labJournalGetInt(r);
+  if (!r->bad)
+    LabCopyRect(&rect, x, y);
+}
+
+static void _labJournalGetPaint(labjournalreader_t* r, labpaint_t* paint)
+{
+  memset(paint, 0, sizeof(*paint));
+  paint->type = (labpainttype_t)_labJournalGetInt(r);
+  paint->x0 = _labJournalGetFloat(r);
+  paint->y0 = _labJournalGetFloat(r);
+  paint->x1 = _labJournalGetFloat(r);
+  paint->y1 = _labJournalGetFloat(r);
+  paint->radius = _labJournalGetFloat(r);
+  paint->color0 = (labrgb_t)_labJournalGetInt(r);
+  paint->color1 = (labrgb_t)_labJournalGetInt(r);
+  // callbacks are recorded as pixels
+  if (paint->type != LABPAINT_LINEAR && paint->type != LABPAINT_RADIAL)
+    r->bad = LAB_TRUE;
+}
+
+static void _labJournalReplayFillPolygon(labjournalreader_t* r)
+{
+  labpaint_t paint;
+  labpoint_t* points;
+  int count = _labJournalGetInt(r);
+
+  points = _labJournalGetPoints(r, count);
+  if (!points)
+    return;
+  _labJournalGetPaint(r, &paint);
+  if (!r->bad)
+    LabFillPolygon(points, count, &paint);
+}
+
+// replay one record, the arguments of the calls are read before the call in the order they are written
+static void _labJournalReplayRecord(labjournalreader_t* r)
+{
+  labpaint_t paint;
+  int a, b, c, d, e;
+  float fa, fb, fc, fd, fe;
+
+  switch (_labJournalGetInt(r))
+  {
+  case JOURNAL_CLEAR_WITH:
+    a = _labJournalGetInt(r);
+    if (!r->bad && a >= 0 && a < LABCOLOR_COUNT)
+      LabClearWith(a);
+    else
+      r->bad = LAB_TRUE;
+    break;
+  case JOURNAL_SET_COLOR:
+    a = _labJournalGetInt(r);
+    if (!r->bad && a >= 0 && a < LABCOLOR_COUNT)
+      LabSetColor(a);
+    else
+      r->bad = LAB_TRUE;
+    break;
+  case JOURNAL_SET_COLOR_RGB:
+    a = _labJournalGetInt(r); b = _labJournalGetInt(r); c = _labJournalGetInt(r);
+    if (!r->bad)
+      LabSetColorRGB(a, b, c);
+    break;
+  case JOURNAL_DRAW_LINE:
+    a = _labJournalGetInt(r); b = _labJournalGetInt(r); c = _labJournalGetInt(r); d = _labJournalGetInt(r);
+    if (!r->bad)
+      LabDrawLine(a, b, c, d);
+    break;
+  case JOURNAL_DRAW_POINT:
+    a = _labJournalGetInt(r); b = _labJournalGetInt(r);
+    if (!r->bad)
+      LabDrawPoint(a, b);
+    break;
+  case JOURNAL_DRAW_RECTANGLE:
+    a = _labJournalGetInt(r); b = _labJournalGetInt(r); c = _labJournalGetInt(r); d = _labJournalGetInt(r);
+    if (!r->bad)
+      LabDrawRectangle(a, b, c, d);
+    break;
+  case JOURNAL_DRAW_CIRCLE:
+    a = _labJournalGetInt(r); b = _labJournalGetInt(r); c = _labJournalGetInt(r);
+    if (!r->bad)
+      LabDrawCircle(a, b, c);
+    break;
+  case JOURNAL_DRAW_ELLIPSE:
+    a = _labJournalGetInt(r); b = _labJournalGetInt(r); c = _labJournalGetInt(r); d = _labJournalGetInt(r);
+    if (!r->bad)
+      LabDrawEllipse(a, b, c, d);
+    break;
+  case JOURNAL_DRAW_POLYLINE:
+    _labJournalReplayPolyline(r);
+    break;
+  case JOURNAL_DRAW_POINTF:
+    fa = _labJournalGetFloat(r); fb = _labJournalGetFloat(r);
+    if (!r->bad)
+      LabDrawPointF(fa, fb);
+    break;
+  case JOURNAL_DRAW_LINEF:
+    fa = _labJournalGetFloat(r); fb = _labJournalGetFloat(r); fc = _labJournalGetFloat(r); fd = _labJournalGetFloat(r);
+    if (!r->bad)
+      LabDrawLineF(fa, fb, fc, fd);
+    break;
+  case JOURNAL_DRAW_POLYLINEF:
+    _labJournalReplayPolylineF(r);
+    break;
+  case JOURNAL_DRAW_CIRCLEF:
+    fa = _labJournalGetFloat(r); fb = _labJournalGetFloat(r); fc = _labJournalGetFloat(r);
+    if (!r->bad)
+      LabDrawCircleF(fa, fb, fc);
+    break;
+  case JOURNAL_DRAW_BEZIER:
+    _labJournalReplayBezier(r);
+    break;
+  case JOURNAL_DRAW_ARC:
+    fa = _labJournalGetFloat(r); fb = _labJournalGetFloat(r); fc = _labJournalGetFloat(r); fd = _labJournalGetFloat(r);
+    fe = _labJournalGetFloat(r);
+    if (!r->bad)
+      LabDrawArc(fa, fb, fc, fd, fe);
+    break;
+  case JOURNAL_SET_BLEND:
+    a = _labJournalGetInt(r);
+    if (!r->bad && a >= LABBLEND_ALPHA && a <= LABBLEND_XOR)
+      LabSetBlend(a);
+    else
+      r->bad = LAB_TRUE;
+    break;
+  case JOURNAL_SET_ALPHA:
+    a = _labJournalGetInt(r);
+    if (!r->bad)
+      LabSetAlpha(a);
+    break;
+  case JOURNAL_FILL_TRIANGLE:
+    _labJournalReplayTriangle(r);
+    break;
+  case JOURNAL_DEPTH_START:
+    a = _labJournalGetInt(r);
+    if (!r->bad && (a == 16 || a == 32))
+      LabDepthStart(a);
+    else
+      r->bad = LAB_TRUE;
+    break;
+  case JOURNAL_DEPTH_STOP:
+    LabDepthStop();
+    break;
+  case JOURNAL_DEPTH_CLEAR:
+    LabDepthClear();
+    break;
+  case JOURNAL_DRAW_TEXT:
+    _labJournalReplayText(r);
+    break;
+  case JOURNAL_PUSH_CLIP:
+    a = _labJournalGetInt(r); b = _labJournalGetInt(r); c = _labJournalGetInt(r); d = _labJournalGetInt(r);
+    if (!r->bad && s_globals.clipDepth < CLIP_STACK_SIZE)
+      LabPushClip(a, b, c, d);
+    break;
+  case JOURNAL_POP_CLIP:
+    if (s_globals.clipDepth > 0)
+      LabPopClip();
+    break;
+  case JOURNAL_SET_ORIGIN:
+    a = _labJournalGetInt(r); b = _labJournalGetInt(r);
+    if (!r->bad)
+      LabSetOrigin(a, b);
+    break;
+  case JOURNAL_DRAW_FLUSH:
+    LabDrawFlush();
+    break;
+  case JOURNAL_FLOOD_FILL:
+    _labJournalReplayFloodFill(r);
+    break;
+  case JOURNAL_WRITE_PIXELS:
+    _labJournalReplayPixels(r);
+    break;
+  case JOURNAL_CLEAR:
+    LabClear();
+    break;
+  case JOURNAL_SET_LAYER:
+    a = _labJournalGetInt(r);
+    if (!r->bad && a >= 0 && a < LAB_LAYER_COUNT)
+      LabSetLayer(a);
+    else
+      r->bad = LAB_TRUE;
+    break;
+  case JOURNAL_SET_LAYER_VISIBLE:
+    a = _labJournalGetInt(r); b = _labJournalGetInt(r);
+    if (!r->bad && a >= 0 && a < LAB_LAYER_COUNT)
+      LabSetLayerVisible(a, b);
+    else
+      r->bad = LAB_TRUE;
+    break;
+  case JOURNAL_SET_LAYER_OPACITY:
+    a = _labJournalGetInt(r); b = _labJournalGetInt(r);
+    if (!r->bad && a >= 0 && a < LAB_LAYER_COUNT)
+      LabSetLayerOpacity(a, b);
+    else
+      r->bad = LAB_TRUE;
+    break;
+  case JOURNAL_COPY_RECT:
+    _labJournalReplayCopyRect(r);
+    break;
+  case JOURNAL_SCROLL:
+    a = _labJournalGetInt(r); b = _labJournalGetInt(r); c = _labJournalGetInt(r);
+    if (!r->bad)
+      LabScroll(a, b, (labrgb_t)c);
+    break;
+  case JOURNAL_FILL_RECT:
+    a = _labJournalGetInt(r); b = _labJournalGetInt(r); c = _labJournalGetInt(r); d = _labJournalGetInt(r);
+    _labJournalGetPaint(r, &paint);
+    if (!r->bad)
+      LabFillRect(a, b, c, d, &paint);
+    break;
+  case JOURNAL_FILL_CIRCLE:
+    a = _labJournalGetInt(r); b = _labJournalGetInt(r); c = _labJournalGetInt(r);
+    _labJournalGetPaint(r, &paint);
+    if (!r->bad)
+      LabFillCircle(a, b, c, &paint);
+    break;
+  case JOURNAL_FILL_POLYGON:
+    _labJournalReplayFillPolygon(r);
+    break;
+  case JOURNAL_DRAW_POINT_RGB:
+    a = _labJournalGetInt(r); b = _labJournalGetInt(r); c = _labJournalGetInt(r);
+    if (!r->bad)
+      LabDrawPointRGB(a, b, (labrgb_t)c);
+    break;
+  case JOURNAL_DRAW_LINE_RGB:
+    a = _labJournalGetInt(r); b = _labJournalGetInt(r); c = _labJournalGetInt(r); d = _labJournalGetInt(r);
+    e = _labJournalGetInt(r);
+    if (!r->bad)
+      LabDrawLineRGB(a, b, c, d, (labrgb_t)e);
+    break;
+  case JOURNAL_DRAW_RECTANGLE_RGB:
+    a = _labJournalGetInt(r); b = _labJournalGetInt(r); c = _labJournalGetInt(r); d = _labJournalGetInt(r);
+    e = _labJournalGetInt(r);
+    if (!r->bad)
+      LabDrawRectangleRGB(a, b, c, d, (labrgb_t)e);
+    break;
+  case JOURNAL_DRAW_POLYLINE_RGB:
+    _labJournalReplayPolylineRGB(r);
+    break;
+  case JOURNAL_INPUT_KEY:
+  case JOURNAL_INPUT_KEY_READY:
+  case JOURNAL_DELAY:
+    // the program has already made its decisions, no need to wait for anything
+    _labJournalGetInt(r);
+    break;
+  default:
+    r->bad = LAB_TRUE;
+    break;
+  }
+}
+
+labbool_t LabJournalReplay(char const* path)
+{
+  HANDLE file;
+  DWORD size, read;
+  BYTE* data = NULL;
+  BYTE const* magic;
+  labjournalreader_t r;
+  labbool_t ok;
+
+  LABASSERT_INIT();
+  LABASSERT(path != NULL);
+
+  file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    _labReportError();
+    return LAB_FALSE;
+  }
+  size = GetFileSize(file, NULL);
+  if (size != INVALID_FILE_SIZE)
+    data = (BYTE*)malloc(size ? size : 1);
+  ok = (data && ReadFile(file, data, size, &read, NULL) && read == size) ? LAB_TRUE : LAB_FALSE;
+  CloseHandle(file);
+  if (!ok)
+  {
+    free(data);
+    return LAB_FALSE;
+  }
+
+  r.p = data;
+  r.end = data + size;
+  r.bad = LAB_FALSE;
+  r.scratch = NULL;
+  r.capacity = 0;
+  magic = _labJournalGetBytes(&r, 4);
+  if (!magic || memcmp(magic, JOURNAL_MAGIC, 4) != 0 || _labJournalGetInt(&r) != JOURNAL_VERSION ||
+    _labJournalGetInt(&r) != s_globals.width || _labJournalGetInt(&r) != s_globals.height)
+    r.bad = LAB_TRUE;
+
+  // the recorded state goes right after the header and expects no clipping, zero origin, no blending
+  // and no depth test
+  if (!r.bad)
+  {
+    _labDepthFree();
+    _labResetClip();
+    _labApplyClip();
+    s_globals.blend = LABBLEND_ALPHA;
+    s_globals.alpha = 255;
+    _labUpdateBlending();
+  }
+  while (!r.bad && r.p < r.end)
+    _labJournalReplayRecord(&r);
+
+  free(r.scratch);
+  free(data);
+  return r.bad ? LAB_FALSE : LAB_TRUE;
+}
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Window procedure
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static LRESULT CALLBACK _labWindowProc(_In_ HWND hwnd, _In_ UINT uMsg, _In_ WPARAM wParam, _In_ LPARAM lParam)
+{
+  LRESULT ret = 0;
+
+#define HANDLE_MESSAGE(msg, func) \
+  case msg: \
+  ret = func(hwnd, uMsg, wParam, lParam); \
+  break;
+
+  switch (uMsg)
+  {
+    HANDLE_MESSAGE(WM_CLOSE, _onClose);
+    HANDLE_MESSAGE(WM_DESTROY, _onDestroy);
+    HANDLE_MESSAGE(WM_PAINT, _onPaint);
+    HANDLE_MESSAGE(WM_KEYDOWN, _onKeydown);
+    HANDLE_MESSAGE(WM_CHAR, _onChar);
+    HANDLE_MESSAGE(WM_LABKEY, _onLabKey);
+
+  default:
+    return DefWindowProc(hwnd, uMsg, wParam, lParam);
+  }
+
+#undef HANDLE_MESSAGE
+
+  return 0;
+}
+
+static HWND _labCreateWindow(void)
+{
+  static LPCTSTR MY_CLASS_NAME = TEXT("LabWindowClass");
+  static LPCTSTR MY_WINDOW_NAME = TEXT("Lab Graphics");
+  WNDCLASSEX wcex;
+  HWND hwnd = NULL;
+  RECT rc = {0, 0, _labGetWindowWidth(), _labGetWindowHeight()};
+  DWORD style = (WS_OVERLAPPEDWINDOW  & ~WS_THICKFRAME  & ~WS_MAXIMIZEBOX) | WS_VISIBLE; /*disable maximize and sising button*/
+  HINSTANCE hInstance = GetModuleHandle(0);
+
+  // Register class
+  wcex.cbSize = sizeof(WNDCLASSEX);
+  wcex.style = CS_HREDRAW | CS_VREDRAW | CS_NOCLOSE; /*disable [X]*/
+  wcex.lpfnWndProc = _labWindowProc;
+  wcex.cbClsExtra = 0;
+  wcex.cbWndExtra = 0;
+  wcex.hInstance = hInstance;
+  wcex.hIcon = LoadIcon(hInstance, IDI_APPLICATION);
+  wcex.hCursor = LoadCursor(NULL, IDC_ARROW);
+  wcex.hbrBackground = (HBRUSH)(COLOR_WINDOW + 1);
+  wcex.lpszMenuName = NULL;
+  wcex.lpszClassName = MY_CLASS_NAME;
+  wcex.hIconSm = LoadIcon(wcex.hInstance, IDI_APPLICATION);
+  if (!RegisterClassEx(&wcex))
+  {
+    _labReportError();
+    return NULL;
+  }
+    
+  // create window
+  AdjustWindowRect(&rc, style, FALSE);
+  hwnd = CreateWindow(MY_CLASS_NAME, MY_WINDOW_NAME, style,
+    CW_USEDEFAULT, CW_USEDEFAULT, rc.right - rc.left, rc.bottom - rc.top, NULL, NULL, hInstance, NULL);
+  if (hwnd == NULL)
+    _labReportError();
+  return hwnd;
+}
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Frame buffer
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// create a 32-bit top-down DIB section, so that both GDI and the code here can draw into it
+static labbool_t _labCreateBitmap(HDC hdc, HBITMAP* hbm, HDC* hbmdc, DWORD** bits)
+{
+  BITMAPINFO bmi;
+
+  ZeroMemory(&bmi, sizeof(bmi));
+  bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+  bmi.bmiHeader.biWidth = s_globals.width;
+  bmi.bmiHeader.biHeight = -s_globals.height; // negative height means top-down rows
+  bmi.bmiHeader.biPlanes = 1;
+  bmi.bmiHeader.biBitCount = 32;
+  bmi.bmiHeader.biCompression = BI_RGB;
+
+  *hbmdc = CreateCompatibleDC(hdc);
+  if (!*hbmdc)
+  {
+    SetLastError(ERROR_INVALID_HANDLE);
+    _labReportError();
+    return LAB_FALSE;
+  }
+  *hbm = CreateDIBSection(*hbmdc, &bmi, DIB_RGB_COLORS, (void**)bits, NULL, 0);
+  if (!*hbm)
+  {
+    SetLastError(ERROR_INVALID_HANDLE);
+    _labReportError();
+    DeleteDC(*hbmdc);
+    *hbmdc = NULL;
+    return LAB_FALSE;
+  }
+  SelectObject(*hbmdc, *hbm);
+
+  // initialize pen and background colors
+  SelectObject(*hbmdc, GetStockObject(WHITE_PEN));
+  SelectObject(*hbmdc, GetStockObject(BLACK_BRUSH));
+  return LAB_TRUE;
+}
+
+static void _labDestroyBitmap(HBITMAP* hbm, HDC* hbmdc, DWORD** bits)
+{
+  if (*hbmdc)
+  {
+    DeleteDC(*hbmdc);
+    *hbmdc = NULL;
+  }
+  if (*hbm)
+  {
+    DeleteObject(*hbm);
+    *hbm = NULL;
+  }
+  *bits = NULL;
+}
+
+static labbool_t _labCreateBuffer(HDC hdc)
+{
+  lablayer_t* layer;
+  int i;
+
+  if (!_labCreateBitmap(hdc, &s_globals.hbm, &s_globals.hbmdc, &s_globals.bits))
+    return LAB_FALSE;
+
+  // layer 0 is the buffer, and it is shown as is until other layers appear
+  for (i = 0; i < LAB_LAYER_COUNT; i++)
+  {
+    layer = &s_globals.layers[i];
+    ZeroMemory(layer, sizeof(*layer));
+    layer->visible = LAB_TRUE;
+    layer->opacity = 255;
+  }
+  layer = &s_globals.layers[0];
+  layer->hbm = s_globals.hbm;
+  layer->hbmdc = s_globals.hbmdc;
+  layer->bits = s_globals.bits;
+  SetRect(&layer->used, 0, 0, s_globals.width, s_globals.height);
+  s_globals.layer = 0;
+  s_globals.penPending = LAB_TRUE;
+  s_globals.frameHbm = NULL;
+  s_globals.frameDC = s_globals.hbmdc;
+  s_globals.frameBits = s_globals.bits;
+
+  // the whole buffer is visible
+  s_globals.clipRgn = CreateRectRgn(0, 0, s_globals.width, s_globals.height);
+  SelectClipRgn(s_globals.hbmdc, s_globals.clipRgn);
+  return LAB_TRUE;
+}
+
+static void _labDestroyBuffer(void)
+{
+  int i;
+
+  for (i = 0; i < LAB_LAYER_COUNT; i++)
+    _labDestroyBitmap(&s_globals.layers[i].hbm, &s_globals.layers[i].hbmdc, &s_globals.layers[i].bits);
+  if (s_globals.frameHbm)
+    _labDestroyBitmap(&s_globals.frameHbm, &s_globals.frameDC, &s_globals.frameBits);
+  if (s_globals.clipRgn)
+  {
+    DeleteObject(s_globals.clipRgn);
+    s_globals.clipRgn = NULL;
+  }
+  s_globals.hbm = NULL;
+  s_globals.hbmdc = NULL;
+  s_globals.bits = NULL;
+  s_globals.frameDC = NULL;
+  s_globals.frameBits = NULL;
+  s_globals.layer = 0;
+}
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Thread procedure
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static DWORD WINAPI _labThreadProc(_In_ LPVOID lpParameter)
+{
+  HDC hdc;
+
+  // create window
+  s_globals.hwnd = _labCreateWindow();
+  if (s_globals.hwnd == NULL)
+    _labReportError();
+
+  // create semaphore object
+  s_globals.ghSemaphore = CreateSemaphore( 
+        NULL,           // default security attributes
+        0,              // initial count
+        MAX_SEM_COUNT,  // maximum count
+        NULL);          // unnamed semaphore
+
+  if (s_globals.ghSemaphore == NULL)
+    _labReportError();
+
+  // create second frame buffer
+  hdc = GetDC(s_globals.hwnd);
+  _labCreateBuffer(hdc);
+  ReleaseDC(s_globals.hwnd, hdc);
+
+  InitializeCriticalSection(&s_globals.cs);
+
+  // require to update the entire window first
+  SetRect(&s_globals.updateRect, 0, 0, s_globals.width, s_globals.height);
+  InvalidateRect(s_globals.hwnd, NULL, TRUE);
+
+  // synchronize with the main thread
+  SetEvent(s_globals.syncEvent);
+  if (!s_globals.hwnd)
+  {
+    _labReportError();
+    return 1;
+  }
+
+  // message loop
+  {
+    MSG msg;
+    BOOL ret;
+    while ((ret = GetMessage(&msg, NULL, 0, 0)) != 0)
+    {
+      if (ret > 0)
+      {
+        TranslateMessage(&msg); 
+        DispatchMessage(&msg);
+      }
+      else
+      {
+        _labReportError();
+        break;
+      }
+    }
+  }
+
+  // exit thread
+  return 0;
+}
+
+
+
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//   Initialization and termination routines
+// ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+static void _labThreadCleanup(void)
+{
+  DWORD res;
+  if (s_globals.thread != NULL)
+  {
+    // destroy the thread
+    res = CloseHandle(s_globals.thread);
+    if (!res)
+      _labReportError();
+    s_globals.thread = NULL;
+    s_globals.threadId = ~0;
+  }
+
+  // destroy the synchronization object
+  if (s_globals.syncEvent)
+  {
+    res = CloseHandle(s_globals.syncEvent);
+    if (!res)
+      _labReportError();
+    s_globals.syncEvent = NULL;
+  }
+}
+
+labbool_t LabInit(void)
+{
+  labparams_t params;
+
+  params.width = 640;
+  params.height = 480;
+  params.scale = 1;
+
+  return LabInitWith(&params);
+}
+
+labbool_t LabInitWith(labparams_t const* params)
+{
+  return LabInitWithFlags(params, LABFLAG_NONE);
+}
+
+labbool_t LabInitWithFlags(labparams_t const* params, unsigned flags)
+{
+  DWORD res;
+  LPTHREAD_START_ROUTINE lpStartAddress = NULL;
+
+  // do not initialize twice
+  LABASSERT(!s_globals.init);
+  if (s_globals.init)
+    return LAB_FALSE;
+
+  LABASSERT((params->width > 0) && (params->height > 0));
+  LABASSERT(params->scale > 0);
+  s_globals.width = params->width;
+  s_globals.height = params->height;
+  s_globals.scale = params->scale;
+  s_globals.flags = flags;
+  if (s_globals.flags & LABFLAG_TERMINAL)
+    s_globals.flags |= LABFLAG_HEADLESS; // the terminal takes the place of the window
+
+  SetRectEmpty(&s_globals.updateRect);
+  _labResetClip();
+  _labRunReset();
+  _labLatencyReset();
+  s_globals.blend = LABBLEND_ALPHA;
+  s_globals.alpha = 255;
+  _labUpdateBlending();
+
+  // initialize colors
+  _labInitColors();
+
+  // without a window there is no need for the message thread, draw right here
+  if (s_globals.flags & LABFLAG_HEADLESS)
+  {
+    s_globals.ghSemaphore = CreateSemaphore(NULL, 0, MAX_SEM_COUNT, NULL);
+    if (!s_globals.ghSemaphore)
+      goto on_error;
+    if (!_labCreateBuffer(NULL))
+      goto on_error;
+    InitializeCriticalSection(&s_globals.cs);
+    if ((s_globals.flags & LABFLAG_TERMINAL) && !_labTerminalInit())
+    {
+      DeleteCriticalSection(&s_globals.cs);
+      goto on_error;
+    }
+
+    s_globals.init = LAB_TRUE;
+    LabSetColor(LABCOLOR_WHITE);
+    return LAB_TRUE;
+  }
+
+  // create synchronization object
+  s_globals.syncEvent = CreateEvent(NULL, FALSE, FALSE, TEXT("LabSyncEvent"));
+  if (!s_globals.syncEvent)
+    goto on_error;
+
+  // create thread for message processing and run it
+  if (_labThreadProc == NULL)
+  {
+    SetLastError(ERROR_INVALID_HANDLE);
+    goto on_error;
+  }
+  s_globals.thread = CreateThread(NULL, 0, _labThreadProc , NULL, 0, &s_globals.threadId);
+  if (!s_globals.thread)
+    goto on_error;
+
+  // wait until the window is created in another thread
+  res = WaitForSingleObject(s_globals.syncEvent, INFINITE);
+  if ((!s_globals.hwnd) || (res == WAIT_FAILED))
+    goto on_error;
+
+  // successfully initialized
+  s_globals.init = LAB_TRUE;
+
+  // set defaults now
+  LabSetColor(LABCOLOR_WHITE);
+
+  return LAB_TRUE;
+
+on_error:
+  _labThreadCleanup();
+  _labReportError();
+  if (s_globals.flags & LABFLAG_HEADLESS)
+  {
+    _labDestroyBuffer();
+    if (s_globals.ghSemaphore)
+      CloseHandle(s_globals.ghSemaphore);
+    s_globals.ghSemaphore = NULL;
+  }
+  return LAB_FALSE;
+}
+
+void LabTerm(void)
+{
+  DWORD res;
+
+  if (!s_globals.init)
+    return;
+
+  LabJournalStop();
+  LabServerStop();
+  LabShareStop();
+  LabHistoryStop();
+  _labSpriteFree();
+  _labDepthFree();
+  if (s_globals.flags & LABFLAG_HEADLESS)
+  {
+    if (s_globals.flags & LABFLAG_TERMINAL)
+      _labTerminalTerm();
+    _labDestroyBuffer();
+    DeleteCriticalSection(&s_globals.cs);
+    CloseHandle(s_globals.ghSemaphore);
+    s_globals.ghSemaphore = NULL;
+    s_globals.init = LAB_FALSE;
+    return;
+  }
+
+  s_globals.quit = LAB_TRUE;
+
+  // request the thread to terminate by closing the window
+  _ASSERT(s_globals.hwnd != NULL);
+  PostMessage(s_globals.hwnd, WM_CLOSE, 0, 0);
+
+  // wait for the thread to finish
+  _ASSERT(s_globals.thread);
+  res = WaitForSingleObject(s_globals.thread, INFINITE); // todo: get rid of INFINITE [9/30/2013 paul.smirnov]
+  if (res == WAIT_FAILED)
+    _labReportError();
+  // done
+  _labThreadCleanup();
+  s_globals.init = LAB_FALSE;
+}
+
+void LabDelay(int time)
+{
+  LABASSERT_INIT();
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_DELAY, 1, time);
+  Sleep(time);
+}
+
+int LabGetWidth(void)
+{
+  LABASSERT_INIT();
+  return s_globals.width;
+}
+
+static __inline int _labGetWindowWidth(void)
+{
+  return s_globals.width * s_globals.scale;
+}
+
+int LabGetHeight(void)
+{
+  LABASSERT_INIT();
+  return s_globals.height;
+}
+
+static __inline int _labGetWindowHeight(void)
+{
+  return s_globals.height * s_globals.scale;
+}
+
+// fill the clip rectangle of the current layer
+static void _labClearWith(labcolor_t color)
+{
+  HBRUSH colorBrush;
+  RECT screenRect = {0, 0, _labGetWindowWidth(), _labGetWindowHeight()};
+
+  // the clip region of the buffer DC limits clearing to the clip rectangle
+  if (IsRectEmpty(&s_globals.clipRect))
+    return;
+  colorBrush = CreateSolidBrush(s_globals.colors[color]); // todo: why not SetDCBrushColor()? [4/3/2015 paul.smirnov]
+
+  EnterCriticalSection(&s_globals.cs);
+  {
+    UnionRect(&s_globals.updateRect, &s_globals.updateRect, &s_globals.clipRect);
+    FillRect(s_globals.hbmdc, &screenRect, colorBrush);
+    LeaveCriticalSection(&s_globals.cs);
+  }
+
+  DeleteObject(colorBrush);
+}
+
+void LabClear()
+{
+  LABASSERT_INIT();
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_CLEAR, 0);
+  s_globals.clearCount++;
+  // layers above 0 become transparent to show what is below
+  if (s_globals.layer > 0)
+    _labClearTransparent();
+  else
+    _labClearWith(LABCOLOR_BLACK);
+}
+
+void LabClearWith(labcolor_t color)
+{
+  LABASSERT_INIT();
+
+  if (s_journal.file)
+    _labJournalCall(JOURNAL_CLEAR_WITH, 1, color);
+  s_globals.clearCount++;
+  _labClearWith(color);
+}
+
+
+// End of file
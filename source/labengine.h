@@ -1,452 +1,1969 @@
-#ifndef LABENGINE_H_INCLUDED
-#define LABENGINE_H_INCLUDED
-#pragma once
-
-/**
- * @mainpage Introduction
- 
-LabEngine       
-       Windows.  
-  ,         
- WinAPI,      .
-
-       :
-
-@code{.c}
-#include "labengine.h"
-
-int main(void)
-{
-  if (LabInit())    // 
-  {
-    // ...          //   - 
-
-    LabTerm();      //  
-  }
-  return 0;
-}
-@endcode
-
-    ,   ,   
- .   ,     , 
-  .
-
-     :
-
-@code
-#include "labengine.h"
-
-int main(void)
-{
-  //  
-  if (LabInit())
-  {
-    //   
-    int width = LabGetWidth();
-    int height = LabGetHeight();
-  
-    //   
-    LabSetColor(LABCOLOR_RED);
-    LabDrawRectangle(0, 0, width, height);
-    
-    //   
-    LabSetColor(LABCOLOR_GREEN);
-    LabDrawLine(1, 1, width - 1, height - 1);
-    LabDrawLine(1, height - 2, width - 1, 0);
-
-    //    
-    LabDrawFlush();
-
-    //      
-    LabInputKey();
-    LabTerm();
-  }
-  return 0;
-}
-@endcode
-
-    ( ---    ).  
- Windows         (
-    ).
-
-  :
-
-@image html basics.png
-
-*/
-
-#pragma comment(lib, "kernel32")
-#pragma comment(lib, "user32")
-#pragma comment(lib, "gdi32")
-
-#if defined(_DEBUG) || !defined(NDEBUG)
-#define LABENGINE_LIB_SUFFIX "-dbg"
-#else
-#define LABENGINE_LIB_SUFFIX
-#endif
-
-#ifdef _MSC_VER
-#if   _MSC_VER >= 1900 // Visual Studio 2015
-#pragma comment(lib, "labengine-vs15" LABENGINE_LIB_SUFFIX)
-#elif _MSC_VER >= 1800 // Visual Studio 2013
-#pragma comment(lib, "labengine-vs13" LABENGINE_LIB_SUFFIX)
-#elif _MSC_VER >= 1700 // Visual Studio 2012
-#pragma comment(lib, "labengine-vs12" LABENGINE_LIB_SUFFIX)
-#elif _MSC_VER >= 1600 // Visual Studio 2010
-#pragma comment(lib, "labengine-vs10" LABENGINE_LIB_SUFFIX)
-#elif _MSC_VER >= 1500 // Visual Studio 2008
-#pragma comment(lib, "labengine-vs08" LABENGINE_LIB_SUFFIX)
-#else
-#error This Visual Studio version is not supported.
-#endif
-#else
-#error This compiler is not supported.
-#endif
-
-#undef LABENGINE_LIB_SUFFIX
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-/**
- * @brief  .
- *
- *       () ,  
- *    int.      ,
- *    .
- */
-typedef enum labbool_t
-{
-  LAB_FALSE, ///<  (0)
-  LAB_TRUE   ///<  (1)
-} labbool_t;
-
-/**
- * @defgroup lifecycle_group Lifecycle Methods
- *
- *         .
- *
- * @{
- */
-
-/**
- *   .
- *
- *     LabInitWith().   LabInit()
- *   ,     .
- */
-typedef struct labparams_t
-{
-  unsigned width;  ///<    
-  unsigned height; ///<    
-  unsigned scale;  ///<       
-} labparams_t;
-
-/**
- * @brief  .
- * 
- *         .
- *      ,  
- * .    ,     ,
- *    LabInitWith().
- *        LabTerm().
- * 
- * @return @ref LAB_TRUE    ,  - @ref LAB_FALSE.
- * @see LabInitWith, LabTerm
- */
-labbool_t LabInit(void);
-
-/**
- * @brief    .
- *
- *         .
- *      ,  
- * .     ,     ,
- *    LabInit().
- *        LabTerm().
- *
- * @param params   
- *
- * @return @ref LAB_TRUE    ,  - @ref LAB_FALSE.
- * @see LabInit, LabTerm
- */
-labbool_t LabInitWith(labparams_t const* params);
-
-/**
- * @brief   c .
- * 
- *           
- *   .
- *         LabInit().
- *
- * @see LabInit, LabInitWith
- */
-void LabTerm(void);
-
-/**
- * @brief   .
- * 
- * @param time  
- */
-void LabDelay(int time);
-
-/**@}*/
-
-
-/**
- * @defgroup graphics_group Graphics Methods
- *
- *        .
- *   : @ref graphics_group
- * @{
- */
-
-/**
- * @brief    .
- *
- *         .
- *       LabSetColor().
- *
- * @see LabSetColor
- */
-typedef enum labcolor_t 
-{ 
-  LABCOLOR_NA = -1,       ///<  
-
-  LABCOLOR_BLACK,         ///< ׸
-  LABCOLOR_DARK_BLUE,     ///< Ҹ-
-  LABCOLOR_DARK_GREEN,    ///< Ҹ-
-  LABCOLOR_DARK_CYAN,     ///< Ҹ-
-  LABCOLOR_DARK_RED,      ///< Ҹ-
-  LABCOLOR_DARK_MAGENTA,  ///< Ҹ-
-  LABCOLOR_BROWN,         ///< 
-  LABCOLOR_LIGHT_GREY,    ///< -
-  LABCOLOR_DARK_GREY,     ///< Ҹ-
-  LABCOLOR_BLUE,          ///< 
-  LABCOLOR_GREEN,         ///< 
-  LABCOLOR_CYAN,          ///< 
-  LABCOLOR_RED,           ///< 
-  LABCOLOR_MAGENTA,       ///< 
-  LABCOLOR_YELLOW,        ///< Ƹ
-  LABCOLOR_WHITE,         ///< 
-
-  LABCOLOR_COUNT,         ///<    
-} labcolor_t;
-
-/**
- * @brief   .
- * 
- * @return   .
- * @see LabGetHeight
- */
-int LabGetWidth(void);
-
-/**
- * @brief   .
- * 
- * @return   .
- * @see LabGetWidth
- */
-int LabGetHeight(void);
-
-/**
- * @brief  .
- *
- *     .    
- *    ,   LabClearWith().
- *
- * @see LabClearWith
- */
-void LabClear();
-
-/**
- * @brief    .
- * 
- * @param color ,   
- * @see LabClear
- */
-void LabClearWith(labcolor_t color);
-
-/**
- * @brief   .
- *
- *          ,
- *      
- *  <code>LabDraw...()</code>.
- *   (    )   
- * (@ref LABCOLOR_WHITE).
- *
- * @param color     <code>labcolor_t</code>.
- * @see labcolor_t, LabSetColorRGB()
- */
-void LabSetColor(labcolor_t color);
-
-/** 
- * @brief     .
- *
- *     16,777,216    ,
- *      
- *  <code>LabDraw...()</code>.    
- * ,      
- *  () - ,   ,   
- * 0 ( )  255 (  ).
- *
- *       
- * ,  LabGetColor()   @ref LABCOLOR_NA.
- *
- * @param r   ,  0  255.
- * @param g   ,  0  255.
- * @param b   ,  0  255.
- *
- * @see LabSetColor
- */
-void LabSetColorRGB(int r, int g, int b);
-
-/** 
- * @brief   .
- *
- * @return     ,   
- *  <code>LabDraw...()</code>.
- */
-labcolor_t LabGetColor(void);
-
-
-/** 
- * @brief   .
- *
- *  ,     (x1, y1)  (x2, y2).
- *    .
- *
- * @param x1     (0 )
- * @param y1     (0 )
- * @param x2    
- * @param y2    .
- */
-void LabDrawLine(int x1, int y1, int x2, int y2);
-
-/** 
- * @brief  .
- *
- *     (x, y).
- *
- * @param x   
- * @param y   .
- */
-void LabDrawPoint(int x, int y);
-
-/** 
- * @brief  .
- *
- *          
- *   (x1, y1)  (x2, y2) .
- *
- * @param x1     
- * @param y1     
- * @param x2     
- * @param y2     .
- */
-void LabDrawRectangle(int x1, int y1, int x2, int y2);
-
-/** 
- * @brief  .
- *
- *      (x, y)   radius.
- *
- * @param x    
- * @param y   
- * @param radius  .
- */
-void LabDrawCircle(int x, int y, int radius);
-
-/** 
- * @brief  .
- *
- *      (x, y)   a  b.
- *
- * @param x    
- * @param y   
- * @param a  
- * @param b  .
- */
-void LabDrawEllipse(int x, int y, int a, int b);
-
-/**
- * @brief      .
- *
- *    <code>LabDraw...()</code>,  
- *        ,  
- *    .     
- *   ,     ,
- *      .
- *
- *        
- *        
- *   .        
- *     .
- *
- */
-void LabDrawFlush(void);
-
-/**@}*/
-
-
-/**
- * @defgroup input_group Input Methods
- *
- *  ,     .
- *   : @ref input_group
- * @{
- */
-
-/**
- * @brief   .
- *
- *     Enter, Escape, ...
- *   ASCII-  ,   
- *   LabInputKey().
- *
- * @see LabInputKey
- */
-typedef enum labkey_t
-{ 
-  LABKEY_ENTER = 0x0D00,      ///< Enter 
-  LABKEY_ESC = 0x1B00,        ///< Escape 
-  LABKEY_BACK = 0x0800,       ///< Backspace 
-  LABKEY_TAB = 0x0900,        ///< Tab 
-  LABKEY_PAGE_UP = 0x2100,    ///< PageUp 
-  LABKEY_PAGE_DOWN = 0x2200,  ///< PageDown 
-  LABKEY_LEFT = 0x2500,       ///<  
-  LABKEY_UP = 0x2600,         ///<  
-  LABKEY_RIGHT = 0x2700,      ///<  
-  LABKEY_DOWN = 0x2800,       ///<  
- 
-} labkey_t;
-
-/**
- * @brief       .
- * 
- *   ,  ,   ,    -
- * ASCII-        <code>labkey_t</code>
- *    (  Enter, Escape,  ... ).
- *
- * @return   .
- * @see labkey_t
- */
-labkey_t LabInputKey(void);
-
-/**
- *     .
- *
- * @return @ref LAB_TRUE     , @ref LAB_FALSE,   .
- */
-labbool_t LabInputKeyReady(void);
-
-/** @}*/
-
-
-#ifdef __cplusplus
-}
-#endif
-
-#endif // LABENGINE_H_INCLUDED
+#ifndef LABENGINE_H_INCLUDED
+#define LABENGINE_H_INCLUDED
+#pragma once
+
+/**
+ * @mainpage Introduction
+ 
+LabEngine представляет собой простейшую графическую библиотеку для проведения
+лабораторных работ в рамках консольных приложений для Windows. Она позволяет
+на первых порах, не вдаваясь в организацию оконных приложений и правила борьбы
+с WinAPI, делать несложные лабораторные с применением графики.
+
+Минимальная программа с использованием библиотеки выглядит следующим образом:
+
+@code{.c}
+#include "labengine.h"
+
+int main(void)
+{
+  if (LabInit())    // Инициализация
+  {
+    // ...          // Здесь можно что-то сделать
+
+    LabTerm();      // Завершение работы
+  }
+  return 0;
+}
+@endcode
+
+Эта программа инициализирует библиотеку и, в случае успеха, сразу же завершает
+работу программы. Можно успеть заметить, как открывается окно для рисования, но
+тут же закрывается.
+
+Более осмысленная версия программы выглядит так:
+
+@code
+#include "labengine.h"
+
+int main(void)
+{
+  // Инициализировать библиотеку
+  if (LabInit())
+  {
+    // Узнать размеры окна
+    int width = LabGetWidth();
+    int height = LabGetHeight();
+  
+    // Нарисовать красный прямоугольник
+    LabSetColor(LABCOLOR_RED);
+    LabDrawRectangle(0, 0, width, height);
+    
+    // Нарисовать зелёный крест
+    LabSetColor(LABCOLOR_GREEN);
+    LabDrawLine(1, 1, width - 1, height - 1);
+    LabDrawLine(1, height - 2, width - 1, 0);
+
+    // Отобразить картинку в окне
+    LabDrawFlush();
+
+    // Подождать нажатия клавиши и закончить работу
+    LabInputKey();
+    LabTerm();
+  }
+  return 0;
+}
+@endcode
+
+Обратите внимание на координаты (ноль --- в левом верхнем углу). По принятому
+в Windows соглашению конечные точки линий и прямоугольников не рисуются (линии
+не доходят до указанных координат).
+
+Результат выполнения программы:
+
+@image html basics.png
+
+*/
+
+#pragma comment(lib, "kernel32")
+#pragma comment(lib, "user32")
+#pragma comment(lib, "gdi32")
+#pragma comment(lib, "ws2_32")
+
+#if defined(_DEBUG) || !defined(NDEBUG)
+#define LABENGINE_LIB_SUFFIX "-dbg"
+#else
+#define LABENGINE_LIB_SUFFIX
+#endif
+
+#ifdef _MSC_VER
+#if   _MSC_VER >= 1900 // Visual Studio 2015
+#pragma comment(lib, "labengine-vs15" LABENGINE_LIB_SUFFIX)
+#elif _MSC_VER >= 1800 // Visual Studio 2013
+#pragma comment(lib, "labengine-vs13" LABENGINE_LIB_SUFFIX)
+#elif _MSC_VER >= 1700 // Visual Studio 2012
+#pragma comment(lib, "labengine-vs12" LABENGINE_LIB_SUFFIX)
+#elif _MSC_VER >= 1600 // Visual Studio 2010
+#pragma comment(lib, "labengine-vs10" LABENGINE_LIB_SUFFIX)
+#elif _MSC_VER >= 1500 // Visual Studio 2008
+#pragma comment(lib, "labengine-vs08" LABENGINE_LIB_SUFFIX)
+#else
+#error This Visual Studio version is not supported.
+#endif
+#else
+#error This compiler is not supported.
+#endif
+
+#undef LABENGINE_LIB_SUFFIX
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Логический тип.
+ *
+ * В языке Си отсутствует выделенный булевский (логический) тип, и вместо
+ * него используется тип int. Чтобы избежать этой потери семантики значений,
+ * библиотека предоставляет данное перечисление.
+ */
+typedef enum labbool_t
+{
+  LAB_FALSE, ///< Ложь (0)
+  LAB_TRUE   ///< Истина (1)
+} labbool_t;
+
+/**
+ * @defgroup lifecycle_group Lifecycle Methods
+ *
+ * Функции инициализации графического режима и окончания работы в нём.
+ *
+ * @{
+ */
+
+/**
+ * @brief Флаги режима работы библиотеки.
+ *
+ * Передаются в функцию LabInitWithFlags(), значения можно объединять
+ * операцией <code>|</code>.
+ */
+typedef enum labflag_t
+{
+  LABFLAG_NONE = 0,          ///< Обычный режим с окном для рисования
+  LABFLAG_HEADLESS = 0x0001, ///< Рисовать только в памяти, окно не создаётся
+  LABFLAG_TERMINAL = 0x0002, ///< Показывать картинку в консоли вместо окна, см. LabInitWithFlags()
+} labflag_t;
+
+/**
+ * Параметры инициализации библиотеки.
+ *
+ * Используются при вызове функции LabInitWith(). При вызове LabInit()
+ * параметры не указывается, используются некоторые значения по умолчанию.
+ */
+typedef struct labparams_t
+{
+  unsigned width;  ///< ширина буфера для рисования
+  unsigned height; ///< высота буфера для рисования
+  unsigned scale;  ///< коэффициент масштабирования буфера при выводе на экран
+} labparams_t;
+
+/**
+ * @brief Инициализировать библиотеку.
+ * 
+ * Перед работой с другими функциями библиотеки необходимо её инициализировать.
+ * При этом заполняются внутренние структуры данных, создаётся графическое
+ * окно. При необходимости задать параметры, отличные от настроек по умолчанию,
+ * следует пользоваться функцией LabInitWith().
+ * По окончании работы с библиотекой необходим вызов LabTerm().
+ * 
+ * @return @ref LAB_TRUE если инициализация прошла успешно, иначе - @ref LAB_FALSE.
+ * @see LabInitWith, LabTerm
+ */
+labbool_t LabInit(void);
+
+/**
+ * @brief Инициализировать библиотеку с параметрами.
+ *
+ * Перед работой с другими функциями библиотеки необходимо её инициализировать.
+ * При этом заполняются внутренние структуры данных, создаётся графическое
+ * окно. Если нет необходимости задавать параметры, отличные от настроек по умолчанию,
+ * следует пользоваться функцией LabInit().
+ * По окончании работы с библиотекой необходим вызов LabTerm().
+ *
+ * @param params параметры инициализации библиотеки
+ *
+ * @return @ref LAB_TRUE если инициализация прошла успешно, иначе - @ref LAB_FALSE.
+ * @see LabInit, LabInitWithFlags, LabTerm
+ */
+labbool_t LabInitWith(labparams_t const* params);
+
+/**
+ * @brief Инициализировать библиотеку с параметрами и флагами режима работы.
+ *
+ * То же, что LabInitWith(), но режим работы задаётся флагами. Вызов
+ * с флагом @ref LABFLAG_NONE равносилен вызову LabInitWith().
+ *
+ * С флагом @ref LABFLAG_HEADLESS окно не создаётся, и всё рисование
+ * происходит только в буфере в памяти. Этот режим удобен для тестов и
+ * замеров производительности; функция LabInputKey() в нём не ждёт нажатия,
+ * а сразу возвращает 0, если очередь клавиш пуста.
+ *
+ * С флагом @ref LABFLAG_TERMINAL окно тоже не создаётся, а при каждом вызове
+ * LabDrawFlush() картинка выводится в консоль (стандартный вывод)
+ * символами полублоков, по две точки на символ, с цветами в 24 бита. Для
+ * этого нужна консоль, понимающая управляющие последовательности ANSI
+ * (Windows 10 и новее, терминал по SSH). Большой буфер уменьшается в целое
+ * число раз, чтобы поместиться в окно консоли. Выводятся только
+ * изменившиеся символы. Нажатия клавиш в консоли попадают в очередь
+ * LabInputKey().
+ *
+ * @param params параметры инициализации библиотеки
+ * @param flags флаги режима работы, комбинация значений labflag_t.
+ *
+ * @return @ref LAB_TRUE если инициализация прошла успешно, иначе - @ref LAB_FALSE.
+ * @see LabInit, LabInitWith, LabTerm
+ */
+labbool_t LabInitWithFlags(labparams_t const* params, unsigned flags);
+
+/**
+ * @brief Завершить работу c библиотекой.
+ * 
+ * Необходим вызов для окончания работы в графическом режиме и закрытия 
+ * окна графического режима.
+ * Перед началом работы в графическом режиме необходим вызов LabInit().
+ *
+ * @see LabInit, LabInitWith
+ */
+void LabTerm(void);
+
+/**
+ * @brief Приостанавить исполнение программы.
+ * 
+ * @param time количество миллисекунд
+ */
+void LabDelay(int time);
+
+/**@}*/
+
+
+/**
+ * @defgroup graphics_group Graphics Methods
+ *
+ * Функции графического вывода и получения информации об окне.
+ * Подробнее о группе: @ref graphics_group
+ * @{
+ */
+
+/**
+ * @brief Названия цветов цветовой палитры.
+ *
+ * Используются для назначения цвета линий и других графических объектов.
+ * Передаются в качестве параметра в функцию LabSetColor().
+ *
+ * @see LabSetColor
+ */
+typedef enum labcolor_t 
+{ 
+  LABCOLOR_NA = -1,       ///< Цвет неопределён
+
+  LABCOLOR_BLACK,         ///< Чёрный
+  LABCOLOR_DARK_BLUE,     ///< Тёмно-синий
+  LABCOLOR_DARK_GREEN,    ///< Тёмно-зелёный
+  LABCOLOR_DARK_CYAN,     ///< Тёмно-голубой
+  LABCOLOR_DARK_RED,      ///< Тёмно-красный
+  LABCOLOR_DARK_MAGENTA,  ///< Тёмно-пурпурный
+  LABCOLOR_BROWN,         ///< Коричневый
+  LABCOLOR_LIGHT_GREY,    ///< Светло-серый
+  LABCOLOR_DARK_GREY,     ///< Тёмно-серый
+  LABCOLOR_BLUE,          ///< Синий
+  LABCOLOR_GREEN,         ///< Зелёный
+  LABCOLOR_CYAN,          ///< Голубой
+  LABCOLOR_RED,           ///< Красный
+  LABCOLOR_MAGENTA,       ///< Пурпурный
+  LABCOLOR_YELLOW,        ///< Жёлтый
+  LABCOLOR_WHITE,         ///< Белый
+
+  LABCOLOR_COUNT,         ///< Количество цветов в палитре
+} labcolor_t;
+
+/**
+ * @brief Узнать ширину окна.
+ * 
+ * @return ширина графического окна.
+ * @see LabGetHeight
+ */
+int LabGetWidth(void);
+
+/**
+ * @brief Узнать высоту окна.
+ * 
+ * @return высота графического окна.
+ * @see LabGetWidth
+ */
+int LabGetHeight(void);
+
+/**
+ * @brief Очистить окно.
+ *
+ * Для очистки используется чёрный цвет. При желании можно быстро
+ * очищать окно другим цветом, воспользовавшись функцией LabClearWith().
+ *
+ * @see LabClearWith
+ */
+void LabClear();
+
+/**
+ * @brief Очистить окно заданным цветом.
+ * 
+ * @param color цвет, которым проливается экран
+ * @see LabClear
+ */
+void LabClearWith(labcolor_t color);
+
+/**
+ * @brief Установить текущий цвет.
+ *
+ * Позволяет задать один из цветов стандартной палитры в качестве текущего,
+ * используемого для последующего рисования графических объектов
+ * функциями <code>LabDraw...()</code>.
+ * По умолчанию (до первого вызова этой функции) используется белый цвет
+ * (@ref LABCOLOR_WHITE).
+ *
+ * @param color новый цвет из перечисления <code>labcolor_t</code>.
+ * @see labcolor_t, LabSetColorRGB()
+ */
+void LabSetColor(labcolor_t color);
+
+/** 
+ * @brief Установить текущий цвет по компонентам.
+ *
+ * Позволяет выбрать один из 16,777,216 цветов в качестве текущего,
+ * используемого для последующего рисования графических объектов
+ * функциями <code>LabDraw...()</code>. Стандартная палитра при этом
+ * игнорируется, цвет составляется как комбинация яркостей отдельных
+ * компонент (каналов) - красной, зелёной и синей, в пределах от
+ * 0 (отсутствие компонены) до 255 (максимальная яркость компоненты).
+ *
+ * Поскольку выбранный цвет не обязательно принадлежит стандартной
+ * палитре, функция LabGetColor() будет возвращать @ref LABCOLOR_NA.
+ *
+ * @param r яркость красной компоненты, от 0 до 255.
+ * @param g яркость зелёной компоненты, от 0 до 255.
+ * @param b яркость синей компоненты, от 0 до 255.
+ *
+ * @see LabSetColor
+ */
+void LabSetColorRGB(int r, int g, int b);
+
+/** 
+ * @brief Узнать текущий цвет.
+ *
+ * @return текущий цвет из стандартной палитры, используемый для рисования
+ * функциями <code>LabDraw...()</code>.
+ */
+labcolor_t LabGetColor(void);
+
+/**
+ * @brief Способ наложения цвета на изображение.
+ *
+ * Определяет, как цвет рисуемых фигур смешивается с уже нарисованными
+ * пикселями. Цвет фигуры предварительно умножается на прозрачность,
+ * заданную функцией LabSetAlpha().
+ *
+ * @see LabSetBlend(), LabSetAlpha()
+ */
+typedef enum labblend_t
+{
+  LABBLEND_ALPHA,    ///< обычное наложение: при прозрачности 255 цвет просто заменяет пиксель
+  LABBLEND_ADD,      ///< сложение цветов с насыщением, для свечения и частиц
+  LABBLEND_MULTIPLY, ///< умножение цветов, для теней и тонировки
+  LABBLEND_XOR,      ///< исключающее ИЛИ, повторное рисование восстанавливает изображение
+} labblend_t;
+
+/**
+ * @brief Выбрать способ наложения цвета.
+ *
+ * Способ используется всеми функциями <code>LabDraw...()</code>,
+ * включая заливку фигур, текст и частицы, а также LabFloodFill().
+ * Спрайты, тайловые карты, LabWritePixels(), LabCopyRect() и LabScroll()
+ * записывают пиксели как есть. На слоях, кроме нулевого, смешивание идёт с чёрным цветом
+ * там, где ещё ничего не нарисовано, и результат становится непрозрачным.
+ *
+ * По умолчанию используется @ref LABBLEND_ALPHA с прозрачностью 255,
+ * при этом рисование выполняется так же быстро, как и без смешивания.
+ * Полупрозрачные окружности и эллипсы рисуются собственным растеризатором
+ * библиотеки: они занимают тот же прямоугольник, что и непрозрачные, но
+ * отдельные точки контура могут незначительно отличаться.
+ *
+ * @param blend способ наложения из перечисления <code>labblend_t</code>.
+ * @see labblend_t, LabSetAlpha()
+ */
+void LabSetBlend(labblend_t blend);
+
+/**
+ * @brief Узнать способ наложения цвета.
+ *
+ * @return текущий способ наложения.
+ */
+labblend_t LabGetBlend(void);
+
+/**
+ * @brief Установить непрозрачность рисования.
+ *
+ * @param alpha непрозрачность от 0 (фигуры не видны) до 255 (фигуры
+ * полностью непрозрачны), значения вне диапазона ограничиваются.
+ * @see LabSetBlend(), LabSetColorRGBA()
+ */
+void LabSetAlpha(int alpha);
+
+/**
+ * @brief Узнать непрозрачность рисования.
+ *
+ * @return текущая непрозрачность от 0 до 255.
+ */
+int LabGetAlpha(void);
+
+/**
+ * @brief Установить текущий цвет и непрозрачность.
+ *
+ * Равносильно вызову LabSetColorRGB() и LabSetAlpha().
+ *
+ * @param r яркость красной компоненты, от 0 до 255.
+ * @param g яркость зелёной компоненты, от 0 до 255.
+ * @param b яркость синей компоненты, от 0 до 255.
+ * @param a непрозрачность, от 0 до 255.
+ */
+void LabSetColorRGBA(int r, int g, int b, int a);
+
+
+/** 
+ * @brief Нарисовать прямую линию.
+ *
+ * Рисование линии, соединяющей точки с координатами (x1, y1) и (x2, y2).
+ * Последняя точка не рисуется.
+ *
+ * @param x1 горизонтальная координата первой точки (0 слева)
+ * @param y1 вертикальная координата первой точки (0 сверху)
+ * @param x2 горизонтальная координата второй точки
+ * @param y2 вертикальная координата второй точки.
+ */
+void LabDrawLine(int x1, int y1, int x2, int y2);
+
+/** 
+ * @brief Нарисовать точку.
+ *
+ * Рисование точки с координатами (x, y).
+ *
+ * @param x горизонтальная координата точки
+ * @param y вертикальная координата точки.
+ */
+void LabDrawPoint(int x, int y);
+
+/** 
+ * @brief Нарисовать прямоугольник.
+ *
+ * Рисование прямоугольника с левым верхним и правым нижним углами 
+ * с координатами (x1, y1) и (x2, y2) соответственно.
+ *
+ * @param x1 горизонтальная координата левого верхнего угла
+ * @param y1 вертикальная координата левого верхнего угла
+ * @param x2 горизонтальная координата правого нижнего угла
+ * @param y2 вертикальная координата правого нижнего угла.
+ */
+void LabDrawRectangle(int x1, int y1, int x2, int y2);
+
+/** 
+ * @brief Нарисовать окружность.
+ *
+ * Рисование окружности с координатами центра (x, y) и радиусом radius.
+ *
+ * @param x горизонтальная координата центра окружности
+ * @param y вертикальная координата центра
+ * @param radius радиус окружности.
+ */
+void LabDrawCircle(int x, int y, int radius);
+
+/** 
+ * @brief Нарисовать эллипс.
+ *
+ * Рисование эллипса с координатами центра (x, y) и полуосями a и b.
+ *
+ * @param x горизонтальная координата центра эллипса
+ * @param y вертикальная координата центра
+ * @param a большая полуось
+ * @param b малая полуось.
+ */
+void LabDrawEllipse(int x, int y, int a, int b);
+
+/**
+ * @brief Точка на плоскости.
+ *
+ * Используется для передачи набора вершин в функцию LabDrawPolyline().
+ */
+typedef struct labpoint_t
+{
+  int x; ///< горизонтальная координата (0 слева)
+  int y; ///< вертикальная координата (0 сверху)
+} labpoint_t;
+
+/**
+ * @brief Нарисовать ломаную линию.
+ *
+ * Рисование ломаной, последовательно соединяющей точки массива points.
+ * Отрезки проходят между теми же точками, что и при вызове LabDrawLine()
+ * для каждой пары соседних точек, но рисуются собственным алгоритмом
+ * Брезенхэма, поэтому отдельные точки наклонных отрезков могут отличаться
+ * от LabDrawLine(). Общие вершины рисуются только один раз, и вся ломаная
+ * рисуется за один вызов, что значительно быстрее при большом количестве
+ * точек (например, при выводе графиков). Как и у линии, последняя точка
+ * незамкнутой ломаной не рисуется.
+ *
+ * @param points массив вершин ломаной
+ * @param count количество вершин
+ * @param closed @ref LAB_TRUE, если нужно соединить последнюю вершину с первой.
+ *
+ * @see LabDrawLine
+ */
+void LabDrawPolyline(labpoint_t const* points, int count, labbool_t closed);
+
+/**
+ * @brief Точка на плоскости с дробными координатами.
+ *
+ * Используется для передачи набора вершин в функцию LabDrawPolylineF().
+ */
+typedef struct labpointf_t
+{
+  float x; ///< горизонтальная координата (0 слева)
+  float y; ///< вертикальная координата (0 сверху)
+} labpointf_t;
+
+/**
+ * @brief Нарисовать точку с дробными координатами.
+ *
+ * Рисуется точка, ближайшая к точке (x, y). Центры точек экрана имеют
+ * целые координаты, так что при целых x и y результат совпадает с
+ * LabDrawPoint().
+ *
+ * Функции с суффиксом <code>F</code> принимают координаты типа
+ * <code>float</code> и учитывают их дробную часть с точностью до 1/256
+ * точки. Благодаря этому медленно движущиеся или поворачивающиеся фигуры
+ * смещаются плавно, а не скачками на целую точку, и не нужно самостоятельно
+ * округлять координаты. Результат не зависит от компьютера и компилятора.
+ * Координаты дальше миллиона точек от края буфера приближаются к этой
+ * границе, а вызовы с координатами NaN ничего не рисуют.
+ *
+ * @param x горизонтальная координата точки
+ * @param y вертикальная координата точки.
+ *
+ * @see LabDrawLineF, LabDrawCircleF, LabDrawPolylineF
+ */
+void LabDrawPointF(float x, float y);
+
+/**
+ * @brief Нарисовать прямую линию с дробными координатами концов.
+ *
+ * Аналог функции LabDrawLine(). Рисуются точки, ближайшие к отрезку, по одной
+ * на каждый столбец (для пологих линий) или строку (для крутых), центр которых
+ * лежит между концами отрезка; точка, попадающая точно на второй конец,
+ * не рисуется.
+ *
+ * @param x1 горизонтальная координата первой точки (0 слева)
+ * @param y1 вертикальная координата первой точки (0 сверху)
+ * @param x2 горизонтальная координата второй точки
+ * @param y2 вертикальная координата второй точки.
+ *
+ * @see LabDrawPointF, LabDrawLine
+ */
+void LabDrawLineF(float x1, float y1, float x2, float y2);
+
+/**
+ * @brief Нарисовать ломаную линию с дробными координатами вершин.
+ *
+ * Аналог функции LabDrawPolyline(), каждое звено рисуется так же, как
+ * функцией LabDrawLineF(). Вершины, у которых хотя бы одна координата
+ * равна NaN, пропускаются, и ломаная соединяет соседние с ними вершины.
+ *
+ * @param points массив вершин ломаной
+ * @param count количество вершин
+ * @param closed @ref LAB_TRUE, если нужно соединить последнюю вершину с первой.
+ *
+ * @see LabDrawLineF, LabDrawPolyline
+ */
+void LabDrawPolylineF(labpointf_t const* points, int count, labbool_t closed);
+
+/**
+ * @brief Нарисовать окружность с дробными координатами центра и радиусом.
+ *
+ * Рисуются точки, ближайшие к окружности с центром (x, y) и радиусом radius.
+ *
+ * @param x горизонтальная координата центра окружности
+ * @param y вертикальная координата центра
+ * @param radius радиус окружности.
+ *
+ * @see LabDrawPointF, LabDrawCircle
+ */
+void LabDrawCircleF(float x, float y, float radius);
+
+/**
+ * @brief Нарисовать кривую Безье.
+ *
+ * Квадратичная кривая задаётся тремя точками, кубическая - четырьмя:
+ * кривая начинается в первой точке, заканчивается в последней, а
+ * промежуточные точки задают её изгиб. Кривая рисуется как ломаная
+ * LabDrawPolylineF() из наименьшего числа звеньев, при котором она отходит
+ * от точной кривой не больше чем на 1/4 точки, поэтому рисовать кривую
+ * отрезками самостоятельно не нужно.
+ *
+ * @param points массив точек кривой
+ * @param count количество точек: 3 или 4.
+ *
+ * @see LabDrawArc, LabDrawPolylineF
+ */
+void LabDrawBezier(labpointf_t const* points, int count);
+
+/**
+ * @brief Нарисовать дугу окружности.
+ *
+ * Углы задаются в радианах и отсчитываются от направления оси x в сторону
+ * оси y, то есть на экране по часовой стрелке. Дуга рисуется как ломаная
+ * LabDrawPolylineF() из наименьшего числа звеньев, при котором она отходит
+ * от точной окружности не больше чем на 1/4 точки.
+ *
+ * @param x горизонтальная координата центра окружности
+ * @param y вертикальная координата центра
+ * @param radius радиус окружности
+ * @param start угол начала дуги
+ * @param sweep угловая величина дуги, отрицательная для дуги против часовой
+ *   стрелки, не больше полного оборота.
+ *
+ * @see LabDrawBezier, LabDrawCircleF
+ */
+void LabDrawArc(float x, float y, float radius, float start, float sweep);
+
+/**
+ * @brief Вывести текст.
+ *
+ * Текст выводится текущим цветом встроенным растровым шрифтом 8x8 точек,
+ * фон под буквами не закрашивается. Левый верхний угол первой буквы
+ * находится в точке (x, y), символ <code>'\\n'</code> переводит вывод
+ * на следующую строку. Строка записывается в кодировке Windows-1251,
+ * поэтому можно использовать русские буквы.
+ *
+ * Недавно выведенные строки запоминаются в уже подготовленном для вывода
+ * виде, так что повторный вывод неизменных надписей (заголовков, подписей
+ * осей) обходится дешевле первого.
+ *
+ * @param x горизонтальная координата левого верхнего угла текста
+ * @param y вертикальная координата левого верхнего угла текста
+ * @param text выводимая строка.
+ *
+ * @see LabDrawTextf, LabGetTextWidth
+ */
+void LabDrawText(int x, int y, char const* text);
+
+/**
+ * @brief Вывести форматированный текст.
+ *
+ * Аналог функции LabDrawText(), строка для вывода составляется по формату
+ * так же, как в функции <code>printf()</code>. Длина получившейся строки
+ * ограничена 1023 символами.
+ *
+ * @param x горизонтальная координата левого верхнего угла текста
+ * @param y вертикальная координата левого верхнего угла текста
+ * @param format строка формата, как в функции <code>printf()</code>
+ * @param ... аргументы для подстановки в формат.
+ *
+ * @see LabDrawText
+ */
+void LabDrawTextf(int x, int y, char const* format, ...);
+
+/**
+ * @brief Узнать ширину текста.
+ *
+ * @param text строка, как для функции LabDrawText().
+ * @return ширина самой длинной строки текста в точках.
+ * @see LabGetTextHeight, LabDrawText
+ */
+int LabGetTextWidth(char const* text);
+
+/**
+ * @brief Узнать высоту строки текста.
+ *
+ * @return высота одной строки текста в точках.
+ * @see LabGetTextWidth, LabDrawText
+ */
+int LabGetTextHeight(void);
+
+/**
+ * @brief Ограничить область рисования прямоугольником.
+ *
+ * Все функции <code>LabDraw...()</code>, а также LabClear() и LabClearWith(),
+ * после этого вызова изменяют только точки внутри прямоугольника с левым
+ * верхним и правым нижним углами (x1, y1) и (x2, y2); правая и нижняя
+ * границы в область не входят. Новая область является пересечением
+ * указанного прямоугольника с текущей областью, а прежняя область
+ * запоминается, и её можно восстановить вызовом LabPopClip(). Вызовы можно
+ * вкладывать друг в друга до 16 уровней.
+ *
+ * Фигуры, целиком лежащие вне области рисования, отбрасываются сразу, почти
+ * без затрат времени, поэтому рисовать невидимые части большой сцены дёшево.
+ *
+ * Координаты задаются с учётом начала координат, установленного функцией
+ * LabSetOrigin().
+ *
+ * @param x1 горизонтальная координата левого верхнего угла
+ * @param y1 вертикальная координата левого верхнего угла
+ * @param x2 горизонтальная координата правого нижнего угла
+ * @param y2 вертикальная координата правого нижнего угла.
+ *
+ * @see LabPopClip, LabSetOrigin
+ */
+void LabPushClip(int x1, int y1, int x2, int y2);
+
+/**
+ * @brief Восстановить предыдущую область рисования.
+ *
+ * Отменяет действие последнего вызова LabPushClip().
+ *
+ * @see LabPushClip
+ */
+void LabPopClip(void);
+
+/**
+ * @brief Сместить начало координат.
+ *
+ * После этого вызова координаты, передаваемые в функции рисования,
+ * отсчитываются от точки (x, y) буфера, а не от его левого верхнего угла.
+ * Удобно для рисования одной и той же картинки в разных местах окна или
+ * для прокрутки большой сцены. По умолчанию начало координат находится
+ * в точке (0, 0).
+ *
+ * @param x горизонтальная координата нового начала координат в буфере
+ * @param y вертикальная координата нового начала координат в буфере.
+ *
+ * @see LabGetOrigin, LabPushClip
+ */
+void LabSetOrigin(int x, int y);
+
+/**
+ * @brief Узнать положение начала координат.
+ *
+ * @param x указатель на переменную для горизонтальной координаты (может быть NULL)
+ * @param y указатель на переменную для вертикальной координаты (может быть NULL).
+ *
+ * @see LabSetOrigin
+ */
+void LabGetOrigin(int* x, int* y);
+
+/// Число слоёв рисования (см. LabSetLayer()).
+#define LAB_LAYER_COUNT 8
+
+/**
+ * @brief Выбрать слой для рисования.
+ *
+ * Картинка на экране складывается из слоёв, лежащих друг над другом: слой 0
+ * внизу, слой @ref LAB_LAYER_COUNT - 1 наверху. Все функции рисования,
+ * а также LabGetPixel(), LabReadPixels() и LabFloodFill() работают с
+ * выбранным слоем. По умолчанию выбран слой 0, и пока другие слои не
+ * используются, библиотека работает как прежде, с одним буфером.
+ *
+ * Слой создаётся при первом выборе и сначала прозрачен. LabClear() на слое
+ * выше нулевого делает его снова прозрачным, а не чёрным. Область рисования
+ * и начало координат при смене слоя сохраняются.
+ *
+ * Слои смешиваются при вызове LabDrawFlush(), причём заново вычисляются
+ * только те части кадра, которые изменились на каком-либо слое. Поэтому
+ * неподвижный фон стоит нарисовать один раз на нижнем слое, а часто
+ * меняющиеся мелкие детали --- на верхних.
+ *
+ * @param layer номер слоя от 0 до @ref LAB_LAYER_COUNT - 1.
+ *
+ * @see LabGetLayer, LabSetLayerVisible, LabSetLayerOpacity
+ */
+void LabSetLayer(int layer);
+
+/**
+ * @brief Узнать номер слоя, выбранного для рисования.
+ *
+ * @see LabSetLayer
+ */
+int LabGetLayer(void);
+
+/**
+ * @brief Показать или скрыть слой.
+ *
+ * @param layer номер слоя от 0 до @ref LAB_LAYER_COUNT - 1
+ * @param visible @ref LAB_TRUE, чтобы показать слой (по умолчанию),
+ *        @ref LAB_FALSE, чтобы скрыть его.
+ *
+ * @see LabSetLayer, LabSetLayerOpacity
+ */
+void LabSetLayerVisible(int layer, labbool_t visible);
+
+/**
+ * @brief Задать непрозрачность слоя.
+ *
+ * Нарисованные точки слоя смешиваются с тем, что лежит под ними, в
+ * пропорции opacity / 255, прозрачные точки пропускаются.
+ *
+ * @param layer номер слоя от 0 до @ref LAB_LAYER_COUNT - 1
+ * @param opacity непрозрачность от 0 (слоя не видно) до 255 (слой закрывает
+ *        нижние, по умолчанию).
+ *
+ * @see LabSetLayer, LabSetLayerVisible
+ */
+void LabSetLayerOpacity(int layer, int opacity);
+
+/**
+ * @brief Насильно отобразить буфер рисования на экран.
+ *
+ * Когда выполняются команды <code>LabDraw...()</code>, для обеспечения
+ * лучшей производительности они рисуют не напрямую на экране, а во
+ * вспомогательном буфере в памяти. На экран содержимое этого буфера
+ * попадает только тогда, когда этого требует операционная система,
+ * либо при явном вызове этой функции.
+ *
+ * Типичное использование этой функции заключается в предварительной подготовке
+ * полного изображения в памяти с последующим однократным отображением
+ * его на экран. При наличии анимации в программе необходимо вызывать данную
+ * функцию после построения каждого кадра.
+ *
+ */
+void LabDrawFlush(void);
+
+/**
+ * @brief Цвет точки, упакованный в 32-битное число.
+ *
+ * Яркости компонент располагаются в младших трёх байтах числа:
+ * <code>0x00RRGGBB</code>. Для составления и разбора значения удобно
+ * пользоваться макросами LABRGB(), LABRGB_R(), LABRGB_G() и LABRGB_B().
+ */
+typedef unsigned int labrgb_t;
+
+/// Составить цвет labrgb_t из яркостей красной, зелёной и синей компонент (от 0 до 255).
+#define LABRGB(r, g, b) ((labrgb_t)((((r) & 0xFF) << 16) | (((g) & 0xFF) << 8) | ((b) & 0xFF)))
+/// Яркость красной компоненты цвета labrgb_t.
+#define LABRGB_R(c) (((c) >> 16) & 0xFF)
+/// Яркость зелёной компоненты цвета labrgb_t.
+#define LABRGB_G(c) (((c) >> 8) & 0xFF)
+/// Яркость синей компоненты цвета labrgb_t.
+#define LABRGB_B(c) ((c) & 0xFF)
+
+/**
+ * @brief Нарисовать точку заданного цвета.
+ *
+ * Аналог функции LabDrawPoint(), но цвет передаётся в вызове, а текущий
+ * цвет, установленный LabSetColor() или LabSetColorRGB(), не используется
+ * и не меняется. Если каждый примитив рисуется своим цветом, такие вызовы
+ * быстрее пары из смены цвета и рисования.
+ *
+ * @param x горизонтальная координата точки
+ * @param y вертикальная координата точки
+ * @param color цвет точки.
+ *
+ * @see LabDrawLineRGB, LabDrawRectangleRGB, LabDrawPolylineRGB
+ */
+void LabDrawPointRGB(int x, int y, labrgb_t color);
+
+/**
+ * @brief Нарисовать прямую линию заданного цвета.
+ *
+ * Аналог функции LabDrawLine(), не меняющий текущий цвет.
+ *
+ * @param x1 горизонтальная координата первой точки
+ * @param y1 вертикальная координата первой точки
+ * @param x2 горизонтальная координата второй точки
+ * @param y2 вертикальная координата второй точки
+ * @param color цвет линии.
+ *
+ * @see LabDrawPointRGB
+ */
+void LabDrawLineRGB(int x1, int y1, int x2, int y2, labrgb_t color);
+
+/**
+ * @brief Нарисовать прямоугольник заданного цвета.
+ *
+ * Аналог функции LabDrawRectangle(), не меняющий текущий цвет.
+ *
+ * @param x1 горизонтальная координата левого верхнего угла
+ * @param y1 вертикальная координата левого верхнего угла
+ * @param x2 горизонтальная координата правого нижнего угла
+ * @param y2 вертикальная координата правого нижнего угла
+ * @param color цвет прямоугольника.
+ *
+ * @see LabDrawPointRGB
+ */
+void LabDrawRectangleRGB(int x1, int y1, int x2, int y2, labrgb_t color);
+
+/**
+ * @brief Нарисовать ломаную линию заданного цвета.
+ *
+ * Аналог функции LabDrawPolyline(), не меняющий текущий цвет.
+ *
+ * @param points массив вершин ломаной
+ * @param count количество вершин
+ * @param closed @ref LAB_TRUE, если нужно соединить последнюю вершину с первой
+ * @param color цвет ломаной.
+ *
+ * @see LabDrawPointRGB
+ */
+void LabDrawPolylineRGB(labpoint_t const* points, int count, labbool_t closed, labrgb_t color);
+
+/**
+ * @brief Прямоугольник.
+ *
+ * Правая и нижняя границы в прямоугольник не входят, так что его ширина
+ * равна <code>right - left</code>, а высота --- <code>bottom - top</code>.
+ */
+typedef struct labrect_t
+{
+  int left;   ///< горизонтальная координата левой границы
+  int top;    ///< вертикальная координата верхней границы
+  int right;  ///< горизонтальная координата правой границы (не входит в прямоугольник)
+  int bottom; ///< вертикальная координата нижней границы (не входит в прямоугольник)
+} labrect_t;
+
+/**
+ * @brief Узнать цвет точки.
+ *
+ * Возвращает цвет точки буфера рисования с координатами (x, y) с учётом
+ * начала координат, установленного функцией LabSetOrigin(). Для точек
+ * за пределами буфера возвращается чёрный цвет.
+ *
+ * Для чтения большого количества точек гораздо быстрее воспользоваться
+ * функцией LabReadPixels().
+ *
+ * @param x горизонтальная координата точки
+ * @param y вертикальная координата точки.
+ * @return цвет точки.
+ *
+ * @see LabReadPixels
+ */
+labrgb_t LabGetPixel(int x, int y);
+
+/**
+ * @brief Прочитать прямоугольную область буфера рисования.
+ *
+ * Копирует цвета точек прямоугольника rect в массив dst строка за строкой.
+ * Точки за пределами буфера заполняются чёрным цветом. Содержимое
+ * прочитанной области соответствует одному моменту времени: она не может
+ * частично измениться во время чтения, даже если в этот момент окно
+ * перерисовывается.
+ *
+ * @param rect читаемый прямоугольник (с учётом начала координат)
+ * @param dst массив для цветов точек, не меньше <code>stride * высота</code> элементов
+ * @param stride расстояние между началами соседних строк в массиве dst,
+ *        в элементах (обычно равно ширине прямоугольника).
+ *
+ * @see LabGetPixel, LabWritePixels
+ */
+void LabReadPixels(labrect_t const* rect, labrgb_t* dst, int stride);
+
+/**
+ * @brief Записать прямоугольную область буфера рисования.
+ *
+ * Копирует цвета точек из массива src в прямоугольник rect строка за
+ * строкой. Действие, обратное LabReadPixels(). Точки за пределами области
+ * отсечения не изменяются.
+ *
+ * @param rect записываемый прямоугольник (с учётом начала координат)
+ * @param src массив цветов точек, не меньше <code>stride * высота</code> элементов
+ * @param stride расстояние между началами соседних строк в массиве src,
+ *        в элементах (обычно равно ширине прямоугольника).
+ *
+ * @see LabReadPixels
+ */
+void LabWritePixels(labrect_t const* rect, labrgb_t const* src, int stride);
+
+/**
+ * @brief Скопировать прямоугольную область буфера рисования.
+ *
+ * Переносит точки прямоугольника src так, что его левый верхний угол
+ * оказывается в точке (x, y). Области могут перекрываться, результат
+ * будет таким, как если бы src сначала скопировали в отдельный массив.
+ * Точки вне области отсечения не изменяются, а части src за пределами
+ * буфера не копируются.
+ *
+ * @param src копируемый прямоугольник (с учётом начала координат)
+ * @param x горизонтальная координата нового положения левого верхнего угла
+ * @param y вертикальная координата нового положения левого верхнего угла.
+ *
+ * @see LabScroll
+ */
+void LabCopyRect(labrect_t const* src, int x, int y);
+
+/**
+ * @brief Прокрутить область рисования.
+ *
+ * Сдвигает содержимое области отсечения (см. LabPushClip()) на dx точек
+ * вправо и dy точек вниз, отрицательные значения сдвигают влево и вверх.
+ * Открывшаяся полоса заполняется цветом color. Для прокручиваемого графика
+ * или журнала сообщений это намного быстрее, чем рисовать всё заново:
+ * после прокрутки остаётся дорисовать только новую полосу.
+ *
+ * @param dx сдвиг по горизонтали
+ * @param dy сдвиг по вертикали
+ * @param color цвет открывшейся полосы.
+ *
+ * @see LabCopyRect
+ */
+void LabScroll(int dx, int dy, labrgb_t color);
+
+/**
+ * @brief Параметры заливки области.
+ *
+ * Используются при вызове функции LabFloodFillWith().
+ */
+typedef struct labfillparams_t
+{
+  int tolerance;      ///< допустимое отличие каждой компоненты цвета от цвета начальной точки (0 - только точное совпадение)
+  labbool_t diagonal; ///< @ref LAB_TRUE, если заливка распространяется и на соседей по диагонали
+} labfillparams_t;
+
+/**
+ * @brief Залить область.
+ *
+ * Закрашивает цветом color точку (x, y) и все связанные с ней точки того
+ * же цвета, что и она, --- как инструмент "заливка" в графических
+ * редакторах. Соседними считаются точки слева, справа, сверху и снизу.
+ * Заливка не выходит за пределы области рисования, заданной LabPushClip().
+ *
+ * Заливка выполняется построчно и не использует рекурсию, поэтому
+ * подходит для областей любого размера и формы.
+ *
+ * @param x горизонтальная координата начальной точки
+ * @param y вертикальная координата начальной точки
+ * @param color цвет заливки.
+ *
+ * @see LabFloodFillWith
+ */
+void LabFloodFill(int x, int y, labrgb_t color);
+
+/**
+ * @brief Залить область с параметрами.
+ *
+ * Аналог функции LabFloodFill(), позволяющий заливать области, цвет которых
+ * немного меняется (например, на фотографиях), и считать соседями точки,
+ * касающиеся друг друга углами.
+ *
+ * @param x горизонтальная координата начальной точки
+ * @param y вертикальная координата начальной точки
+ * @param color цвет заливки
+ * @param params параметры заливки.
+ *
+ * @see LabFloodFill
+ */
+void LabFloodFillWith(int x, int y, labrgb_t color, labfillparams_t const* params);
+
+/**
+ * @brief Способ закраски фигуры.
+ *
+ * @see labpaint_t
+ */
+typedef enum labpainttype_t
+{
+  LABPAINT_LINEAR, ///< линейный градиент: цвет color0 в точке (x0, y0) плавно переходит в color1 в точке (x1, y1)
+  LABPAINT_RADIAL, ///< радиальный градиент: цвет color0 в центре (x0, y0) плавно переходит в color1 на расстоянии radius
+  LABPAINT_SPAN    ///< цвета точек вычисляет функция пользователя span
+} labpainttype_t;
+
+/**
+ * @brief Функция, вычисляющая цвета отрезка строки.
+ *
+ * Вызывается один раз для каждого горизонтального отрезка закрашиваемой
+ * фигуры, а не для каждой точки. Должна записать в массив pixels цвета
+ * count точек, начиная с точки (x, y) и дальше вправо. Перед вызовом массив
+ * содержит текущие цвета этих точек, поэтому их можно и смешивать с новыми.
+ *
+ * @param x горизонтальная координата первой точки отрезка (с учётом начала координат)
+ * @param y вертикальная координата отрезка
+ * @param count количество точек в отрезке
+ * @param pixels цвета точек отрезка
+ * @param context значение поля context из описания закраски.
+ */
+typedef void (*labspanfunc_t)(int x, int y, int count, labrgb_t* pixels, void* context);
+
+/**
+ * @brief Описание закраски фигуры.
+ *
+ * Используется функциями LabFillRect(), LabFillCircle() и LabFillPolygon().
+ * Поля, не нужные для выбранного способа закраски, не используются.
+ * Промежуточные цвета градиентов вычисляются с точностью 1/256 расстояния
+ * между крайними; за пределами градиента используются крайние цвета.
+ */
+typedef struct labpaint_t
+{
+  labpainttype_t type;   ///< способ закраски
+  float x0, y0;          ///< начало линейного градиента или центр радиального
+  float x1, y1;          ///< конец линейного градиента
+  float radius;          ///< радиус радиального градиента
+  labrgb_t color0;       ///< цвет в начале градиента
+  labrgb_t color1;       ///< цвет в конце градиента
+  labspanfunc_t span;    ///< функция пользователя для @ref LABPAINT_SPAN
+  void* context;         ///< произвольное значение, передаваемое функции span
+} labpaint_t;
+
+/**
+ * @brief Закрасить прямоугольник.
+ *
+ * Правая и нижняя границы в прямоугольник не входят, как и у labrect_t.
+ * Градиенты задаются в тех же координатах, что и фигура, и не зависят
+ * от её положения: соседние фигуры с одинаковой закраской стыкуются без швов.
+ *
+ * Закраска функцией пользователя не записывается в журнал как вызов
+ * (функцию нельзя сохранить в файл), вместо этого записываются получившиеся
+ * точки.
+ *
+ * @param x1 горизонтальная координата левой границы
+ * @param y1 вертикальная координата верхней границы
+ * @param x2 горизонтальная координата правой границы
+ * @param y2 вертикальная координата нижней границы
+ * @param paint способ закраски.
+ *
+ * @see LabFillCircle, LabFillPolygon
+ */
+void LabFillRect(int x1, int y1, int x2, int y2, labpaint_t const* paint);
+
+/**
+ * @brief Закрасить круг.
+ *
+ * Закрашиваются точки, удалённые от центра (x, y) не больше чем на radius.
+ *
+ * @param x горизонтальная координата центра
+ * @param y вертикальная координата центра
+ * @param radius радиус круга
+ * @param paint способ закраски.
+ *
+ * @see LabFillRect, LabFillPolygon
+ */
+void LabFillCircle(int x, int y, int radius, labpaint_t const* paint);
+
+/**
+ * @brief Закрасить многоугольник.
+ *
+ * Закрашиваются точки, центры которых лежат внутри многоугольника
+ * с вершинами points. Если стороны пересекаются, точка считается
+ * внутренней, когда луч из неё пересекает стороны нечётное число раз.
+ * Последняя вершина соединяется с первой.
+ *
+ * @param points массив вершин
+ * @param count количество вершин
+ * @param paint способ закраски.
+ *
+ * @see LabFillRect, LabFillCircle
+ */
+void LabFillPolygon(labpoint_t const* points, int count, labpaint_t const* paint);
+
+/**
+ * @brief Вершина треугольника.
+ *
+ * @see LabFillTriangle
+ */
+typedef struct labvertex_t
+{
+  float x, y;      ///< координаты вершины, как у функций с дробными координатами
+  float z;         ///< глубина от 0 (ближе всего) до 1, используется после LabDepthStart()
+  labrgb_t color;  ///< цвет в вершине
+} labvertex_t;
+
+/**
+ * @brief Закрасить треугольник с плавным переходом цветов.
+ *
+ * Закрашиваются точки, центры которых лежат внутри треугольника. Точка на
+ * общей стороне двух треугольников закрашивается только одним из них, поэтому
+ * сетка из треугольников закрашивается без щелей и без двойного наложения
+ * цвета. Цвет и глубина каждой точки плавно меняются между вершинами
+ * (закраска Гуро). Порядок вершин любой.
+ *
+ * После LabDepthStart() точка рисуется, только если её глубина меньше
+ * глубины, уже записанной для этой точки, и тогда глубина запоминается.
+ * Так ближние треугольники закрывают дальние в любом порядке рисования.
+ *
+ * @param vertices массив из трёх вершин.
+ *
+ * @see labvertex_t, LabDepthStart
+ */
+void LabFillTriangle(labvertex_t const* vertices);
+
+/**
+ * @brief Включить проверку глубины.
+ *
+ * Создаёт буфер глубины размером с буфер рисования, общий для всех слоёв,
+ * и очищает его. 16-битный буфер занимает вдвое меньше памяти, 32-битный
+ * различает гораздо более близкие глубины. Повторный вызов создаёт буфер
+ * заново.
+ *
+ * @param bits 16 или 32 бита на точку.
+ *
+ * @return @ref LAB_TRUE, если буфер создан.
+ *
+ * @see LabFillTriangle, LabDepthClear, LabDepthStop
+ */
+labbool_t LabDepthStart(int bits);
+
+/**
+ * @brief Очистить буфер глубины.
+ *
+ * Обычно вызывается вместе с LabClear() перед рисованием кадра.
+ */
+void LabDepthClear(void);
+
+/**
+ * @brief Выключить проверку глубины и освободить буфер.
+ */
+void LabDepthStop(void);
+
+/**
+ * @brief Набор частиц.
+ *
+ * Хранит положения, скорости, цвета и время жизни множества частиц для
+ * анимаций вроде фейерверков, газа или орбит. Создаётся функцией
+ * LabParticlesCreate(), двигается LabParticlesUpdate() и рисуется
+ * LabParticlesDraw(). Все частицы набора обрабатываются за один вызов,
+ * что намного быстрее, чем двигать и рисовать каждую по отдельности.
+ */
+typedef struct labparticles_t labparticles_t;
+
+/**
+ * @brief Что происходит с частицей на границе области.
+ *
+ * @see labparticleparams_t
+ */
+typedef enum labparticleedge_t
+{
+  LABPARTICLE_PASS,   ///< частица свободно летит дальше
+  LABPARTICLE_BOUNCE, ///< частица отражается от границы
+  LABPARTICLE_REMOVE  ///< частица исчезает
+} labparticleedge_t;
+
+/**
+ * @brief Параметры движения частиц.
+ *
+ * Используются при вызове функции LabParticlesUpdate(). Координаты
+ * измеряются в точках, время --- в секундах.
+ */
+typedef struct labparticleparams_t
+{
+  float ax, ay;             ///< ускорение всех частиц (например, сила тяжести)
+  labparticleedge_t edge;   ///< поведение частиц на границе области
+  float left, top;          ///< левая и верхняя граница области
+  float right, bottom;      ///< правая и нижняя граница области
+  float bounce;             ///< доля скорости, сохраняющаяся при отражении (1 - без потерь)
+} labparticleparams_t;
+
+/**
+ * @brief Создать набор частиц.
+ *
+ * @param capacity наибольшее количество частиц в наборе.
+ * @return новый пустой набор или NULL, если не хватило памяти.
+ *
+ * @see LabParticlesDestroy
+ */
+labparticles_t* LabParticlesCreate(int capacity);
+
+/**
+ * @brief Удалить набор частиц.
+ *
+ * @param particles набор, созданный функцией LabParticlesCreate(), или NULL.
+ */
+void LabParticlesDestroy(labparticles_t* particles);
+
+/**
+ * @brief Добавить частицу.
+ *
+ * @param particles набор частиц
+ * @param x горизонтальная координата частицы
+ * @param y вертикальная координата частицы
+ * @param vx горизонтальная скорость, точек в секунду
+ * @param vy вертикальная скорость, точек в секунду
+ * @param color цвет частицы
+ * @param life время жизни в секундах, 0 --- частица живёт, пока не покинет область.
+ * @return @ref LAB_TRUE, если частица добавлена, или @ref LAB_FALSE, если набор заполнен.
+ */
+labbool_t LabParticlesAdd(labparticles_t* particles, float x, float y, float vx, float vy, labrgb_t color, float life);
+
+/**
+ * @brief Узнать количество частиц в наборе.
+ *
+ * @param particles набор частиц.
+ * @return количество живых частиц.
+ */
+int LabParticlesCount(labparticles_t const* particles);
+
+/**
+ * @brief Передвинуть частицы.
+ *
+ * Продвигает все частицы на время dt: скорости меняются на ускорение,
+ * положения --- на скорость. Частицы, время жизни которых истекло,
+ * удаляются; порядок оставшихся частиц при этом может измениться.
+ *
+ * @param particles набор частиц
+ * @param dt прошедшее время в секундах
+ * @param params параметры движения или NULL, если ускорения и границ нет.
+ */
+void LabParticlesUpdate(labparticles_t* particles, float dt, labparticleparams_t const* params);
+
+/**
+ * @brief Нарисовать частицы.
+ *
+ * Каждая частица рисуется одной точкой своего цвета в ближайшей к ней
+ * точке буфера с учётом начала координат. Частицы за пределами области
+ * отсечения пропускаются. Текущий цвет не используется и не меняется.
+ *
+ * @param particles набор частиц.
+ */
+void LabParticlesDraw(labparticles_t const* particles);
+
+/**
+ * @brief Карта из плиток.
+ *
+ * Прямоугольная сетка клеток, в каждой из которых рисуется одна из плиток ---
+ * небольших картинок одинакового размера. Подходит для игр на клетчатом
+ * поле: змейки, тетриса, лабиринтов, игры "Жизнь". Карта помнит, какие
+ * клетки изменились, и LabTilemapDraw() перерисовывает только их, так что
+ * время рисования зависит от количества изменений, а не от размера поля.
+ */
+typedef struct labtilemap_t labtilemap_t;
+
+/**
+ * @brief Создать карту из плиток.
+ *
+ * Изначально все плитки чёрные, а во всех клетках находится плитка 0.
+ *
+ * @param columns количество клеток по горизонтали
+ * @param rows количество клеток по вертикали
+ * @param tileWidth ширина плитки в точках
+ * @param tileHeight высота плитки в точках
+ * @param tileCount количество разных плиток.
+ * @return новая карта или NULL, если не хватило памяти.
+ *
+ * @see LabTilemapDestroy
+ */
+labtilemap_t* LabTilemapCreate(int columns, int rows, int tileWidth, int tileHeight, int tileCount);
+
+/**
+ * @brief Удалить карту из плиток.
+ *
+ * @param map карта, созданная функцией LabTilemapCreate(), или NULL.
+ */
+void LabTilemapDestroy(labtilemap_t* map);
+
+/**
+ * @brief Задать картинку плитки.
+ *
+ * Копирует в плитку tile цвета точек из массива pixels строка за строкой.
+ * Все клетки карты при следующем рисовании будут перерисованы.
+ *
+ * @param map карта
+ * @param tile номер плитки, от 0 до <code>tileCount - 1</code>
+ * @param pixels цвета точек плитки
+ * @param stride расстояние между началами соседних строк в массиве pixels,
+ *        в элементах (обычно равно ширине плитки).
+ */
+void LabTilemapSetTile(labtilemap_t* map, int tile, labrgb_t const* pixels, int stride);
+
+/**
+ * @brief Положить плитку в клетку.
+ *
+ * Клетка будет перерисована при следующем вызове LabTilemapDraw(), если
+ * плитка в ней изменилась.
+ *
+ * @param map карта
+ * @param x номер столбца клетки (0 слева)
+ * @param y номер строки клетки (0 сверху)
+ * @param tile номер плитки.
+ */
+void LabTilemapSet(labtilemap_t* map, int x, int y, int tile);
+
+/**
+ * @brief Узнать, какая плитка лежит в клетке.
+ *
+ * @param map карта
+ * @param x номер столбца клетки
+ * @param y номер строки клетки.
+ * @return номер плитки или -1 для клетки за пределами карты.
+ */
+int LabTilemapGet(labtilemap_t const* map, int x, int y);
+
+/**
+ * @brief Перерисовать всю карту.
+ *
+ * Отмечает все клетки как изменённые. Нужна, если поверх карты рисовали
+ * другими функциями. Очистка LabClear() и LabClearWith(), перемещение карты,
+ * смена слоя и области отсечения учитываются автоматически.
+ *
+ * @param map карта.
+ */
+void LabTilemapInvalidate(labtilemap_t* map);
+
+/**
+ * @brief Нарисовать карту.
+ *
+ * Рисует клетки, изменившиеся с прошлого вызова, так что левый верхний угол
+ * карты оказывается в точке (x, y). Чтобы это давало полную картинку,
+ * не очищайте буфер перед рисованием карты: после LabClear() карта будет
+ * нарисована целиком.
+ *
+ * @param map карта
+ * @param x горизонтальная координата левого верхнего угла карты
+ * @param y вертикальная координата левого верхнего угла карты.
+ */
+void LabTilemapDraw(labtilemap_t* map, int x, int y);
+
+/**
+ * @brief Картинка для рисования спрайтов.
+ *
+ * Описывает массив цветов точек, принадлежащий программе. Библиотека его
+ * не копирует, поэтому массив должен существовать, пока картинка используется.
+ *
+ * @see LabSpriteSubmit
+ */
+typedef struct labimage_t
+{
+  int width;               ///< ширина картинки в точках
+  int height;              ///< высота картинки в точках
+  labrgb_t const* pixels;  ///< цвета точек строка за строкой, <code>width * height</code> элементов
+  labbool_t transparent;   ///< @ref LAB_TRUE, если точки цвета key не рисуются
+  labrgb_t key;            ///< прозрачный цвет
+} labimage_t;
+
+/**
+ * @brief Начать набор спрайтов.
+ *
+ * Спрайты, переданные функции LabSpriteSubmit() между LabSpriteBegin()
+ * и LabSpriteEnd(), накапливаются и рисуются все вместе в порядке
+ * возрастания глубины z. Так программе не нужно самой сортировать сцену
+ * из тысяч перекрывающихся спрайтов, а рисование выполняется за один проход.
+ *
+ * @see LabSpriteSubmit, LabSpriteEnd
+ */
+void LabSpriteBegin(void);
+
+/**
+ * @brief Добавить спрайт в набор.
+ *
+ * Спрайты с большим z рисуются поверх спрайтов с меньшим, спрайты
+ * с одинаковым z --- в порядке вызовов LabSpriteSubmit().
+ * Начало координат и область отсечения учитываются в момент вызова,
+ * спрайты за пределами области отсечения сразу отбрасываются.
+ *
+ * @param image картинка спрайта, должна существовать до вызова LabSpriteEnd()
+ * @param x горизонтальная координата левого верхнего угла
+ * @param y вертикальная координата левого верхнего угла
+ * @param z глубина спрайта.
+ *
+ * @see LabSpriteBegin, LabSpriteEnd
+ */
+void LabSpriteSubmit(labimage_t const* image, int x, int y, int z);
+
+/**
+ * @brief Нарисовать набор спрайтов.
+ *
+ * Рисует все спрайты, добавленные с момента вызова LabSpriteBegin(),
+ * и очищает набор.
+ *
+ * @see LabSpriteBegin, LabSpriteSubmit
+ */
+void LabSpriteEnd(void);
+
+/**@}*/
+
+
+/**
+ * @defgroup input_group Input Methods
+ *
+ * Группа функций, обеспечивающая возможность работы с клавиатурой.
+ * Подробнее о группе: @ref input_group
+ * @{
+ */
+
+/**
+ * @brief Коды несимвольных клавиш.
+ *
+ * Специальные коды для клавиш Enter, Escape, стрелок...
+ * Наряду с ASCII-кодами символьных клавиш, являются возвращаемым значением
+ * из функции LabInputKey().
+ *
+ * @see LabInputKey
+ */
+typedef enum labkey_t
+{ 
+  LABKEY_ENTER = 0x0D00,      ///< Enter 
+  LABKEY_ESC = 0x1B00,        ///< Escape 
+  LABKEY_BACK = 0x0800,       ///< Backspace 
+  LABKEY_TAB = 0x0900,        ///< Tab 
+  LABKEY_PAGE_UP = 0x2100,    ///< PageUp 
+  LABKEY_PAGE_DOWN = 0x2200,  ///< PageDown 
+  LABKEY_LEFT = 0x2500,       ///< Стрелка влево
+  LABKEY_UP = 0x2600,         ///< Стрелка вверх
+  LABKEY_RIGHT = 0x2700,      ///< Стрелка вправо
+  LABKEY_DOWN = 0x2800,       ///< Стрелка вниз
+ 
+} labkey_t;
+
+/**
+ * @brief Ожидать нажатия клавиши и узнать её код.
+ * 
+ * Ожидает нажатия клавиши, а затем, когда клавиша нажата, возвращает её код -
+ * ASCII-код для символьных клавиш или код из перечисления <code>labkey_t</code>
+ * для несимвольных клавиш (такий как Enter, Escape, стрелки ... ).
+ *
+ * @return код нажатой клавиши.
+ * @see labkey_t
+ */
+labkey_t LabInputKey(void);
+
+/**
+ * @brief Добавить нажатие клавиши в очередь.
+ *
+ * Клавиша будет получена LabInputKey() так же, как нажатая на клавиатуре.
+ * Функцию можно вызывать из любого потока, например, чтобы имитировать
+ * ввод в режиме @ref LABFLAG_HEADLESS.
+ *
+ * @param key код клавиши, как его возвращает LabInputKey().
+ */
+void LabInputKeyPost(labkey_t key);
+
+/**
+ * Проверить наличие необработанных нажатий клавиш.
+ *
+ * @return @ref LAB_TRUE если есть необработанные нажатия клавиш, @ref LAB_FALSE, если таких нет.
+ */
+labbool_t LabInputKeyReady(void);
+
+/**
+ * @brief Обработчики событий для LabRun().
+ *
+ * Любой из обработчиков может быть равен NULL.
+ *
+ * @see LabRun
+ */
+typedef struct labcallbacks_t
+{
+  void (*onFrame)(void* context);              ///< нарисовать кадр, после него вызывается LabDrawFlush()
+  void (*onKey)(labkey_t key, void* context);  ///< обработать нажатие клавиши
+  void (*onTimer)(int timer, void* context);   ///< обработать срабатывание таймера
+  void* context;                               ///< значение, передаваемое обработчикам
+} labcallbacks_t;
+
+/**
+ * @brief Обрабатывать события до вызова LabRunStop().
+ *
+ * В отличие от цикла, проверяющего LabInputKeyReady(), программа не
+ * занимает процессор, пока ничего не происходит: LabRun() спит до
+ * ближайшего таймера или нажатия клавиши. Кадр рисуется первый раз
+ * и затем только после вызова LabRunInvalidate(). Если ждать больше
+ * нечего, например в режиме @ref LABFLAG_HEADLESS без таймеров
+ * и без источника нажатий, функция возвращает управление.
+ *
+ * @param callbacks обработчики событий.
+ *
+ * @see labcallbacks_t, LabRunStop, LabRunInvalidate, LabTimerStart
+ */
+void LabRun(labcallbacks_t const* callbacks);
+
+/**
+ * @brief Завершить LabRun() после текущего обработчика.
+ *
+ * @see LabRun
+ */
+void LabRunStop(void);
+
+/**
+ * @brief Попросить LabRun() нарисовать кадр.
+ *
+ * Несколько вызовов до следующего кадра дают один кадр. Вызов из
+ * onFrame() рисует кадры без перерыва, например для анимации.
+ *
+ * @see LabRun
+ */
+void LabRunInvalidate(void);
+
+/**
+ * @brief Узнать, сколько раз LabRun() просыпался.
+ *
+ * Считаются ожидания таймера или клавиши с момента последнего вызова
+ * LabRun(). Позволяет проверить, что программа не занимает процессор
+ * без дела.
+ *
+ * @return число пробуждений.
+ */
+int LabRunWakeups(void);
+
+/**
+ * @brief Запустить таймер.
+ *
+ * Таймер срабатывает только внутри LabRun() и вызывает onTimer() со своим
+ * номером. Точность таймера ограничена системными часами.
+ *
+ * @param delay число миллисекунд до первого срабатывания
+ * @param period число миллисекунд между срабатываниями, 0 для однократного таймера.
+ *
+ * @return номер таймера или 0, если таймеров слишком много.
+ *
+ * @see LabTimerStop, LabRun
+ */
+int LabTimerStart(int delay, int period);
+
+/**
+ * @brief Остановить таймер.
+ *
+ * Номера отработавших или уже остановленных таймеров игнорируются.
+ *
+ * @param timer номер таймера, полученный от LabTimerStart().
+ */
+void LabTimerStop(int timer);
+
+/**
+ * @brief Этап обработки нажатия клавиши.
+ *
+ * Время каждого этапа отсчитывается от момента, когда нажатие попало
+ * в очередь клавиш.
+ *
+ * @see LabLatencyGetInfo
+ */
+typedef enum lablatencystage_t
+{
+  LABLATENCY_QUEUE,       ///< программа получила клавишу от LabInputKey() или LabRun()
+  LABLATENCY_FLUSH,       ///< программа вызвала LabDrawFlush() после этого
+  LABLATENCY_PRESENT,     ///< кадр выведен в окно (или в консоль)
+  LABLATENCY_STAGE_COUNT, ///< Количество этапов
+} lablatencystage_t;
+
+/**
+ * @brief Задержки одного этапа обработки нажатий.
+ *
+ * Все времена в микросекундах, с точностью около 6%.
+ *
+ * @see LabLatencyGetInfo
+ */
+typedef struct lablatencyinfo_t
+{
+  int count;  ///< число измеренных нажатий
+  float p50;  ///< медиана: половина нажатий прошла этап быстрее
+  float p99;  ///< 99% нажатий прошли этап быстрее
+  float max;  ///< самая большая задержка
+} lablatencyinfo_t;
+
+/**
+ * @brief Узнать задержки обработки нажатий.
+ *
+ * Библиотека всегда отмечает время нажатия каждой клавиши и момент, когда
+ * программа её получила, а затем --- когда следующий кадр после этого
+ * отдан в LabDrawFlush() и выведен на экран. Если ввод кажется
+ * запаздывающим, сравнение этапов показывает, где теряется время: в
+ * очереди, пока программа занята, или при рисовании и выводе кадра.
+ *
+ * @param stage этап из перечисления <code>lablatencystage_t</code>.
+ * @param info структура для результата.
+ *
+ * @see LabLatencyPercentile, LabLatencyReset
+ */
+void LabLatencyGetInfo(lablatencystage_t stage, lablatencyinfo_t* info);
+
+/**
+ * @brief Узнать задержку, которую не превышает заданная доля нажатий.
+ *
+ * @param stage этап из перечисления <code>lablatencystage_t</code>.
+ * @param percent доля нажатий в процентах, от 0 до 100.
+ *
+ * @return задержка в микросекундах или 0, если нажатий ещё не было.
+ */
+float LabLatencyPercentile(lablatencystage_t stage, float percent);
+
+/**
+ * @brief Забыть измеренные задержки.
+ *
+ * Например, перед началом замера в тесте.
+ */
+void LabLatencyReset(void);
+
+/** @}*/
+
+/**
+ * @defgroup server_group Remote Viewer
+ *
+ * Просмотр картинки и ввод с клавиатуры из другой программы, например, когда
+ * библиотека работает в режиме @ref LABFLAG_HEADLESS на машине без экрана,
+ * и чтение кадров другими программами через общую память.
+ *
+ * @{
+ */
+
+/**
+ * @brief Запустить сервер для удалённого просмотра.
+ *
+ * Сервер принимает одно подключение по TCP на адресе 127.0.0.1 и указанном
+ * порту и после каждого вызова LabDrawFlush() отправляет подключённой
+ * программе просмотра изменившиеся части буфера рисования. Кодирование и
+ * отправка происходят в отдельном потоке. Если программа просмотра не
+ * успевает принимать данные, промежуточные кадры пропускаются, а рисование
+ * не замедляется. Клавиши, присланные программой просмотра, попадают в ту
+ * же очередь, что и нажатия в окне, и возвращаются функцией LabInputKey().
+ * В режиме @ref LABFLAG_HEADLESS при запущенном сервере LabInputKey() ждёт
+ * нажатия клавиши.
+ *
+ * Протокол (все числа --- little-endian, u16 и u32 --- беззнаковые
+ * целые размером 2 и 4 байта):
+ * - при подключении сервер отправляет приветствие: байты <code>LABF</code>,
+ *   u16 версия протокола (1), u16 ширина, u16 высота буфера и u16 размер
+ *   стороны квадратного блока;
+ * - кадр: байт <code>F</code>, u32 номер кадра, u32 число блоков и сами
+ *   блоки. Блок: u16 x, u16 y, u16 ширина, u16 высота, байт способа
+ *   кодирования, u32 размер данных и данные. Способ 0 --- цвета точек
+ *   блока строка за строкой (u32 0x00RRGGBB), способ 1 --- пары
+ *   (u16 длина, u32 значение), значения надо применить операцией XOR к
+ *   точкам блока, которые уже есть у программы просмотра. После
+ *   подключения считается, что у программы просмотра весь экран чёрный;
+ * - программа просмотра отправляет клавиши: байт <code>K</code> и u32 код
+ *   клавиши (см. LabInputKey()).
+ *
+ * @param port номер порта TCP.
+ * @return @ref LAB_TRUE, если сервер запущен, @ref LAB_FALSE, если он уже
+ *         был запущен или порт занят.
+ *
+ * @see LabServerStop
+ */
+labbool_t LabServerStart(int port);
+
+/**
+ * @brief Остановить сервер для удалённого просмотра.
+ *
+ * Отключает программу просмотра и освобождает порт. Вызывается
+ * автоматически из LabTerm().
+ *
+ * @see LabServerStart
+ */
+void LabServerStop(void);
+
+/**
+ * @brief Формат точек кадра в общей памяти.
+ */
+typedef enum labshareformat_t
+{
+  LABSHARE_FORMAT_XRGB8888 = 1, ///< 32 бита на точку, 0x00RRGGBB (см. labrgb_t)
+} labshareformat_t;
+
+/// Значение поля labshareheader_t::magic, байты <code>LABS</code>.
+#define LABSHARE_MAGIC 0x5342414Cu
+
+/**
+ * @brief Заголовок кадра в общей памяти.
+ *
+ * Лежит в начале области, созданной функцией LabShareStart(). Поля
+ * sequence и frame меняются при каждом вызове LabDrawFlush(), остальные
+ * постоянны.
+ */
+typedef struct labshareheader_t
+{
+  unsigned magic;         ///< @ref LABSHARE_MAGIC
+  unsigned size;          ///< размер всей области в байтах
+  unsigned offset;        ///< смещение первой точки кадра от начала заголовка в байтах
+  unsigned width;         ///< ширина кадра
+  unsigned height;        ///< высота кадра
+  unsigned pitch;         ///< расстояние между началами соседних строк в байтах
+  unsigned format;        ///< формат точек, значение labshareformat_t
+  long volatile sequence; ///< счётчик записей, нечётный, пока кадр записывается
+  unsigned frame;         ///< номер кадра, увеличивается при каждой записи кадра
+} labshareheader_t;
+
+/**
+ * @brief Открыть доступ к кадрам через общую память.
+ *
+ * Создаёт именованную общую память (file mapping) с заголовком
+ * labshareheader_t и копией буфера рисования, которая обновляется при каждом
+ * вызове LabDrawFlush(). Другие программы могут читать кадры без обращения к
+ * окну и без блокировок: запись кадра окружена увеличением счётчика
+ * sequence (seqlock), и чтение надо повторить, если счётчик был нечётным или
+ * изменился за время копирования.
+ *
+ * @code
+ * HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, "Local\\mylab");
+ * labshareheader_t const* header = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+ * long sequence;
+ * do
+ * {
+ *   sequence = header->sequence;
+ *   MemoryBarrier();
+ *   memcpy(pixels, (char const*)header + header->offset, header->height * header->pitch);
+ *   MemoryBarrier();
+ * } while ((sequence & 1) || header->sequence != sequence);
+ * @endcode
+ *
+ * @param name имя общей памяти, например <code>"Local\\mylab"</code>.
+ * @return @ref LAB_TRUE в случае успеха, @ref LAB_FALSE, если доступ уже
+ *         открыт или имя занято.
+ *
+ * @see LabShareStop
+ */
+labbool_t LabShareStart(char const* name);
+
+/**
+ * @brief Закрыть доступ к кадрам через общую память.
+ *
+ * Вызывается автоматически из LabTerm(). Программы, которые уже открыли
+ * общую память, продолжают видеть последний кадр.
+ *
+ * @see LabShareStart
+ */
+void LabShareStop(void);
+
+/** @}*/
+
+/**
+ * @defgroup journal_group Journal
+ *
+ * Запись вызовов библиотеки в файл и их воспроизведение, чтобы повторить
+ * сеанс работы программы без участия человека, например, для измерения
+ * скорости рисования.
+ *
+ * @{
+ */
+
+/**
+ * @brief Начать запись журнала.
+ *
+ * Создаёт файл и записывает в него содержимое буфера рисования, текущие
+ * цвет, область отсечения и начало координат, а затем каждый вызов функций,
+ * которые меняют буфер или состояние рисования, вместе с аргументами.
+ * Туда же попадают результаты LabInputKey() и LabInputKeyReady() и
+ * задержки LabDelay(). Числа записываются в сжатом виде, так что журнал
+ * обычно занимает несколько байт на вызов. Функции, которые только читают
+ * буфер или состояние (LabGetPixel(), LabGetWidth() и т.п.), не
+ * записываются. Вызовы из других потоков во время записи не допускаются.
+ *
+ * @param path имя файла журнала.
+ * @return @ref LAB_TRUE в случае успеха, @ref LAB_FALSE, если запись уже
+ *         идёт или файл не удалось создать.
+ *
+ * @see LabJournalStop, LabJournalReplay
+ */
+labbool_t LabJournalStart(char const* path);
+
+/**
+ * @brief Закончить запись журнала.
+ *
+ * Вызывается автоматически из LabTerm().
+ *
+ * @return @ref LAB_TRUE, если весь журнал записан в файл, @ref LAB_FALSE,
+ *         если запись не шла или при записи произошла ошибка.
+ *
+ * @see LabJournalStart
+ */
+labbool_t LabJournalStop(void);
+
+/**
+ * @brief Воспроизвести журнал.
+ *
+ * Сбрасывает область отсечения и начало координат и повторяет все
+ * записанные вызовы так быстро, как только возможно: задержки LabDelay()
+ * пропускаются, а клавиши не ждутся, ведь все решения программы уже
+ * записаны в журнал. Результат совпадает с тем, что было нарисовано во
+ * время записи, поэтому воспроизведение в режиме @ref LABFLAG_HEADLESS
+ * годится для сравнения скорости разных версий библиотеки на одном и том
+ * же сеансе.
+ *
+ * @param path имя файла журнала.
+ * @return @ref LAB_TRUE в случае успеха, @ref LAB_FALSE, если файл не
+ *         удалось прочитать, он повреждён или размер буфера рисования не
+ *         совпадает с размером во время записи.
+ *
+ * @see LabJournalStart
+ */
+labbool_t LabJournalReplay(char const* path);
+
+/** @}*/
+
+/**
+ * @defgroup history_group Frame History
+ *
+ * Хранение последних кадров в памяти, чтобы при поиске ошибок в анимации
+ * можно было вернуться на несколько кадров назад.
+ *
+ * @{
+ */
+
+/**
+ * @brief Сведения об истории кадров.
+ *
+ * @see LabHistoryGetInfo
+ */
+typedef struct labhistoryinfo_t
+{
+  int frames;              ///< число кадров, которые можно восстановить
+  int deltaBytes;          ///< байт занято разностями кадров
+  int memoryBytes;         ///< всего байт памяти, занятой историей
+  int flushes;             ///< число кадров, записанных с вызова LabHistoryStart()
+  float flushMicroseconds; ///< среднее время записи одного кадра в микросекундах
+} labhistoryinfo_t;
+
+/**
+ * @brief Начать запись истории кадров.
+ *
+ * При каждом вызове LabDrawFlush() запоминается разность нового кадра с
+ * предыдущим (XOR точек, сжатый повторами), а кадры восстанавливаются
+ * от последнего назад. Обычно кадр отличается от предыдущего немногими
+ * точками, так что в память помещаются сотни кадров. Когда место
+ * кончается, забываются самые старые кадры. Кроме разностей хранится одна
+ * копия последнего кадра.
+ *
+ * В окне клавиша F12 сохраняет все кадры истории в файлы, как
+ * LabHistoryDump() с префиксом "labhistory". Файлы записываются при
+ * следующем вызове LabDrawFlush(), так что окно продолжает отвечать.
+ *
+ * @param budget число байт памяти для разностей кадров.
+ * @return @ref LAB_TRUE в случае успеха, @ref LAB_FALSE, если история уже
+ *         записывается или не хватило памяти.
+ *
+ * @see LabHistoryStop, LabHistoryGetFrame, LabHistoryDump
+ */
+labbool_t LabHistoryStart(int budget);
+
+/**
+ * @brief Закончить запись истории кадров и освободить память.
+ *
+ * Вызывается автоматически из LabTerm().
+ */
+void LabHistoryStop(void);
+
+/**
+ * @brief Узнать число кадров в истории.
+ *
+ * @return число кадров, которые можно восстановить.
+ */
+int LabHistoryCount(void);
+
+/**
+ * @brief Восстановить кадр из истории.
+ *
+ * @param age номер кадра, считая назад от последнего: 0 - кадр последнего
+ *   вызова LabDrawFlush(), 1 - предыдущий и т.д.
+ * @param pixels массив <code>LabGetWidth() * LabGetHeight()</code> цветов,
+ *   куда записывается кадр строка за строкой.
+ * @return @ref LAB_TRUE в случае успеха, @ref LAB_FALSE, если такого кадра
+ *   в истории нет.
+ */
+labbool_t LabHistoryGetFrame(int age, labrgb_t* pixels);
+
+/**
+ * @brief Сохранить кадры истории в файлы BMP.
+ *
+ * Кадры с номерами от first до last (считая назад от последнего, как в
+ * LabHistoryGetFrame()) записываются в файлы с именами из префикса и
+ * порядкового номера кадра с вызова LabHistoryStart(), например
+ * "labhistory000123.bmp", так что файлы идут в порядке показа. Файлы
+ * записываются с копии истории, и рисование в других потоках на это время
+ * не останавливается.
+ *
+ * @param prefix начало имён файлов, может включать путь
+ * @param first номер самого нового из сохраняемых кадров
+ * @param last номер самого старого из сохраняемых кадров.
+ * @return число сохранённых кадров.
+ */
+int LabHistoryDump(char const* prefix, int first, int last);
+
+/**
+ * @brief Узнать, сколько памяти и времени занимает история кадров.
+ *
+ * @param info структура, которая заполняется сведениями.
+ */
+void LabHistoryGetInfo(labhistoryinfo_t* info);
+
+/** @}*/
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LABENGINE_H_INCLUDED
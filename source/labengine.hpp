@@ -0,0 +1,634 @@
+#ifndef LABENGINE_HPP_INCLUDED
+#define LABENGINE_HPP_INCLUDED
+#pragma once
+
+/**
+ * @file labengine.hpp
+ * @brief Необязательная обёртка библиотеки для языка C++.
+ *
+ * Содержит классы, автоматически вызывающие парные функции библиотеки
+ * (LabInit() и LabTerm(), LabPushClip() и LabPopClip()), и поверхности
+ * для рисования в памяти в разных форматах точек, в том числе разбитые
+ * на плитки для быстрого доступа по столбцам. Функции рисования на
+ * поверхностях являются шаблонами, параметризованными форматом точек и
+ * режимом смешивания, поэтому выбор формата и режима происходит один раз
+ * при компиляции, а не для каждой точки.
+
+@code{.cpp}
+#include "labengine.hpp"
+
+int main(void)
+{
+  lab::Engine engine;
+  if (engine.IsOk())
+  {
+    lab::Surface<lab::Rgb565> sprite(64, 64);
+    lab::Fill<lab::BlendCopy>(sprite, 0, 0, 64, 64, LABRGB(0, 0, 255));
+    lab::Fill<lab::BlendAdd>(sprite, 16, 16, 32, 32, LABRGB(255, 0, 0));
+    lab::Present(sprite, 10, 10);
+    LabDrawFlush();
+    LabInputKey();
+  }
+  return 0;
+}
+@endcode
+ */
+
+#include "labengine.h"
+#include <string.h>
+#include <vector>
+
+namespace lab {
+
+/**
+ * @defgroup cpp_group C++ Wrapper
+ *
+ * Классы и шаблоны обёртки для языка C++.
+ *
+ * @{
+ */
+
+/**
+ * @brief Инициализация библиотеки на время жизни объекта.
+ *
+ * Конструктор вызывает LabInit(), LabInitWith() или LabInitWithFlags(), деструктор --- LabTerm(),
+ * если инициализация прошла успешно.
+ */
+class Engine
+{
+public:
+  Engine() : m_ok(LabInit() != LAB_FALSE) {}
+  explicit Engine(labparams_t const& params) : m_ok(LabInitWith(&params) != LAB_FALSE) {}
+  Engine(labparams_t const& params, unsigned flags) : m_ok(LabInitWithFlags(&params, flags) != LAB_FALSE) {}
+  ~Engine() { if (m_ok) LabTerm(); }
+
+  /// Успешно ли инициализирована библиотека.
+  bool IsOk() const { return m_ok; }
+
+private:
+  Engine(Engine const&);
+  Engine& operator=(Engine const&);
+
+  bool m_ok;
+};
+
+/**
+ * @brief Область отсечения на время жизни объекта.
+ *
+ * Конструктор вызывает LabPushClip(), деструктор --- LabPopClip().
+ */
+class ClipScope
+{
+public:
+  ClipScope(int x1, int y1, int x2, int y2) { LabPushClip(x1, y1, x2, y2); }
+  ~ClipScope() { LabPopClip(); }
+
+private:
+  ClipScope(ClipScope const&);
+  ClipScope& operator=(ClipScope const&);
+};
+
+/**
+ * @brief Формат точки BGRA8888: 32 бита, байты в памяти в порядке B, G, R, A.
+ *
+ * Совпадает с форматом буфера рисования, альфа-канал всегда равен 255.
+ * Каждый формат точки определяет тип точки pixel_t и функции Pack() и
+ * Unpack() для перевода цвета labrgb_t в точку и обратно.
+ */
+struct Bgra8888
+{
+  typedef unsigned int pixel_t;
+
+  pixel_t Pack(labrgb_t color) const { return color | 0xFF000000u; }
+  labrgb_t Unpack(pixel_t pixel) const { return pixel & 0x00FFFFFFu; }
+  bool operator==(Bgra8888 const&) const { return true; }
+};
+
+/**
+ * @brief Формат точки RGB565: 16 бит, по 5 бит на красный и синий каналы и 6 бит на зелёный.
+ */
+struct Rgb565
+{
+  typedef unsigned short pixel_t;
+
+  pixel_t Pack(labrgb_t color) const
+  {
+    return (pixel_t)(((color >> 8) & 0xF800) | ((color >> 5) & 0x07E0) | ((color >> 3) & 0x001F));
+  }
+  labrgb_t Unpack(pixel_t pixel) const
+  {
+    // the high bits are replicated into the low ones, so that white stays white
+    unsigned r = (pixel >> 11) & 0x1F, g = (pixel >> 5) & 0x3F, b = pixel & 0x1F;
+    return LABRGB((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+  }
+  bool operator==(Rgb565 const&) const { return true; }
+};
+
+/**
+ * @brief Палитра из 256 цветов для формата Indexed8.
+ *
+ * Для быстрого поиска ближайшего цвета палитра хранит таблицу на 32768
+ * элементов (по 5 бит на канал), которая заполняется в конструкторе.
+ */
+class Palette
+{
+public:
+  /// Палитра 3-3-2: 3 бита на красный и зелёный каналы и 2 бита на синий.
+  Palette()
+  {
+    int i;
+    for (i = 0; i < 256; i++)
+      m_colors[i] = LABRGB((i >> 5) * 255 / 7, ((i >> 2) & 7) * 255 / 7, (i & 3) * 255 / 3);
+    Build();
+  }
+
+  /// Палитра из заданных 256 цветов.
+  explicit Palette(labrgb_t const colors[256])
+  {
+    memcpy(m_colors, colors, sizeof(m_colors));
+    Build();
+  }
+
+  /// Цвет с номером index.
+  labrgb_t Color(unsigned char index) const { return m_colors[index]; }
+
+  /// Номер ближайшего к color цвета палитры.
+  unsigned char Nearest(labrgb_t color) const
+  {
+    return m_inverse[((color >> 9) & 0x7C00) | ((color >> 6) & 0x03E0) | ((color >> 3) & 0x001F)];
+  }
+
+private:
+  void Build()
+  {
+    int i, j;
+    for (i = 0; i < 32768; i++)
+    {
+      int r = ((i >> 7) & 0xF8) | 4, g = ((i >> 2) & 0xF8) | 4, b = ((i << 3) & 0xF8) | 4;
+      int best = 0, bestDistance = 0x7FFFFFFF;
+      for (j = 0; j < 256; j++)
+      {
+        int dr = r - (int)LABRGB_R(m_colors[j]), dg = g - (int)LABRGB_G(m_colors[j]), db = b - (int)LABRGB_B(m_colors[j]);
+        int distance = dr * dr + dg * dg + db * db;
+        if (distance < bestDistance)
+        {
+          best = j;
+          bestDistance = distance;
+        }
+      }
+      m_inverse[i] = (unsigned char)best;
+    }
+  }
+
+  labrgb_t m_colors[256];
+  unsigned char m_inverse[32768];
+};
+
+/**
+ * @brief Формат точки Indexed8: 8-битный номер цвета в палитре.
+ *
+ * Палитра не копируется и должна существовать, пока используется формат.
+ */
+class Indexed8
+{
+public:
+  typedef unsigned char pixel_t;
+
+  explicit Indexed8(Palette const& palette) : m_palette(&palette) {}
+
+  pixel_t Pack(labrgb_t color) const { return m_palette->Nearest(color); }
+  labrgb_t Unpack(pixel_t pixel) const { return m_palette->Color(pixel); }
+  bool operator==(Indexed8 const& other) const { return m_palette == other.m_palette; }
+
+private:
+  Palette const* m_palette;
+};
+
+/**
+ * @brief Режим смешивания: новый цвет заменяет старый.
+ *
+ * Каждый режим смешивания определяет функцию Apply(), которая по старому
+ * цвету точки dst и рисуемому цвету src вычисляет новый цвет точки.
+ */
+struct BlendCopy
+{
+  static labrgb_t Apply(labrgb_t dst, labrgb_t src) { (void)dst; return src; }
+};
+
+/// Режим смешивания: покомпонентная сумма цветов с насыщением.
+struct BlendAdd
+{
+  static labrgb_t Apply(labrgb_t dst, labrgb_t src)
+  {
+    unsigned r = LABRGB_R(dst) + LABRGB_R(src), g = LABRGB_G(dst) + LABRGB_G(src), b = LABRGB_B(dst) + LABRGB_B(src);
+    return LABRGB(r < 255 ? r : 255, g < 255 ? g : 255, b < 255 ? b : 255);
+  }
+};
+
+/// Режим смешивания: покомпонентное среднее цветов (полупрозрачность).
+struct BlendAverage
+{
+  static labrgb_t Apply(labrgb_t dst, labrgb_t src)
+  {
+    // halve each channel before adding, so that no carry crosses into the next one
+    return ((dst & 0xFEFEFEu) >> 1) + ((src & 0xFEFEFEu) >> 1) + (dst & src & 0x010101u);
+  }
+};
+
+/// Режим смешивания: исключающее ИЛИ цветов (повторное рисование стирает).
+struct BlendXor
+{
+  static labrgb_t Apply(labrgb_t dst, labrgb_t src) { return dst ^ src; }
+};
+
+/**
+ * @brief Поверхность для рисования в памяти.
+ *
+ * Хранит width * height точек формата Format строка за строкой. Память
+ * освобождается вместе с объектом.
+ *
+ * @see Fill, Blit, Present
+ */
+template <class Format>
+class Surface
+{
+public:
+  typedef typename Format::pixel_t pixel_t;
+
+  Surface(int width, int height, Format const& format = Format())
+    : m_width(width > 0 ? width : 0), m_height(height > 0 ? height : 0), m_format(format),
+    m_pixels((size_t)m_width * m_height)
+  {
+  }
+
+  int GetWidth() const { return m_width; }
+  int GetHeight() const { return m_height; }
+  Format const& GetFormat() const { return m_format; }
+
+  /// Указатель на начало строки y.
+  pixel_t* Row(int y) { return &m_pixels[(size_t)y * m_width]; }
+  pixel_t const* Row(int y) const { return &m_pixels[(size_t)y * m_width]; }
+
+  /// Цвет точки (x, y), чёрный за пределами поверхности.
+  labrgb_t GetPixel(int x, int y) const
+  {
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height)
+      return 0;
+    return m_format.Unpack(Row(y)[x]);
+  }
+
+private:
+  int m_width, m_height;
+  Format m_format;
+  std::vector<pixel_t> m_pixels;
+};
+
+/// @cond
+namespace detail {
+
+// the bits of v moved to the even positions, tile coordinates stay below 1 << 16
+inline unsigned Spread(unsigned v)
+{
+  v &= 0xFFFF;
+  v = (v | (v << 8)) & 0x00FF00FFu;
+  v = (v | (v << 4)) & 0x0F0F0F0Fu;
+  v = (v | (v << 2)) & 0x33333333u;
+  v = (v | (v << 1)) & 0x55555555u;
+  return v;
+}
+
+// clip the rectangle [x, x + width) x [y, y + height) to the surface,
+// shifting the source point (sx, sy) by the same amount
+inline bool ClipToSurface(int surfaceWidth, int surfaceHeight, int& x, int& y, int& width, int& height, int& sx, int& sy)
+{
+  if (x < 0)
+  {
+    width += x;
+    sx -= x;
+    x = 0;
+  }
+  if (y < 0)
+  {
+    height += y;
+    sy -= y;
+    y = 0;
+  }
+  if (width > surfaceWidth - x)
+    width = surfaceWidth - x;
+  if (height > surfaceHeight - y)
+    height = surfaceHeight - y;
+  return width > 0 && height > 0;
+}
+
+// the generic row kernels read, blend and write back every pixel
+template <class Format, class Blend>
+struct FillKernel
+{
+  static void Run(Format const& format, typename Format::pixel_t* dst, int count, labrgb_t color)
+  {
+    int i;
+    for (i = 0; i < count; i++)
+      dst[i] = format.Pack(Blend::Apply(format.Unpack(dst[i]), color));
+  }
+};
+
+// copying never reads the destination, so the color is packed only once
+template <class Format>
+struct FillKernel<Format, BlendCopy>
+{
+  static void Run(Format const& format, typename Format::pixel_t* dst, int count, labrgb_t color)
+  {
+    typename Format::pixel_t const pixel = format.Pack(color);
+    int i;
+    for (i = 0; i < count; i++)
+      dst[i] = pixel;
+  }
+};
+
+template <class DstFormat, class SrcFormat, class Blend>
+struct BlitKernel
+{
+  static void Run(DstFormat const& dstFormat, typename DstFormat::pixel_t* dst,
+    SrcFormat const& srcFormat, typename SrcFormat::pixel_t const* src, int count)
+  {
+    int i;
+    for (i = 0; i < count; i++)
+      dst[i] = dstFormat.Pack(Blend::Apply(dstFormat.Unpack(dst[i]), srcFormat.Unpack(src[i])));
+  }
+};
+
+template <class DstFormat, class SrcFormat>
+struct BlitKernel<DstFormat, SrcFormat, BlendCopy>
+{
+  static void Run(DstFormat const& dstFormat, typename DstFormat::pixel_t* dst,
+    SrcFormat const& srcFormat, typename SrcFormat::pixel_t const* src, int count)
+  {
+    int i;
+    for (i = 0; i < count; i++)
+      dst[i] = dstFormat.Pack(srcFormat.Unpack(src[i]));
+  }
+};
+
+// equal formats copy rows as is (indexed ones only if they share a palette)
+template <class Format>
+struct BlitKernel<Format, Format, BlendCopy>
+{
+  static void Run(Format const& dstFormat, typename Format::pixel_t* dst,
+    Format const& srcFormat, typename Format::pixel_t const* src, int count)
+  {
+    int i;
+    if (dstFormat == srcFormat)
+      memcpy(dst, src, count * sizeof(*dst));
+    else
+      for (i = 0; i < count; i++)
+        dst[i] = dstFormat.Pack(srcFormat.Unpack(src[i]));
+  }
+};
+
+} // namespace detail
+/// @endcond
+
+/**
+ * @brief Поверхность для рисования в памяти, разбитая на квадратные плитки.
+ *
+ * Хранит точки плитками по (1 << TileShift) * (1 << TileShift) точек,
+ * внутри плитки --- строка за строкой, а сами плитки --- в порядке кривой
+ * Мортона (Z-порядке). Соседние по вертикали точки оказываются рядом
+ * в памяти, поэтому вертикальные линии и случайный доступ задевают меньше
+ * строк кэша, чем в обычной поверхности, а горизонтальные остаются почти
+ * такими же быстрыми. Каждая плитка начинается с границы 64 байт.
+ *
+ * Z-порядок действует внутри квадратных блоков плиток со стороной, равной
+ * меньшей стороне поверхности в плитках, дополненной до степени двойки;
+ * вдоль большей стороны блоки идут друг за другом. Поэтому плиток хранится
+ * не больше чем в четыре раза больше, чем нужно, чтобы покрыть поверхность
+ * (для 640x480 и плиток 8x8 --- в 1,7 раза, для узких 8x4096 --- ровно
+ * столько, сколько нужно).
+ *
+ * @see Fill, Plot, Present
+ */
+template <class Format, int TileShift = 3>
+class TiledSurface
+{
+public:
+  typedef typename Format::pixel_t pixel_t;
+
+  /// Сторона плитки в точках.
+  static int const TileSize = 1 << TileShift;
+
+  TiledSurface(int width, int height, Format const& format = Format())
+    : m_width(width > 0 ? width : 0), m_height(height > 0 ? height : 0), m_format(format),
+    m_columns((m_width + TileSize - 1) >> TileShift), m_rows((m_height + TileSize - 1) >> TileShift), m_pixels(0)
+  {
+    int i, bits = 0;
+    size_t tiles, block, blockColumns;
+    // square blocks of 2^bits x 2^bits tiles in Z-order, where 2^bits is the shorter side
+    // rounded up to a power of two, and the blocks themselves row by row along the longer one
+    while ((1 << bits) < m_columns && (1 << bits) < m_rows)
+      bits++;
+    block = (size_t)1 << (2 * bits);
+    blockColumns = (m_columns + (1 << bits) - 1) >> bits;
+    // the offsets of the tiles of a column and a row, their sum gives the tile
+    for (i = 0; i < m_columns; i++)
+      m_offsetX.push_back(((i >> bits) * block + detail::Spread(i & ((1 << bits) - 1))) << (2 * TileShift));
+    for (i = 0; i < m_rows; i++)
+      m_offsetY.push_back(((i >> bits) * blockColumns * block + (detail::Spread(i & ((1 << bits) - 1)) << 1)) << (2 * TileShift));
+    // the last tile has the largest offset along both sides, the extra bytes align the first tile
+    tiles = (m_columns && m_rows) ? ((m_offsetX[m_columns - 1] + m_offsetY[m_rows - 1]) >> (2 * TileShift)) + 1 : 0;
+    m_storage.resize(tiles * TileSize * TileSize * sizeof(pixel_t) + 64);
+    m_pixels = (pixel_t*)(&m_storage[0] + ((64 - ((size_t)&m_storage[0] & 63)) & 63));
+  }
+
+  int GetWidth() const { return m_width; }
+  int GetHeight() const { return m_height; }
+  Format const& GetFormat() const { return m_format; }
+
+  /// Указатель на точку (x, y); следующие точки строки до края плитки идут за ней подряд.
+  pixel_t* At(int x, int y)
+  {
+    return m_pixels + m_offsetX[x >> TileShift] + m_offsetY[y >> TileShift] +
+      ((y & (TileSize - 1)) << TileShift) + (x & (TileSize - 1));
+  }
+  pixel_t const* At(int x, int y) const { return const_cast<TiledSurface*>(this)->At(x, y); }
+
+  /// Цвет точки (x, y), чёрный за пределами поверхности.
+  labrgb_t GetPixel(int x, int y) const
+  {
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height)
+      return 0;
+    return m_format.Unpack(*At(x, y));
+  }
+
+private:
+  TiledSurface(TiledSurface const&);
+  TiledSurface& operator=(TiledSurface const&);
+
+  int m_width, m_height;
+  Format m_format;
+  int m_columns, m_rows;
+  std::vector<size_t> m_offsetX, m_offsetY;
+  std::vector<char> m_storage;
+  pixel_t* m_pixels;
+};
+
+/**
+ * @brief Закрасить прямоугольник на поверхности.
+ *
+ * Закрашивает width * height точек, начиная с точки (x, y), смешивая их
+ * цвет с color в режиме Blend. Точки за пределами поверхности пропускаются.
+ *
+ * @code{.cpp}
+ * lab::Fill<lab::BlendAverage>(surface, 0, 0, 100, 50, LABRGB(255, 255, 255));
+ * @endcode
+ */
+template <class Blend, class Format>
+void Fill(Surface<Format>& surface, int x, int y, int width, int height, labrgb_t color)
+{
+  int j, sx = 0, sy = 0;
+  if (!detail::ClipToSurface(surface.GetWidth(), surface.GetHeight(), x, y, width, height, sx, sy))
+    return;
+  for (j = 0; j < height; j++)
+    detail::FillKernel<Format, Blend>::Run(surface.GetFormat(), surface.Row(y + j) + x, width, color);
+}
+
+/**
+ * @brief Закрасить прямоугольник на поверхности из плиток.
+ *
+ * То же, что Fill() для Surface; прямоугольник закрашивается по частям,
+ * попадающим в отдельные плитки.
+ */
+template <class Blend, class Format, int TileShift>
+void Fill(TiledSurface<Format, TileShift>& surface, int x, int y, int width, int height, labrgb_t color)
+{
+  int i, j, k, count, rows, sx = 0, sy = 0;
+  int const size = TiledSurface<Format, TileShift>::TileSize;
+  typename Format::pixel_t* p;
+  if (!detail::ClipToSurface(surface.GetWidth(), surface.GetHeight(), x, y, width, height, sx, sy))
+    return;
+  // the part of the rectangle in each tile is found once and painted row by row
+  for (j = y; j < y + height; j += rows)
+  {
+    rows = size - (j & (size - 1));
+    if (rows > y + height - j)
+      rows = y + height - j;
+    for (i = x; i < x + width; i += count)
+    {
+      count = size - (i & (size - 1));
+      if (count > x + width - i)
+        count = x + width - i;
+      p = surface.At(i, j);
+      for (k = 0; k < rows; k++, p += size)
+        detail::FillKernel<Format, Blend>::Run(surface.GetFormat(), p, count, color);
+    }
+  }
+}
+
+/**
+ * @brief Нарисовать точку на поверхности.
+ *
+ * Смешивает цвет точки (x, y) с color в режиме Blend. Точки за пределами
+ * поверхности пропускаются.
+ */
+template <class Blend, class Format>
+void Plot(Surface<Format>& surface, int x, int y, labrgb_t color)
+{
+  if (x >= 0 && y >= 0 && x < surface.GetWidth() && y < surface.GetHeight())
+    detail::FillKernel<Format, Blend>::Run(surface.GetFormat(), surface.Row(y) + x, 1, color);
+}
+
+/// Нарисовать точку на поверхности из плиток, см. Plot() для Surface.
+template <class Blend, class Format, int TileShift>
+void Plot(TiledSurface<Format, TileShift>& surface, int x, int y, labrgb_t color)
+{
+  if (x >= 0 && y >= 0 && x < surface.GetWidth() && y < surface.GetHeight())
+    detail::FillKernel<Format, Blend>::Run(surface.GetFormat(), surface.At(x, y), 1, color);
+}
+
+/**
+ * @brief Перенести одну поверхность на другую.
+ *
+ * Смешивает точки поверхности src в режиме Blend с точками поверхности dst,
+ * начиная с точки (x, y). Форматы поверхностей могут различаться.
+ */
+template <class Blend, class DstFormat, class SrcFormat>
+void Blit(Surface<DstFormat>& dst, int x, int y, Surface<SrcFormat> const& src)
+{
+  int j, sx = 0, sy = 0, width = src.GetWidth(), height = src.GetHeight();
+  if (!detail::ClipToSurface(dst.GetWidth(), dst.GetHeight(), x, y, width, height, sx, sy))
+    return;
+  for (j = 0; j < height; j++)
+    detail::BlitKernel<DstFormat, SrcFormat, Blend>::Run(dst.GetFormat(), dst.Row(y + j) + x,
+      src.GetFormat(), src.Row(sy + j) + sx, width);
+}
+
+/**
+ * @brief Вывести поверхность в буфер рисования.
+ *
+ * Переводит точки поверхности в цвета labrgb_t и записывает их в буфер
+ * рисования функцией LabWritePixels(), начиная с точки (x, y).
+ */
+template <class Format>
+void Present(Surface<Format> const& surface, int x, int y)
+{
+  int i, j, width = surface.GetWidth(), height = surface.GetHeight();
+  labrect_t rect;
+  if (width == 0 || height == 0)
+    return;
+
+  std::vector<labrgb_t> pixels((size_t)width * height);
+  for (j = 0; j < height; j++)
+  {
+    typename Format::pixel_t const* row = surface.Row(j);
+    labrgb_t* line = &pixels[(size_t)j * width];
+    for (i = 0; i < width; i++)
+      line[i] = surface.GetFormat().Unpack(row[i]);
+  }
+  rect.left = x;
+  rect.top = y;
+  rect.right = x + width;
+  rect.bottom = y + height;
+  LabWritePixels(&rect, &pixels[0], width);
+}
+
+/**
+ * @brief Вывести поверхность из плиток в буфер рисования.
+ *
+ * Плитки обходятся по одной, и строки каждой плитки раскладываются
+ * по строкам обычного изображения; для формата Bgra8888
+ * это копирование кусков строк, которое компилятор выполняет векторными
+ * командами.
+ */
+template <class Format, int TileShift>
+void Present(TiledSurface<Format, TileShift> const& surface, int x, int y)
+{
+  int i, j, tx, ty, count, width = surface.GetWidth(), height = surface.GetHeight();
+  int const size = TiledSurface<Format, TileShift>::TileSize;
+  labrect_t rect;
+  if (width == 0 || height == 0)
+    return;
+
+  std::vector<labrgb_t> pixels((size_t)width * height);
+  for (ty = 0; ty < height; ty += size)
+    for (tx = 0; tx < width; tx += size)
+    {
+      count = width - tx < size ? width - tx : size;
+      for (j = ty; j < ty + size && j < height; j++)
+      {
+        typename Format::pixel_t const* row = surface.At(tx, j);
+        labrgb_t* line = &pixels[(size_t)j * width + tx];
+        for (i = 0; i < count; i++)
+          line[i] = surface.GetFormat().Unpack(row[i]);
+      }
+    }
+  rect.left = x;
+  rect.top = y;
+  rect.right = x + width;
+  rect.bottom = y + height;
+  LabWritePixels(&rect, &pixels[0], width);
+}
+
+/** @} */
+
+} // namespace lab
+
+#endif // LABENGINE_HPP_INCLUDED
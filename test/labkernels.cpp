@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <time.h>
+#include "../source/labengine.hpp"
+
+extern "C" double BenchMicroseconds(clock_t start, int count);
+extern "C" void Check(int condition, char const* what);
+
+namespace {
+
+lab::Palette const s_palette;
+
+template <class Blend, class Format>
+void BenchFill(char const* name, char const* blend, Format const& format)
+{
+	int i, frames = 100;
+	lab::Surface<Format> surface(640, 480, format);
+	clock_t start;
+
+	start = clock();
+	for (i = 0; i < frames; i++)
+		lab::Fill<Blend>(surface, 0, 0, 640, 480, LABRGB(i, 2 * i, 3 * i));
+	printf("Fill 640x480, %-8s %-8s  %8.3f ms\n", name, blend, BenchMicroseconds(start, frames) / 1000);
+}
+
+template <class Blend, class Format>
+void BenchBlit(char const* name, char const* blend, Format const& format)
+{
+	int i, frames = 100;
+	lab::Surface<Format> surface(640, 480, format);
+	lab::Surface<lab::Bgra8888> sprite(256, 256);
+	clock_t start;
+
+	lab::Fill<lab::BlendCopy>(sprite, 0, 0, 256, 256, LABRGB(40, 80, 120));
+	start = clock();
+	for (i = 0; i < frames; i++)
+		lab::Blit<Blend>(surface, i, i, sprite);
+	printf("Blit 256x256, %-8s %-8s  %8.3f ms\n", name, blend, BenchMicroseconds(start, frames) / 1000);
+}
+
+template <class Format>
+void BenchFormat(char const* name, Format const& format)
+{
+	BenchFill<lab::BlendCopy>(name, "copy", format);
+	BenchFill<lab::BlendAdd>(name, "add", format);
+	BenchFill<lab::BlendAverage>(name, "average", format);
+	BenchFill<lab::BlendXor>(name, "xor", format);
+
+	BenchBlit<lab::BlendCopy>(name, "copy", format);
+	BenchBlit<lab::BlendAdd>(name, "add", format);
+	BenchBlit<lab::BlendAverage>(name, "average", format);
+	BenchBlit<lab::BlendXor>(name, "xor", format);
+}
+
+// vertical lines as in RunTV(), horizontal ones and random points all over the surface, then the surface shown
+template <class SurfaceType>
+void BenchLayout(char const* name, SurfaceType& surface)
+{
+	int i, j, frames = 4, width = surface.GetWidth(), height = surface.GetHeight();
+	unsigned seed = 1;
+	clock_t start;
+
+	start = clock();
+	for (i = 0; i < frames; i++)
+		for (j = 0; j < width; j++)
+			lab::Fill<lab::BlendXor>(surface, j, 0, 1, height, LABRGB(i, j, 0));
+	printf("%-12s vertical lines    %8.3f ms\n", name, BenchMicroseconds(start, frames) / 1000);
+
+	start = clock();
+	for (i = 0; i < frames; i++)
+		for (j = 0; j < height; j++)
+			lab::Fill<lab::BlendXor>(surface, 0, j, width, 1, LABRGB(i, j, 0));
+	printf("%-12s horizontal lines  %8.3f ms\n", name, BenchMicroseconds(start, frames) / 1000);
+
+	start = clock();
+	for (i = 0; i < frames; i++)
+		for (j = 0; j < width * height; j++)
+		{
+			seed = seed * 1103515245u + 12345u;
+			lab::Plot<lab::BlendXor>(surface, (seed >> 8) % width, (seed >> 20) % height, LABRGB(i, j, 0));
+		}
+	printf("%-12s random points     %8.3f ms\n", name, BenchMicroseconds(start, frames) / 1000);
+
+	start = clock();
+	for (i = 0; i < frames; i++)
+		lab::Present(surface, 0, 0);
+	printf("%-12s present           %8.3f ms\n", name, BenchMicroseconds(start, frames) / 1000);
+}
+
+} // namespace
+
+extern "C" void BenchKernels(void)
+{
+	int i, frames = 100;
+	lab::Surface<lab::Rgb565> surface(640, 480);
+	clock_t start;
+
+	BenchFormat("BGRA8888", lab::Bgra8888());
+	BenchFormat("RGB565", lab::Rgb565());
+	BenchFormat("Indexed8", lab::Indexed8(s_palette));
+
+	start = clock();
+	for (i = 0; i < frames; i++)
+		lab::Present(surface, 0, 0);
+	printf("Present 640x480, RGB565         %8.3f ms\n", BenchMicroseconds(start, frames) / 1000);
+
+	{
+		// larger than the caches, where the layout matters; the frame shown is clipped to the window
+		lab::Surface<lab::Bgra8888> linear(2048, 2048);
+		lab::TiledSurface<lab::Bgra8888> tiled8(2048, 2048);
+		lab::TiledSurface<lab::Bgra8888, 4> tiled16(2048, 2048);
+		BenchLayout("2048 linear", linear);
+		BenchLayout("2048 8x8", tiled8);
+		BenchLayout("2048 16x16", tiled16);
+	}
+}
+
+extern "C" void CheckKernels(void)
+{
+	lab::Surface<lab::Rgb565> wide(16, 16);
+	lab::Surface<lab::Indexed8> indexed(16, 16, lab::Indexed8(s_palette));
+	lab::Surface<lab::Bgra8888> surface(16, 16);
+
+	lab::Fill<lab::BlendCopy>(wide, 0, 0, 16, 16, LABRGB(255, 255, 255));
+	lab::Fill<lab::BlendCopy>(wide, -4, -4, 8, 8, LABRGB(255, 0, 0));
+	Check(wide.GetPixel(3, 3) == LABRGB(255, 0, 0) && wide.GetPixel(4, 4) == LABRGB(255, 255, 255),
+		"lab::Fill clips to an RGB565 surface");
+
+	lab::Fill<lab::BlendCopy>(surface, 0, 0, 16, 16, LABRGB(200, 100, 10));
+	lab::Fill<lab::BlendAdd>(surface, 0, 0, 16, 16, LABRGB(100, 100, 100));
+	Check(surface.GetPixel(5, 5) == LABRGB(255, 200, 110), "lab::BlendAdd saturates");
+	lab::Fill<lab::BlendAverage>(surface, 0, 0, 16, 16, LABRGB(0, 0, 0));
+	Check(surface.GetPixel(5, 5) == LABRGB(127, 100, 55), "lab::BlendAverage halves");
+
+	lab::Fill<lab::BlendCopy>(indexed, 0, 0, 16, 16, LABRGB(255, 0, 0));
+	lab::Blit<lab::BlendCopy>(surface, 8, 8, indexed);
+	Check(surface.GetPixel(8, 8) == LABRGB(255, 0, 0) && surface.GetPixel(7, 7) == LABRGB(127, 100, 55),
+		"lab::Blit converts Indexed8 to BGRA8888");
+
+	{
+		lab::Surface<lab::Rgb565> linear(37, 21);
+		lab::TiledSurface<lab::Rgb565> tiled(37, 21);
+		labrect_t rect = { 200, 100, 237, 121 };
+		labrgb_t pixels[37 * 21];
+		int i, x, y, same = 1;
+
+		for (i = 0; i < 37; i += 3)
+		{
+			lab::Fill<lab::BlendCopy>(linear, i, -2, 2, 30, LABRGB(i * 7, 255, 0));
+			lab::Fill<lab::BlendCopy>(tiled, i, -2, 2, 30, LABRGB(i * 7, 255, 0));
+			lab::Fill<lab::BlendXor>(linear, -5, i / 2, 60, 3, LABRGB(0, i, 255));
+			lab::Fill<lab::BlendXor>(tiled, -5, i / 2, 60, 3, LABRGB(0, i, 255));
+			lab::Plot<lab::BlendAdd>(linear, i, i / 2 + 5, LABRGB(100, 0, 0));
+			lab::Plot<lab::BlendAdd>(tiled, i, i / 2 + 5, LABRGB(100, 0, 0));
+		}
+		for (y = -1; y <= 21; y++)
+			for (x = -1; x <= 37; x++)
+				same = same && tiled.GetPixel(x, y) == linear.GetPixel(x, y);
+		Check(same && ((size_t)tiled.At(0, 0) & 63) == 0 && tiled.At(8, 0) - tiled.At(0, 0) == 64 &&
+			tiled.At(0, 8) - tiled.At(0, 0) == 128, "lab::TiledSurface keeps pixels in Z-ordered tiles");
+
+		LabClear();
+		lab::Present(tiled, 200, 100);
+		LabReadPixels(&rect, pixels, 37);
+		for (y = 0; y < 21; y++)
+			for (x = 0; x < 37; x++)
+				same = same && pixels[y * 37 + x] == linear.GetPixel(x, y);
+		Check(same, "lab::Present writes a tiled surface");
+	}
+
+	{
+		// long and narrow surfaces keep Z-order within square blocks only, not padding the short side
+		lab::TiledSurface<lab::Bgra8888> tall(8, 4096), wide(4096, 8), strip(2048, 16), odd(200, 72);
+		lab::Surface<lab::Bgra8888> linear(200, 72);
+		int x, y, same = 1;
+
+		for (y = 0; y < 72; y += 5)
+		{
+			lab::Fill<lab::BlendXor>(linear, y, y, 150, 3, LABRGB(y, 255, 0));
+			lab::Fill<lab::BlendXor>(odd, y, y, 150, 3, LABRGB(y, 255, 0));
+		}
+		for (y = 0; y < 72; y++)
+			for (x = 0; x < 200; x++)
+				same = same && odd.GetPixel(x, y) == linear.GetPixel(x, y);
+		Check(same && tall.At(7, 4095) - tall.At(0, 0) == 8 * 4096 - 1 && wide.At(4095, 7) - wide.At(0, 0) == 8 * 4096 - 1 &&
+			strip.At(2047, 15) - strip.At(0, 0) == 16 * 2048 - 1 && odd.At(199, 71) - odd.At(0, 0) < 4 * 200 * 72,
+			"lab::TiledSurface pads narrow surfaces at most 4 times");
+	}
+
+	LabClear();
+	lab::Present(surface, 100, 100);
+	Check(LabGetPixel(100, 100) == LABRGB(127, 100, 55) && LabGetPixel(115, 115) == LABRGB(255, 0, 0) &&
+		LabGetPixel(116, 116) == 0, "lab::Present writes to the buffer");
+}
@@ -1,90 +1,2721 @@
-#include <stdio.h>
-#include <math.h>
-#include "../source/labengine.h"
-
-void RunTV(void)
-{
-	int width, height;
-	int color;
-	int i;
-	int x;
-
-	width = LabGetWidth() / LABCOLOR_COUNT;
-	height = LabGetHeight();
-
-	color = 0;
-	for (color = 0; color < LABCOLOR_COUNT; color++)
-	{
-		LabSetColor(color);
-		for (i = 0; i < width; i++)
-		{
-			x = color * width + i;
-			LabDrawLine(x, 0, x, height);
-		}
-	}
-
-	LabInputKey();
-}
-
-void DrawCircle(double angle, int radius, int color)
-{
-	int x, y;
-	int co, si;
-
-	x = LabGetWidth() / 2;
-	y = LabGetHeight() / 2;
-	co = (int)(cos(angle) * radius);
-	si = (int)(sin(angle) * radius);
-
-	LabSetColor(color);
-	LabDrawLine(x + co, y + si, x - si, y + co);
-	LabDrawLine(x - si, y + co, x - co, y - si);
-	LabDrawLine(x - co, y - si, x + si, y - co);
-	LabDrawLine(x + si, y - co, x + co, y + si);
-}
-
-void RunPoly(void)
-{
-	double angle = 0.0;
-	int radius = LabGetHeight() / 4;
-	while (!LabInputKeyReady())
-	{
-		LabClear();
-		angle += 0.0001;
-		DrawCircle(angle, radius, LABCOLOR_GREEN);
-//		LabDelay(20);
-		LabDrawFlush();
-	}
-
-	LabInputKey();
-}
-
-void RunTruecolor(void)
-{
-	int x, y, w, h, b, r, f;
-
-	LabClear();
-
-	for (y = 0, h = LabGetHeight(); y < h; y++) {
-		for (x = 0, w = LabGetWidth(); x < w; x++) {
-			b = x < 256 ? x : x < 512 ? 255 : 0;
-			r = x < 256 ? 0 : x < 512 ? x - 256 : 0;
-			f = x < 512 ? 0 : x - 512;
-			LabSetColorRGB(r, r, b);
-			LabDrawPoint(x, y);
-		}
-	}
-
-	LabDrawFlush();
-	LabInputKey();
-}
-
-int main(void)
-{
-	if (LabInit())
-	{
-		RunPoly();
-		// RunTruecolor();
-		LabTerm();
-	}
-}
+#include <winsock2.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include "../source/labengine.h"
+
+#pragma comment(lib, "ws2_32")
+
+#define SERVER_PORT 47011
+#define SHARE_NAME "Local\\labtest"
+#define JOURNAL_NAME "labtest.journal"
+
+// pixel format kernels of the C++ wrapper, see labkernels.cpp
+void BenchKernels(void);
+void CheckKernels(void);
+
+void RunTV(void)
+{
+	int width, height;
+	int color;
+	int i;
+	int x;
+
+	width = LabGetWidth() / LABCOLOR_COUNT;
+	height = LabGetHeight();
+
+	color = 0;
+	for (color = 0; color < LABCOLOR_COUNT; color++)
+	{
+		LabSetColor(color);
+		for (i = 0; i < width; i++)
+		{
+			x = color * width + i;
+			LabDrawLine(x, 0, x, height);
+		}
+	}
+
+	LabInputKey();
+}
+
+void DrawCircle(double angle, int radius, int color)
+{
+	float x, y;
+	float co, si;
+	labpointf_t square[4];
+
+	x = LabGetWidth() / 2.0f;
+	y = LabGetHeight() / 2.0f;
+	co = (float)(cos(angle) * radius);
+	si = (float)(sin(angle) * radius);
+
+	square[0].x = x + co; square[0].y = y + si;
+	square[1].x = x - si; square[1].y = y + co;
+	square[2].x = x - co; square[2].y = y - si;
+	square[3].x = x + si; square[3].y = y - co;
+
+	LabSetColor(color);
+	LabDrawPolylineF(square, 4, LAB_TRUE);
+}
+
+void PolyFrame(void* context)
+{
+	LabClear();
+	DrawCircle(*(double*)context, LabGetHeight() / 4, LABCOLOR_GREEN);
+}
+
+void PolyKey(labkey_t key, void* context)
+{
+	LabRunStop();
+}
+
+void PolyTimer(int timer, void* context)
+{
+	*(double*)context += 0.02;
+	LabRunInvalidate();
+}
+
+void RunPoly(void)
+{
+	double angle = 0.0;
+	labcallbacks_t callbacks;
+	int timer;
+
+	callbacks.onFrame = PolyFrame;
+	callbacks.onKey = PolyKey;
+	callbacks.onTimer = PolyTimer;
+	callbacks.context = &angle;
+	timer = LabTimerStart(20, 20);
+	LabRun(&callbacks);
+	LabTimerStop(timer);
+}
+
+void RunTruecolor(void)
+{
+	int x, y, w, h, b, r, f;
+
+	LabClear();
+
+	for (y = 0, h = LabGetHeight(); y < h; y++) {
+		for (x = 0, w = LabGetWidth(); x < w; x++) {
+			b = x < 256 ? x : x < 512 ? 255 : 0;
+			r = x < 256 ? 0 : x < 512 ? x - 256 : 0;
+			f = x < 512 ? 0 : x - 512;
+			LabSetColorRGB(r, r, b);
+			LabDrawPoint(x, y);
+		}
+	}
+
+	LabDrawFlush();
+	LabInputKey();
+}
+
+void RunText(void)
+{
+	int y;
+
+	LabClear();
+
+	LabSetColor(LABCOLOR_YELLOW);
+	LabDrawText(10, 10, "LabEngine text output");
+	LabSetColor(LABCOLOR_WHITE);
+	LabDrawText(10, 30, "\xcf\xf0\xe8\xe2\xe5\xf2, \xec\xe8\xf0!\n\xd1\xf7\xb8\xf2: 12345");
+	for (y = 0; y < 8; y++)
+	{
+		LabSetColor(LABCOLOR_BLUE + y);
+		LabDrawTextf(10, 60 + y * LabGetTextHeight(), "Line %d of %d", y + 1, 8);
+	}
+
+	LabDrawFlush();
+	LabInputKey();
+}
+
+// ////////////////////////////////////////////////////////////////////////////
+//   Benchmarks (run as "labtest bench", no window is created)
+// ////////////////////////////////////////////////////////////////////////////
+
+double BenchMicroseconds(clock_t start, int count)
+{
+	return 1e6 * (double)(clock() - start) / CLOCKS_PER_SEC / count;
+}
+
+void BenchText(void)
+{
+	int i, n = 200000;
+	clock_t start;
+
+	start = clock();
+	for (i = 0; i < n; i++)
+		LabDrawText(10, 10, "Score: 12345");
+	printf("LabDrawText, static label     %8.3f us\n", BenchMicroseconds(start, n));
+
+	start = clock();
+	for (i = 0; i < n; i++)
+		LabDrawText(10, 20, "\xd1\xf7\xb8\xf2: 12345");
+	printf("LabDrawText, static Cyrillic  %8.3f us\n", BenchMicroseconds(start, n));
+
+	start = clock();
+	for (i = 0; i < n; i++)
+		LabDrawTextf(10, 30, "Frame %d", i);
+	printf("LabDrawTextf, changing label  %8.3f us\n", BenchMicroseconds(start, n));
+
+	start = clock();
+	for (i = 0; i < n; i++)
+		LabDrawText(-20, LabGetHeight() - 4, "Clipped at two edges");
+	printf("LabDrawText, clipped label    %8.3f us\n", BenchMicroseconds(start, n));
+}
+
+void BenchPolyline(void)
+{
+	static labpoint_t wave[10000];
+	int i, frame, frames = 200;
+	int count = sizeof(wave) / sizeof(wave[0]);
+	int width = LabGetWidth(), height = LabGetHeight();
+	clock_t start;
+
+	for (i = 0; i < count; i++)
+	{
+		wave[i].x = i * width / count;
+		wave[i].y = height / 2 + (int)(height / 3 * sin(i * 0.05) * cos(i * 0.0031));
+	}
+
+	start = clock();
+	for (frame = 0; frame < frames; frame++)
+		for (i = 1; i < count; i++)
+			LabDrawLine(wave[i - 1].x, wave[i - 1].y, wave[i].x, wave[i].y);
+	printf("LabDrawLine, 10k-point strip  %8.3f us\n", BenchMicroseconds(start, frames));
+
+	start = clock();
+	for (frame = 0; frame < frames; frame++)
+		LabDrawPolyline(wave, count, LAB_FALSE);
+	printf("LabDrawPolyline, 10k points   %8.3f us\n", BenchMicroseconds(start, frames));
+
+	// half of the strip is out of the buffer
+	for (i = 0; i < count; i++)
+		wave[i].x = i * width * 2 / count - width / 2;
+	start = clock();
+	for (frame = 0; frame < frames; frame++)
+		LabDrawPolyline(wave, count, LAB_FALSE);
+	printf("LabDrawPolyline, clipped      %8.3f us\n", BenchMicroseconds(start, frames));
+}
+
+void BenchClip(void)
+{
+	labpoint_t zoomed[64];
+	int i, n = 200000;
+	int width = LabGetWidth(), height = LabGetHeight();
+	clock_t start;
+
+	// a zoomed plot where most of the geometry lies far out of view
+	start = clock();
+	for (i = 0; i < n; i++)
+		LabDrawLine(width * 4 + i % 1000, i % 700 - 100, width * 5, height * 3);
+	printf("LabDrawLine, out of view      %8.3f us\n", BenchMicroseconds(start, n));
+
+	// zoomed in so far that every segment of the plot crosses the view from a million pixels away
+	for (i = 0; i < 64; i++)
+	{
+		zoomed[i].x = (i & 1) ? -1000000 - i : 1000000 + i;
+		zoomed[i].y = height / 2 + (i & 2 ? 1 : -1) * (i * height / 128);
+	}
+	start = clock();
+	for (i = 0; i < n / 100; i++)
+		LabDrawPolyline(zoomed, 64, LAB_FALSE);
+	printf("LabDrawPolyline, zoomed in    %8.3f us\n", BenchMicroseconds(start, n / 100));
+
+	LabPushClip(width / 4, height / 4, width / 2, height / 2);
+	start = clock();
+	for (i = 0; i < n; i++)
+		LabDrawCircle(i % width, height - 20, 10);
+	printf("LabDrawCircle, clipped out    %8.3f us\n", BenchMicroseconds(start, n));
+
+	LabSetOrigin(-width, 0);
+	start = clock();
+	for (i = 0; i < n; i++)
+		LabDrawText(i % width, height / 3, "Moved away by the origin");
+	printf("LabDrawText, clipped out      %8.3f us\n", BenchMicroseconds(start, n));
+	LabSetOrigin(0, 0);
+	LabPopClip();
+}
+
+void BenchSubpixel(void)
+{
+	int i, n = 20000;
+	int width = LabGetWidth(), height = LabGetHeight();
+	clock_t start;
+
+	start = clock();
+	for (i = 0; i < n; i++)
+		LabDrawLine(i % width, 0, width - 1 - i % width, height - 1);
+	printf("LabDrawLine, full height      %8.3f us\n", BenchMicroseconds(start, n));
+
+	start = clock();
+	for (i = 0; i < n; i++)
+		LabDrawLineF(i % width + 0.25f, 0.5f, width - 1 - i % width + 0.75f, height - 1.5f);
+	printf("LabDrawLineF, full height     %8.3f us\n", BenchMicroseconds(start, n));
+
+	start = clock();
+	for (i = 0; i < n; i++)
+		LabDrawCircle(width / 2, height / 2, i % (height / 2));
+	printf("LabDrawCircle                 %8.3f us\n", BenchMicroseconds(start, n));
+
+	start = clock();
+	for (i = 0; i < n; i++)
+		LabDrawCircleF(width / 2.0f + 0.3f, height / 2.0f - 0.6f, i % (height / 2) + 0.5f);
+	printf("LabDrawCircleF                %8.3f us\n", BenchMicroseconds(start, n));
+}
+
+void BenchReadback(void)
+{
+	int i, x, y, frames = 100;
+	int width = LabGetWidth(), height = LabGetHeight();
+	labrect_t all = { 0, 0, 0, 0 };
+	labrgb_t* pixels = (labrgb_t*)malloc(width * height * sizeof(labrgb_t));
+	clock_t start;
+
+	all.right = width;
+	all.bottom = height;
+
+	start = clock();
+	for (i = 0; i < frames; i++)
+		for (y = 0; y < height; y++)
+			for (x = 0; x < width; x++)
+				pixels[y * width + x] = LabGetPixel(x, y);
+	printf("LabGetPixel, whole frame      %8.3f us\n", BenchMicroseconds(start, frames));
+
+	start = clock();
+	for (i = 0; i < frames; i++)
+		LabReadPixels(&all, pixels, width);
+	printf("LabReadPixels, whole frame    %8.3f us\n", BenchMicroseconds(start, frames));
+
+	free(pixels);
+}
+
+// a serpentine corridor one pixel wide, the worst case for a scanline fill
+void DrawMaze(void)
+{
+	int y, width = LabGetWidth(), height = LabGetHeight();
+
+	LabClear();
+	LabSetColor(LABCOLOR_WHITE);
+	for (y = 1; y < height; y += 2)
+	{
+		if (y % 4 == 1)
+			LabDrawLine(0, y, width - 1, y);
+		else
+			LabDrawLine(1, y, width, y);
+	}
+}
+
+void BenchFloodFillAt(int width, int height)
+{
+	labparams_t params;
+	int i, frames = 10;
+	clock_t start;
+
+	LabTerm();
+	params.width = width;
+	params.height = height;
+	params.scale = 1;
+	LabInitWithFlags(&params, LABFLAG_HEADLESS);
+
+	start = clock();
+	for (i = 0; i < frames; i++)
+		LabFloodFill(width / 2, height / 2, i & 1 ? LABRGB(255, 0, 0) : LABRGB(0, 0, 255));
+	printf("LabFloodFill, %4dx%-4d open   %8.3f ms\n", width, height, BenchMicroseconds(start, frames) / 1000);
+
+	start = clock();
+	for (i = 0; i < frames; i++)
+	{
+		DrawMaze();
+		LabFloodFill(0, 0, LABRGB(255, 0, 0));
+	}
+	printf("LabFloodFill, %4dx%-4d maze   %8.3f ms\n", width, height, BenchMicroseconds(start, frames) / 1000);
+}
+
+void BenchFloodFill(void)
+{
+	int width = LabGetWidth(), height = LabGetHeight();
+
+	BenchFloodFillAt(width, height);
+	BenchFloodFillAt(3840, 2160);
+	BenchFloodFillAt(width, height);
+}
+
+int PlotValue(int t, int height)
+{
+	return height / 2 + (int)(height / 3 * sin(t * 0.05));
+}
+
+// a strip chart: the whole plot drawn again against a scroll and one new segment
+void BenchScroll(void)
+{
+	int i, x, frames = 200, width = LabGetWidth(), height = LabGetHeight();
+	labpoint_t* points = (labpoint_t*)malloc(width * sizeof(labpoint_t));
+	clock_t start;
+
+	LabSetColor(LABCOLOR_GREEN);
+	start = clock();
+	for (i = 0; i < frames; i++)
+	{
+		LabClear();
+		for (x = 0; x < width; x++)
+		{
+			points[x].x = x;
+			points[x].y = PlotValue(i + x, height);
+		}
+		LabDrawPolyline(points, width, LAB_FALSE);
+		LabDrawFlush();
+	}
+	printf("Strip chart, %dx%d redraw   %8.3f us\n", width, height, BenchMicroseconds(start, frames));
+
+	start = clock();
+	for (i = 0; i < frames; i++)
+	{
+		LabScroll(-1, 0, LABRGB(0, 0, 0));
+		LabDrawLine(width - 2, PlotValue(i + width - 2, height), width - 1, PlotValue(i + width - 1, height));
+		LabDrawFlush();
+	}
+	printf("Strip chart, %dx%d scroll   %8.3f us\n", width, height, BenchMicroseconds(start, frames));
+	free(points);
+}
+
+void DrawCursor(int x, int y)
+{
+	LabSetColor(LABCOLOR_YELLOW);
+	LabDrawLine(x - 8, y, x + 9, y);
+	LabDrawLine(x, y - 8, x, y + 9);
+}
+
+// a dashboard: a static background, a chart changing now and then and a cursor moving every frame
+void BenchLayersAt(int width, int height)
+{
+	labparams_t params;
+	int i, frames = 20;
+	clock_t start;
+
+	LabTerm();
+	params.width = width;
+	params.height = height;
+	params.scale = 1;
+	LabInitWithFlags(&params, LABFLAG_HEADLESS);
+
+	start = clock();
+	for (i = 0; i < frames; i++)
+	{
+		DrawMaze();
+		DrawCursor(100 + i * 10, 100);
+		LabDrawFlush();
+	}
+	printf("One layer, %4dx%-4d redraw      %8.3f ms\n", width, height, BenchMicroseconds(start, frames) / 1000);
+
+	DrawMaze();
+	LabSetLayer(1);
+	LabSetLayerOpacity(1, 192);
+	LabSetColor(LABCOLOR_GREEN);
+	LabDrawCircle(width / 2, height / 2, height / 3);
+	LabSetLayer(2);
+	LabDrawFlush();
+
+	start = clock();
+	for (i = 0; i < frames; i++)
+	{
+		LabClear();
+		DrawCursor(100 + i * 10, 100);
+		LabDrawFlush();
+	}
+	printf("Layers, %4dx%-4d cursor         %8.3f ms\n", width, height, BenchMicroseconds(start, frames) / 1000);
+
+	start = clock();
+	for (i = 0; i < frames; i++)
+	{
+		LabSetLayerOpacity(1, i & 1 ? 128 : 192);
+		LabDrawFlush();
+	}
+	printf("Layers, %4dx%-4d chart          %8.3f ms\n", width, height, BenchMicroseconds(start, frames) / 1000);
+
+	start = clock();
+	for (i = 0; i < frames; i++)
+	{
+		LabSetLayerVisible(0, i & 1);
+		LabDrawFlush();
+	}
+	printf("Layers, %4dx%-4d everything     %8.3f ms\n", width, height, BenchMicroseconds(start, frames) / 1000);
+}
+
+void BenchLayers(void)
+{
+	int width = LabGetWidth(), height = LabGetHeight();
+	labparams_t params;
+
+	BenchLayersAt(3840, 2160);
+
+	LabTerm();
+	params.width = width;
+	params.height = height;
+	params.scale = 1;
+	LabInitWithFlags(&params, LABFLAG_HEADLESS);
+}
+
+// a sample reader of LabShareStart(), as a recorder in another process would do it
+int ReadSharedFrame(labshareheader_t const* header, labrgb_t* dst, unsigned* frame)
+{
+	long sequence;
+	int tries;
+
+	for (tries = 0; tries < 1000000; tries++)
+	{
+		sequence = header->sequence;
+		MemoryBarrier();
+		if (sequence & 1)
+			continue;
+		memcpy(dst, (char const*)header + header->offset, header->height * header->pitch);
+		*frame = header->frame;
+		MemoryBarrier();
+		if (header->sequence == sequence)
+			return 1;
+	}
+	return 0;
+}
+
+labshareheader_t const* OpenSharedFrame(HANDLE* mapping)
+{
+	*mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, SHARE_NAME);
+	if (!*mapping)
+		return NULL;
+	return (labshareheader_t const*)MapViewOfFile(*mapping, FILE_MAP_READ, 0, 0, 0);
+}
+
+void BenchShare(void)
+{
+	int i, frames = 1000, width = LabGetWidth(), height = LabGetHeight();
+	labshareheader_t const* header;
+	HANDLE mapping;
+	labrgb_t* pixels;
+	unsigned frame;
+	double us;
+	clock_t start;
+
+	start = clock();
+	for (i = 0; i < frames; i++)
+		LabDrawFlush();
+	printf("LabDrawFlush, no export          %8.3f us\n", BenchMicroseconds(start, frames));
+
+	LabShareStart(SHARE_NAME);
+	start = clock();
+	for (i = 0; i < frames; i++)
+		LabDrawFlush();
+	printf("LabDrawFlush, shared memory      %8.3f us\n", BenchMicroseconds(start, frames));
+
+	header = OpenSharedFrame(&mapping);
+	if (header)
+	{
+		pixels = malloc(width * height * sizeof(labrgb_t));
+		start = clock();
+		for (i = 0; i < frames; i++)
+			ReadSharedFrame(header, pixels, &frame);
+		us = BenchMicroseconds(start, frames);
+		printf("ReadSharedFrame, %dx%d      %8.3f us, %.0f MB/s\n", width, height, us, width * height * sizeof(labrgb_t) / us);
+		free(pixels);
+		UnmapViewOfFile(header);
+		CloseHandle(mapping);
+	}
+	LabShareStop();
+}
+
+void DrawPolyFrame(int frame, int radius)
+{
+	LabClear();
+	DrawCircle(frame * 0.01, radius, LABCOLOR_GREEN);
+	LabDrawFlush();
+}
+
+void BenchJournal(void)
+{
+	int i, frames = 1000, radius = LabGetHeight() / 4;
+	clock_t start;
+
+	start = clock();
+	for (i = 0; i < frames; i++)
+		DrawPolyFrame(i, radius);
+	printf("RunPoly frame, no journal        %8.3f us\n", BenchMicroseconds(start, frames));
+
+	LabJournalStart(JOURNAL_NAME);
+	start = clock();
+	for (i = 0; i < frames; i++)
+		DrawPolyFrame(i, radius);
+	LabJournalStop();
+	printf("RunPoly frame, journal           %8.3f us\n", BenchMicroseconds(start, frames));
+
+	start = clock();
+	LabJournalReplay(JOURNAL_NAME);
+	printf("RunPoly frame, replay            %8.3f us\n", BenchMicroseconds(start, frames));
+	remove(JOURNAL_NAME);
+}
+
+void PaintNoise(int x, int y, int count, labrgb_t* pixels, void* context)
+{
+	unsigned seed = (unsigned)(x * 7919 + y * 104729);
+	int i;
+
+	for (i = 0; i < count; i++, seed = seed * 1103515245 + 12345)
+		pixels[i] = (seed >> 8) & 0x00FFFFFF;
+}
+
+// a gradient drawn point by point against the span fills
+void BenchGradient(void)
+{
+	int i, x, y, frames = 200, width = LabGetWidth(), height = LabGetHeight();
+	labpaint_t paint;
+	clock_t start;
+
+	start = clock();
+	for (i = 0; i < frames / 20; i++)
+		for (y = 0; y < height; y++)
+			for (x = 0; x < width; x++)
+			{
+				LabSetColorRGB(x * 255 / width, i, 255 - x * 255 / width);
+				LabDrawPoint(x, y);
+			}
+	printf("Gradient %dx%d, per point   %8.3f ms\n", width, height, BenchMicroseconds(start, frames / 20) / 1000);
+
+	memset(&paint, 0, sizeof(paint));
+	paint.type = LABPAINT_LINEAR;
+	paint.x1 = (float)width;
+	paint.y1 = (float)height / 4;
+	paint.color0 = LABRGB(0, 0, 255);
+	paint.color1 = LABRGB(255, 0, 0);
+	start = clock();
+	for (i = 0; i < frames; i++)
+		LabFillRect(0, 0, width, height, &paint);
+	printf("Gradient %dx%d, linear      %8.3f ms\n", width, height, BenchMicroseconds(start, frames) / 1000);
+
+	paint.type = LABPAINT_RADIAL;
+	paint.x0 = (float)width / 2;
+	paint.y0 = (float)height / 2;
+	paint.radius = (float)height / 2;
+	start = clock();
+	for (i = 0; i < frames; i++)
+		LabFillCircle(width / 2, height / 2, height / 2, &paint);
+	printf("Gradient %dx%d, radial      %8.3f ms\n", width, height, BenchMicroseconds(start, frames) / 1000);
+
+	paint.type = LABPAINT_SPAN;
+	paint.span = PaintNoise;
+	start = clock();
+	for (i = 0; i < frames; i++)
+		LabFillRect(0, 0, width, height, &paint);
+	printf("Gradient %dx%d, span func   %8.3f ms\n", width, height, BenchMicroseconds(start, frames) / 1000);
+}
+
+// every primitive in a color of its own, through the current color and through the RGB calls
+void BenchColors(void)
+{
+	int i, count = 200000, width = LabGetWidth(), height = LabGetHeight();
+	clock_t start;
+
+	start = clock();
+	for (i = 0; i < count; i++)
+	{
+		LabSetColorRGB(i, i >> 8, i >> 16);
+		LabDrawLine(i % width, i % height, (i * 7) % width, i % height);
+	}
+	printf("Mixed colors, LabSetColorRGB line  %8.3f us\n", BenchMicroseconds(start, count));
+
+	start = clock();
+	for (i = 0; i < count; i++)
+		LabDrawLineRGB(i % width, i % height, (i * 7) % width, i % height, LABRGB(i, i >> 8, i >> 16));
+	printf("Mixed colors, LabDrawLineRGB       %8.3f us\n", BenchMicroseconds(start, count));
+
+	start = clock();
+	for (i = 0; i < count; i++)
+	{
+		LabSetColorRGB(i, i >> 8, i >> 16);
+		LabDrawPoint(i % width, (i / width) % height);
+	}
+	printf("Mixed colors, LabSetColorRGB point %8.3f us\n", BenchMicroseconds(start, count));
+
+	start = clock();
+	for (i = 0; i < count; i++)
+		LabDrawPointRGB(i % width, (i / width) % height, LABRGB(i, i >> 8, i >> 16));
+	printf("Mixed colors, LabDrawPointRGB      %8.3f us\n", BenchMicroseconds(start, count));
+
+	// the same color set again and again before every primitive
+	start = clock();
+	for (i = 0; i < count; i++)
+	{
+		LabSetColor(LABCOLOR_YELLOW);
+		LabDrawLine(i % width, i % height, (i * 7) % width, i % height);
+	}
+	printf("Same color, LabSetColor line       %8.3f us\n", BenchMicroseconds(start, count));
+}
+
+// a million particles falling and bouncing in the window
+void BenchParticles(void)
+{
+	int i, count = 1000000, frames = 20, width = LabGetWidth(), height = LabGetHeight();
+	labparticles_t* particles = LabParticlesCreate(count);
+	labparticleparams_t params;
+	clock_t start;
+
+	if (!particles)
+		return;
+	srand(1);
+	for (i = 0; i < count; i++)
+		LabParticlesAdd(particles, (float)(rand() % width), (float)(rand() % height),
+			(float)(rand() % 200 - 100), (float)(rand() % 200 - 100), LABRGB(rand(), rand(), rand()), 0);
+	memset(&params, 0, sizeof(params));
+	params.ay = 100.0f;
+	params.edge = LABPARTICLE_BOUNCE;
+	params.right = (float)width;
+	params.bottom = (float)height;
+	params.bounce = 0.9f;
+
+	start = clock();
+	for (i = 0; i < frames; i++)
+		LabParticlesUpdate(particles, 1.0f / 60, &params);
+	printf("Particles 1M, update          %8.3f ms\n", BenchMicroseconds(start, frames) / 1000);
+
+	start = clock();
+	for (i = 0; i < frames; i++)
+	{
+		LabClear();
+		LabParticlesDraw(particles);
+		LabDrawFlush();
+	}
+	printf("Particles 1M, draw            %8.3f ms\n", BenchMicroseconds(start, frames) / 1000);
+
+	start = clock();
+	for (i = 0; i < count; i++)
+	{
+		LabSetColorRGB(i, i >> 8, i >> 16);
+		LabDrawPoint(i % width, (i / width) % height);
+	}
+	printf("Particles 1M, LabDrawPoint    %8.3f ms\n", BenchMicroseconds(start, 1) / 1000);
+	LabParticlesDestroy(particles);
+}
+
+// a 256x256 game of life field with 4x4 cells, drawn cell by cell and as a tile map
+void BenchTilemap(void)
+{
+	labparams_t params;
+	labtilemap_t* map;
+	labrgb_t tile[4 * 4];
+	int i, j, k, frames = 20;
+	clock_t start;
+
+	LabTerm();
+	params.width = 1024;
+	params.height = 1024;
+	params.scale = 1;
+	if (!LabInitWithFlags(&params, LABFLAG_HEADLESS))
+		return;
+	map = LabTilemapCreate(256, 256, 4, 4, 2);
+	for (i = 0; i < 16; i++)
+		tile[i] = (i & 3) == 3 || i >= 12 ? LABRGB(0, 0, 0) : LABRGB(0, 200, 0);
+	LabTilemapSetTile(map, 1, tile, 4);
+	srand(1);
+	for (i = 0; i < 256; i++)
+		for (j = 0; j < 256; j++)
+			LabTilemapSet(map, j, i, rand() & 1);
+
+	start = clock();
+	for (k = 0; k < frames; k++)
+	{
+		for (i = 0; i < 256; i++)
+			for (j = 0; j < 256; j++)
+			{
+				LabSetColor(LabTilemapGet(map, j, i) ? LABCOLOR_GREEN : LABCOLOR_BLACK);
+				LabDrawRectangle(j * 4, i * 4, j * 4 + 3, i * 4 + 3);
+				LabDrawRectangle(j * 4 + 1, i * 4 + 1, j * 4 + 2, i * 4 + 2);
+			}
+		LabDrawFlush();
+	}
+	printf("Tiles 256x256, rectangles     %8.3f ms\n", BenchMicroseconds(start, frames) / 1000);
+
+	start = clock();
+	for (k = 0; k < frames; k++)
+	{
+		LabTilemapInvalidate(map);
+		LabTilemapDraw(map, 0, 0);
+		LabDrawFlush();
+	}
+	printf("Tiles 256x256, whole map      %8.3f ms\n", BenchMicroseconds(start, frames) / 1000);
+
+	start = clock();
+	for (k = 0; k < frames * 10; k++)
+	{
+		for (i = 0; i < 100; i++)
+			LabTilemapSet(map, rand() & 255, rand() & 255, rand() & 1);
+		LabTilemapDraw(map, 0, 0);
+		LabDrawFlush();
+	}
+	printf("Tiles 256x256, 100 changes    %8.3f ms\n", BenchMicroseconds(start, frames * 10) / 1000);
+
+	LabTilemapDestroy(map);
+	LabTerm();
+	params.width = 640;
+	params.height = 480;
+	LabInitWithFlags(&params, LABFLAG_HEADLESS);
+}
+
+int CompareSprites(void const* a, void const* b)
+{
+	return ((int const*)a)[2] - ((int const*)b)[2];
+}
+
+// random opaque 16x16 sprites sorted and drawn in a batch against qsort and LabWritePixels
+void BenchSprites(void)
+{
+	static labrgb_t pixels[16 * 16];
+	labimage_t images[4];
+	labrect_t rect;
+	int* sprites = (int*)malloc(100000 * 3 * sizeof(int));
+	int i, j, count, frames, width = LabGetWidth(), height = LabGetHeight();
+	clock_t start;
+
+	for (i = 0; i < 16 * 16; i++)
+		pixels[i] = LABRGB(i, 100, 255 - i);
+	for (i = 0; i < 4; i++)
+	{
+		images[i].width = images[i].height = 16;
+		images[i].pixels = pixels;
+		images[i].transparent = LAB_FALSE;
+		images[i].key = 0;
+	}
+	srand(1);
+	for (i = 0; i < 100000; i++)
+	{
+		sprites[i * 3] = rand() % (width + 16) - 16;
+		sprites[i * 3 + 1] = rand() % (height + 16) - 16;
+		sprites[i * 3 + 2] = rand() % 1000;
+	}
+
+	for (count = 100; count <= 100000; count *= 10)
+	{
+		frames = 1000000 / count;
+		start = clock();
+		for (j = 0; j < frames; j++)
+		{
+			LabSpriteBegin();
+			for (i = 0; i < count; i++)
+				LabSpriteSubmit(&images[i & 3], sprites[i * 3], sprites[i * 3 + 1], sprites[i * 3 + 2]);
+			LabSpriteEnd();
+		}
+		printf("Sprites %6d, batch         %8.3f ms\n", count, BenchMicroseconds(start, frames) / 1000);
+
+		start = clock();
+		for (j = 0; j < frames; j++)
+		{
+			qsort(sprites, count, 3 * sizeof(int), CompareSprites);
+			for (i = 0; i < count; i++)
+			{
+				rect.left = sprites[i * 3];
+				rect.top = sprites[i * 3 + 1];
+				rect.right = rect.left + 16;
+				rect.bottom = rect.top + 16;
+				LabWritePixels(&rect, pixels, 16);
+			}
+		}
+		printf("Sprites %6d, qsort+write   %8.3f ms\n", count, BenchMicroseconds(start, frames) / 1000);
+	}
+	free(sprites);
+}
+
+// curves drawn with LabDrawLineF() steps evaluated from sin and cos or the polynomial, against LabDrawArc()
+// and LabDrawBezier(); the adaptive arc count follows the 1/4 pixel tolerance
+void BenchCurves(void)
+{
+	labpointf_t curve[4] = { { 20, 400 }, { 100, 50 }, { 500, 50 }, { 600, 400 } };
+	int i, j, frames = 1000, steps = 360, adaptive;
+	float x1, y1, x2, y2, t;
+	clock_t start;
+
+	LabClear();
+	start = clock();
+	for (i = 0; i < frames; i++)
+		for (j = 0, x2 = 420, y2 = 240; j < steps; j++)
+		{
+			x1 = x2;
+			y1 = y2;
+			x2 = (float)(320 + 100 * cos(6.28318530718 * (j + 1) / steps));
+			y2 = (float)(240 + 100 * sin(6.28318530718 * (j + 1) / steps));
+			LabDrawLineF(x1, y1, x2, y2);
+		}
+	printf("Arc r=100, %3d fixed steps       %8.3f us\n", steps, BenchMicroseconds(start, frames));
+	adaptive = (int)ceil(6.28318530718 / (2 * acos(1 - 0.25 / 100)));
+	start = clock();
+	for (i = 0; i < frames; i++)
+		LabDrawArc(320, 240, 100, 0, 6.28318530718f);
+	printf("Arc r=100, %3d adaptive steps    %8.3f us\n", adaptive, BenchMicroseconds(start, frames));
+
+	start = clock();
+	for (i = 0; i < frames; i++)
+		for (j = 0, x2 = curve[0].x, y2 = curve[0].y; j < steps; j++)
+		{
+			x1 = x2;
+			y1 = y2;
+			t = (float)(j + 1) / steps;
+			x2 = (1 - t) * (1 - t) * (1 - t) * curve[0].x + 3 * (1 - t) * (1 - t) * t * curve[1].x +
+				3 * (1 - t) * t * t * curve[2].x + t * t * t * curve[3].x;
+			y2 = (1 - t) * (1 - t) * (1 - t) * curve[0].y + 3 * (1 - t) * (1 - t) * t * curve[1].y +
+				3 * (1 - t) * t * t * curve[2].y + t * t * t * curve[3].y;
+			LabDrawLineF(x1, y1, x2, y2);
+		}
+	printf("Cubic Bezier, %3d fixed steps    %8.3f us\n", steps, BenchMicroseconds(start, frames));
+	start = clock();
+	for (i = 0; i < frames; i++)
+		LabDrawBezier(curve, 4);
+	printf("Cubic Bezier, adaptive           %8.3f us\n", BenchMicroseconds(start, frames));
+
+	for (i = 0; i < 4; i++)
+		curve[i].y += 1000;
+	start = clock();
+	for (i = 0; i < frames; i++)
+		LabDrawBezier(curve, 4);
+	printf("Cubic Bezier, out of view        %8.3f us\n", BenchMicroseconds(start, frames));
+}
+
+// the RunPoly frame flushed with and without the history, and the memory a frame takes
+void BenchHistory(void)
+{
+	labhistoryinfo_t info;
+	int i, frames = 1000, radius = LabGetHeight() / 4;
+	clock_t start;
+
+	start = clock();
+	for (i = 0; i < frames; i++)
+		DrawPolyFrame(i, radius);
+	printf("RunPoly frame, no history        %8.3f us\n", BenchMicroseconds(start, frames));
+
+	LabHistoryStart(16 << 20);
+	start = clock();
+	for (i = 0; i < frames; i++)
+		DrawPolyFrame(i, radius);
+	printf("RunPoly frame, history           %8.3f us\n", BenchMicroseconds(start, frames));
+	LabHistoryGetInfo(&info);
+	printf("History, %4d frames, %8d bytes of deltas, %4d bytes a frame, %8.3f us a flush\n",
+		info.frames, info.deltaBytes, info.deltaBytes / (info.frames - 1), info.flushMicroseconds);
+	LabHistoryStop();
+}
+
+// the same shapes drawn opaque and translucent
+void BenchBlend(void)
+{
+	int i, j, count = 200000, frames = 100, width = LabGetWidth(), height = LabGetHeight();
+	labpaint_t paint;
+	clock_t start;
+
+	paint.type = LABPAINT_LINEAR;
+	paint.x0 = paint.y0 = 0;
+	paint.x1 = (float)width;
+	paint.y1 = 0;
+	paint.color0 = LABRGB(0, 0, 255);
+	paint.color1 = LABRGB(255, 0, 0);
+	for (i = 0; i < 2; i++)
+	{
+		LabSetAlpha(i ? 128 : 255);
+		start = clock();
+		for (j = 0; j < frames; j++)
+			LabFillRect(0, 0, width, height, &paint);
+		printf("Gradient 640x480, alpha %3d      %8.3f ms\n", LabGetAlpha(), BenchMicroseconds(start, frames) / 1000);
+
+		start = clock();
+		for (j = 0; j < count; j++)
+			LabDrawLine(j % width, j % height, (j * 7) % width, j % height);
+		printf("Lines, alpha %3d                 %8.3f us\n", LabGetAlpha(), BenchMicroseconds(start, count));
+	}
+
+	LabSetBlend(LABBLEND_ADD);
+	start = clock();
+	for (i = 0; i < frames; i++)
+		LabFillRect(0, 0, width, height, &paint);
+	printf("Gradient 640x480, additive       %8.3f ms\n", BenchMicroseconds(start, frames) / 1000);
+	LabSetBlend(LABBLEND_ALPHA);
+	LabSetAlpha(255);
+}
+
+// synthetic keys going through the queue to the RunPoly frame
+void BenchLatency(void)
+{
+	lablatencyinfo_t info;
+	char const* names[LABLATENCY_STAGE_COUNT] = { "queue", "flush", "present" };
+	int i, keys = 1000, radius = LabGetHeight() / 4;
+
+	LabLatencyReset();
+	for (i = 0; i < keys; i++)
+	{
+		LabInputKeyPost(LABKEY_RIGHT);
+		LabInputKey();
+		DrawPolyFrame(i, radius);
+	}
+	for (i = 0; i < LABLATENCY_STAGE_COUNT; i++)
+	{
+		LabLatencyGetInfo(i, &info);
+		printf("Key to %-8s p50 %8.1f us, p99 %8.1f us, max %8.1f us\n", names[i], info.p50, info.p99, info.max);
+	}
+}
+
+// fill a flat triangle with a line per row, the way it is done without LabFillTriangle()
+void FillTriangleByLines(labvertex_t const* v)
+{
+	double x[3], y[3], left, right, t;
+	int i, j, row;
+
+	for (i = 0; i < 3; i++)
+	{
+		x[i] = v[i].x;
+		y[i] = v[i].y;
+	}
+	LabSetColorRGB(LABRGB_R(v[0].color), LABRGB_G(v[0].color), LABRGB_B(v[0].color));
+	for (row = (int)ceil(min(y[0], min(y[1], y[2]))); row < max(y[0], max(y[1], y[2])); row++)
+	{
+		left = 1e9;
+		right = -1e9;
+		for (i = 0; i < 3; i++)
+		{
+			j = (i + 1) % 3;
+			if ((y[i] <= row && row < y[j]) || (y[j] <= row && row < y[i]))
+			{
+				t = x[i] + (row - y[i]) * (x[j] - x[i]) / (y[j] - y[i]);
+				left = min(left, t);
+				right = max(right, t);
+			}
+		}
+		if (left <= right)
+			LabDrawLine((int)ceil(left), row, (int)ceil(right), row);
+	}
+}
+
+// triangles per second in a spinning mesh of small, medium and large triangles
+void BenchTriangles(void)
+{
+	int i, j, k, count, sizes[3] = { 8, 32, 128 }, width = LabGetWidth(), height = LabGetHeight();
+	labvertex_t v[3];
+	clock_t start;
+
+	for (k = 0; k < 3; k++)
+	{
+		count = 2000000 / sizes[k] / sizes[k] * 40;
+		for (j = 0; j < 3; j++)
+		{
+			if (j == 1)
+				LabDepthStart(32);
+			start = clock();
+			for (i = 0; i < count; i++)
+			{
+				float x = (float)((i * 37) % (width - sizes[k])), y = (float)((i * 91) % (height - sizes[k]));
+				v[0].x = x;
+				v[0].y = y;
+				v[1].x = x + sizes[k];
+				v[1].y = y + sizes[k] * 0.25f;
+				v[2].x = x + sizes[k] * 0.5f;
+				v[2].y = y + sizes[k];
+				v[0].z = v[1].z = v[2].z = (float)(i % 1000) / 1000;
+				v[0].color = LABRGB(i, 0, 0);
+				v[1].color = LABRGB(0, i, 0);
+				v[2].color = LABRGB(0, 0, i);
+				if (j == 2)
+					FillTriangleByLines(v);
+				else
+					LabFillTriangle(v);
+			}
+			printf("Triangles %3d px, %-10s %10.0f per second\n", sizes[k],
+				j == 0 ? "shaded" : j == 1 ? "depth" : "lines", 1e6 / BenchMicroseconds(start, count));
+			if (j == 1)
+				LabDepthStop();
+		}
+	}
+}
+
+int RunBenchmarks(void)
+{
+	labparams_t params;
+
+	params.width = 640;
+	params.height = 480;
+	params.scale = 1;
+	if (!LabInitWithFlags(&params, LABFLAG_HEADLESS))
+		return 1;
+
+	BenchText();
+	BenchPolyline();
+	BenchClip();
+	BenchSubpixel();
+	BenchReadback();
+	BenchFloodFill();
+	BenchKernels();
+	BenchShare();
+	BenchJournal();
+	BenchLayers();
+	BenchScroll();
+	BenchGradient();
+	BenchColors();
+	BenchParticles();
+	BenchTilemap();
+	BenchSprites();
+	BenchCurves();
+	BenchHistory();
+	BenchBlend();
+	BenchLatency();
+	BenchTriangles();
+
+	LabTerm();
+	return 0;
+}
+
+// ////////////////////////////////////////////////////////////////////////////
+//   Checks (run as "labtest check", no window is created)
+// ////////////////////////////////////////////////////////////////////////////
+
+int s_failures = 0;
+
+void Check(int condition, char const* what)
+{
+	printf("%-44s %s\n", what, condition ? "ok" : "FAILED");
+	if (!condition)
+		s_failures++;
+}
+
+unsigned HashPixels(labrect_t const* rect)
+{
+	int i, count = (rect->right - rect->left) * (rect->bottom - rect->top);
+	labrgb_t* pixels = (labrgb_t*)malloc(count * sizeof(labrgb_t));
+	unsigned hash = 2166136261u;
+
+	LabReadPixels(rect, pixels, rect->right - rect->left);
+	for (i = 0; i < count; i++)
+		hash = (hash ^ pixels[i]) * 16777619u;
+	free(pixels);
+	return hash;
+}
+
+// only basic arithmetic here, so that the coordinates are the same with any math library
+void DrawSubpixelScene(void)
+{
+	int i;
+	double t, c, s;
+
+	LabSetColor(LABCOLOR_WHITE);
+	for (i = 0; i < 64; i++)
+	{
+		// a point on the unit circle from the rational parametrization
+		t = (i - 32) / 17.0;
+		c = (1 - t * t) / (1 + t * t);
+		s = 2 * t / (1 + t * t);
+		LabDrawLineF(160.3f, 120.7f, (float)(160.3 + 150 * c), (float)(120.7 + 110 * s));
+		LabDrawCircleF((float)(40 + i * 3.7), (float)(60.2 + i * 1.3), (float)(5 + i * 0.41));
+	}
+	LabDrawPointF(13.49f, 12.5f);
+}
+
+void CheckSubpixel(void)
+{
+	labpointf_t strip[4] = { { 10.5f, 10.5f }, { 0, 200.5f }, { 300.25f, 20.0f }, { 150.0f, 230.75f } };
+	labrect_t all = { 0, 0, 320, 240 };
+	unsigned first, second;
+	float zero, nan;
+
+	LabClear();
+	DrawSubpixelScene();
+	first = HashPixels(&all);
+	LabClear();
+	DrawSubpixelScene();
+	second = HashPixels(&all);
+	Check(first == second, "sub-pixel drawing is repeatable");
+	Check(first == 0x01AF5AC5u, "sub-pixel drawing matches reference image");
+
+	// the same scene moved by whole pixels gives the same pixels moved
+	LabClear();
+	LabSetOrigin(7, -5);
+	DrawSubpixelScene();
+	second = HashPixels(&all);
+	LabSetOrigin(0, 0);
+	Check(first == second, "sub-pixel drawing is translation invariant");
+
+	// points with NaN are left out of a polyline, other calls with NaN draw nothing
+	zero = 0;
+	nan = zero / zero;
+	strip[1].x = nan;
+	LabClear();
+	LabDrawPolylineF(strip, 4, LAB_TRUE);
+	LabDrawLineF(nan, 1.0f, 100.0f, 100.0f);
+	LabDrawPointF(20.0f, nan);
+	LabDrawCircleF(160.0f, 120.0f, nan);
+	first = HashPixels(&all);
+	strip[1] = strip[0];
+	LabClear();
+	LabDrawPolylineF(strip, 4, LAB_TRUE);
+	Check(HashPixels(&all) == first, "sub-pixel drawing skips NaN");
+
+	// far away coordinates are clamped and still give the visible part
+	LabClear();
+	LabDrawLineF(-1e30f, 100.0f, 1e30f, 100.0f);
+	Check(LabGetPixel(0, 100) != 0 && LabGetPixel(319, 100) != 0, "sub-pixel drawing clamps far coordinates");
+}
+
+// plain Bresenham over every step of the segment without its last point, in doubles to hold huge coordinates
+void DrawReferenceLine(labrgb_t* pixels, double x1, double y1, double x2, double y2, labrgb_t color)
+{
+	double dx = fabs(x2 - x1), dy = fabs(y2 - y1), sx = x1 < x2 ? 1 : -1, sy = y1 < y2 ? 1 : -1, i, err;
+
+	for (i = 0, err = floor((dx >= dy ? dx : dy) / 2); i < (dx >= dy ? dx : dy); i++)
+	{
+		if (x1 >= 0 && x1 < 320 && y1 >= 0 && y1 < 240)
+			pixels[(int)y1 * 320 + (int)x1] = color;
+		if (dx >= dy)
+		{
+			x1 += sx;
+			if ((err -= dy) < 0)
+			{
+				err += dx;
+				y1 += sy;
+			}
+		}
+		else
+		{
+			y1 += sy;
+			if ((err -= dx) < 0)
+			{
+				err += dy;
+				x1 += sx;
+			}
+		}
+	}
+}
+
+void CheckPolyline(void)
+{
+	static labpoint_t const strip[] = {
+		{ -1000000, 100 }, { 1000000, 141 }, { 150, -3000000 }, { 170, 3000000 }, { -400, -7 }, { 700, 300 },
+		{ 330, -90 }, { -10, 250 }, { 319, 0 }, { 0, 239 }, { 200, -1 }, { 100, 240 }
+	};
+	labpoint_t huge[3];
+	labrect_t all = { 0, 0, 320, 240 };
+	labrgb_t* expected = (labrgb_t*)calloc(320 * 240, sizeof(labrgb_t));
+	labrgb_t* pixels = (labrgb_t*)malloc(320 * 240 * sizeof(labrgb_t));
+	int i, count = sizeof(strip) / sizeof(strip[0]), same, row;
+
+	// the clipped walk starts where the segment enters the buffer, but puts the same points as the whole one
+	LabClear();
+	LabSetColor(LABCOLOR_WHITE);
+	LabDrawPolyline(strip, count, LAB_TRUE);
+	LabReadPixels(&all, pixels, 320);
+	for (i = 0; i < count; i++)
+		DrawReferenceLine(expected, strip[i].x, strip[i].y, strip[(i + 1) % count].x, strip[(i + 1) % count].y, LABRGB(255, 255, 255));
+	for (i = 0, same = 1; i < 320 * 240; i++)
+		same = same && pixels[i] == expected[i];
+	Check(same, "LabDrawPolyline clips segments exactly");
+
+	// coordinates pushed beyond int by the origin, the middle of the segment is far to the left
+	LabClear();
+	LabSetOrigin(-1000, 0);
+	huge[0].x = INT_MIN + 10;
+	huge[0].y = 100;
+	huge[1].x = INT_MAX;
+	huge[1].y = 101;
+	huge[2].x = INT_MAX;
+	huge[2].y = INT_MIN;
+	LabDrawPolyline(huge, 3, LAB_FALSE);
+	LabSetOrigin(0, 0);
+	LabReadPixels(&all, pixels, 320);
+	for (i = 0, same = 0, row = 1; i < 320 * 240; i++)
+		if (pixels[i] != 0)
+		{
+			same++;
+			row = row && i / 320 == 101;
+		}
+	Check(same == 320 && row, "LabDrawPolyline draws huge coordinates");
+	free(pixels);
+	free(expected);
+}
+
+void CheckReadback(void)
+{
+	labrect_t rect = { -2, 3, 6, 5 };
+	labrgb_t pixels[2 * 8];
+	int i, black = 1;
+
+	LabClear();
+	LabSetColorRGB(10, 20, 30);
+	LabDrawPoint(5, 7);
+	LabDrawPoint(0, 4);
+	Check(LabGetPixel(5, 7) == LABRGB(10, 20, 30), "LabGetPixel reads a drawn point");
+	Check(LabGetPixel(-1, 7) == 0 && LabGetPixel(5, 100000) == 0, "LabGetPixel is black out of the buffer");
+
+	for (i = 0; i < 2 * 8; i++)
+		pixels[i] = 0xDEADBEEF;
+	LabReadPixels(&rect, pixels, 8);
+	for (i = 0; i < 2 * 8; i++)
+		if (i != 8 + 2 && pixels[i] != 0)
+			black = 0;
+	Check(pixels[8 + 2] == LABRGB(10, 20, 30) && black, "LabReadPixels reads a clipped rectangle");
+}
+
+void CheckFloodFill(void)
+{
+	labfillparams_t params;
+
+	LabClear();
+	LabSetColor(LABCOLOR_WHITE);
+	LabDrawRectangle(10, 10, 30, 20);
+	LabFloodFill(15, 15, LABRGB(255, 0, 0));
+	Check(LabGetPixel(11, 11) == LABRGB(255, 0, 0) && LabGetPixel(28, 18) == LABRGB(255, 0, 0) &&
+		LabGetPixel(10, 10) == LABRGB(255, 255, 255) && LabGetPixel(5, 5) == 0, "LabFloodFill stays inside a rectangle");
+
+	// a diagonal line stops a 4-connected fill, but not an 8-connected one
+	LabClear();
+	LabDrawLine(0, 40, 41, -1);
+	LabFloodFill(2, 2, LABRGB(0, 255, 0));
+	Check(LabGetPixel(20, 19) == LABRGB(0, 255, 0) && LabGetPixel(21, 20) == 0, "LabFloodFill 4-connected");
+	LabClear();
+	LabDrawLine(0, 40, 41, -1);
+	params.tolerance = 0;
+	params.diagonal = LAB_TRUE;
+	LabFloodFillWith(2, 2, LABRGB(0, 0, 255), &params);
+	Check(LabGetPixel(21, 20) == LABRGB(0, 0, 255) && LabGetPixel(20, 20) == LABRGB(255, 255, 255), "LabFloodFillWith 8-connected");
+
+	// a gradient fills with enough tolerance
+	LabClear();
+	LabSetColorRGB(0, 0, 3);
+	LabDrawLine(0, 50, 100, 50);
+	LabSetColorRGB(0, 0, 6);
+	LabDrawLine(0, 51, 100, 51);
+	params.tolerance = 3;
+	params.diagonal = LAB_FALSE;
+	LabFloodFillWith(0, 0, LABRGB(9, 9, 9), &params);
+	Check(LabGetPixel(50, 49) == LABRGB(9, 9, 9) && LabGetPixel(50, 50) == LABRGB(9, 9, 9) &&
+		LabGetPixel(50, 51) == LABRGB(0, 0, 6), "LabFloodFillWith tolerance");
+}
+
+int RecvAll(SOCKET s, unsigned char* buffer, int size)
+{
+	int done, res;
+
+	for (done = 0; done < size; done += res)
+	{
+		res = recv(s, (char*)buffer + done, size - done, 0);
+		if (res <= 0)
+			return 0;
+	}
+	return 1;
+}
+
+unsigned Get16(unsigned char const* p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+unsigned Get32(unsigned char const* p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned)p[3] << 24);
+}
+
+// a stand-in viewer: applies a frame message to its copy of the screen, returns the number of tiles or -1
+int ReceiveFrame(SOCKET s, labrgb_t* screen, int width)
+{
+	static unsigned char data[6 * 64 * 64];
+	unsigned char head[13];
+	unsigned char const* p;
+	unsigned x, y, w, size, count, i, t, tiles;
+	labrgb_t value;
+
+	if (!RecvAll(s, head, 9) || head[0] != 'F')
+		return -1;
+	tiles = Get32(head + 5);
+	for (t = 0; t < tiles; t++)
+	{
+		if (!RecvAll(s, head, 13))
+			return -1;
+		x = Get16(head);
+		y = Get16(head + 2);
+		w = Get16(head + 4);
+		size = Get32(head + 9);
+		if (size > sizeof(data) || !RecvAll(s, data, size))
+			return -1;
+		for (p = data, i = 0; p < data + size; )
+		{
+			if (head[8] == 0)
+			{
+				screen[(y + i / w) * width + x + i % w] = Get32(p);
+				p += 4;
+				i++;
+				continue;
+			}
+			count = Get16(p);
+			value = Get32(p + 2);
+			for (p += 6; count > 0; count--, i++)
+				screen[(y + i / w) * width + x + i % w] ^= value;
+		}
+	}
+	return (int)tiles;
+}
+
+typedef struct runstate_t
+{
+	int frames;
+	int ticks;
+	int ticker;
+	int last;
+	int stopped;
+	labkey_t key;
+} runstate_t;
+
+void RunStateFrame(void* context)
+{
+	((runstate_t*)context)->frames++;
+}
+
+void RunStateKey(labkey_t key, void* context)
+{
+	((runstate_t*)context)->key = key;
+	LabRunStop();
+}
+
+void RunStateTimer(int timer, void* context)
+{
+	runstate_t* state = (runstate_t*)context;
+
+	if (timer == state->stopped)
+		state->stopped = -1;
+	if (timer != state->ticker)
+	{
+		state->last = timer;
+		LabRunStop();
+		return;
+	}
+	if (++state->ticks < 5)
+		return;
+	LabTimerStop(timer);
+	LabRunInvalidate();
+	LabTimerStart(30, 0);
+}
+
+void CheckRun(void)
+{
+	runstate_t state;
+	labcallbacks_t callbacks;
+	clock_t start;
+	int last;
+
+	memset(&state, 0, sizeof(state));
+	callbacks.onFrame = RunStateFrame;
+	callbacks.onKey = RunStateKey;
+	callbacks.onTimer = RunStateTimer;
+	callbacks.context = &state;
+	LabRun(&callbacks);
+	Check(state.frames == 1 && LabRunWakeups() == 0, "LabRun returns when there is nothing to wait");
+
+	// five ticks 10 ms apart, then a frame and a single timer that stops the loop
+	memset(&state, 0, sizeof(state));
+	state.ticker = LabTimerStart(10, 10);
+	state.stopped = LabTimerStart(20, 0);
+	LabTimerStop(state.stopped);
+	last = LabTimerStart(1000, 0);
+	LabTimerStop(last);
+	start = clock();
+	LabRun(&callbacks);
+	Check(state.ticks == 5 && state.frames == 2 && state.last > last && state.stopped > 0,
+		"LabRun calls the handlers");
+	Check(LabRunWakeups() >= 6 && LabRunWakeups() <= 8 && clock() - start < CLOCKS_PER_SEC / 2,
+		"LabRun sleeps between timers");
+}
+
+void CheckServer(void)
+{
+	WSADATA wsaData;
+	SOCKET s;
+	struct sockaddr_in addr;
+	unsigned char hello[12], key[5];
+	labrect_t rect;
+	labrgb_t *screen, *pixels;
+	int width = LabGetWidth(), height = LabGetHeight(), tiles, timer;
+	runstate_t state;
+	labcallbacks_t callbacks;
+
+	if (!LabServerStart(SERVER_PORT))
+	{
+		Check(0, "LabServerStart listens");
+		return;
+	}
+	WSAStartup(MAKEWORD(2, 2), &wsaData);
+	s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(SERVER_PORT);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	Check(connect(s, (struct sockaddr*)&addr, sizeof(addr)) == 0 && RecvAll(s, hello, sizeof(hello)) &&
+		memcmp(hello, "LABF", 4) == 0 && Get16(hello + 6) == width && Get16(hello + 8) == height, "LabServerStart greets a viewer");
+
+	screen = calloc(width * height, sizeof(labrgb_t));
+	pixels = malloc(width * height * sizeof(labrgb_t));
+	rect.left = rect.top = 0;
+	rect.right = width;
+	rect.bottom = height;
+
+	LabClear();
+	LabSetColor(LABCOLOR_RED);
+	LabDrawRectangle(10, 10, 100, 50);
+	LabDrawText(20, 20, "server");
+	LabDrawFlush();
+	tiles = ReceiveFrame(s, screen, width);
+	LabReadPixels(&rect, pixels, width);
+	Check(tiles > 0 && memcmp(screen, pixels, width * height * sizeof(labrgb_t)) == 0, "the viewer gets the whole frame");
+
+	LabSetColor(LABCOLOR_GREEN);
+	LabDrawPoint(37, 37);
+	LabDrawFlush();
+	tiles = ReceiveFrame(s, screen, width);
+	LabReadPixels(&rect, pixels, width);
+	Check(tiles == 1 && memcmp(screen, pixels, width * height * sizeof(labrgb_t)) == 0, "the viewer gets only changed tiles");
+
+	key[0] = 'K';
+	key[1] = LABKEY_ENTER & 0xFF;
+	key[2] = (LABKEY_ENTER >> 8) & 0xFF;
+	key[3] = key[4] = 0;
+	send(s, (char const*)key, sizeof(key), 0);
+	Check(LabInputKey() == LABKEY_ENTER, "keys from the viewer reach LabInputKey");
+
+	memset(&state, 0, sizeof(state));
+	callbacks.onFrame = RunStateFrame;
+	callbacks.onKey = RunStateKey;
+	callbacks.onTimer = RunStateTimer;
+	callbacks.context = &state;
+	key[1] = LABKEY_ESC & 0xFF;
+	key[2] = (LABKEY_ESC >> 8) & 0xFF;
+	send(s, (char const*)key, sizeof(key), 0);
+	timer = LabTimerStart(5000, 0);
+	LabRun(&callbacks);
+	LabTimerStop(timer);
+	Check(state.key == LABKEY_ESC, "keys from the viewer reach LabRun");
+
+	closesocket(s);
+	WSACleanup();
+	LabServerStop();
+	free(screen);
+	free(pixels);
+}
+
+typedef struct sharereader_t
+{
+	labshareheader_t const* header;
+	labrgb_t* pixels;
+	int snapshots;
+	int torn;
+	LONG volatile done;
+} sharereader_t;
+
+DWORD WINAPI ShareReaderProc(LPVOID param)
+{
+	sharereader_t* reader = (sharereader_t*)param;
+	unsigned frame, i, count = reader->header->width * reader->header->height;
+	int n;
+
+	for (n = 0; n < reader->snapshots; n++)
+	{
+		if (!ReadSharedFrame(reader->header, reader->pixels, &frame))
+			continue;
+		for (i = 1; i < count && reader->pixels[i] == reader->pixels[0]; i++)
+			;
+		if (i < count)
+			reader->torn++;
+	}
+	InterlockedExchange(&reader->done, 1);
+	return 0;
+}
+
+void CheckShare(void)
+{
+	int i, width = LabGetWidth(), height = LabGetHeight();
+	sharereader_t reader;
+	labrect_t rect;
+	labrgb_t* pixels;
+	unsigned frame;
+	HANDLE mapping, thread;
+
+	Check(LabShareStart(SHARE_NAME) && !LabShareStart(SHARE_NAME), "LabShareStart exports once");
+	reader.header = OpenSharedFrame(&mapping);
+	if (!reader.header)
+	{
+		Check(0, "LabShareStart is visible to readers");
+		LabShareStop();
+		return;
+	}
+	Check(reader.header->magic == LABSHARE_MAGIC && reader.header->width == (unsigned)width &&
+		reader.header->height == (unsigned)height && reader.header->format == LABSHARE_FORMAT_XRGB8888, "LabShareStart header");
+
+	reader.pixels = malloc(width * height * sizeof(labrgb_t));
+	pixels = malloc(width * height * sizeof(labrgb_t));
+	rect.left = rect.top = 0;
+	rect.right = width;
+	rect.bottom = height;
+	LabClear();
+	LabSetColor(LABCOLOR_YELLOW);
+	LabDrawCircle(100, 100, 50);
+	LabDrawFlush();
+	LabReadPixels(&rect, pixels, width);
+	Check(ReadSharedFrame(reader.header, reader.pixels, &frame) && frame == 2 &&
+		memcmp(reader.pixels, pixels, width * height * sizeof(labrgb_t)) == 0, "shared frame matches the buffer");
+
+	// the buffer is always a single color, so a reader must never see two
+	reader.snapshots = 2000;
+	reader.torn = 0;
+	reader.done = 0;
+	thread = CreateThread(NULL, 0, ShareReaderProc, &reader, 0, NULL);
+	for (i = 0; !reader.done; i++)
+	{
+		LabClearWith(i & 1 ? LABCOLOR_RED : LABCOLOR_BLUE);
+		LabDrawFlush();
+	}
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+	Check(reader.torn == 0, "shared frames are never torn");
+
+	UnmapViewOfFile(reader.header);
+	CloseHandle(mapping);
+	LabShareStop();
+	free(reader.pixels);
+	free(pixels);
+}
+
+// read what the terminal backend has written since the last call
+DWORD ReadTerminal(HANDLE file, DWORD* offset, char* buffer, DWORD size)
+{
+	DWORD end, read = 0;
+
+	end = SetFilePointer(file, 0, NULL, FILE_CURRENT);
+	SetFilePointer(file, *offset, NULL, FILE_BEGIN);
+	ReadFile(file, buffer, min(size - 1, end - *offset), &read, NULL);
+	SetFilePointer(file, end, NULL, FILE_BEGIN);
+	buffer[read] = '\0';
+	*offset = end;
+	return read;
+}
+
+int CountCells(char const* text)
+{
+	int count = 0;
+
+	while ((text = strstr(text, "\xE2\x96\x80")) != NULL)
+	{
+		count++;
+		text += 3;
+	}
+	return count;
+}
+
+void CheckTerminal(void)
+{
+	static char text[65536];
+	labparams_t params;
+	HANDLE file, output = GetStdHandle(STD_OUTPUT_HANDLE);
+	DWORD offset = 0;
+
+	// the backend writes to the standard output, which is a file here
+	file = CreateFileA("labtest.term", GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+		FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		Check(0, "LABFLAG_TERMINAL output file");
+		return;
+	}
+	SetStdHandle(STD_OUTPUT_HANDLE, file);
+	LabTerm();
+	params.width = 32;
+	params.height = 16;
+	params.scale = 1;
+	Check(LabInitWithFlags(&params, LABFLAG_TERMINAL), "LABFLAG_TERMINAL initializes");
+
+	LabClear();
+	LabDrawFlush();
+	ReadTerminal(file, &offset, text, sizeof(text));
+	Check(CountCells(text) == 32 * 8, "LABFLAG_TERMINAL writes the first frame");
+
+	LabDrawFlush();
+	Check(ReadTerminal(file, &offset, text, sizeof(text)) == 0, "LABFLAG_TERMINAL skips an unchanged frame");
+
+	LabSetColorRGB(255, 0, 0);
+	LabDrawPoint(5, 5);
+	LabDrawFlush();
+	ReadTerminal(file, &offset, text, sizeof(text));
+	Check(CountCells(text) == 1 && strstr(text, "\x1B[3;6H") && strstr(text, "48;2;255;0;0"), "LABFLAG_TERMINAL writes a changed cell");
+
+	LabTerm();
+	SetStdHandle(STD_OUTPUT_HANDLE, output);
+	CloseHandle(file);
+
+	params.width = 320;
+	params.height = 240;
+	LabInitWithFlags(&params, LABFLAG_HEADLESS);
+}
+
+// a bit of everything the journal records
+void DrawJournalScene(void)
+{
+	static labpoint_t const zigzag[] = { { 10, 200 }, { 30, 180 }, { 50, 200 }, { 70, 180 } };
+	static labpointf_t const triangle[] = { { 250.5f, 150.25f }, { 300.0f, 230.75f }, { 210.0f, 220.5f } };
+	labrect_t rect = { 200, 20, 216, 36 };
+	labfillparams_t params;
+	labrgb_t pixels[16 * 16];
+	int i;
+
+	for (i = 0; i < 16 * 16; i++)
+		pixels[i] = LABRGB(i, 255 - i, i / 2);
+	params.tolerance = 8;
+	params.diagonal = LAB_TRUE;
+
+	LabDrawLine(5, 230, 310, 5); // in the color set before the recording
+	LabSetColor(LABCOLOR_YELLOW);
+	LabDrawRectangle(10, 10, 100, 60);
+	LabFloodFillWith(50, 30, LABRGB(0, 0, 200), &params);
+	LabSetColorRGB(10, 200, 30);
+	LabDrawPolyline(zigzag, 4, LAB_FALSE);
+	LabDrawPolylineF(triangle, 3, LAB_TRUE);
+	LabPushClip(100, 100, 200, 200);
+	LabSetOrigin(120, 120);
+	LabDrawCircleF(20.5f, 20.25f, 30.0f);
+	LabDrawEllipse(0, 0, 70, 20);
+	LabDrawText(-10, 40, "journal");
+	LabSetOrigin(0, 0);
+	LabPopClip();
+	LabWritePixels(&rect, pixels, 16);
+	LabDrawFlush();
+}
+
+void CheckJournal(void)
+{
+	labrect_t all = { 0, 0, 320, 240 };
+	unsigned recorded;
+	FILE* file;
+
+	// the picture and the state before the recording are a part of the journal too
+	LabClear();
+	LabSetColor(LABCOLOR_DARK_GREY);
+	LabDrawCircle(160, 120, 100);
+	LabSetColor(LABCOLOR_RED);
+	LabPushClip(0, 0, 300, 220);
+	Check(LabJournalStart(JOURNAL_NAME), "LabJournalStart creates the journal");
+	DrawJournalScene();
+	LabInputKeyReady();
+	LabDelay(1);
+	recorded = HashPixels(&all);
+	Check(LabJournalStop(), "LabJournalStop writes the journal");
+	LabPopClip();
+
+	LabClearWith(LABCOLOR_WHITE);
+	LabSetColor(LABCOLOR_BLUE);
+	Check(LabJournalReplay(JOURNAL_NAME) && HashPixels(&all) == recorded, "LabJournalReplay repeats the picture");
+	Check(LabGetColor() == LABCOLOR_NA, "LabJournalReplay repeats the state");
+	LabPopClip();
+
+	file = fopen(JOURNAL_NAME, "r+b");
+	if (file)
+	{
+		fputs("LABX", file);
+		fclose(file);
+	}
+	Check(!LabJournalReplay(JOURNAL_NAME), "LabJournalReplay rejects a broken journal");
+	remove(JOURNAL_NAME);
+}
+
+// the layers are blended into the frame, which is seen through the shared memory
+labrgb_t GetFramePixel(labshareheader_t const* header, int x, int y)
+{
+	return ((labrgb_t const*)((char const*)header + header->offset))[y * header->width + x];
+}
+
+labrgb_t BlendPixel(labrgb_t s, labrgb_t d, int opacity)
+{
+	int a = opacity + (opacity >> 7);
+	return LABRGB((LABRGB_R(s) * a + LABRGB_R(d) * (256 - a)) >> 8, (LABRGB_G(s) * a + LABRGB_G(d) * (256 - a)) >> 8,
+		(LABRGB_B(s) * a + LABRGB_B(d) * (256 - a)) >> 8);
+}
+
+void CheckLayers(void)
+{
+	labrgb_t const blue = LABRGB(0, 0, 255), white = LABRGB(255, 255, 255);
+	labshareheader_t const* header;
+	labparams_t params;
+	HANDLE mapping;
+	int i, ok;
+
+	LabClearWith(LABCOLOR_BLUE);
+	LabShareStart(SHARE_NAME);
+	header = OpenSharedFrame(&mapping);
+	if (!header)
+	{
+		Check(0, "layers: shared frame");
+		LabShareStop();
+		return;
+	}
+
+	LabSetLayer(2);
+	Check(LabGetLayer() == 2 && LabGetPixel(10, 10) == 0, "LabSetLayer creates a transparent layer");
+	LabSetColor(LABCOLOR_WHITE);
+	LabDrawPoint(10, 10);
+	LabDrawFlush();
+	Check(GetFramePixel(header, 10, 10) == white && GetFramePixel(header, 11, 10) == blue, "LabSetLayer draws over layer 0");
+
+	LabSetLayerOpacity(2, 128);
+	LabDrawFlush();
+	Check(GetFramePixel(header, 10, 10) == LABRGB(128, 128, 255), "LabSetLayerOpacity blends layers");
+	LabSetLayerVisible(2, LAB_FALSE);
+	LabDrawFlush();
+	Check(GetFramePixel(header, 10, 10) == blue, "LabSetLayerVisible hides a layer");
+	LabSetLayerVisible(2, LAB_TRUE);
+
+	// a row of odd length with gaps goes through both the vector and the scalar blending
+	LabSetLayerOpacity(2, 200);
+	for (i = 0; i < 37; i++)
+	{
+		LabSetColorRGB(i * 7, 255 - i * 3, i * 11);
+		if (i % 5)
+			LabDrawPoint(1 + i, 50);
+	}
+	LabDrawFlush();
+	for (ok = 1, i = 0; i < 37; i++)
+		ok &= GetFramePixel(header, 1 + i, 50) == (i % 5 ? BlendPixel(LABRGB(i * 7, 255 - i * 3, i * 11), blue, 200) : blue);
+	Check(ok, "LabSetLayerOpacity blends every pixel");
+
+	LabClear();
+	LabDrawFlush();
+	Check(GetFramePixel(header, 10, 10) == blue && GetFramePixel(header, 2, 50) == blue, "LabClear makes a layer transparent");
+
+	// changes of a lower layer do not show through an upper one
+	LabSetLayerOpacity(2, 255);
+	LabSetColor(LABCOLOR_WHITE);
+	LabDrawPoint(100, 100);
+	LabSetLayer(0);
+	LabSetColor(LABCOLOR_RED);
+	LabDrawPoint(100, 100);
+	LabDrawPoint(200, 200);
+	LabDrawFlush();
+	Check(GetFramePixel(header, 100, 100) == white && GetFramePixel(header, 200, 200) == LABRGB(255, 0, 0),
+		"LabDrawFlush composes the changed areas");
+
+	UnmapViewOfFile(header);
+	CloseHandle(mapping);
+	LabShareStop();
+
+	// back to a single layer
+	LabTerm();
+	params.width = 320;
+	params.height = 240;
+	params.scale = 1;
+	LabInitWithFlags(&params, LABFLAG_HEADLESS);
+}
+
+labrgb_t GetPattern(int x, int y)
+{
+	return LABRGB(x, y, x ^ y);
+}
+
+void DrawPattern(labrgb_t* pixels)
+{
+	labrect_t all = { 0, 0, 320, 240 };
+	int x, y;
+
+	for (y = 0; y < 240; y++)
+		for (x = 0; x < 320; x++)
+			pixels[y * 320 + x] = GetPattern(x, y);
+	LabWritePixels(&all, pixels, 320);
+}
+
+void CheckScroll(void)
+{
+	labrect_t all = { 0, 0, 320, 240 };
+	labrect_t src = { 10, 10, 60, 40 };
+	labrgb_t* pixels = (labrgb_t*)malloc(320 * 240 * sizeof(labrgb_t));
+	labrgb_t expected;
+	int x, y, ok;
+
+	DrawPattern(pixels);
+	LabScroll(-3, 2, LABRGB(1, 2, 3));
+	LabReadPixels(&all, pixels, 320);
+	for (ok = 1, y = 0; y < 240; y++)
+		for (x = 0; x < 320; x++)
+		{
+			expected = (x >= 317 || y < 2) ? LABRGB(1, 2, 3) : GetPattern(x + 3, y - 2);
+			ok &= pixels[y * 320 + x] == expected;
+		}
+	Check(ok, "LabScroll moves pixels and fills the strip");
+
+	DrawPattern(pixels);
+	LabCopyRect(&src, 20, 15);
+	LabReadPixels(&all, pixels, 320);
+	for (ok = 1, y = 0; y < 240; y++)
+		for (x = 0; x < 320; x++)
+		{
+			expected = (x >= 20 && x < 70 && y >= 15 && y < 45) ? GetPattern(x - 10, y - 5) : GetPattern(x, y);
+			ok &= pixels[y * 320 + x] == expected;
+		}
+	DrawPattern(pixels);
+	LabCopyRect(&src, 5, 8);
+	LabReadPixels(&all, pixels, 320);
+	for (y = 0; y < 240; y++)
+		for (x = 0; x < 320; x++)
+		{
+			expected = (x >= 5 && x < 55 && y >= 8 && y < 38) ? GetPattern(x + 5, y + 2) : GetPattern(x, y);
+			ok &= pixels[y * 320 + x] == expected;
+		}
+	Check(ok, "LabCopyRect copies overlapping rectangles");
+
+	DrawPattern(pixels);
+	LabPushClip(0, 0, 100, 100);
+	LabScroll(0, 10, LABRGB(0, 0, 0));
+	LabPopClip();
+	LabReadPixels(&all, pixels, 320);
+	for (ok = 1, y = 0; y < 240; y++)
+		for (x = 0; x < 320; x++)
+		{
+			expected = (x >= 100 || y >= 100) ? GetPattern(x, y) : y < 10 ? 0 : GetPattern(x, y - 10);
+			ok &= pixels[y * 320 + x] == expected;
+		}
+	Check(ok, "LabScroll stays within the clip rectangle");
+	free(pixels);
+}
+
+void PaintCells(int x, int y, int count, labrgb_t* pixels, void* context)
+{
+	int i;
+
+	++*(int*)context;
+	for (i = 0; i < count; i++)
+		pixels[i] = GetPattern(x + i, y);
+}
+
+void SetLinearPaint(labpaint_t* paint, float x0, float x1, labrgb_t color0, labrgb_t color1)
+{
+	memset(paint, 0, sizeof(*paint));
+	paint->type = LABPAINT_LINEAR;
+	paint->x0 = x0;
+	paint->x1 = x1;
+	paint->color0 = color0;
+	paint->color1 = color1;
+}
+
+void CheckGradient(void)
+{
+	static labpoint_t const square[] = { { 10, 10 }, { 60, 10 }, { 60, 40 }, { 10, 40 } };
+	static labpoint_t const triangle[] = { { 0, 0 }, { 100, 0 }, { 0, 100 } };
+	labrect_t all = { 0, 0, 320, 240 };
+	labrgb_t* pixels = (labrgb_t*)malloc(320 * 240 * sizeof(labrgb_t));
+	labpaint_t paint;
+	unsigned hash;
+	int x, y, ok, calls;
+
+	LabClear();
+	SetLinearPaint(&paint, 0.0f, 256.0f, LABRGB(0, 0, 0), LABRGB(255, 255, 255));
+	LabFillRect(0, 0, 320, 10, &paint);
+	LabReadPixels(&all, pixels, 320);
+	for (ok = 1, y = 0; y < 10; y++)
+		for (x = 0; x < 320; x++)
+			ok &= pixels[y * 320 + x] == (x < 256 ? LABRGB(255 * x >> 8, 255 * x >> 8, 255 * x >> 8) : LABRGB(255, 255, 255));
+	Check(ok, "LabFillRect draws a linear gradient");
+
+	SetLinearPaint(&paint, 300.0f, 7.5f, LABRGB(200, 0, 0), LABRGB(0, 0, 200));
+	paint.y1 = 120.0f;
+	LabFillRect(0, 0, 320, 240, &paint);
+	hash = HashPixels(&all);
+	LabClear();
+	LabFillRect(0, 0, 157, 240, &paint);
+	LabFillRect(157, 0, 320, 240, &paint);
+	Check(HashPixels(&all) == hash, "LabFillRect gradients have no seams");
+
+	LabClear();
+	memset(&paint, 0, sizeof(paint));
+	paint.type = LABPAINT_RADIAL;
+	paint.x0 = 160.0f;
+	paint.y0 = 120.0f;
+	paint.radius = 50.0f;
+	paint.color0 = LABRGB(255, 0, 0);
+	paint.color1 = LABRGB(0, 0, 255);
+	LabFillCircle(160, 120, 50, &paint);
+	Check(LabGetPixel(160, 120) == LABRGB(255, 0, 0) && LabGetPixel(210, 120) == LABRGB(0, 0, 255) &&
+		LabGetPixel(185, 120) == LABRGB(127, 0, 127) && LabGetPixel(160, 69) == 0 && LabGetPixel(197, 157) == 0,
+		"LabFillCircle draws a radial gradient");
+
+	LabClear();
+	SetLinearPaint(&paint, 0.0f, 0.0f, LABRGB(1, 2, 3), 0);
+	LabSetOrigin(20, 30);
+	LabFillPolygon(triangle, 3, &paint);
+	LabSetOrigin(0, 0);
+	LabReadPixels(&all, pixels, 320);
+	for (ok = 1, y = 0; y < 240; y++)
+		for (x = 0; x < 320; x++)
+			ok &= (pixels[y * 320 + x] != 0) == (y >= 30 && x >= 20 && x - 20 < 100 - (y - 30));
+	Check(ok, "LabFillPolygon fills pixel centers inside");
+
+	LabClear();
+	paint.type = LABPAINT_SPAN;
+	paint.span = PaintCells;
+	paint.context = &calls;
+	calls = 0;
+	LabFillRect(10, 10, 60, 40, &paint);
+	hash = HashPixels(&all);
+	Check(calls == 30 && LabGetPixel(30, 20) == GetPattern(30, 20), "LabFillRect calls the span function per row");
+	LabClear();
+	LabFillPolygon(square, 4, &paint);
+	Check(HashPixels(&all) == hash, "LabFillPolygon matches LabFillRect");
+
+	// a callback is recorded as its pixels
+	LabClear();
+	Check(LabJournalStart(JOURNAL_NAME), "LabJournalStart records fills");
+	LabFillCircle(100, 100, 40, &paint);
+	SetLinearPaint(&paint, 10.0f, 300.0f, LABRGB(0, 90, 0), LABRGB(90, 0, 90));
+	LabFillPolygon(triangle, 3, &paint);
+	paint.type = LABPAINT_RADIAL;
+	paint.radius = 60.0f;
+	LabFillRect(150, 20, 300, 200, &paint);
+	hash = HashPixels(&all);
+	LabJournalStop();
+	LabClear();
+	Check(LabJournalReplay(JOURNAL_NAME) && HashPixels(&all) == hash, "LabJournalReplay repeats fills");
+	remove(JOURNAL_NAME);
+	free(pixels);
+}
+
+void CheckColors(void)
+{
+	static labpoint_t const zigzag[] = { { 10, 200 }, { 30, 180 }, { 50, 200 }, { 70, 180 } };
+	labrect_t all = { 0, 0, 320, 240 };
+	unsigned hash;
+
+	LabClear();
+	LabSetColorRGB(10, 20, 30);
+	LabDrawRectangle(20, 20, 120, 80);
+	LabDrawRectangle(200, 50, 201, 51);
+	LabDrawPolyline(zigzag, 4, LAB_TRUE);
+	LabDrawPolyline(zigzag, 2, LAB_FALSE);
+	LabSetColor(LABCOLOR_RED);
+	hash = HashPixels(&all);
+	LabClear();
+	LabDrawRectangleRGB(120, 80, 20, 20, LABRGB(10, 20, 30));
+	LabDrawRectangleRGB(200, 50, 201, 51, LABRGB(10, 20, 30));
+	LabDrawPolylineRGB(zigzag, 4, LAB_TRUE, LABRGB(10, 20, 30));
+	LabDrawLineRGB(10, 200, 30, 180, LABRGB(10, 20, 30));
+	Check(HashPixels(&all) == hash, "RGB calls draw like the current color ones");
+
+	LabDrawPointRGB(5, 5, LABRGB(0, 255, 0));
+	LabDrawLine(0, 10, 10, 10);
+	Check(LabGetPixel(5, 5) == LABRGB(0, 255, 0) && LabGetPixel(5, 10) == LABRGB(255, 0, 0) &&
+		LabGetColor() == LABCOLOR_RED, "RGB calls leave the current color alone");
+
+	LabSetColorRGB(1, 2, 3);
+	LabSetColor(LABCOLOR_WHITE);
+	LabSetColor(LABCOLOR_RED);
+	LabDrawLine(0, 12, 10, 12);
+	LabSetLayer(1);
+	LabDrawLine(0, 14, 10, 14);
+	LabSetLayer(0);
+	LabSetLayerVisible(1, LAB_FALSE);
+	LabDrawLine(0, 16, 10, 16);
+	Check(LabGetPixel(5, 12) == LABRGB(255, 0, 0) && LabGetPixel(5, 16) == LABRGB(255, 0, 0) &&
+		LabGetColor() == LABCOLOR_RED, "a deferred color reaches the pen");
+	LabSetLayer(1);
+	Check(LabGetPixel(5, 14) == LABRGB(255, 0, 0), "a deferred color reaches a layer pen");
+	LabClear();
+	LabSetLayer(0);
+	LabSetColor(LABCOLOR_WHITE);
+}
+
+void CheckParticles(void)
+{
+	labparticles_t* particles = LabParticlesCreate(7);
+	labparticleparams_t params;
+	labrect_t all = { 0, 0, 320, 240 };
+	unsigned hash;
+	int i;
+
+	Check(particles != NULL, "LabParticlesCreate");
+	if (!particles)
+		return;
+	for (i = 0; i < 7; i++)
+		LabParticlesAdd(particles, 10.0f + i * 10, 20.0f, 400.0f, 0.0f, LABRGB(i * 30, 255, 0), 0.0f);
+	Check(!LabParticlesAdd(particles, 0, 0, 0, 0, 0, 0) && LabParticlesCount(particles) == 7,
+		"LabParticlesAdd stops at the capacity");
+
+	memset(&params, 0, sizeof(params));
+	params.ay = 200.0f;
+	params.edge = LABPARTICLE_BOUNCE;
+	params.right = 100.0f;
+	params.bottom = 200.0f;
+	params.bounce = 0.5f;
+	LabParticlesUpdate(particles, 0.1f, &params);
+	LabClear();
+	LabParticlesDraw(particles);
+	Check(LabGetPixel(50, 22) == LABRGB(0, 255, 0) && LabGetPixel(100, 22) == LABRGB(150, 255, 0) &&
+		LabGetPixel(90, 22) == LABRGB(180, 255, 0) && LabGetPixel(110, 22) == 0, "LabParticlesUpdate bounces");
+
+	params.edge = LABPARTICLE_REMOVE;
+	LabParticlesUpdate(particles, 0.1f, &params);
+	Check(LabParticlesCount(particles) == 3, "LabParticlesUpdate removes at the edge");
+	LabParticlesDestroy(particles);
+
+	particles = LabParticlesCreate(100);
+	LabParticlesAdd(particles, 0, 0, 0, 0, 0, 0.3f);
+	LabParticlesAdd(particles, 0, 0, 0, 0, 0, 0.1f);
+	LabParticlesAdd(particles, 0, 0, 0, 0, 0, 0.5f);
+	LabParticlesAdd(particles, 0, 0, 0, 0, 0, 0.15f);
+	LabParticlesAdd(particles, 0, 0, 0, 0, 0, 0.0f);
+	LabParticlesAdd(particles, 0, 0, 0, 0, 0, 1.0f);
+	LabParticlesUpdate(particles, 0.2f, NULL);
+	Check(LabParticlesCount(particles) == 4, "LabParticlesUpdate removes expired ones");
+	LabParticlesDestroy(particles);
+
+	LabClear();
+	LabDrawPointRGB(105, 106, LABRGB(1, 2, 3));
+	hash = HashPixels(&all);
+	LabClear();
+	particles = LabParticlesCreate(100);
+	LabParticlesAdd(particles, -105.0f, 10.0f, 0, 0, LABRGB(1, 2, 3), 0);
+	LabParticlesAdd(particles, 1000.0f, 10.0f, 0, 0, LABRGB(1, 2, 3), 0);
+	LabParticlesAdd(particles, 5.4f, 5.6f, 0, 0, LABRGB(1, 2, 3), 0);
+	LabParticlesAdd(particles, 5.0f, -1000.0f, 0, 0, LABRGB(1, 2, 3), 0);
+	LabParticlesAdd(particles, -100.6f, 5.0f, 0, 0, LABRGB(1, 2, 3), 0);
+	LabSetOrigin(100, 100);
+	LabParticlesDraw(particles);
+	LabSetOrigin(0, 0);
+	Check(HashPixels(&all) == hash, "LabParticlesDraw culls off-screen ones");
+
+	for (i = 0; i < 90; i++)
+		LabParticlesAdd(particles, (float)(i * 3), (float)(i * 2), 0, 0, LABRGB(i, 100, 200), 0);
+	LabClear();
+	LabJournalStart(JOURNAL_NAME);
+	LabParticlesDraw(particles);
+	hash = HashPixels(&all);
+	LabJournalStop();
+	LabClear();
+	Check(LabJournalReplay(JOURNAL_NAME) && HashPixels(&all) == hash, "LabJournalReplay repeats particles");
+	remove(JOURNAL_NAME);
+	LabParticlesDestroy(particles);
+}
+
+void CheckTilemap(void)
+{
+	labtilemap_t* map = LabTilemapCreate(10, 8, 4, 3, 3);
+	labrgb_t tile[4 * 3];
+	int i;
+
+	Check(map != NULL, "LabTilemapCreate");
+	if (!map)
+		return;
+	for (i = 0; i < 12; i++)
+		tile[i] = LABRGB(i, 100, 0);
+	LabTilemapSetTile(map, 1, tile, 4);
+	for (i = 0; i < 12; i++)
+		tile[i] = LABRGB(0, 0, 200);
+	LabTilemapSetTile(map, 2, tile, 4);
+
+	LabClearWith(LABCOLOR_WHITE);
+	LabTilemapSet(map, 2, 1, 1);
+	LabTilemapDraw(map, 20, 10);
+	Check(LabGetPixel(28, 13) == LABRGB(0, 100, 0) && LabGetPixel(31, 15) == LABRGB(11, 100, 0) &&
+		LabGetPixel(27, 13) == 0 && LabGetPixel(59, 33) == 0 && LabGetPixel(60, 34) == LABRGB(255, 255, 255),
+		"LabTilemapDraw draws the whole map first");
+
+	// pixels drawn over the map stay until their cell changes
+	LabDrawPointRGB(21, 11, LABRGB(1, 1, 1));
+	LabDrawPointRGB(33, 11, LABRGB(1, 1, 1));
+	LabTilemapSet(map, 3, 0, 2);
+	LabTilemapSet(map, 2, 1, 1);
+	LabTilemapDraw(map, 20, 10);
+	Check(LabGetPixel(21, 11) == LABRGB(1, 1, 1) && LabGetPixel(33, 11) == LABRGB(0, 0, 200) &&
+		LabTilemapGet(map, 3, 0) == 2 && LabTilemapGet(map, 10, 0) == -1, "LabTilemapDraw draws changed cells only");
+
+	LabTilemapDraw(map, 21, 10);
+	Check(LabGetPixel(21, 11) == 0 && LabGetPixel(34, 11) == LABRGB(0, 0, 200), "LabTilemapDraw redraws a moved map");
+	LabDrawPointRGB(21, 11, LABRGB(1, 1, 1));
+	LabClear();
+	LabTilemapDraw(map, 21, 10);
+	Check(LabGetPixel(21, 11) == 0 && LabGetPixel(30, 14) == LABRGB(5, 100, 0), "LabTilemapDraw redraws after LabClear");
+	LabTilemapDestroy(map);
+}
+
+void CheckSprites(void)
+{
+	static labrgb_t red[8 * 8], blue[8 * 8], ring[8 * 8];
+	labimage_t a = { 8, 8, red, LAB_FALSE, 0 };
+	labimage_t b = { 8, 8, blue, LAB_FALSE, 0 };
+	labimage_t c = { 8, 8, ring, LAB_TRUE, LABRGB(255, 0, 255) };
+	labrect_t all = { 0, 0, 320, 240 };
+	unsigned hash;
+	int i;
+
+	for (i = 0; i < 64; i++)
+	{
+		red[i] = LABRGB(200, 0, 0);
+		blue[i] = LABRGB(0, 0, 200);
+		ring[i] = (i % 8 == 0 || i % 8 == 7 || i < 8 || i >= 56) ? LABRGB(0, 200, 0) : LABRGB(255, 0, 255);
+	}
+
+	LabClear();
+	LabSpriteBegin();
+	LabSpriteSubmit(&c, 20, 20, 9);
+	LabSpriteSubmit(&a, 10, 10, 5);
+	LabSpriteSubmit(&b, 14, 14, -3);
+	LabSpriteSubmit(&b, 1000, 10, 100);
+	LabSpriteEnd();
+	Check(LabGetPixel(15, 15) == LABRGB(200, 0, 0) && LabGetPixel(20, 20) == LABRGB(0, 200, 0) &&
+		LabGetPixel(21, 21) == LABRGB(0, 0, 200) && LabGetPixel(23, 23) == 0, "LabSpriteEnd draws in the order of z");
+
+	LabClear();
+	LabSpriteBegin();
+	LabSpriteSubmit(&b, 10, 10, 1);
+	LabSpriteSubmit(&a, 12, 12, 1);
+	LabSpriteSubmit(&b, 14, 14, 1);
+	LabSpriteSubmit(&a, 16, 16, 1);
+	LabSpriteEnd();
+	Check(LabGetPixel(10, 10) == LABRGB(0, 0, 200) && LabGetPixel(13, 13) == LABRGB(200, 0, 0) &&
+		LabGetPixel(15, 15) == LABRGB(0, 0, 200) && LabGetPixel(17, 17) == LABRGB(200, 0, 0),
+		"LabSpriteEnd keeps the order of equal z");
+
+	LabClear();
+	LabSetOrigin(-4, -6);
+	LabSpriteBegin();
+	LabSpriteSubmit(&c, 0, 0, 0);
+	LabSetOrigin(0, 0);
+	LabSpriteEnd();
+	Check(LabGetPixel(3, 1) == LABRGB(0, 200, 0) && LabGetPixel(0, 0) == 0 && LabGetPixel(4, 1) == 0 && LabGetPixel(0, 2) == 0,
+		"LabSpriteSubmit clips a sprite");
+
+	LabClear();
+	LabJournalStart(JOURNAL_NAME);
+	LabSpriteBegin();
+	for (i = 0; i < 50; i++)
+		LabSpriteSubmit(i % 3 ? &a : &c, i * 5, i * 3, i % 7);
+	LabSpriteEnd();
+	hash = HashPixels(&all);
+	LabJournalStop();
+	LabClear();
+	Check(LabJournalReplay(JOURNAL_NAME) && HashPixels(&all) == hash, "LabJournalReplay repeats sprites");
+	remove(JOURNAL_NAME);
+}
+
+// number of pixels in the rectangle drawn in other colors than black, and whether they all are within
+// the given distances from (cx, cy)
+int CountRing(labrect_t const* rect, int cx, int cy, double inner, double outer, int* outside)
+{
+	int x, y, count = 0;
+	double d;
+
+	*outside = 0;
+	for (y = rect->top; y < rect->bottom; y++)
+		for (x = rect->left; x < rect->right; x++)
+			if (LabGetPixel(x, y) != 0)
+			{
+				d = sqrt((double)(x - cx) * (x - cx) + (double)(y - cy) * (y - cy));
+				count++;
+				if (d < inner || d > outer)
+					(*outside)++;
+			}
+	return count;
+}
+
+void CheckCurves(void)
+{
+	labpointf_t line[3] = { { 10, 10 }, { 60, 35 }, { 110, 60 } };
+	labpointf_t curve[4] = { { 20, 200 }, { 20, 100 }, { 120, 100 }, { 120, 200 } };
+	labrect_t all = { 0, 0, 320, 240 };
+	unsigned hash;
+	int count, outside;
+
+	LabSetColor(LABCOLOR_WHITE);
+	LabClear();
+	LabDrawLineF(10, 10, 110, 60);
+	hash = HashPixels(&all);
+	LabClear();
+	LabDrawBezier(line, 3);
+	Check(HashPixels(&all) == hash, "LabDrawBezier draws a straight curve as a line");
+
+	LabClear();
+	LabDrawBezier(curve, 4);
+	count = CountRing(&all, 70, 1000, 0, 1e9, &outside);
+	Check(LabGetPixel(20, 200) != 0 && LabGetPixel(70, 125) != 0 && LabGetPixel(70, 124) == 0 &&
+		LabGetPixel(70, 126) == 0 && count > 170 && count < 200, "LabDrawBezier draws a cubic curve");
+
+	LabClear();
+	LabDrawArc(160, 120, 50, 0, 7);
+	count = CountRing(&all, 160, 120, 49.3, 50.7, &outside);
+	Check(LabGetPixel(210, 120) != 0 && count >= 270 && count <= 290 && outside == 0, "LabDrawArc draws a circle");
+
+	LabClear();
+	LabSetOrigin(10, 10);
+	LabDrawArc(150, 110, 50, 3.14159265f / 2, -3.14159265f / 2);
+	LabSetOrigin(0, 0);
+	count = CountRing(&all, 160, 120, 49.3, 50.7, &outside);
+	all.left = 160;
+	all.top = 120;
+	Check(LabGetPixel(160, 170) != 0 && outside == 0 && CountRing(&all, 160, 120, 0, 1e9, &outside) == count,
+		"LabDrawArc draws a quarter");
+	all.left = all.top = 0;
+
+	// a curve touching the view by its edge is still drawn, one out of view is not
+	LabClear();
+	LabDrawArc(-50, 120, 50, -1, 2);
+	count = CountRing(&all, 0, 0, 0, 1e9, &outside);
+	LabDrawArc(160, 500, 100, 0, 7);
+	Check(LabGetPixel(0, 120) != 0 && LabGetPixel(1, 120) == 0 && CountRing(&all, 0, 0, 0, 1e9, &outside) == count,
+		"LabDrawArc rejects curves out of view");
+
+	LabClear();
+	LabJournalStart(JOURNAL_NAME);
+	LabDrawBezier(curve, 4);
+	LabDrawBezier(line, 3);
+	LabDrawArc(200, 100, 30, 1, -4);
+	hash = HashPixels(&all);
+	LabJournalStop();
+	LabClear();
+	Check(LabJournalReplay(JOURNAL_NAME) && HashPixels(&all) == hash, "LabJournalReplay repeats curves");
+	remove(JOURNAL_NAME);
+}
+
+void CheckHistory(void)
+{
+	labrect_t all = { 0, 0, 320, 240 }, noise = { 100, 100, 200, 200 };
+	labhistoryinfo_t info;
+	labrgb_t *frames, *pixels, *random;
+	int i, j, count, ok, size = 320 * 240;
+	char path[32];
+	FILE* file;
+
+	frames = malloc(10 * size * sizeof(labrgb_t));
+	pixels = malloc(size * sizeof(labrgb_t));
+	random = malloc(100 * 100 * sizeof(labrgb_t));
+	Check(LabHistoryStart(1 << 20) && !LabHistoryStart(1 << 20) && LabHistoryCount() == 0, "LabHistoryStart starts once");
+	for (i = 0; i < 10; i++)
+	{
+		LabClear();
+		LabSetColor(i % 2 ? LABCOLOR_RED : LABCOLOR_GREEN);
+		LabDrawCircle(40 + i * 20, 120, 30);
+		LabDrawText(10, 10, "history");
+		LabDrawFlush();
+		LabReadPixels(&all, frames + i * size, 320);
+	}
+	for (i = 0, ok = LabHistoryCount() == 10; i < 10; i++)
+		ok = ok && LabHistoryGetFrame(9 - i, pixels) && memcmp(pixels, frames + i * size, size * sizeof(labrgb_t)) == 0;
+	Check(ok && !LabHistoryGetFrame(10, pixels) && !LabHistoryGetFrame(-1, pixels), "LabHistoryGetFrame restores frames");
+	LabHistoryGetInfo(&info);
+	Check(info.frames == 10 && info.flushes == 10 && info.deltaBytes > 0 && info.deltaBytes < size &&
+		info.memoryBytes > (1 << 20), "LabHistoryGetInfo counts frames and bytes");
+
+	ok = LabHistoryDump("labtest", 2, 3) == 2;
+	file = fopen("labtest000006.bmp", "rb");
+	ok = ok && file && fseek(file, 54, SEEK_SET) == 0 && fread(pixels, sizeof(labrgb_t), size, file) == (size_t)size &&
+		memcmp(pixels, frames + 6 * size, size * sizeof(labrgb_t)) == 0;
+	if (file)
+		fclose(file);
+	Check(ok && remove("labtest000007.bmp") == 0, "LabHistoryDump saves frames");
+	remove("labtest000006.bmp");
+	LabHistoryStop();
+
+	// each difference of noise takes some 40 KB, so only a few fit and the ring wraps around
+	LabHistoryStart(100000);
+	srand(5);
+	for (i = 0; i < 8; i++)
+	{
+		for (j = 0; j < 100 * 100; j++)
+			random[j] = LABRGB(rand() & 255, rand() & 255, rand() & 255);
+		LabWritePixels(&noise, random, 100);
+		LabDrawFlush();
+		LabReadPixels(&all, frames + (i % 4) * size, 320);
+	}
+	count = LabHistoryCount();
+	ok = count >= 2 && count <= 4;
+	for (i = 0; i < count && ok; i++)
+		ok = LabHistoryGetFrame(i, pixels) && memcmp(pixels, frames + ((7 - i) % 4) * size, size * sizeof(labrgb_t)) == 0;
+	LabHistoryGetInfo(&info);
+	Check(ok && info.deltaBytes <= 100000, "LabHistoryStart keeps the newest frames");
+
+	// the oldest frame is restored from a copy of the wrapped ring
+	ok = LabHistoryDump("labtest", count - 1, count - 1) == 1;
+	sprintf(path, "labtest%06d.bmp", 8 - count);
+	file = fopen(path, "rb");
+	ok = ok && file && fseek(file, 54, SEEK_SET) == 0 && fread(pixels, sizeof(labrgb_t), size, file) == (size_t)size &&
+		memcmp(pixels, frames + ((8 - count) % 4) * size, size * sizeof(labrgb_t)) == 0;
+	if (file)
+		fclose(file);
+	remove(path);
+	Check(ok, "LabHistoryDump saves frames of a wrapped ring");
+	LabHistoryStop();
+	Check(LabHistoryCount() == 0, "LabHistoryStop forgets frames");
+
+	free(frames);
+	free(pixels);
+	free(random);
+}
+
+// number of pixels in the rectangle drawn in other colors than black and the given one
+int CountOther(labrect_t const* rect, labrgb_t color)
+{
+	int x, y, count = 0;
+
+	for (y = rect->top; y < rect->bottom; y++)
+		for (x = rect->left; x < rect->right; x++)
+			if (LabGetPixel(x, y) != 0 && LabGetPixel(x, y) != color)
+				count++;
+	return count;
+}
+
+void CheckBlend(void)
+{
+	labrect_t all = { 0, 0, 320, 240 };
+	labrgb_t gray = LABRGB(128, 128, 128);
+	labpaint_t paint;
+	labpoint_t line[2];
+	unsigned hash;
+
+	LabClear();
+	LabDrawPointRGB(10, 10, LABRGB(100, 100, 100));
+	LabSetColorRGBA(200, 0, 50, 128);
+	LabDrawPoint(10, 10);
+	Check(LabGetPixel(10, 10) == LABRGB(150, 50, 75) && LabGetAlpha() == 128, "LABBLEND_ALPHA mixes colors");
+
+	// explicit colors are blended too, so the background goes first
+	LabSetAlpha(255);
+	LabDrawPointRGB(10, 10, LABRGB(100, 100, 100));
+	LabSetBlend(LABBLEND_ADD);
+	LabDrawPoint(10, 10);
+	Check(LabGetPixel(10, 10) == LABRGB(255, 100, 150) && LabGetBlend() == LABBLEND_ADD, "LABBLEND_ADD saturates");
+
+	LabSetBlend(LABBLEND_ALPHA);
+	LabDrawPointRGB(10, 10, LABRGB(100, 100, 100));
+	LabSetBlend(LABBLEND_MULTIPLY);
+	LabSetColorRGB(128, 255, 0);
+	LabDrawPoint(10, 10);
+	Check(LabGetPixel(10, 10) == LABRGB(50, 100, 0), "LABBLEND_MULTIPLY scales colors");
+
+	hash = HashPixels(&all);
+	LabSetBlend(LABBLEND_XOR);
+	LabDrawText(20, 20, "XOR");
+	LabDrawLine(0, 0, 300, 200);
+	Check(HashPixels(&all) != hash, "LABBLEND_XOR draws");
+	LabDrawLine(0, 0, 300, 200);
+	LabDrawText(20, 20, "XOR");
+	Check(HashPixels(&all) == hash, "LABBLEND_XOR draws twice to erase");
+
+	// every pixel of a translucent shape is blended once
+	LabSetBlend(LABBLEND_ALPHA);
+	LabSetColorRGBA(255, 255, 255, 128);
+	LabClear();
+	LabDrawRectangle(10, 10, 50, 40);
+	LabDrawCircle(100, 100, 40);
+	LabDrawEllipse(220, 100, 60, 25);
+	LabDrawText(20, 200, "Translucent");
+	LabDrawLineF(10.5f, 150.25f, 300.0f, 230.75f);
+	Check(LabGetPixel(10, 10) == gray && LabGetPixel(49, 39) == gray && LabGetPixel(30, 39) == gray &&
+		LabGetPixel(139, 100) == gray && LabGetPixel(220, 124) == gray && CountOther(&all, gray) == 0,
+		"Translucent outlines blend every pixel once");
+	// the same box as GDI Ellipse() takes, without the right and bottom sides
+	Check(LabGetPixel(60, 100) == gray && LabGetPixel(59, 100) == 0 && LabGetPixel(140, 100) == 0 &&
+		LabGetPixel(100, 60) == gray && LabGetPixel(100, 139) == gray && LabGetPixel(100, 140) == 0 &&
+		LabGetPixel(160, 100) == gray && LabGetPixel(279, 99) == gray && LabGetPixel(280, 99) == 0 &&
+		LabGetPixel(220, 75) == gray && LabGetPixel(220, 125) == 0, "Translucent ellipses keep their extents");
+
+	// a huge circle is walked within the clip rectangle only
+	LabClear();
+	LabDrawCircle(160, 1000100, 1000000);
+	Check(LabGetPixel(160, 100) == gray && LabGetPixel(160, 99) == 0 && CountOther(&all, gray) == 0,
+		"Translucent huge circles are clipped");
+
+	// a flood fill blends too
+	LabClear();
+	LabSetAlpha(255);
+	LabDrawRectangle(10, 10, 30, 20);
+	LabSetAlpha(128);
+	LabFloodFill(15, 15, LABRGB(255, 255, 255));
+	Check(LabGetPixel(15, 15) == gray && LabGetPixel(28, 18) == gray && LabGetPixel(10, 10) == LABRGB(255, 255, 255) &&
+		LabGetPixel(5, 5) == 0, "Translucent flood fill blends every pixel once");
+
+	// thin rectangles and closed paths of two points do not go back over their pixels
+	LabClear();
+	line[0].x = 100;
+	line[0].y = 10;
+	line[1].x = 150;
+	line[1].y = 30;
+	LabSetBlend(LABBLEND_ADD);
+	LabSetColorRGBA(100, 100, 100, 255);
+	LabDrawRectangle(10, 10, 11, 40);
+	LabDrawRectangle(20, 10, 60, 11);
+	LabDrawRectangleRGB(70, 10, 71, 40, LABRGB(100, 100, 100));
+	LabDrawPolyline(line, 2, LAB_TRUE);
+	Check(LabGetPixel(10, 25) == LABRGB(100, 100, 100) && LabGetPixel(10, 39) == LABRGB(100, 100, 100) &&
+		LabGetPixel(10, 40) == 0 && LabGetPixel(40, 10) == LABRGB(100, 100, 100) && LabGetPixel(59, 10) == LABRGB(100, 100, 100) &&
+		LabGetPixel(60, 10) == 0 && LabGetPixel(70, 25) == LABRGB(100, 100, 100) && LabGetPixel(100, 10) == LABRGB(100, 100, 100) &&
+		LabGetPixel(150, 30) == LABRGB(100, 100, 100) && CountOther(&all, LABRGB(100, 100, 100)) == 0,
+		"LABBLEND_ADD puts thin rectangles and closed two-point paths once");
+	LabClear();
+	LabSetBlend(LABBLEND_XOR);
+	LabDrawRectangle(10, 10, 11, 40);
+	LabDrawRectangle(20, 10, 60, 11);
+	LabDrawRectangleRGB(70, 10, 71, 40, LABRGB(100, 100, 100));
+	LabDrawPolyline(line, 2, LAB_TRUE);
+	hash = HashPixels(&all);
+	Check(LabGetPixel(10, 25) == LABRGB(100, 100, 100) && LabGetPixel(40, 10) == LABRGB(100, 100, 100) &&
+		LabGetPixel(70, 25) == LABRGB(100, 100, 100) && LabGetPixel(125, 20) == LABRGB(100, 100, 100) &&
+		LabGetPixel(150, 30) == LABRGB(100, 100, 100), "LABBLEND_XOR keeps thin rectangles and closed two-point paths");
+	LabDrawRectangle(10, 10, 11, 40);
+	LabDrawRectangle(20, 10, 60, 11);
+	LabDrawRectangleRGB(70, 10, 71, 40, LABRGB(100, 100, 100));
+	LabDrawPolyline(line, 2, LAB_TRUE);
+	Check(HashPixels(&all) != hash && CountOther(&all, 0) == 0, "LABBLEND_XOR erases them when drawn twice");
+	LabSetBlend(LABBLEND_ALPHA);
+	LabSetColorRGBA(255, 255, 255, 128);
+
+	paint.type = LABPAINT_LINEAR;
+	paint.x0 = paint.y0 = paint.y1 = 0;
+	paint.x1 = 320;
+	paint.color0 = paint.color1 = LABRGB(255, 255, 255);
+	LabClear();
+	LabFillRect(3, 3, 316, 20, &paint);
+	LabFillCircle(160, 120, 50, &paint);
+	Check(LabGetPixel(3, 3) == gray && LabGetPixel(315, 19) == gray && LabGetPixel(160, 120) == gray &&
+		LabGetPixel(316, 19) == 0 && CountOther(&all, gray) == 0, "Translucent fills blend every pixel once");
+
+	// alpha 0 leaves everything as it is
+	hash = HashPixels(&all);
+	LabSetAlpha(0);
+	LabDrawLine(0, 0, 319, 239);
+	LabDrawCircle(160, 120, 100);
+	LabFillRect(0, 0, 320, 240, &paint);
+	Check(HashPixels(&all) == hash, "Alpha 0 draws nothing");
+
+	LabClear();
+	LabJournalStart(JOURNAL_NAME);
+	LabSetColorRGBA(0, 255, 0, 100);
+	LabDrawCircle(160, 120, 60);
+	LabFillRect(100, 100, 200, 150, &paint);
+	LabSetBlend(LABBLEND_ADD);
+	LabDrawLine(0, 0, 319, 239);
+	hash = HashPixels(&all);
+	LabJournalStop();
+	LabSetBlend(LABBLEND_XOR);
+	LabClear();
+	Check(LabJournalReplay(JOURNAL_NAME) && HashPixels(&all) == hash, "LabJournalReplay repeats blending");
+	remove(JOURNAL_NAME);
+
+	LabSetBlend(LABBLEND_ALPHA);
+	LabSetAlpha(255);
+	LabSetColor(LABCOLOR_WHITE);
+}
+
+void CheckLatency(void)
+{
+	lablatencyinfo_t queue, flush, present;
+	int i, keys = 0;
+
+	// the program is busy for 2 ms before it takes every key, then draws and flushes
+	LabLatencyReset();
+	for (i = 0; i < 20; i++)
+	{
+		LabInputKeyPost(LABKEY_RIGHT);
+		Sleep(2);
+		keys += LabInputKey() == LABKEY_RIGHT;
+		DrawPolyFrame(i, 50);
+	}
+	LabLatencyGetInfo(LABLATENCY_QUEUE, &queue);
+	LabLatencyGetInfo(LABLATENCY_FLUSH, &flush);
+	LabLatencyGetInfo(LABLATENCY_PRESENT, &present);
+	Check(keys == 20 && queue.count == 20 && flush.count == 20 && present.count == 20,
+		"Latency is measured for every key");
+	Check(queue.p50 >= 1800 && queue.p50 <= flush.p50 && flush.p50 <= present.p50 && present.p50 <= present.p99 &&
+		present.p99 <= present.max, "Latency stages follow each other");
+
+	// two keys shown by one frame, and a frame with no keys
+	LabLatencyReset();
+	LabInputKeyPost('a');
+	LabInputKeyPost('b');
+	LabInputKey();
+	LabInputKey();
+	LabDrawFlush();
+	LabDrawFlush();
+	LabLatencyGetInfo(LABLATENCY_FLUSH, &flush);
+	LabLatencyGetInfo(LABLATENCY_PRESENT, &present);
+	Check(flush.count == 2 && present.count == 2, "Latency counts keys, not frames");
+
+	LabLatencyReset();
+	LabLatencyGetInfo(LABLATENCY_QUEUE, &queue);
+	Check(queue.count == 0 && queue.max == 0 && LabLatencyPercentile(LABLATENCY_QUEUE, 99) == 0,
+		"LabLatencyReset forgets the keys");
+}
+
+void CheckTriangles(void)
+{
+	labvertex_t upper[3] = { { 10, 10, 0, LABRGB(100, 0, 0) }, { 50, 10, 0, LABRGB(100, 0, 0) }, { 50, 30, 0, LABRGB(100, 0, 0) } };
+	labvertex_t lower[3] = { { 10, 10, 0, LABRGB(100, 0, 0) }, { 10, 30, 0, LABRGB(100, 0, 0) }, { 50, 30, 0, LABRGB(100, 0, 0) } };
+	labvertex_t shaded[3] = { { 100, 20, 0, LABRGB(255, 0, 0) }, { 300, 20, 0, LABRGB(0, 255, 0) }, { 200, 220, 0, LABRGB(0, 0, 255) } };
+	labvertex_t huge[3] = { { -100000, -100000, 0, LABRGB(1, 2, 3) }, { 100000, -100000, 0, LABRGB(1, 2, 3) }, { 0, 100000, 0, LABRGB(1, 2, 3) } };
+	labvertex_t near[3] = { { 20, 20, 0.25f, LABRGB(255, 0, 0) }, { 120, 20, 0.25f, LABRGB(255, 0, 0) }, { 20, 120, 0.25f, LABRGB(255, 0, 0) } };
+	labvertex_t far[3] = { { 10, 10, 0.75f, LABRGB(0, 255, 0) }, { 100, 100, 0.75f, LABRGB(0, 255, 0) }, { 10, 100, 0.75f, LABRGB(0, 255, 0) } };
+	labrect_t all = { 0, 0, 320, 240 }, square = { 10, 10, 50, 30 };
+	labrgb_t c;
+	unsigned hash;
+	int bits;
+
+	// two halves of a square share the diagonal, every pixel is added once
+	LabClear();
+	LabSetBlend(LABBLEND_ADD);
+	LabFillTriangle(upper);
+	LabFillTriangle(lower);
+	LabSetBlend(LABBLEND_ALPHA);
+	Check(CountOther(&all, LABRGB(100, 0, 0)) == 0 && CountRing(&square, 0, 0, 0, 1e9, &bits) == 800 &&
+		LabGetPixel(10, 10) != 0 && LabGetPixel(49, 29) != 0 && LabGetPixel(50, 29) == 0 && LabGetPixel(49, 30) == 0,
+		"LabFillTriangle follows the top-left rule");
+
+	LabClear();
+	LabFillTriangle(shaded);
+	c = LabGetPixel(101, 21);
+	bits = LABRGB_R(c) >= 250 && LABRGB_G(c) <= 3 && LABRGB_B(c) <= 3;
+	c = LabGetPixel(200, 87);
+	Check(bits && LABRGB_R(c) >= 83 && LABRGB_R(c) <= 87 &&
+		LABRGB_G(c) >= 83 && LABRGB_G(c) <= 87 && LABRGB_B(c) >= 83 && LABRGB_B(c) <= 87,
+		"LabFillTriangle blends vertex colors");
+
+	// covered blocks are written directly, adding to black goes through every pixel and gives the same
+	hash = HashPixels(&all);
+	LabClear();
+	LabSetBlend(LABBLEND_ADD);
+	LabFillTriangle(shaded);
+	LabSetBlend(LABBLEND_ALPHA);
+	Check(HashPixels(&all) == hash, "LabFillTriangle writes covered blocks as the others");
+
+	LabClear();
+	LabFillTriangle(huge);
+	Check(CountOther(&all, LABRGB(1, 2, 3)) == 0 && CountRing(&all, 0, 0, 0, 1e9, &bits) == 320 * 240,
+		"LabFillTriangle fills huge triangles");
+
+	for (bits = 16; bits <= 32; bits += 16)
+	{
+		LabClear();
+		Check(LabDepthStart(bits), "LabDepthStart creates the depth buffer");
+		LabFillTriangle(near);
+		LabFillTriangle(far);
+		c = LabGetPixel(50, 60);
+		LabClear();
+		LabDepthClear();
+		LabFillTriangle(far);
+		LabFillTriangle(near);
+		Check(c == LABRGB(255, 0, 0) && LabGetPixel(50, 60) == c && LabGetPixel(15, 90) == LABRGB(0, 255, 0),
+			bits == 16 ? "16-bit depth hides far triangles" : "32-bit depth hides far triangles");
+		LabDepthClear();
+		LabFillTriangle(far);
+		Check(LabGetPixel(50, 60) == LABRGB(0, 255, 0), "LabDepthClear forgets the depths");
+	}
+	LabDepthStop();
+	LabClear();
+	LabFillTriangle(far);
+	LabFillTriangle(near);
+	Check(LabGetPixel(50, 60) == LABRGB(255, 0, 0), "LabDepthStop draws in order");
+
+	LabClear();
+	LabJournalStart(JOURNAL_NAME);
+	LabDepthStart(16);
+	LabFillTriangle(shaded);
+	LabFillTriangle(near);
+	LabSetOrigin(30, 5);
+	LabFillTriangle(far);
+	LabSetOrigin(0, 0);
+	LabDepthStop();
+	hash = HashPixels(&all);
+	LabJournalStop();
+	LabClear();
+	Check(LabJournalReplay(JOURNAL_NAME) && HashPixels(&all) == hash, "LabJournalReplay repeats triangles");
+	remove(JOURNAL_NAME);
+}
+
+int RunChecks(void)
+{
+	labparams_t params;
+
+	params.width = 320;
+	params.height = 240;
+	params.scale = 1;
+	if (!LabInitWithFlags(&params, LABFLAG_HEADLESS))
+		return 1;
+
+	CheckReadback();
+	CheckSubpixel();
+	CheckPolyline();
+	CheckFloodFill();
+	CheckKernels();
+	CheckServer();
+	CheckShare();
+	CheckTerminal();
+	CheckJournal();
+	CheckLayers();
+	CheckScroll();
+	CheckGradient();
+	CheckColors();
+	CheckParticles();
+	CheckTilemap();
+	CheckSprites();
+	CheckRun();
+	CheckCurves();
+	CheckHistory();
+	CheckBlend();
+	CheckLatency();
+	CheckTriangles();
+
+	LabTerm();
+	printf(s_failures ? "%d check(s) FAILED\n" : "All checks passed\n", s_failures);
+	return s_failures ? 1 : 0;
+}
+
+// replay a journal recorded by "labtest record <file>" as fast as possible
+int RunReplay(char const* path)
+{
+	labparams_t params;
+	clock_t start;
+	labbool_t ok;
+
+	params.width = 640;
+	params.height = 480;
+	params.scale = 1;
+	if (!LabInitWithFlags(&params, LABFLAG_HEADLESS))
+		return 1;
+
+	start = clock();
+	ok = LabJournalReplay(path);
+	printf("LabJournalReplay %s  %8.3f ms\n", ok ? "ok" : "FAILED", BenchMicroseconds(start, 1) / 1000);
+
+	LabTerm();
+	return ok ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc > 1 && strcmp(argv[1], "bench") == 0)
+		return RunBenchmarks();
+	if (argc > 1 && strcmp(argv[1], "check") == 0)
+		return RunChecks();
+	if (argc > 1 && strcmp(argv[1], "term") == 0)
+	{
+		labparams_t params;
+
+		params.width = 160;
+		params.height = 96;
+		params.scale = 1;
+		if (LabInitWithFlags(&params, LABFLAG_TERMINAL))
+		{
+			RunPoly();
+			LabTerm();
+		}
+		return 0;
+	}
+
+	if (argc > 2 && strcmp(argv[1], "replay") == 0)
+		return RunReplay(argv[2]);
+
+	if (LabInit())
+	{
+		if (argc > 2 && strcmp(argv[1], "record") == 0)
+			LabJournalStart(argv[2]);
+		RunPoly();
+		// RunTruecolor();
+		// RunText();
+		LabTerm();
+	}
+	return 0;
+}